@@ -1127,6 +1127,20 @@ const globalPrefs: Field[] = [
   )
     .ver("3.7")
     .doc("valid values: (empty), os, sumatrapdf"),
+  field(
+    "PreloadNextDocument",
+    Bool,
+    true,
+    "if true, going to the next or previous file in a folder also starts loading the file after it " +
+      "in the background, so that the following step doesn't wait for it to load",
+  ).ver("3.7"),
+  field(
+    "PageCacheSizeMB",
+    Int,
+    256,
+    "memory, in MB, that a PDF document can use to cache the contents of its pages. " +
+      "Past it, the caches of the pages furthest from the view are freed",
+  ).ver("3.7"),
   field(
     "ReloadModifiedDocuments",
     Bool,
@@ -149,7 +149,11 @@ const utils: LibDef = {
         "LzmaSimpleArchive.*",
         "Pixmap.*",
         "Pixmap_win.cpp",
+        "PixmapPool.*",
+        "PixmapResize.*",
+        "RectIndex.*",
         "RegistryPaths.*",
+        "SettingsJournal.*",
         "SettingsUtil.*",
         "SquareTreeParser.*",
         "Strconv.*",
@@ -161,6 +165,7 @@ const utils: LibDef = {
         "StrQueue.*",
         "TempAllocator.*",
         "Thread.*",
+        "Trace.*",
         "TgaReader.*",
         "TgaReader_win.cpp",
         "TxtParser.*",
@@ -259,10 +264,13 @@ const sumatraFiles: FileGroup[] = [
       "EnginePs.*",
       "EbookDoc.*",
       "EbookFormatter.*",
+      "GlyphIndex.*",
       "GumboHtmlParser.*",
       "HtmlFormatter.*",
+      "HtmlStyleSheet.*",
       "LitDoc.*",
       "MobiDoc.*",
+      "PageStructure.*",
       "PdfCadDetect.*",
       "PdfCadEnhanceDevice.*",
       "PdfDarkModeAnalysis.cpp",
@@ -342,6 +350,7 @@ const sumatraFiles: FileGroup[] = [
       "CrashHandler.*",
       "DisplayModel.*",
       "DocumentLayout.*",
+      "DocPreload.*",
       "DisplayMode.*",
       "PageRenderPolicy.*",
       "PageRenderService.*",
@@ -372,6 +381,7 @@ const sumatraFiles: FileGroup[] = [
       "Notifications.*",
       "PdfSync.*",
       "PdfTools.*",
+      "PerfStats.*",
       "PngOptimizer.*",
       "Print.*",
       "ProgressUpdateUI.*",
@@ -414,11 +424,14 @@ const sumatraFiles: FileGroup[] = [
       "StressTesting.*",
       "SvgIcons.*",
       "TableOfContents.*",
+      "TocFilter.*",
       "Tabs.*",
       "TabGroupsManage.*",
       "Tester.*",
       "Tests.cpp",
+      "TextExport.*",
       "TextSearch.*",
+      "TextSearchPattern.*",
       "TextSelection.*",
       "TextViewWnd.*",
       "Theme.*",
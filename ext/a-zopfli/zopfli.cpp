@@ -182,6 +182,15 @@ typedef struct ZopfliOptions {
   int blocksplittinglast;
 
   int blocksplittingmax;
+
+  /* SumatraPDF: number of threads the blocks of a block split are optimized
+  on. The output doesn't depend on it. */
+  int numthreads;
+
+  /* SumatraPDF: if not 0, fewer threads are used when the blocks optimized at
+  the same time would need more memory than this (see
+  ZOPFLI_BLOCK_MEMORY_PER_BYTE). */
+  size_t maxthreadsmemory;
 } ZopfliOptions;
 
 void ZopfliInitOptions(ZopfliOptions* options);
@@ -282,6 +291,9 @@ void ZopfliBlockSplitSimple(const unsigned char* in,
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #ifndef ZOPFLI_DEFLATE_H_
 #define ZOPFLI_DEFLATE_H_
@@ -1576,11 +1588,70 @@ static void AddLZ77BlockAutoType(const ZopfliOptions* options, int final,
   ZopfliCleanLZ77Store(&fixedstore);
 }
 
+/*
+SumatraPDF: memory used to optimize a block, per byte of it: 28 for the
+longest match cache, the rest for the cost and length arrays and the stores.
+*/
+#define ZOPFLI_BLOCK_MEMORY_PER_BYTE 40
+
+/*
+SumatraPDF: runs ZopfliLZ77Optimal on each of the npoints + 1 blocks between
+the split points into stores[i]. A block only reads the input (including the
+window before it), so the blocks are optimized in parallel on up to
+options->numthreads threads, fewer if that many of the biggest block wouldn't
+fit in options->maxthreadsmemory. The stores are the same as when done in
+order.
+*/
+static void ZopfliLZ77OptimalBlocks(const ZopfliOptions* options,
+                                    const unsigned char* in,
+                                    size_t instart, size_t inend,
+                                    const size_t* splitpoints_uncompressed,
+                                    size_t npoints, ZopfliLZ77Store* stores) {
+  size_t nblocks = npoints + 1;
+  std::atomic<size_t> next(0);
+  auto optimizeBlocks = [&]() {
+    for (;;) {
+      size_t i = next.fetch_add(1);
+      if (i >= nblocks) break;
+      size_t start = i == 0 ? instart : splitpoints_uncompressed[i - 1];
+      size_t end = i == npoints ? inend : splitpoints_uncompressed[i];
+      ZopfliBlockState s;
+      ZopfliInitBlockState(options, start, end, 1, &s);
+      ZopfliLZ77Optimal(&s, in, start, end, options->numiterations, &stores[i]);
+      ZopfliCleanBlockState(&s);
+    }
+  };
+  size_t nthreads = options->numthreads > 1 ? (size_t)options->numthreads : 1;
+  if (nthreads > nblocks) nthreads = nblocks;
+  if (nthreads > 1 && options->maxthreadsmemory > 0) {
+    size_t maxblocksize = 0;
+    size_t maxthreads;
+    for (size_t i = 0; i < nblocks; i++) {
+      size_t start = i == 0 ? instart : splitpoints_uncompressed[i - 1];
+      size_t end = i == npoints ? inend : splitpoints_uncompressed[i];
+      if (end - start > maxblocksize) maxblocksize = end - start;
+    }
+    maxthreads = options->maxthreadsmemory /
+        (maxblocksize * ZOPFLI_BLOCK_MEMORY_PER_BYTE + 1);
+    if (maxthreads < 1) maxthreads = 1;
+    if (nthreads > maxthreads) nthreads = maxthreads;
+  }
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < nthreads; i++) {
+    threads.emplace_back(optimizeBlocks);
+  }
+  optimizeBlocks();
+  for (std::thread& t : threads) {
+    t.join();
+  }
+}
+
 void ZopfliDeflatePart(const ZopfliOptions* options, int btype, int final,
                        const unsigned char* in, size_t instart, size_t inend,
                        unsigned char* bp, unsigned char** out,
                        size_t* outsize) {
   size_t i;
+  ZopfliLZ77Store* stores;
 
   size_t* splitpoints_uncompressed = 0;
   size_t npoints = 0;
@@ -1615,22 +1686,22 @@ void ZopfliDeflatePart(const ZopfliOptions* options, int btype, int final,
 
   ZopfliInitLZ77Store(in, &lz77);
 
+  stores = (ZopfliLZ77Store*)malloc(sizeof(*stores) * (npoints + 1));
   for (i = 0; i <= npoints; i++) {
-    size_t start = i == 0 ? instart : splitpoints_uncompressed[i - 1];
-    size_t end = i == npoints ? inend : splitpoints_uncompressed[i];
-    ZopfliBlockState s;
-    ZopfliLZ77Store store;
-    ZopfliInitLZ77Store(in, &store);
-    ZopfliInitBlockState(options, start, end, 1, &s);
-    ZopfliLZ77Optimal(&s, in, start, end, options->numiterations, &store);
-    totalcost += ZopfliCalculateBlockSizeAutoType(&store, 0, store.size);
+    ZopfliInitLZ77Store(in, &stores[i]);
+  }
+  ZopfliLZ77OptimalBlocks(options, in, instart, inend,
+                          splitpoints_uncompressed, npoints, stores);
+  for (i = 0; i <= npoints; i++) {
+    ZopfliLZ77Store* store = &stores[i];
+    totalcost += ZopfliCalculateBlockSizeAutoType(store, 0, store->size);
 
-    ZopfliAppendLZ77Store(&store, &lz77);
+    ZopfliAppendLZ77Store(store, &lz77);
     if (i < npoints) splitpoints[i] = lz77.size;
 
-    ZopfliCleanBlockState(&s);
-    ZopfliCleanLZ77Store(&store);
+    ZopfliCleanLZ77Store(store);
   }
+  free(stores);
 
   if (options->blocksplitting && npoints > 1) {
     size_t* splitpoints2 = 0;
@@ -3200,6 +3271,8 @@ void ZopfliInitOptions(ZopfliOptions* options) {
   options->blocksplitting = 1;
   options->blocksplittinglast = 0;
   options->blocksplittingmax = 15;
+  options->numthreads = 1;
+  options->maxthreadsmemory = 0;
 }
 
 #ifndef ZOPFLI_ZLIB_H_
@@ -10723,7 +10796,9 @@ ZopfliPNGOptions::ZopfliPNGOptions()
   , use_zopfli(true)
   , num_iterations(15)
   , num_iterations_large(5)
-  , block_split_strategy(1) {
+  , block_split_strategy(1)
+  , num_threads(1)
+  , max_threads_memory(0) {
 }
 
 unsigned CustomPNGDeflate(unsigned char** out, size_t* outsize,
@@ -10738,6 +10813,8 @@ unsigned CustomPNGDeflate(unsigned char** out, size_t* outsize,
   options.verbose = png_options->verbose;
   options.numiterations = insize < 200000
       ? png_options->num_iterations : png_options->num_iterations_large;
+  options.numthreads = png_options->num_threads;
+  options.maxthreadsmemory = png_options->max_threads_memory;
 
   ZopfliDeflate(&options, 2 , 1, in, insize, &bp, out, outsize);
 
@@ -11125,6 +11202,8 @@ extern "C" void CZopfliPNGSetDefaults(CZopfliPNGOptions* png_options) {
   png_options->num_iterations       = opts.num_iterations;
   png_options->num_iterations_large = opts.num_iterations_large;
   png_options->block_split_strategy = opts.block_split_strategy;
+  png_options->num_threads          = opts.num_threads;
+  png_options->max_threads_memory   = opts.max_threads_memory;
 }
 
 extern "C" int CZopfliPNGOptimize(const unsigned char* origpng,
@@ -11142,6 +11221,8 @@ extern "C" int CZopfliPNGOptimize(const unsigned char* origpng,
   opts.num_iterations       = png_options->num_iterations;
   opts.num_iterations_large = png_options->num_iterations_large;
   opts.block_split_strategy = png_options->block_split_strategy;
+  opts.num_threads          = png_options->num_threads;
+  opts.max_threads_memory   = png_options->max_threads_memory;
 
   for (int i = 0; i < png_options->num_filter_strategies; i++) {
     opts.filter_strategies.push_back(png_options->filter_strategies[i]);
@@ -46,6 +46,12 @@ typedef struct CZopfliPNGOptions {
   int num_iterations_large;
 
   int block_split_strategy;
+
+  // SumatraPDF: threads used for each zopfli run
+  int num_threads;
+
+  // SumatraPDF: if not 0, memory budget that limits the threads used
+  size_t max_threads_memory;
 } CZopfliPNGOptions;
 
 void CZopfliPNGSetDefaults(CZopfliPNGOptions *png_options);
@@ -87,6 +93,13 @@ struct ZopfliPNGOptions {
   int num_iterations_large;
 
   int block_split_strategy;
+
+  // SumatraPDF: threads used for each zopfli run, doesn't change the output
+  int num_threads;
+
+  // SumatraPDF: if not 0, fewer threads are used when the blocks optimized
+  // at the same time would need more memory than this
+  size_t max_threads_memory;
 };
 
 int ZopfliPNGOptimize(const std::vector<unsigned char>& origpng,
@@ -139,4 +139,13 @@ fz_image *fz_new_image_from_display_list(fz_context *ctx, float w, float h, fz_d
 */
 int fz_display_list_is_empty(fz_context *ctx, const fz_display_list *list);
 
+/**
+	SumatraPDF: Return the number of bytes held by a display list
+	itself: the list and its node buffer. Paths are packed into the
+	node buffer, text and images are only referenced.
+
+	list: The list to measure (may be NULL).
+*/
+size_t fz_display_list_size(fz_context *ctx, const fz_display_list *list);
+
 #endif
@@ -1,6 +1,18 @@
 // this file is compiled as part of mupdf library and ends up
 // in libsumatrapdf.dll, to avoid issues related to crossing .dll boundaries
 // It implements loading of Fonts included in windows
+//
+// Finding a font by name needs the names of all installed fonts, and those are
+// only in the fonts' 'name' tables: parsing thousands of font files stalled the
+// first document without embedded fonts for a second or more, on every launch.
+// So the names are kept in an index file (set_system_font_cache_path()). A font
+// directory whose mtime didn't change is taken from it as is; in one that did,
+// only the files that are new or whose mtime / size changed are parsed. The
+// index is built on a background thread at startup (start_system_font_index())
+// and looked up through hash tables.
+// Only loading the fonts into mupdf needs Windows. The index can be built over
+// any directories (set_system_font_dirs()), which is how test_engines
+// -bench-font-index tests it.
 #include "mupdf/fitz.h"
 #include "mupdf/ucdn.h"
 #include "mupdf/pdf.h"
@@ -15,9 +27,20 @@
 #endif
 
 #include <windows.h>
+#else
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>
 
+typedef uint8_t u8;
+typedef uint16_t u16;
 typedef uint32_t u32;
+typedef uint64_t u64;
 
 // TODO: Use more of FreeType for TTF parsing (for performance reasons,
 //       the fonts can't be parsed completely, though)
@@ -30,184 +53,129 @@ typedef uint32_t u32;
 
 #define MAX_FACENAME 256
 
+// PRIMARYLANGID(id) == LANG_CHINESE, without needing <windows.h>
+#define IS_CHINESE_LANGID(id) (((id)&0x3ff) == 0x04)
+
+// bump when what's parsed out of a font changes, so old index files are ignored
+#define FONT_INDEX_VERSION 1
+
+typedef struct win_font_info win_font_info;
+
 // a font file we've seen, and its contents once something needed them.
 // intrusive list: a win_font_info points at one of these, so they have to keep
-// their address. file_path is allocated with the node, right after it
+// their address. file_path is allocated with the node, right after it.
+// mtime and file_size are what the index file is checked against. dir is the
+// index of the font directory it's in (-1: added some other way, so not in the
+// index file). Its names are the n_names nodes of g_win_fonts from first_name
 typedef struct font_file {
     struct font_file* next;
     void* data;
     size_t size;
     const char* file_path;
+    u64 mtime;
+    u64 file_size;
+    int dir;
+    int n_names;
+    win_font_info* first_name;
 } font_file;
 
 // one name a font answers to. Intrusive list, in registration order, which is
-// also the order a lookup walks. Both names live in the same allocation as the
-// node: full_name is how the font spells it ("Courier New"), clean_name is the
-// form a lookup is normalized to ("CourierNew"), and the lengths are kept so a
-// comparison can reject a candidate without touching its characters
-typedef struct win_font_info {
+// also the order a lookup prefers. Both names live in the same allocation as
+// the node: full_name is how the font spells it ("Courier New"), clean_name is
+// the form a lookup is normalized to ("CourierNew"), and the lengths are kept
+// so a comparison can reject a candidate without touching its characters.
+// next_full / next_clean chain the names in one bucket of the hash tables over
+// full_name / clean_name, in registration order too
+struct win_font_info {
     struct win_font_info* next;
+    struct win_font_info* next_full;
+    struct win_font_info* next_clean;
     font_file* file;
     u32 index; // the face within the file, for .ttc collections
     int full_name_len;
     int clean_name_len;
     const char* full_name;
     const char* clean_name;
-} win_font_info;
+};
 
 static font_file* g_font_files = NULL;
 static font_file* g_font_files_last = NULL;
 
+static win_font_info* g_win_fonts = NULL;
+static win_font_info* g_win_fonts_last = NULL;
+
+// g_n_buckets (a power of 2) each. Not allocated: lookups walk g_win_fonts
+static win_font_info** g_full_buckets = NULL;
+static win_font_info** g_clean_buckets = NULL;
+static u32 g_n_buckets = 0;
+
+// UTF-8. No directories set: the Windows fonts directory
+static char** g_font_dirs = NULL;
+static int g_n_font_dirs = 0;
+// no path: the index isn't kept between runs
+static char* g_font_index_path = NULL;
+
+static int g_font_index_built = 0;
+// set to stop a build in progress, at exit
+static volatile int g_font_index_cancel = 0;
+
+static int g_n_font_files = 0;
+static int g_n_font_names = 0;
+// files in the font directories the last build had to parse, rather than
+// take from the index file
+static int g_n_fonts_parsed = 0;
+
+#ifdef _WIN32
+static CRITICAL_SECTION cs_fonts;
+void init_system_font_list(void);
+static void lock_fonts(void) {
+    init_system_font_list();
+    EnterCriticalSection(&cs_fonts);
+}
+#define unlock_fonts() LeaveCriticalSection(&cs_fonts)
+#else
+// no fonts are loaded from here off Windows: the index is only built by tests,
+// on one thread
+#define lock_fonts()
+#define unlock_fonts()
+#endif
+
 typedef struct {
-    ULONG uVersion;
-    USHORT uNumOfTables;
-    USHORT uSearchRange;
-    USHORT uEntrySelector;
-    USHORT uRangeShift;
+    u32 uVersion;
+    u16 uNumOfTables;
+    u16 uSearchRange;
+    u16 uEntrySelector;
+    u16 uRangeShift;
 } TT_OFFSET_TABLE;
 
 typedef struct {
-    ULONG uTag;      // table name
-    ULONG uCheckSum; // Check sum
-    ULONG uOffset;   // Offset from beginning of file
-    ULONG uLength;   // length of the table in bytes
+    u32 uTag;      // table name
+    u32 uCheckSum; // Check sum
+    u32 uOffset;   // Offset from beginning of file
+    u32 uLength;   // length of the table in bytes
 } TT_TABLE_DIRECTORY;
 
 typedef struct {
-    USHORT uFSelector;     // format selector. Always 0
-    USHORT uNRCount;       // Name Records count
-    USHORT uStorageOffset; // Offset for strings storage, from start of the table
+    u16 uFSelector;     // format selector. Always 0
+    u16 uNRCount;       // Name Records count
+    u16 uStorageOffset; // Offset for strings storage, from start of the table
 } TT_NAME_TABLE_HEADER;
 
 typedef struct {
-    USHORT uPlatformID;
-    USHORT uEncodingID;
-    USHORT uLanguageID;
-    USHORT uNameID;
-    USHORT uStringLength;
-    USHORT uStringOffset; // from start of storage area
+    u16 uPlatformID;
+    u16 uEncodingID;
+    u16 uLanguageID;
+    u16 uNameID;
+    u16 uStringLength;
+    u16 uStringOffset; // from start of storage area
 } TT_NAME_RECORD;
 
 typedef struct {
-    ULONG Tag;
-    ULONG Version;
-    ULONG NumFonts;
+    u32 Tag;
+    u32 Version;
+    u32 NumFonts;
 } FONT_COLLECTION;
 
-static struct {
-    const char* name;
-    const char* pattern;
-} baseSubstitutes[] = {
-    {"Courier", "CourierNewPSMT"},
-    {"Courier-Bold", "CourierNewPS-BoldMT"},
-    {"Courier-Oblique", "CourierNewPS-ItalicMT"},
-    {"Courier-BoldOblique", "CourierNewPS-BoldItalicMT"},
-    {"Helvetica", "ArialMT"},
-    {"Helvetica-Bold", "Arial-BoldMT"},
-    {"Helvetica-Oblique", "Arial-ItalicMT"},
-    {"Helvetica-BoldOblique", "Arial-BoldItalicMT"},
-    {"Times-Roman", "TimesNewRomanPSMT"},
-    {"Times-Bold", "TimesNewRomanPS-BoldMT"},
-    {"Times-Italic", "TimesNewRomanPS-ItalicMT"},
-    {"Times-BoldItalic", "TimesNewRomanPS-BoldItalicMT"},
-    {"Symbol", "SymbolMT"},
-    // CSS generic font families used in EPUB files
-    {"serif", "TimesNewRomanPSMT"},
-    {"sans-serif", "ArialMT"},
-    {"sans", "ArialMT"},
-    {"monospace", "CourierNewPSMT"},
-    {"cursive", "ComicSansMS"},
-    {"fantasy", "Impact"},
-    // fallbacks for fonts commonly used in EPUBs that may not be installed
-    {"DroidSansMono", "Consolas"},
-    {"SourceSansPro", "SegoeUI"},
-    {"SourceSansPro-Bold", "SegoeUI-Bold"},
-    {"SourceSansPro-Italic", "SegoeUI-Italic"},
-    {"SourceSansPro-BoldItalic", "SegoeUI-BoldItalic"},
-    {"SourceSansPro-Light", "SegoeUI-Light"},
-    {"SourceSansPro-Semibold", "SegoeUI-Semibold"},
-    {"HelveticaNeue", "ArialMT"},
-    {"HelveticaNeue-Bold", "Arial-BoldMT"},
-    {"HelveticaNeue-Italic", "Arial-ItalicMT"},
-    {"HelveticaNeue-BoldItalic", "Arial-BoldItalicMT"},
-    {"HelveticaNeue-Light", "ArialMT"},
-    {"HelveticaNeueLight", "ArialMT"},
-    {"LucidaSans", "SegoeUI"},
-    {"LucidaGrande", "SegoeUI"},
-    {"LucidaConsole", "Consolas"},
-    {"LucidaBright", "Georgia"},
-    {"Handwriting", "SegoeScript"},
-    {"Console", "Consolas"},
-    {"FuturaStd-Bold", "SegoeUI-Bold"},
-    {"DINPro", "SegoeUI"},
-    {"ACaslonPro-Regular", "Georgia"},
-    {"ACaslonPro-Italic", "Georgia-Italic"},
-    // Liberation Sans (Linux metrically compatible with Arial) fallbacks
-    {"LiberationSans", "ArialMT"},
-    {"LiberationSans-Bold", "Arial-BoldMT"},
-    {"LiberationSans-Italic", "Arial-ItalicMT"},
-    {"LiberationSans-BoldItalic", "Arial-BoldItalicMT"},
-    // Safari placeholder font
-    {"SafariFakeFont", "ArialMT"},
-    // PingFang SC (macOS/iOS Simplified Chinese) fallbacks
-    {"PingFangSC-Regular", "Microsoft YaHei"},
-    {"PingFangSC-Medium", "Microsoft YaHei"},
-    {"PingFangSC-Semibold", "Microsoft YaHei Bold"},
-    {"PingFangSC-Bold", "Microsoft YaHei Bold"},
-    {"PingFangSC-Light", "Microsoft YaHei Light"},
-    {"PingFangSC-Ultralight", "Microsoft YaHei Light"},
-    {"PingFangSC-Thin", "Microsoft YaHei Light"},
-    {"PingFang SC", "Microsoft YaHei"},
-    // Founder FangSong font fallback
-    {"FZFangSong-Z02", "FangSong"},
-    {"FZFangSong-Z02S", "FangSong"},
-    // Chinese Kai (regular script) font fallbacks
-    {"MKai PRC", "KaiTi"},
-    {"MKaiPRC-Regular", "KaiTi"},
-    {"MKaiPRC", "KaiTi"},
-    {"STKaiti", "KaiTi"},
-    {"STKaiti-Regular", "KaiTi"},
-    {"STKai", "KaiTi"},
-    {"Kai", "KaiTi"},
-    {"Kaiti_GB2312", "KaiTi"},
-    {"Kaiti SC", "KaiTi"},
-    {"Kaiti TC", "KaiTi"},
-};
-
-static win_font_info* g_win_fonts = NULL;
-static win_font_info* g_win_fonts_last = NULL;
-
-static int did_init = 0;
-static CRITICAL_SECTION cs_fonts;
-
-// cache of font names that failed to load, to avoid repeated lookups
-// names are stored 0-separated in gFontsFailedToLoad
-static char gFontsFailedToLoad[256];
-static int gFontsFailedToLoadLen = 0;
-
-static int is_font_failed(const char* name) {
-    int nameLen = (int)strlen(name);
-    int pos = 0;
-    while (pos < gFontsFailedToLoadLen) {
-        const char* entry = gFontsFailedToLoad + pos;
-        int entryLen = (int)strlen(entry);
-        if (entryLen == nameLen && memcmp(entry, name, nameLen) == 0) {
-            return 1;
-        }
-        pos += entryLen + 1;
-    }
-    return 0;
-}
-
-static void add_font_failed(const char* name) {
-    int n = (int)strlen(name) + 1;
-    if (gFontsFailedToLoadLen + n > (int)sizeof(gFontsFailedToLoad)) {
-        return; // buffer full, just skip
-    }
-    memcpy(gFontsFailedToLoad + gFontsFailedToLoadLen, name, n);
-    gFontsFailedToLoadLen += n;
-}
-
 static void remove_spaces(char* srcDest);
 
 static int streq(const char* s1, const char* s2) {
@@ -218,20 +186,20 @@ static int streq(const char* s1, const char* s2) {
 }
 
 static int streqi(const char* s1, const char* s2) {
-    if (_stricmp(s1, s2) == 0) {
+    if (fz_strcasecmp(s1, s2) == 0) {
         return 1;
     }
     return 0;
 }
 
-static inline USHORT BEtoHs(USHORT x) {
-    BYTE* data = (BYTE*)&x;
-    return (data[0] << 8) | data[1];
+static inline u16 BEtoHs(u16 x) {
+    u8* data = (u8*)&x;
+    return (u16)((data[0] << 8) | data[1]);
 }
 
-static inline ULONG BEtoHl(ULONG x) {
-    BYTE* data = (BYTE*)&x;
-    return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+static inline u32 BEtoHl(u32 x) {
+    u8* data = (u8*)&x;
+    return ((u32)data[0] << 24) | ((u32)data[1] << 16) | ((u32)data[2] << 8) | data[3];
 }
 
 /* A little bit more sophisticated name matching so that e.g. "EurostileExtended"
@@ -242,10 +210,10 @@ static int cmp_font_name(const char* name1, const char* name2) {
 
     if (len1 != len2) {
         const char* rest = len1 > len2 ? name1 + len2 : name2 + len1;
-        if (',' == *rest || streqi(rest, "-roman")) return _strnicmp(name1, name2, fz_mini(len1, len2));
+        if (',' == *rest || streqi(rest, "-roman")) return fz_strncasecmp(name1, name2, fz_mini(len1, len2));
     }
 
-    return _stricmp(name1, name2);
+    return fz_strcasecmp(name1, name2);
 }
 
 static int font_name_eq(const char* name1, const char* name2) {
@@ -261,16 +229,31 @@ static int font_name_matches(const char* n1, int len1, const char* n2, int len2)
         if (*rest != ',' && !streqi(rest, "-roman")) {
             return 0;
         }
-        return _strnicmp(n1, n2, (size_t)(len1 < len2 ? len1 : len2)) == 0;
+        return fz_strncasecmp(n1, n2, (size_t)(len1 < len2 ? len1 : len2)) == 0;
     }
-    return _strnicmp(n1, n2, (size_t)len1) == 0;
+    return fz_strncasecmp(n1, n2, (size_t)len1) == 0;
 }
 
-/* the first name registered wins, so a font that answers to a name under its
-   own spelling is preferred over one that only matches after normalizing.
-   use_clean_name compares against the space-less form, which is what a family
-   name written the way a human writes it turns into */
-static win_font_info* find_font(const char* name, int name_len, int use_clean_name) {
+/* font_name_matches() ignores case and, past the end of the shorter name, a
+   tail that starts with ',' or is "-roman". What's hashed is the name without
+   those, so names that match always land in the same bucket */
+static u32 font_name_hash(const char* name, int len) {
+    u32 h = 2166136261u;
+    int n = 0, i;
+    while (n < len && name[n] != ',') {
+        n++;
+    }
+    while (n >= 6 && fz_strncasecmp(name + n - 6, "-roman", 6) == 0) {
+        n -= 6;
+    }
+    for (i = 0; i < n; i++) {
+        h ^= (u32)fz_tolower((unsigned char)name[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static win_font_info* find_font_linear(const char* name, int name_len, int use_clean_name) {
     win_font_info* fi;
     for (fi = g_win_fonts; fi; fi = fi->next) {
         const char* cand = use_clean_name ? fi->clean_name : fi->full_name;
@@ -282,24 +265,125 @@ static win_font_info* find_font(const char* name, int name_len, int use_clean_na
     return NULL;
 }
 
+/* the first name registered wins, so a font that answers to a name under its
+   own spelling is preferred over one that only matches after normalizing.
+   use_clean_name compares against the space-less form, which is what a family
+   name written the way a human writes it turns into. A bucket is in
+   registration order and has every name that matches, so its first match is
+   the one find_font_linear() would find */
+static win_font_info* find_font(const char* name, int name_len, int use_clean_name) {
+    win_font_info* fi;
+    u32 bucket;
+    if (!g_n_buckets) {
+        return find_font_linear(name, name_len, use_clean_name);
+    }
+    bucket = font_name_hash(name, name_len) & (g_n_buckets - 1);
+    if (use_clean_name) {
+        for (fi = g_clean_buckets[bucket]; fi; fi = fi->next_clean) {
+            if (font_name_matches(fi->clean_name, fi->clean_name_len, name, name_len)) {
+                return fi;
+            }
+        }
+        return NULL;
+    }
+    for (fi = g_full_buckets[bucket]; fi; fi = fi->next_full) {
+        if (font_name_matches(fi->full_name, fi->full_name_len, name, name_len)) {
+            return fi;
+        }
+    }
+    return NULL;
+}
+
 static win_font_info* find_font_name(const char* name, int use_clean_name) {
     return find_font(name, (int)strlen(name), use_clean_name);
 }
 
+static void free_font_name_index(void) {
+    free(g_full_buckets);
+    free(g_clean_buckets);
+    g_full_buckets = NULL;
+    g_clean_buckets = NULL;
+    g_n_buckets = 0;
+}
+
+// on OOM there's no index and lookups walk the list
+static void build_font_name_index(void) {
+    win_font_info** full_last;
+    win_font_info** clean_last;
+    win_font_info* fi;
+    u32 n = 64;
+    free_font_name_index();
+    while (n < 2 * (u32)g_n_font_names) {
+        n *= 2;
+    }
+    g_full_buckets = (win_font_info**)calloc(n, sizeof(win_font_info*));
+    g_clean_buckets = (win_font_info**)calloc(n, sizeof(win_font_info*));
+    // the last node of each bucket, to keep the buckets in registration order
+    full_last = (win_font_info**)calloc(n, sizeof(win_font_info*));
+    clean_last = (win_font_info**)calloc(n, sizeof(win_font_info*));
+    if (!g_full_buckets || !g_clean_buckets || !full_last || !clean_last) {
+        free_font_name_index();
+        free(full_last);
+        free(clean_last);
+        return;
+    }
+    for (fi = g_win_fonts; fi; fi = fi->next) {
+        u32 b = font_name_hash(fi->full_name, fi->full_name_len) & (n - 1);
+        fi->next_full = NULL;
+        if (full_last[b]) {
+            full_last[b]->next_full = fi;
+        } else {
+            g_full_buckets[b] = fi;
+        }
+        full_last[b] = fi;
+
+        b = font_name_hash(fi->clean_name, fi->clean_name_len) & (n - 1);
+        fi->next_clean = NULL;
+        if (clean_last[b]) {
+            clean_last[b]->next_clean = fi;
+        } else {
+            g_clean_buckets[b] = fi;
+        }
+        clean_last[b] = fi;
+    }
+    free(full_last);
+    free(clean_last);
+    g_n_buckets = n;
+}
+
 /* source and dest can be same */
 static void decode_unicode_BE(fz_context* ctx, char* source, int sourcelen, char* dest, int destlen) {
-    WCHAR* tmp;
-    int converted, i;
+    const u8* s = (const u8*)source;
+    char* tmp;
+    int i, n = 0;
 
     if (sourcelen % 2 != 0) fz_throw(ctx, FZ_ERROR_GENERIC, "fonterror : invalid unicode string");
 
-    tmp = fz_malloc_array(ctx, sourcelen / 2 + 1, WCHAR);
-    for (i = 0; i < sourcelen / 2; i++) tmp[i] = BEtoHs(((WCHAR*)source)[i]);
-    tmp[sourcelen / 2] = '\0';
-
-    converted = WideCharToMultiByte(CP_UTF8, 0, tmp, -1, dest, destlen, NULL, NULL);
+    tmp = (char*)fz_malloc(ctx, (size_t)(sourcelen / 2) * FZ_UTFMAX + 1);
+    for (i = 0; i + 1 < sourcelen; i += 2) {
+        int c = (s[i] << 8) | s[i + 1];
+        if (c >= 0xd800 && c < 0xdc00 && i + 3 < sourcelen) {
+            int c2 = (s[i + 2] << 8) | s[i + 3];
+            if (c2 >= 0xdc00 && c2 < 0xe000) {
+                c = 0x10000 + ((c - 0xd800) << 10) + (c2 - 0xdc00);
+                i += 2;
+            }
+        }
+        if (c == 0) {
+            break;
+        }
+        if (c >= 0xd800 && c < 0xe000) {
+            c = 0xfffd; // unpaired surrogate
+        }
+        n += fz_runetochar(tmp + n, c);
+    }
+    if (n + 1 > destlen) {
+        fz_free(ctx, tmp);
+        fz_throw(ctx, FZ_ERROR_GENERIC, "fonterror : invalid unicode string");
+    }
+    memcpy(dest, tmp, (size_t)n);
+    dest[n] = 0;
     fz_free(ctx, tmp);
-    if (!converted) fz_throw(ctx, FZ_ERROR_GENERIC, "fonterror : invalid unicode string");
 }
 
 static void decode_platform_string(fz_context* ctx, int platform, int enctype, char* source, int sourcelen, char* dest,
@@ -341,16 +425,11 @@ static void decode_platform_string(fz_context* ctx, int platform, int enctype, c
 // on my machine it's ~21k for facename and path
 static int g_font_allocated = 0;
 
-static font_file* get_or_append_font_file(const char* file_path) {
-    font_file* ff;
-    for (ff = g_font_files; ff; ff = ff->next) {
-        if (streq(file_path, ff->file_path)) {
-            return ff;
-        }
-    }
+// dir: see font_file
+static font_file* new_font_file(const char* file_path, u64 mtime, u64 file_size, int dir) {
     // one allocation: the node, then the path right after it
     size_t path_size = strlen(file_path) + 1;
-    ff = (font_file*)malloc(sizeof(font_file) + path_size);
+    font_file* ff = (font_file*)malloc(sizeof(font_file) + path_size);
     if (!ff) {
         return NULL;
     }
@@ -361,20 +440,22 @@ static font_file* get_or_append_font_file(const char* file_path) {
     ff->data = NULL;
     ff->size = 0;
     ff->file_path = path_copy;
+    ff->mtime = mtime;
+    ff->file_size = file_size;
+    ff->dir = dir;
+    ff->n_names = 0;
+    ff->first_name = NULL;
     if (g_font_files_last) {
         g_font_files_last->next = ff;
     } else {
         g_font_files = ff;
     }
     g_font_files_last = ff;
+    g_n_font_files++;
     return ff;
 }
 
-static void append_mapping(fz_context* ctx, const char* facename, const char* path, int index) {
-    font_file* file = get_or_append_font_file(path);
-    if (!file) {
-        return;
-    }
+static void append_mapping(fz_context* ctx, const char* facename, font_file* file, int index) {
     // one allocation: the node, then the name, then the name without spaces
     // (which can only be shorter, so the same size is always enough)
     int name_len = (int)strlen(facename);
@@ -390,6 +471,8 @@ static void append_mapping(fz_context* ctx, const char* facename, const char* pa
     memcpy(clean, facename, (size_t)name_len + 1);
     remove_spaces(clean);
     fi->next = NULL;
+    fi->next_full = NULL;
+    fi->next_clean = NULL;
     fi->file = file;
     fi->index = (u32)index;
     fi->full_name = full;
@@ -402,6 +485,12 @@ static void append_mapping(fz_context* ctx, const char* facename, const char* pa
         g_win_fonts = fi;
     }
     g_win_fonts_last = fi;
+    // a file's names are registered one after the other
+    if (!file->first_name) {
+        file->first_name = fi;
+    }
+    file->n_names++;
+    g_n_font_names++;
 }
 
 static void safe_read(fz_context* ctx, fz_stream* file, int offset, char* buf, int size) {
@@ -442,7 +531,8 @@ static void makeFakePSName(char szName[MAX_FACENAME], const char* szStyle) {
     remove_spaces(szName);
 }
 
-static void parseTTF(fz_context* ctx, fz_stream* file, int offset, int index, const char* path) {
+static void parseTTF(fz_context* ctx, fz_stream* file, int offset, int index, font_file* ff) {
+    const char* path = ff->file_path;
     TT_OFFSET_TABLE ttOffsetTableBE;
     TT_TABLE_DIRECTORY tblDirBE;
     TT_NAME_TABLE_HEADER ttNTHeaderBE;
@@ -485,13 +575,13 @@ static void parseTTF(fz_context* ctx, fz_stream* file, int offset, int index, co
     count = BEtoHs(ttNTHeaderBE.uNRCount);
     for (i = 0; i < count; i++) {
         short langId, nameId;
-        BOOL isCJKName;
+        int isCJKName;
 
         safe_read(ctx, file, offset + i * sizeof(TT_NAME_RECORD), (char*)&ttRecordBE, sizeof(TT_NAME_RECORD));
 
         langId = BEtoHs(ttRecordBE.uLanguageID);
         nameId = BEtoHs(ttRecordBE.uNameID);
-        isCJKName = TT_NAME_ID_FONT_FAMILY == nameId && LANG_CHINESE == PRIMARYLANGID(langId);
+        isCJKName = TT_NAME_ID_FONT_FAMILY == nameId && IS_CHINESE_LANGID(langId);
 
         // ignore non-English strings (except for Chinese font names)
         if (langId && langId != TT_MS_LANGID_ENGLISH_UNITED_STATES && !isCJKName) {
@@ -527,180 +617,942 @@ static void parseTTF(fz_context* ctx, fz_stream* file, int offset, int index, co
         }
     }
 
-    if (szPSName[0]) {
-        append_mapping(ctx, szPSName, path, index);
+    if (szPSName[0]) {
+        append_mapping(ctx, szPSName, ff, index);
+    }
+    if (szTTName[0]) {
+        // every face of a family carries the same TT family name, so only the
+        // regular one may answer to it - a lookup for "Georgia" used to land on
+        // whichever face came first, the italic one. The others are registered
+        // with the style appended, which is how a PDF asks for them
+        // ("Georgia,Bold" is normalized to "Georgia-Bold")
+        // cf. https://code.google.com/archive/p/sumatrapdf/issues/376
+        char szStyledName[MAX_FACENAME];
+        const char* ttName = szTTName;
+        if (szStyle[0] && !streqi(szStyle, "Regular")) {
+            fz_strlcpy(szStyledName, szTTName, MAX_FACENAME);
+            makeFakePSName(szStyledName, szStyle);
+            ttName = szStyledName;
+        }
+        // the space-less form a lookup uses is computed by append_mapping, so
+        // "Courier New" is found by its family name even though its PostScript
+        // name is "CourierNewPSMT" (#4600)
+        if (!font_name_eq(ttName, szPSName)) {
+            append_mapping(ctx, ttName, ff, index);
+        }
+    }
+    if (szCJKName[0]) {
+        makeFakePSName(szCJKName, szStyle);
+        if (!font_name_eq(szCJKName, szPSName) && !font_name_eq(szCJKName, szTTName)) {
+            append_mapping(ctx, szCJKName, ff, index);
+        }
+    }
+}
+
+static void parseTTFs(fz_context* ctx, font_file* ff) {
+    fz_stream* file = 0;
+    fz_try(ctx) {
+        file = fz_open_file(ctx, ff->file_path);
+        parseTTF(ctx, file, 0, 0, ff);
+    }
+    fz_always(ctx) {
+        fz_drop_stream(ctx, file);
+    }
+    fz_catch(ctx) {
+        fz_rethrow(ctx);
+    }
+}
+
+static void parseTTCs(fz_context* ctx, font_file* ff) {
+    FONT_COLLECTION fontcollectionBE;
+    u32 i, numFonts, *offsettableBE = NULL;
+
+    fz_stream* file = fz_open_file(ctx, ff->file_path);
+
+    fz_var(offsettableBE);
+
+    fz_try(ctx) {
+        safe_read(ctx, file, 0, (char*)&fontcollectionBE, sizeof(FONT_COLLECTION));
+        if (BEtoHl(fontcollectionBE.Tag) != TTAG_ttcf) {
+            fz_throw(ctx, FZ_ERROR_GENERIC, "fonterror : wrong format %x", BEtoHl(fontcollectionBE.Tag));
+        }
+        if (BEtoHl(fontcollectionBE.Version) != TTC_VERSION1 && BEtoHl(fontcollectionBE.Version) != TTC_VERSION2) {
+            fz_throw(ctx, FZ_ERROR_GENERIC, "fonterror : invalid version %x", BEtoHl(fontcollectionBE.Version));
+        }
+
+        numFonts = BEtoHl(fontcollectionBE.NumFonts);
+        offsettableBE = fz_malloc_array(ctx, numFonts, u32);
+
+        int offset = (int)sizeof(FONT_COLLECTION);
+        safe_read(ctx, file, offset, (char*)offsettableBE, numFonts * sizeof(u32));
+        for (i = 0; i < numFonts; i++) {
+            parseTTF(ctx, file, BEtoHl(offsettableBE[i]), i, ff);
+        }
+    }
+    fz_always(ctx) {
+        fz_free(ctx, offsettableBE);
+        fz_drop_stream(ctx, file);
+    }
+    fz_catch(ctx) {
+        fz_rethrow(ctx);
+    }
+}
+
+static int is_font_file_name(const char* path) {
+    const char* ext = strrchr(path, '.');
+    return ext && (streqi(ext, ".ttc") || streqi(ext, ".ttf") || streqi(ext, ".otf"));
+}
+
+// a file that can't be parsed registers no names, but stays in the list so
+// that the index file remembers it
+static void parse_font_file(fz_context* ctx, font_file* ff) {
+    const char* ext = strrchr(ff->file_path, '.');
+    fz_try(ctx) {
+        if (ext && streqi(ext, ".ttc")) {
+            parseTTCs(ctx, ff);
+        } else {
+            parseTTFs(ctx, ff);
+        }
+    }
+    fz_catch(ctx) {
+        fz_ignore_error(ctx);
+        // ignore errors occurring while parsing a given font file
+    }
+}
+
+typedef void (*font_file_found_fn)(fz_context* ctx, const char* path, u64 mtime, u64 size, void* user);
+
+#ifdef _WIN32
+static u64 filetime_to_u64(FILETIME ft) {
+    return ((u64)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+// pattern is anything FindFirstFile() takes: "<dir>\*.?t?", a single file,
+// or a "fonts\*.ttf" given for debugging
+static void list_font_files(fz_context* ctx, const char* pattern, font_file_found_fn found, void* user) {
+    WCHAR szPath[MAX_PATH], *lpFileName;
+    WIN32_FIND_DATA FileData;
+    HANDLE hList;
+
+    WCHAR* patternW = fz_wchar_from_utf8(ctx, pattern);
+    GetFullPathNameW(patternW, nelem(szPath), szPath, &lpFileName);
+    fz_free(ctx, patternW);
+
+    hList = FindFirstFile(szPath, &FileData);
+    if (hList == INVALID_HANDLE_VALUE) {
+        // Don't complain about missing directories
+        if (GetLastError() == ERROR_FILE_NOT_FOUND || GetLastError() == ERROR_PATH_NOT_FOUND) {
+            return;
+        }
+        fz_throw(ctx, FZ_ERROR_GENERIC, "list_font_files: unknown error %d", GetLastError());
+    }
+    do {
+        if (!(FileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            char szPathUtf8[MAX_PATH];
+            u64 size = ((u64)FileData.nFileSizeHigh << 32) | FileData.nFileSizeLow;
+            lstrcpynW(lpFileName, FileData.cFileName, szPath + MAX_PATH - lpFileName);
+            if (!WideCharToMultiByte(CP_UTF8, 0, szPath, -1, szPathUtf8, sizeof(szPathUtf8), NULL, NULL)) {
+                fz_warn(ctx, "WideCharToMultiByte failed");
+                continue;
+            }
+            found(ctx, szPathUtf8, filetime_to_u64(FileData.ftLastWriteTime), size, user);
+        }
+    } while (FindNextFile(hList, &FileData));
+    FindClose(hList);
+}
+
+static void list_font_dir(fz_context* ctx, const char* dir, font_file_found_fn found, void* user) {
+    char* pattern = fz_asprintf(ctx, "%s\\*.?t?", dir);
+    fz_try(ctx) {
+        list_font_files(ctx, pattern, found, user);
+    }
+    fz_always(ctx) {
+        fz_free(ctx, pattern);
+    }
+    fz_catch(ctx) {
+        fz_rethrow(ctx);
+    }
+}
+
+// adding, removing or renaming a file in a directory changes its mtime
+static int get_dir_mtime(fz_context* ctx, const char* dir, u64* mtime) {
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    WCHAR* dirW = fz_wchar_from_utf8(ctx, dir);
+    BOOL ok = GetFileAttributesExW(dirW, GetFileExInfoStandard, &fad);
+    fz_free(ctx, dirW);
+    if (!ok) {
+        return 0;
+    }
+    *mtime = filetime_to_u64(fad.ftLastWriteTime);
+    return 1;
+}
+
+static void replace_file(fz_context* ctx, const char* from, const char* to) {
+    WCHAR* fromW = fz_wchar_from_utf8(ctx, from);
+    WCHAR* toW = fz_wchar_from_utf8(ctx, to);
+    if (!MoveFileExW(fromW, toW, MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileW(fromW);
+    }
+    fz_free(ctx, fromW);
+    fz_free(ctx, toW);
+}
+
+static int get_pid(void) {
+    return (int)GetCurrentProcessId();
+}
+#else
+static void list_font_dir(fz_context* ctx, const char* dir, font_file_found_fn found, void* user) {
+    DIR* d = opendir(dir);
+    struct dirent* de;
+    if (!d) {
+        return;
+    }
+    while ((de = readdir(d)) != NULL) {
+        char path[4096];
+        struct stat st;
+        fz_snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        found(ctx, path, (u64)st.st_mtime, (u64)st.st_size, user);
+    }
+    closedir(d);
+}
+
+static int get_dir_mtime(fz_context* ctx, const char* dir, u64* mtime) {
+    struct stat st;
+    (void)ctx;
+    if (stat(dir, &st) != 0) {
+        return 0;
+    }
+    *mtime = (u64)st.st_mtime;
+    return 1;
+}
+
+static void replace_file(fz_context* ctx, const char* from, const char* to) {
+    (void)ctx;
+    if (rename(from, to) != 0) {
+        remove(from);
+    }
+}
+
+static int get_pid(void) {
+    return (int)getpid();
+}
+
+static void set_default_font_dirs(fz_context* ctx) {
+    (void)ctx;
+}
+
+static void add_extra_font_files(fz_context* ctx) {
+    (void)ctx;
+}
+#endif
+
+/* The index file: all integers little-endian, strings as a u16 length and the
+   bytes, no terminating 0.
+     "SFIX", u32 FONT_INDEX_VERSION, u32 number of dirs, then for each dir:
+       path, u64 mtime, u32 number of files, then for each file:
+         path, u64 mtime, u64 size, u32 number of names, then for each name:
+           u32 face index, name
+   It's read into the structs below, which point into its data. It's all
+   checked when it's read, so nothing after that has to be */
+
+typedef struct {
+    const u8* path;
+    int path_len;
+    u64 mtime;
+    u64 size;
+    u32 n_names;
+    const u8* names;
+    const u8* names_end;
+} cached_font_file;
+
+typedef struct {
+    const u8* path;
+    int path_len;
+    u64 mtime;
+    int first_file;
+    int n_files;
+} cached_font_dir;
+
+typedef struct {
+    fz_buffer* data;
+    cached_font_dir* dirs;
+    int n_dirs;
+    cached_font_file* files;
+    int n_files;
+    // open addressing hash table of indexes into files, n_slots (a power of 2)
+    int* slots;
+    int n_slots;
+} font_index_file;
+
+typedef struct {
+    const u8* p;
+    const u8* end;
+    int ok;
+} index_reader;
+
+static u32 read_u32(index_reader* r) {
+    u32 v;
+    if (r->end - r->p < 4) {
+        r->ok = 0;
+        return 0;
+    }
+    v = (u32)r->p[0] | ((u32)r->p[1] << 8) | ((u32)r->p[2] << 16) | ((u32)r->p[3] << 24);
+    r->p += 4;
+    return v;
+}
+
+static u64 read_u64(index_reader* r) {
+    u64 lo = read_u32(r);
+    u64 hi = read_u32(r);
+    return lo | (hi << 32);
+}
+
+static const u8* read_str(index_reader* r, int* len) {
+    const u8* s;
+    if (r->end - r->p < 2) {
+        r->ok = 0;
+        return NULL;
+    }
+    *len = r->p[0] | (r->p[1] << 8);
+    r->p += 2;
+    if (r->end - r->p < *len) {
+        r->ok = 0;
+        return NULL;
+    }
+    s = r->p;
+    r->p += *len;
+    return s;
+}
+
+static u32 path_hash(const u8* s, int len) {
+    u32 h = 2166136261u;
+    int i;
+    for (i = 0; i < len; i++) {
+        h ^= s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void drop_font_index_file(fz_context* ctx, font_index_file* f) {
+    fz_drop_buffer(ctx, f->data);
+    fz_free(ctx, f->dirs);
+    fz_free(ctx, f->files);
+    fz_free(ctx, f->slots);
+    memset(f, 0, sizeof(*f));
+}
+
+static void parse_font_index_file(fz_context* ctx, font_index_file* f) {
+    index_reader r;
+    int i, j, len, cap_files = 256;
+    unsigned char* data;
+    size_t size = fz_buffer_storage(ctx, f->data, &data);
+    r.p = data;
+    r.end = data + size;
+    r.ok = 1;
+    if (size < 4 || memcmp(data, "SFIX", 4) != 0) {
+        fz_throw(ctx, FZ_ERROR_FORMAT, "not a font index");
+    }
+    r.p += 4;
+    if (read_u32(&r) != FONT_INDEX_VERSION) {
+        fz_throw(ctx, FZ_ERROR_FORMAT, "old font index");
+    }
+    f->n_dirs = (int)read_u32(&r);
+    if (!r.ok || f->n_dirs > 1024) {
+        fz_throw(ctx, FZ_ERROR_FORMAT, "bad font index");
+    }
+    f->dirs = fz_malloc_array(ctx, f->n_dirs + 1, cached_font_dir);
+    f->files = fz_malloc_array(ctx, cap_files, cached_font_file);
+    for (i = 0; i < f->n_dirs && r.ok; i++) {
+        cached_font_dir* d = &f->dirs[i];
+        d->path = read_str(&r, &d->path_len);
+        d->mtime = read_u64(&r);
+        d->n_files = (int)read_u32(&r);
+        d->first_file = f->n_files;
+        for (j = 0; j < d->n_files && r.ok; j++) {
+            cached_font_file* cf;
+            u32 k;
+            if (f->n_files == cap_files) {
+                cap_files *= 2;
+                f->files = fz_realloc_array(ctx, f->files, cap_files, cached_font_file);
+            }
+            cf = &f->files[f->n_files++];
+            cf->path = read_str(&r, &cf->path_len);
+            cf->mtime = read_u64(&r);
+            cf->size = read_u64(&r);
+            cf->n_names = read_u32(&r);
+            cf->names = r.p;
+            for (k = 0; k < cf->n_names && r.ok; k++) {
+                read_u32(&r);
+                read_str(&r, &len);
+                if (len >= MAX_FACENAME) {
+                    r.ok = 0;
+                }
+            }
+            cf->names_end = r.p;
+        }
+    }
+    if (!r.ok || r.p != r.end) {
+        fz_throw(ctx, FZ_ERROR_FORMAT, "bad font index");
+    }
+
+    f->n_slots = 64;
+    while (f->n_slots < 2 * f->n_files) {
+        f->n_slots *= 2;
+    }
+    f->slots = fz_malloc_array(ctx, f->n_slots, int);
+    for (i = 0; i < f->n_slots; i++) {
+        f->slots[i] = -1;
+    }
+    for (i = 0; i < f->n_files; i++) {
+        u32 slot = path_hash(f->files[i].path, f->files[i].path_len) & (f->n_slots - 1);
+        while (f->slots[slot] >= 0) {
+            slot = (slot + 1) & (f->n_slots - 1);
+        }
+        f->slots[slot] = i;
+    }
+}
+
+// an index file that's missing or can't be used is just not there
+static void load_font_index_file(fz_context* ctx, font_index_file* f) {
+    memset(f, 0, sizeof(*f));
+    if (!g_font_index_path) {
+        return;
+    }
+    fz_try(ctx) {
+        f->data = fz_read_file(ctx, g_font_index_path);
+        parse_font_index_file(ctx, f);
+    }
+    fz_catch(ctx) {
+        fz_ignore_error(ctx);
+        drop_font_index_file(ctx, f);
+    }
+}
+
+static int str_eq_len(const u8* s, int len, const char* s2) {
+    return (int)strlen(s2) == len && memcmp(s, s2, (size_t)len) == 0;
+}
+
+static cached_font_dir* find_cached_dir(font_index_file* f, const char* path) {
+    int i;
+    for (i = 0; i < f->n_dirs; i++) {
+        if (str_eq_len(f->dirs[i].path, f->dirs[i].path_len, path)) {
+            return &f->dirs[i];
+        }
+    }
+    return NULL;
+}
+
+static cached_font_file* find_cached_file(font_index_file* f, const char* path) {
+    int len = (int)strlen(path);
+    u32 slot;
+    if (!f->n_slots) {
+        return NULL;
+    }
+    slot = path_hash((const u8*)path, len) & (f->n_slots - 1);
+    while (f->slots[slot] >= 0) {
+        cached_font_file* cf = &f->files[f->slots[slot]];
+        if (cf->path_len == len && memcmp(cf->path, path, (size_t)len) == 0) {
+            return cf;
+        }
+        slot = (slot + 1) & (f->n_slots - 1);
+    }
+    return NULL;
+}
+
+static void copy_str(char* dst, const u8* s, int len) {
+    memcpy(dst, s, (size_t)len);
+    dst[len] = 0;
+}
+
+static void add_cached_font_file(fz_context* ctx, cached_font_file* cf, int dir) {
+    char path[4096];
+    index_reader r;
+    font_file* ff;
+    u32 i;
+    if (cf->path_len >= (int)sizeof(path)) {
+        return;
+    }
+    copy_str(path, cf->path, cf->path_len);
+    ff = new_font_file(path, cf->mtime, cf->size, dir);
+    if (!ff) {
+        return;
+    }
+    r.p = cf->names;
+    r.end = cf->names_end;
+    r.ok = 1;
+    for (i = 0; i < cf->n_names; i++) {
+        char name[MAX_FACENAME];
+        int len;
+        u32 index = read_u32(&r);
+        const u8* s = read_str(&r, &len);
+        copy_str(name, s, len);
+        append_mapping(ctx, name, ff, (int)index);
+    }
+}
+
+static void append_str(fz_context* ctx, fz_buffer* buf, const char* s) {
+    size_t len = strlen(s);
+    fz_append_uint16_le(ctx, buf, (uint16_t)len);
+    fz_append_data(ctx, buf, s, len);
+}
+
+static void append_u64(fz_context* ctx, fz_buffer* buf, u64 v) {
+    fz_append_uint32_le(ctx, buf, (uint32_t)v);
+    fz_append_uint32_le(ctx, buf, (uint32_t)(v >> 32));
+}
+
+// written to a temporary file first: other instances may be reading it
+static void save_font_index_file(fz_context* ctx, const u64* dir_mtimes) {
+    fz_buffer* buf = NULL;
+    char* tmp_path = NULL;
+    font_file* ff;
+    win_font_info* fi;
+    int i, n;
+
+    fz_var(buf);
+    fz_var(tmp_path);
+    fz_try(ctx) {
+        buf = fz_new_buffer(ctx, 64 * 1024);
+        fz_append_data(ctx, buf, "SFIX", 4);
+        fz_append_uint32_le(ctx, buf, FONT_INDEX_VERSION);
+        fz_append_uint32_le(ctx, buf, (uint32_t)g_n_font_dirs);
+        for (i = 0; i < g_n_font_dirs; i++) {
+            append_str(ctx, buf, g_font_dirs[i]);
+            append_u64(ctx, buf, dir_mtimes[i]);
+            n = 0;
+            for (ff = g_font_files; ff; ff = ff->next) {
+                n += ff->dir == i;
+            }
+            fz_append_uint32_le(ctx, buf, (uint32_t)n);
+            for (ff = g_font_files; ff; ff = ff->next) {
+                if (ff->dir != i) {
+                    continue;
+                }
+                append_str(ctx, buf, ff->file_path);
+                append_u64(ctx, buf, ff->mtime);
+                append_u64(ctx, buf, ff->file_size);
+                fz_append_uint32_le(ctx, buf, (uint32_t)ff->n_names);
+                fi = ff->first_name;
+                for (n = 0; n < ff->n_names; n++, fi = fi->next) {
+                    fz_append_uint32_le(ctx, buf, fi->index);
+                    append_str(ctx, buf, fi->full_name);
+                }
+            }
+        }
+        tmp_path = fz_asprintf(ctx, "%s.%d.tmp", g_font_index_path, get_pid());
+        fz_save_buffer(ctx, buf, tmp_path);
+        replace_file(ctx, tmp_path, g_font_index_path);
+    }
+    fz_always(ctx) {
+        fz_drop_buffer(ctx, buf);
+        fz_free(ctx, tmp_path);
+    }
+    fz_catch(ctx) {
+        fz_report_error(ctx);
+        fz_warn(ctx, "couldn't save font index '%s'", g_font_index_path);
+    }
+}
+
+typedef struct {
+    font_index_file* cached;
+    int dir;
+} font_dir_scan;
+
+static void on_font_dir_file(fz_context* ctx, const char* path, u64 mtime, u64 size, void* user) {
+    font_dir_scan* scan = (font_dir_scan*)user;
+    cached_font_file* cf;
+    font_file* ff;
+    if (g_font_index_cancel || !is_font_file_name(path)) {
+        return;
+    }
+    cf = find_cached_file(scan->cached, path);
+    if (cf && cf->mtime == mtime && cf->size == size) {
+        add_cached_font_file(ctx, cf, scan->dir);
+        return;
+    }
+    ff = new_font_file(path, mtime, size, scan->dir);
+    if (ff) {
+        g_n_fonts_parsed++;
+        parse_font_file(ctx, ff);
+    }
+}
+
+static void add_extra_font_files(fz_context* ctx);
+static void set_default_font_dirs(fz_context* ctx);
+
+static void free_font_list(void) {
+    // both names are part of the node's allocation, so the node is all there
+    // is to free
+    win_font_info* fi = g_win_fonts;
+    while (fi) {
+        win_font_info* next = fi->next;
+        free(fi);
+        fi = next;
+    }
+    g_win_fonts = NULL;
+    g_win_fonts_last = NULL;
+    // ... and so is file_path, but the file's contents are their own block
+    font_file* ff = g_font_files;
+    while (ff) {
+        font_file* next = ff->next;
+        free(ff->data);
+        free(ff);
+        ff = next;
+    }
+    g_font_files = NULL;
+    g_font_files_last = NULL;
+    free_font_name_index();
+    g_n_font_files = 0;
+    g_n_font_names = 0;
+    g_font_index_built = 0;
+}
+
+// must be called with the fonts locked
+static void create_system_font_list(fz_context* ctx) {
+    font_index_file cached;
+    font_dir_scan scan;
+    u64* dir_mtimes;
+    int i, changed;
+
+    g_n_fonts_parsed = 0;
+    if (!g_n_font_dirs) {
+        set_default_font_dirs(ctx);
+    }
+    load_font_index_file(ctx, &cached);
+    changed = !cached.data || cached.n_dirs != g_n_font_dirs;
+    dir_mtimes = (u64*)calloc((size_t)g_n_font_dirs + 1, sizeof(u64));
+    if (!dir_mtimes) {
+        drop_font_index_file(ctx, &cached);
+        fz_throw(ctx, FZ_ERROR_SYSTEM, "out of memory");
+    }
+    for (i = 0; i < g_n_font_dirs && !g_font_index_cancel; i++) {
+        const char* dir = g_font_dirs[i];
+        cached_font_dir* cd = find_cached_dir(&cached, dir);
+        int has_mtime = get_dir_mtime(ctx, dir, &dir_mtimes[i]);
+        if (cd && has_mtime && cd->mtime == dir_mtimes[i]) {
+            int j;
+            for (j = 0; j < cd->n_files; j++) {
+                add_cached_font_file(ctx, &cached.files[cd->first_file + j], i);
+            }
+            continue;
+        }
+        changed = 1;
+        scan.cached = &cached;
+        scan.dir = i;
+        fz_try(ctx) {
+            list_font_dir(ctx, dir, on_font_dir_file, &scan);
+        }
+        fz_catch(ctx) {
+            fz_report_error(ctx);
+        }
+    }
+    drop_font_index_file(ctx, &cached);
+
+    add_extra_font_files(ctx);
+    if (!g_win_fonts) {
+        fz_warn(ctx, "couldn't find any usable system fonts");
     }
-    if (szTTName[0]) {
-        // every face of a family carries the same TT family name, so only the
-        // regular one may answer to it - a lookup for "Georgia" used to land on
-        // whichever face came first, the italic one. The others are registered
-        // with the style appended, which is how a PDF asks for them
-        // ("Georgia,Bold" is normalized to "Georgia-Bold")
-        // cf. https://code.google.com/archive/p/sumatrapdf/issues/376
-        char szStyledName[MAX_FACENAME];
-        const char* ttName = szTTName;
-        if (szStyle[0] && !streqi(szStyle, "Regular")) {
-            fz_strlcpy(szStyledName, szTTName, MAX_FACENAME);
-            makeFakePSName(szStyledName, szStyle);
-            ttName = szStyledName;
-        }
-        // the space-less form a lookup uses is computed by append_mapping, so
-        // "Courier New" is found by its family name even though its PostScript
-        // name is "CourierNewPSMT" (#4600)
-        if (!font_name_eq(ttName, szPSName)) {
-            append_mapping(ctx, ttName, path, index);
-        }
+    build_font_name_index();
+    // a cancelled build is incomplete
+    if (changed && g_font_index_path && !g_font_index_cancel) {
+        save_font_index_file(ctx, dir_mtimes);
     }
-    if (szCJKName[0]) {
-        makeFakePSName(szCJKName, szStyle);
-        if (!font_name_eq(szCJKName, szPSName) && !font_name_eq(szCJKName, szTTName)) {
-            append_mapping(ctx, szCJKName, path, index);
-        }
+    free(dir_mtimes);
+    g_font_index_built = 1;
+}
+
+// malloc()ed, so that it outlives any fz_context
+static char* dup_str(const char* s) {
+    size_t n = strlen(s) + 1;
+    char* res = (char*)malloc(n);
+    if (res) {
+        memcpy(res, s, n);
     }
+    return res;
 }
 
-static void parseTTFs(fz_context* ctx, const char* path) {
-    fz_stream* file = 0;
-    fz_try(ctx) {
-        file = fz_open_file(ctx, path);
-        parseTTF(ctx, file, 0, 0, path);
+// dirs are UTF-8. Call before the index is built
+void set_system_font_dirs(const char* const* dirs, int n_dirs) {
+    int i;
+    for (i = 0; i < g_n_font_dirs; i++) {
+        free(g_font_dirs[i]);
     }
-    fz_always(ctx) {
-        fz_drop_stream(ctx, file);
+    free(g_font_dirs);
+    g_font_dirs = NULL;
+    g_n_font_dirs = 0;
+    if (n_dirs <= 0) {
+        return;
     }
-    fz_catch(ctx) {
-        fz_rethrow(ctx);
+    g_font_dirs = (char**)calloc((size_t)n_dirs, sizeof(char*));
+    if (!g_font_dirs) {
+        return;
+    }
+    for (i = 0; i < n_dirs; i++) {
+        g_font_dirs[g_n_font_dirs] = dup_str(dirs[i]);
+        if (g_font_dirs[g_n_font_dirs]) {
+            g_n_font_dirs++;
+        }
     }
 }
 
-static void parseTTCs(fz_context* ctx, const char* path) {
-    FONT_COLLECTION fontcollectionBE;
-    ULONG i, numFonts, *offsettableBE = NULL;
-
-    fz_stream* file = fz_open_file(ctx, path);
-
-    fz_var(offsettableBE);
+// UTF-8, NULL to not keep the index. Call before the index is built
+void set_system_font_cache_path(const char* path) {
+    free(g_font_index_path);
+    g_font_index_path = path ? dup_str(path) : NULL;
+}
 
+// builds the index if it isn't yet, returns the number of names in it
+int build_system_font_index(fz_context* ctx) {
+    int n;
+    lock_fonts();
     fz_try(ctx) {
-        safe_read(ctx, file, 0, (char*)&fontcollectionBE, sizeof(FONT_COLLECTION));
-        if (BEtoHl(fontcollectionBE.Tag) != TTAG_ttcf) {
-            fz_throw(ctx, FZ_ERROR_GENERIC, "fonterror : wrong format %x", BEtoHl(fontcollectionBE.Tag));
-        }
-        if (BEtoHl(fontcollectionBE.Version) != TTC_VERSION1 && BEtoHl(fontcollectionBE.Version) != TTC_VERSION2) {
-            fz_throw(ctx, FZ_ERROR_GENERIC, "fonterror : invalid version %x", BEtoHl(fontcollectionBE.Version));
-        }
-
-        numFonts = BEtoHl(fontcollectionBE.NumFonts);
-        offsettableBE = fz_malloc_array(ctx, numFonts, ULONG);
-
-        int offset = (int)sizeof(FONT_COLLECTION);
-        safe_read(ctx, file, offset, (char*)offsettableBE, numFonts * sizeof(ULONG));
-        for (i = 0; i < numFonts; i++) {
-            parseTTF(ctx, file, BEtoHl(offsettableBE[i]), i, path);
+        if (!g_font_index_built) {
+            create_system_font_list(ctx);
         }
     }
     fz_always(ctx) {
-        fz_free(ctx, offsettableBE);
-        fz_drop_stream(ctx, file);
+        n = g_n_font_names;
+        unlock_fonts();
     }
     fz_catch(ctx) {
         fz_rethrow(ctx);
     }
+    return n;
 }
 
-static void extend_system_font_list(fz_context* ctx, const WCHAR* path) {
-    WCHAR szPath[MAX_PATH], *lpFileName;
-    WIN32_FIND_DATA FileData;
-    HANDLE hList;
+// drops the index, the next lookup (or build_system_font_index()) builds it again
+void reset_system_font_index(void) {
+    lock_fonts();
+    free_font_list();
+    unlock_fonts();
+}
 
-    GetFullPathNameW(path, nelem(szPath), szPath, &lpFileName);
+// n_parsed: how many files the last build couldn't take from the index file
+void get_system_font_index_stats(int* n_files, int* n_names, int* n_parsed) {
+    lock_fonts();
+    *n_files = g_n_font_files;
+    *n_names = g_n_font_names;
+    *n_parsed = g_n_fonts_parsed;
+    unlock_fonts();
+}
 
-    hList = FindFirstFile(szPath, &FileData);
-    if (hList == INVALID_HANDLE_VALUE) {
-        // Don't complain about missing directories
-        if (GetLastError() == ERROR_FILE_NOT_FOUND) {
-            return;
+// the number of names a hash lookup finds a different font for than a walk of
+// the list does. Always 0, unless the hashing is broken
+int check_system_font_index(void) {
+    win_font_info* fi;
+    int use_clean_name, n_bad = 0;
+    lock_fonts();
+    for (fi = g_win_fonts; fi; fi = fi->next) {
+        for (use_clean_name = 0; use_clean_name < 2; use_clean_name++) {
+            const char* name = use_clean_name ? fi->clean_name : fi->full_name;
+            int len = use_clean_name ? fi->clean_name_len : fi->full_name_len;
+            if (find_font(name, len, use_clean_name) != find_font_linear(name, len, use_clean_name)) {
+                n_bad++;
+            }
         }
-        fz_throw(ctx, FZ_ERROR_GENERIC, "extend_system_font_list: unknown error %d", GetLastError());
     }
-    do {
-        if (!(FileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-            char szPathUtf8[MAX_PATH], *fileExt;
-            int res;
-            lstrcpynW(lpFileName, FileData.cFileName, szPath + MAX_PATH - lpFileName);
-            res = WideCharToMultiByte(CP_UTF8, 0, szPath, -1, szPathUtf8, sizeof(szPathUtf8), NULL, NULL);
-            if (!res) {
-                fz_warn(ctx, "WideCharToMultiByte failed");
-                continue;
-            }
-            fileExt = szPathUtf8 + strlen(szPathUtf8) - 4;
-            fz_try(ctx) {
-                if (streqi(fileExt, ".ttc")) {
-                    parseTTCs(ctx, szPathUtf8);
-                } else if (streqi(fileExt, ".ttf") || streqi(fileExt, ".otf")) {
-                    parseTTFs(ctx, szPathUtf8);
-                }
-            }
-            fz_catch(ctx) {
-                fz_ignore_error(ctx);
-                // ignore errors occurring while parsing a given font file
-            }
+    unlock_fonts();
+    return n_bad;
+}
+
+#ifdef _WIN32
+static struct {
+    const char* name;
+    const char* pattern;
+} baseSubstitutes[] = {
+    {"Courier", "CourierNewPSMT"},
+    {"Courier-Bold", "CourierNewPS-BoldMT"},
+    {"Courier-Oblique", "CourierNewPS-ItalicMT"},
+    {"Courier-BoldOblique", "CourierNewPS-BoldItalicMT"},
+    {"Helvetica", "ArialMT"},
+    {"Helvetica-Bold", "Arial-BoldMT"},
+    {"Helvetica-Oblique", "Arial-ItalicMT"},
+    {"Helvetica-BoldOblique", "Arial-BoldItalicMT"},
+    {"Times-Roman", "TimesNewRomanPSMT"},
+    {"Times-Bold", "TimesNewRomanPS-BoldMT"},
+    {"Times-Italic", "TimesNewRomanPS-ItalicMT"},
+    {"Times-BoldItalic", "TimesNewRomanPS-BoldItalicMT"},
+    {"Symbol", "SymbolMT"},
+    // CSS generic font families used in EPUB files
+    {"serif", "TimesNewRomanPSMT"},
+    {"sans-serif", "ArialMT"},
+    {"sans", "ArialMT"},
+    {"monospace", "CourierNewPSMT"},
+    {"cursive", "ComicSansMS"},
+    {"fantasy", "Impact"},
+    // fallbacks for fonts commonly used in EPUBs that may not be installed
+    {"DroidSansMono", "Consolas"},
+    {"SourceSansPro", "SegoeUI"},
+    {"SourceSansPro-Bold", "SegoeUI-Bold"},
+    {"SourceSansPro-Italic", "SegoeUI-Italic"},
+    {"SourceSansPro-BoldItalic", "SegoeUI-BoldItalic"},
+    {"SourceSansPro-Light", "SegoeUI-Light"},
+    {"SourceSansPro-Semibold", "SegoeUI-Semibold"},
+    {"HelveticaNeue", "ArialMT"},
+    {"HelveticaNeue-Bold", "Arial-BoldMT"},
+    {"HelveticaNeue-Italic", "Arial-ItalicMT"},
+    {"HelveticaNeue-BoldItalic", "Arial-BoldItalicMT"},
+    {"HelveticaNeue-Light", "ArialMT"},
+    {"HelveticaNeueLight", "ArialMT"},
+    {"LucidaSans", "SegoeUI"},
+    {"LucidaGrande", "SegoeUI"},
+    {"LucidaConsole", "Consolas"},
+    {"LucidaBright", "Georgia"},
+    {"Handwriting", "SegoeScript"},
+    {"Console", "Consolas"},
+    {"FuturaStd-Bold", "SegoeUI-Bold"},
+    {"DINPro", "SegoeUI"},
+    {"ACaslonPro-Regular", "Georgia"},
+    {"ACaslonPro-Italic", "Georgia-Italic"},
+    // Liberation Sans (Linux metrically compatible with Arial) fallbacks
+    {"LiberationSans", "ArialMT"},
+    {"LiberationSans-Bold", "Arial-BoldMT"},
+    {"LiberationSans-Italic", "Arial-ItalicMT"},
+    {"LiberationSans-BoldItalic", "Arial-BoldItalicMT"},
+    // Safari placeholder font
+    {"SafariFakeFont", "ArialMT"},
+    // PingFang SC (macOS/iOS Simplified Chinese) fallbacks
+    {"PingFangSC-Regular", "Microsoft YaHei"},
+    {"PingFangSC-Medium", "Microsoft YaHei"},
+    {"PingFangSC-Semibold", "Microsoft YaHei Bold"},
+    {"PingFangSC-Bold", "Microsoft YaHei Bold"},
+    {"PingFangSC-Light", "Microsoft YaHei Light"},
+    {"PingFangSC-Ultralight", "Microsoft YaHei Light"},
+    {"PingFangSC-Thin", "Microsoft YaHei Light"},
+    {"PingFang SC", "Microsoft YaHei"},
+    // Founder FangSong font fallback
+    {"FZFangSong-Z02", "FangSong"},
+    {"FZFangSong-Z02S", "FangSong"},
+    // Chinese Kai (regular script) font fallbacks
+    {"MKai PRC", "KaiTi"},
+    {"MKaiPRC-Regular", "KaiTi"},
+    {"MKaiPRC", "KaiTi"},
+    {"STKaiti", "KaiTi"},
+    {"STKaiti-Regular", "KaiTi"},
+    {"STKai", "KaiTi"},
+    {"Kai", "KaiTi"},
+    {"Kaiti_GB2312", "KaiTi"},
+    {"Kaiti SC", "KaiTi"},
+    {"Kaiti TC", "KaiTi"},
+};
+
+// cache of font names that failed to load, to avoid repeated lookups
+// names are stored 0-separated in gFontsFailedToLoad
+static char gFontsFailedToLoad[256];
+static int gFontsFailedToLoadLen = 0;
+
+static int is_font_failed(const char* name) {
+    int nameLen = (int)strlen(name);
+    int pos = 0;
+    while (pos < gFontsFailedToLoadLen) {
+        const char* entry = gFontsFailedToLoad + pos;
+        int entryLen = (int)strlen(entry);
+        if (entryLen == nameLen && memcmp(entry, name, nameLen) == 0) {
+            return 1;
         }
-    } while (FindNextFile(hList, &FileData));
-    FindClose(hList);
+        pos += entryLen + 1;
+    }
+    return 0;
+}
+
+static void add_font_failed(const char* name) {
+    int n = (int)strlen(name) + 1;
+    if (gFontsFailedToLoadLen + n > (int)sizeof(gFontsFailedToLoad)) {
+        return; // buffer full, just skip
+    }
+    memcpy(gFontsFailedToLoad + gFontsFailedToLoadLen, name, n);
+    gFontsFailedToLoadLen += n;
 }
 
+
+static int did_init = 0;
+
 // cf. https://blogs.msdn.com/b/oldnewthing/archive/2004/10/25/247180.aspx
 EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 #define CURRENT_HMODULE ((HMODULE) & __ImageBase)
 
-static void create_system_font_list(fz_context* ctx) {
+// %WINDIR%\Fonts
+static void set_default_font_dirs(fz_context* ctx) {
     WCHAR szFontDir[MAX_PATH];
-    UINT cch;
-
-    cch = GetWindowsDirectory(szFontDir, nelem(szFontDir) - 12);
+    UINT cch = GetWindowsDirectory(szFontDir, nelem(szFontDir) - 12);
     if (0 < cch && cch < nelem(szFontDir) - 12) {
-        wcscat_s(szFontDir, MAX_PATH, L"\\Fonts\\*.?t?");
-        extend_system_font_list(ctx, szFontDir);
+        char* dir;
+        wcscat_s(szFontDir, MAX_PATH, L"\\Fonts");
+        dir = fz_utf8_from_wchar(ctx, szFontDir);
+        set_system_font_dirs((const char* const*)&dir, 1);
+        fz_free(ctx, dir);
+    }
+}
+
+static void on_extra_font_file(fz_context* ctx, const char* path, u64 mtime, u64 size, void* user) {
+    font_file* ff;
+    if (!is_font_file_name(path)) {
+        return;
     }
+    ff = new_font_file(path, mtime, size, -1);
+    if (ff) {
+        parse_font_file(ctx, ff);
+    }
+}
 
-    if (!g_win_fonts) {
-        fz_warn(ctx, "couldn't find any usable system fonts");
+static void extend_system_font_list(fz_context* ctx, const WCHAR* path) {
+    char* pathUtf8 = fz_utf8_from_wchar(ctx, path);
+    fz_try(ctx) {
+        list_font_files(ctx, pathUtf8, on_extra_font_file, NULL);
+    }
+    fz_always(ctx) {
+        fz_free(ctx, pathUtf8);
     }
+    fz_catch(ctx) {
+        fz_report_error(ctx);
+    }
+}
 
+// fonts that aren't in the font directories, so not in the index file either:
+// they're parsed on every build
+static void add_extra_font_files(fz_context* ctx) {
 #ifdef NOCJKFONT
     {
         // If no CJK fallback font is builtin but one has been shipped separately (in the same
         // directory as the main executable), add it to the list of loadable system fonts
+        WCHAR szModule[MAX_PATH];
         WCHAR szFile[MAX_PATH], *lpFileName;
         szFile[0] = '\0';
-        GetModuleFileName(CURRENT_HMODULE, szFontDir, MAX_PATH);
-        szFontDir[nelem(szFontDir) - 1] = '\0';
-        GetFullPathNameW(szFontDir, MAX_PATH, szFile, &lpFileName);
+        GetModuleFileName(CURRENT_HMODULE, szModule, MAX_PATH);
+        szModule[nelem(szModule) - 1] = '\0';
+        GetFullPathNameW(szModule, MAX_PATH, szFile, &lpFileName);
         lstrcpyn(lpFileName, L"DroidSansFallback.ttf", szFile + MAX_PATH - lpFileName);
         extend_system_font_list(ctx, szFile);
     }
 #endif
 
 #ifdef DEBUG
-    // allow to overwrite system fonts for debugging purposes
-    // (either pass a full path or a search pattern such as "fonts\*.ttf")
-    cch = GetEnvironmentVariable(L"MUPDF_FONTS_PATTERN", szFontDir, nelem(szFontDir));
-    if (0 < cch && cch < nelem(szFontDir)) {
-        win_font_info* prev_head = g_win_fonts;
-        win_font_info* prev_last = g_win_fonts_last;
-        extend_system_font_list(ctx, szFontDir);
-        // a lookup takes the first match, so move what we just added to the
-        // front for it to override the system fonts of the same name
-        if (prev_last && prev_last->next) {
-            win_font_info* added = prev_last->next;
-            prev_last->next = NULL;
-            g_win_fonts_last->next = prev_head;
-            g_win_fonts_last = prev_last;
-            g_win_fonts = added;
+    {
+        // allow to overwrite system fonts for debugging purposes
+        // (either pass a full path or a search pattern such as "fonts\*.ttf")
+        WCHAR szPattern[MAX_PATH];
+        UINT cch = GetEnvironmentVariable(L"MUPDF_FONTS_PATTERN", szPattern, nelem(szPattern));
+        if (0 < cch && cch < nelem(szPattern)) {
+            win_font_info* prev_head = g_win_fonts;
+            win_font_info* prev_last = g_win_fonts_last;
+            extend_system_font_list(ctx, szPattern);
+            // a lookup takes the first match, so move what we just added to the
+            // front for it to override the system fonts of the same name
+            if (prev_last && prev_last->next) {
+                win_font_info* added = prev_last->next;
+                prev_last->next = NULL;
+                g_win_fonts_last->next = prev_head;
+                g_win_fonts_last = prev_last;
+                g_win_fonts = added;
+            }
         }
     }
 #endif
+    (void)ctx;
 }
 
 // TODO(port): replace the caller
@@ -768,7 +1620,7 @@ static fz_font* load_windows_font_by_name(fz_context* ctx, const char* orig_name
     }
 
     EnterCriticalSection(&cs_fonts);
-    if (!g_win_fonts) {
+    if (!g_font_index_built) {
         fz_try(ctx) {
             create_system_font_list(ctx);
         }
@@ -1110,41 +1962,59 @@ static fz_font* load_windows_fallback_font(fz_context* ctx, int script, int lang
     return font;
 }
 
+
 void init_system_font_list(void) {
     // this should always happen on main thread
     if (did_init) {
         return;
     }
     InitializeCriticalSection(&cs_fonts);
-    g_win_fonts = NULL;
-    g_win_fonts_last = NULL;
-    g_font_files = NULL;
-    g_font_files_last = NULL;
     did_init = 1;
 }
 
+static HANDLE g_font_index_thread = NULL;
+
+static DWORD WINAPI font_index_thread_proc(LPVOID arg) {
+    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+    (void)arg;
+    if (!ctx) {
+        return 0;
+    }
+    fz_try(ctx) {
+        build_system_font_index(ctx);
+    }
+    fz_catch(ctx) {
+        fz_report_error(ctx);
+    }
+    fz_drop_context(ctx);
+    return 0;
+}
+
+// builds the index on a thread, so that it's usually ready by the time a
+// document needs a system font. A lookup made before then waits for it
+void start_system_font_index(void) {
+    init_system_font_list();
+    if (g_font_index_thread || g_font_index_built) {
+        return;
+    }
+    g_font_index_thread = CreateThread(NULL, 0, font_index_thread_proc, NULL, 0, NULL);
+}
+
 void destroy_system_font_list(void) {
-    // both names are part of the node's allocation, so the node is all there
-    // is to free
-    win_font_info* fi = g_win_fonts;
-    while (fi) {
-        win_font_info* next = fi->next;
-        free(fi);
-        fi = next;
+    if (!did_init) {
+        return;
     }
-    g_win_fonts = NULL;
-    g_win_fonts_last = NULL;
-    // ... and so is file_path, but the file's contents are their own block
-    font_file* ff = g_font_files;
-    while (ff) {
-        font_file* next = ff->next;
-        free(ff->data);
-        free(ff);
-        ff = next;
+    if (g_font_index_thread) {
+        g_font_index_cancel = 1;
+        WaitForSingleObject(g_font_index_thread, INFINITE);
+        CloseHandle(g_font_index_thread);
+        g_font_index_thread = NULL;
     }
-    g_font_files = NULL;
-    g_font_files_last = NULL;
+    free_font_list();
+    set_system_font_dirs(NULL, 0);
+    set_system_font_cache_path(NULL);
     DeleteCriticalSection(&cs_fonts);
+    did_init = 0;
 }
 
 void install_load_windows_font_funcs(fz_context* ctx) {
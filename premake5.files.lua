@@ -38,6 +38,7 @@ function makelzsa_files()
     "StrUtf8.*",
     "StrVec.*",
     "Thread.*",
+    "Trace.*",
     "WinDynCalls.h",
     "WinDynCalls_win.cpp",
     "Win.*",
@@ -651,6 +652,7 @@ function sumatrapdf_files()
     "ReaderModel.*",
     "gui/CommandPaletteModel.*",
     "DocController.h",
+    "DocPreload.*",
     "DocProperties.*",
     "EditAnnotations.*",
     "EngineDump.cpp",
@@ -681,6 +683,7 @@ function sumatrapdf_files()
     "Notifications.*",
     "PdfSync.*",
     "PdfTools.*",
+    "PerfStats.*",
     "PngOptimizer.*",
     "Print.*",
     "ProgressUpdateUI.*",
@@ -727,11 +730,14 @@ function sumatrapdf_files()
     "SumatraTest.*",
     "SvgIcons.*",
     "TableOfContents.*",
+    "TocFilter.*",
     "Tabs.*",
     "TabGroupsManage.*",
     "Tester.*",
     "Tests.cpp",
+    "TextExport.*",
     "TextSearch.*",
+    "TextSearchPattern.*",
     "TextSelection.*",
     "TextToSpeech.*",
     "TextViewWnd.*",
@@ -848,9 +854,13 @@ function base_files()
     "LzmaSimpleArchive.*",
     "Pixmap.*",
     "Pixmap_win.cpp",
+    "PixmapPool.*",
+    "PixmapResize.*",
+    "RectIndex.*",
     "RegistryPaths.*",
     "Scoped.h",
     "ScopedWin.h",
+    "SettingsJournal.*",
     "SettingsUtil.*",
     "SquareTreeParser.*",
     "Strconv.*",
@@ -862,6 +872,7 @@ function base_files()
     "TgaReader.*",
     "TgaReader_win.cpp",
     "Thread.*",
+    "Trace.*",
     "TxtParser.*",
     "UITask.*",
     "Vec.h",
@@ -922,11 +933,14 @@ function engines_files()
     "EngineMupdf.*",
     "EngineMupdfImpl.*",
     "EnginePs.*",
+    "GlyphIndex.*",
     "GumboHtmlParser.*",
     "GumboHelpers.*",
     "HtmlFormatter.*",
+    "HtmlStyleSheet.*",
     "LitDoc.*",
     "MobiDoc.*",
+    "PageStructure.*",
     "PalmDbReader.*",
     "PdfCadDetect.*",
     "PdfCadEnhanceDevice.*",
@@ -1322,7 +1336,11 @@ function test_util_files()
     "Log.h",
     "Pixmap.*",
     "Pixmap_win.cpp",
+    "PixmapPool.*",
+    "PixmapResize.*",
+    "RectIndex.*",
     "Scoped.*",
+    "SettingsJournal.*",
     "SettingsUtil.*",
     "SquareTreeParser.*",
     "Strconv.*",
@@ -1332,6 +1350,7 @@ function test_util_files()
     "StrUtf8.*",
     "StrVec.*",
     "Thread.*",
+    "Trace.*",
     "tests/*",
     "UtAssert.*",
     "Vec.*",
@@ -1354,7 +1373,12 @@ function test_util_files()
     "DocProperties.*",
     "Flags.*",
     "FilterUtil.*",
+    "GlyphIndex.*",
+    "GumboHelpers.*",
+    "GumboHtmlParser.*",
+    "HtmlStyleSheet.*",
     "PageRenderPolicy.*",
+    "PageStructure.*",
     "RefHoverDetect.*",
     "RefHoverTextDetect.*",
     "SettingsStructs.*",
@@ -1362,6 +1386,8 @@ function test_util_files()
     "SumatraConfig.*",
     "SumatraLog.*",
     "SumatraUnitTests.cpp",
+    "TextSearchPattern.*",
+    "TocFilter.*",
     "SimpleLog_ut.cpp",
     "PdfDarkMode.h",
     "PdfDarkModeImageRules.cpp",
@@ -1389,12 +1415,16 @@ function test_engines_files()
     "src/EngineMupdf.cpp",
     "src/ImageReader.cpp",
     "src/ImageReader_win.cpp",
+    "src/GlyphIndex.cpp",
+    "src/GlyphIndex.h",
     "src/GumboHtmlParser.cpp",
     "src/GumboHelpers.cpp",
     "src/JxlReader.cpp",
     "src/LitDoc.cpp",
     "src/LitDoc.h",
     "src/MobiDoc.cpp",
+    "src/PageStructure.cpp",
+    "src/PageStructure.h",
     "src/PalmDbReader.cpp",
     "src/PdfCadDetect.cpp",
     "src/PdfCadDetect.h",
@@ -1402,8 +1432,14 @@ function test_engines_files()
     "src/PdfCadEnhanceDevice.h",
     "src/PdfDarkMode.h",
     "src/PdfDarkModeNoOp.cpp",
+    "src/PerfStats.cpp",
+    "src/PerfStats.h",
+    "src/TextExport.cpp",
+    "src/TextExport.h",
     "src/TextSearch.cpp",
     "src/TextSearch.h",
+    "src/TextSearchPattern.cpp",
+    "src/TextSearchPattern.h",
     "src/TextSelection.cpp",
     "src/TextSelection.h",
     "src/WebpReader.cpp",
@@ -1492,9 +1528,11 @@ function pdf_preview_files()
     "ImageReader.h",
     "ImageReader.cpp",
     "ImageReader_win.cpp",
+    "GlyphIndex.*",
     "GumboHtmlParser.*",
     "GumboHelpers.*",
     "HtmlFormatter.*",
+    "HtmlStyleSheet.*",
     "JxlReader.*",
     "MobiDoc.*",
     "gui/PlatformFont.*",
@@ -1502,6 +1540,7 @@ function pdf_preview_files()
     "gui/PlatformText.*",
     "gui/PlatformText_win.*",
     "MUPDF_Exports.cpp",
+    "PageStructure.*",
     "PalmDbReader.*",
     "PdfCadDetect.*",
     "PdfCadEnhanceDevice.*",
@@ -1533,10 +1572,12 @@ function search_filter_files()
     "EngineBase.*",
     "EngineMupdf.*",
     "EngineMupdfImpl.*",
+    "GlyphIndex.*",
     "GumboHtmlParser.*",
     "GumboHelpers.*",
     "MobiDoc.*",
     "MUPDF_Exports.cpp",
+    "PageStructure.*",
     "PalmDbReader.*",
     "PdfCadDetect.*",
     "PdfCadEnhanceDevice.*",
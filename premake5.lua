@@ -1091,7 +1091,7 @@ workspace "SumatraPDF"
     includedirs { "src" }
     test_util_files()
     setup_base_pch()
-    links { "gdiplus", "comctl32", "shlwapi", "Version", "wininet", "shcore", "wintrust", "crypt32" }
+    links { "a-gumbo", "gdiplus", "comctl32", "shlwapi", "Version", "wininet", "shcore", "wintrust", "crypt32" }
 
   project "test_engines"
     static_app_objdir()
@@ -1131,6 +1131,7 @@ workspace "SumatraPDF"
     links { "gdiplus", "comctl32", "shlwapi", "Version" }
 
   -- Image decode microbench: native lib vs WIC vs GDI+ (-jpeg / -webp / -avif / -heif / -jxl)
+  -- and zopflipng recompression, 1 thread vs all cores (-png)
   project "bench_image"
     static_app_objdir()
     static_linker_intermediates()
@@ -1141,14 +1142,14 @@ workspace "SumatraPDF"
     disablewarnings { "4611", "4838" } -- setjmp / C++ destruction; QITABENT
     includedirs {
       "src", "ext/libjpeg-turbo/src", "ext/libwebp/src", "ext/heicdec",
-      "ext/jxldec",
+      "ext/jxldec", "ext/a-zopfli",
     }
     bench_image_files()
     setup_base_pch()
     -- heicdec needs dav1d (AV1), a-zlib / brotli (unci compressed HEIC)
     links {
       "base", "libjpeg-turbo", "libwebp", "heicdec", "dav1d", "a-zlib",
-      "jxldec", "brotli",
+      "jxldec", "brotli", "a-zopfli",
     }
     links {
       "gdiplus", "gdi32", "user32", "comctl32", "shlwapi", "Version",
@@ -3,6 +3,7 @@
 
 #include "base/Base.h"
 #include "base/Pixmap.h"
+#include "base/RectIndex.h"
 #include "base/ScopedWin.h"
 
 extern "C" {
@@ -227,7 +228,8 @@ void SetRect(Annotation* annot, RectF r) {
     // pdf_update_annot can rewrite the rect (rubber stamps keep a 190x50
     // aspect). Cached bounds must match that, or resize handles and hit
     // testing cover empty space around the visible stamp (issue #5933).
-    annot->bounds = GetBounds(annot);
+    // MarkNotificationAsModified() refreshes them, after using the old ones
+    // to know which part of the page to re-render.
     // must be called outside docLock to avoid deadlock with pagesLock
     MarkNotificationAsModified(e, annot);
 }
@@ -4,6 +4,9 @@
 #include "base/Base.h"
 #include "base/File.h"
 #include "base/FileWatcher.h"
+#include "base/AppendStore.h"
+#include "base/SettingsUtil.h"
+#include "base/SettingsJournal.h"
 #include "base/SquareTreeParser.h"
 #include "base/UITask.h"
 #include "base/Win.h"
@@ -53,6 +56,11 @@ static bool gSaveSettingsPending = false;
 // are skipped when the file / serialized prefs still match this.
 static Str gLastSavedPrefs;
 
+// FileStates (history and per-document state) that changed since the last full
+// write of the settings file are appended here instead, so that with a long
+// history a save doesn't re-serialize and rewrite all of it
+static SettingsJournal gFileStatesJournal;
+
 static bool IsLastSavedPrefs(Str s) {
     return len(gLastSavedPrefs) == len(s) && str::Eq(gLastSavedPrefs, s);
 }
@@ -88,6 +96,8 @@ static bool ApplyReadAloudVoiceFromSettings() {
 extern void RememberDefaultWindowPosition(MainWindow* win);
 
 static WatchedFile* gWatchedSettingsFile = nullptr;
+// the journal of gFileStatesJournal: other processes' saves usually only go there
+static WatchedFile* gWatchedFileStatesJournal = nullptr;
 
 static DocumentColorsFollowTheme MapLegacyDocumentColorMode(Str v) {
     if (str::EqI(v, StrL("auto"))) {
@@ -361,6 +371,51 @@ void ApplySettingsToOpenWindows() {
     }
 }
 
+// identifies the settings file a journal was started on
+static TempStr SettingsFileStampTemp(Str path) {
+    FILETIME t = file::GetModificationTime(path);
+    i64 time = (i64)(((u64)t.dwHighDateTime << 32) | t.dwLowDateTime);
+    return fmt("%lld %lld", file::GetSize(path), time);
+}
+
+// a FileState another process removed from the history is kept while it's
+// still referenced: the favorites tree of a window points at it
+static bool IsFileStateInUse(const void* item) {
+    auto fs = (FileState*)item;
+    for (MainWindow* win : gWindows) {
+        if (win->expandedFavorites.Contains(fs)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// applies what SaveSettings() journaled since the settings file was last written
+static void LoadFileStatesJournal(Str settingsPath) {
+    SettingsJournal* j = &gFileStatesJournal;
+    if (gForTesting || !HasPermission(Perm::SavePreferences)) {
+        return;
+    }
+    if (!j->itemInfo) {
+        InitFileStatesJournal(j);
+        j->isItemInUse = IsFileStateInUse;
+        j->dir = str::Dup(path::GetDirTemp(settingsPath));
+        j->indexFileName = StrL("SumatraPDF-settings-journal.txt");
+        j->dataFileName = StrL("SumatraPDF-settings-journal.bin");
+    }
+    auto fileStates = (Vec<void*>*)gGlobalPrefs->fileStates;
+    Str rest = SettingsJournalLoad(j, fileStates, SettingsFileStampTemp(settingsPath));
+    if (!rest.s) {
+        return;
+    }
+    // everything but FileStates, as of the last journaled save
+    GlobalPrefs* prefs = NewGlobalPrefs(rest);
+    str::Free(rest);
+    std::swap(prefs->fileStates, gGlobalPrefs->fileStates);
+    DeleteGlobalPrefs(gGlobalPrefs);
+    gGlobalPrefs = prefs;
+}
+
 bool LoadSettings() {
     ReportIf(gGlobalPrefs);
 
@@ -374,6 +429,7 @@ bool LoadSettings() {
 
         gGlobalPrefs = NewGlobalPrefs(prefsData);
         ReportIf(!gGlobalPrefs);
+        LoadFileStatesJournal(settingsPath);
         gprefs = gGlobalPrefs;
         migratedDocumentColorsFollowTheme = MigrateDocumentColorsFollowThemeSetting(prefsData);
         RememberLastSavedPrefs(prefsData);
@@ -387,6 +443,9 @@ bool LoadSettings() {
     // takes effect for PDFs loaded after this (startup, and on settings reload)
     EngineMupdfSetDisableJavaScript(gGlobalPrefs->disableJavaScript);
     EngineMupdfSetAllowExternalImages(gGlobalPrefs->allowExternalImages);
+    // a tiny budget would evict the pages being rendered right away
+    i64 pageCacheMB = std::max(gGlobalPrefs->pageCacheSizeMB, 16);
+    EngineMupdfSetPageCacheBudget(pageCacheMB * 1024 * 1024);
     SetEngineeringDrawingEnhanceMode(gGlobalPrefs->engineeringDrawingEnhance);
     ExplorerQuickLookApplyFromSettings();
 
@@ -757,6 +816,57 @@ void FlushScheduledSaveSettings() {
     SaveSettings();
 }
 
+// the common save only changes a few FileStates (a document was opened, closed
+// or scrolled): append those to the journal instead of rewriting the file
+static bool SaveSettingsIncrementally(Str path) {
+    SettingsJournal* j = &gFileStatesJournal;
+    if (!j->isOpen) {
+        return false;
+    }
+    // with either off SerializeGlobalPrefs() filters FileStates, which the
+    // journal doesn't replicate
+    if (!gGlobalPrefs->rememberOpenedFiles || !gGlobalPrefs->rememberStatePerDocument) {
+        return false;
+    }
+    // written by another process or edited by hand: the journal's base is gone
+    if (!FileTimeEq(file::GetModificationTime(path), gGlobalPrefs->lastPrefUpdate)) {
+        return false;
+    }
+    Str rest = SerializeGlobalPrefsWithoutFileStates(gGlobalPrefs);
+    WatchedFileSetIgnore(gWatchedFileStatesJournal, true);
+    bool ok = SettingsJournalAppend(j, (Vec<void*>*)gGlobalPrefs->fileStates, rest);
+    WatchedFileSetIgnore(gWatchedFileStatesJournal, false);
+    str::Free(rest);
+    return ok;
+}
+
+// picks up what other SumatraPDF processes journaled since we loaded or last
+// synced it. A full write replaces the journal, so it must come first
+static int SyncFileStatesJournal() {
+    SettingsJournal* j = &gFileStatesJournal;
+    int nChanged = SettingsJournalSync(j, (Vec<void*>*)gGlobalPrefs->fileStates);
+    if (nChanged > 0) {
+        // FileStates are updated in place but can be removed and re-ordered,
+        // which the home page layout cache doesn't expect
+        HomePageInvalidateLayoutCache();
+        logf("SyncFileStatesJournal: %d file states changed by another process\n", nChanged);
+    }
+    return nChanged;
+}
+
+// the settings file now holds everything: start a new, empty journal on top of it
+static void ResetFileStatesJournal(Str path) {
+    SettingsJournal* j = &gFileStatesJournal;
+    if (!j->itemInfo) {
+        return;
+    }
+    Str rest = SerializeGlobalPrefsWithoutFileStates(gGlobalPrefs);
+    WatchedFileSetIgnore(gWatchedFileStatesJournal, true);
+    SettingsJournalReset(j, (Vec<void*>*)gGlobalPrefs->fileStates, rest, SettingsFileStampTemp(path));
+    WatchedFileSetIgnore(gWatchedFileStatesJournal, false);
+    str::Free(rest);
+}
+
 // called whenever global preferences change or a file is
 // added or removed from the file history (in order to keep
 // the list of recently opened documents in sync)
@@ -813,6 +923,10 @@ bool SaveSettings() {
     if (!path) {
         return false;
     }
+    if (SaveSettingsIncrementally(path)) {
+        return true;
+    }
+    SyncFileStatesJournal();
     TempStr prevPrefs = file::ReadFileWithArena(path, GetTempArena());
     Str prefs = SerializeGlobalPrefs(gGlobalPrefs, prevPrefs);
     AutoCall freePrefs((void (*)(Str))str::Free, prefs);
@@ -823,6 +937,7 @@ bool SaveSettings() {
 
     if (IsLastSavedPrefs(prefs) || (prevPrefs.len == prefs.len && str::Eq(prefs, prevPrefs))) {
         RememberLastSavedPrefs(prefs);
+        ResetFileStatesJournal(path);
         return true;
     }
 
@@ -831,6 +946,7 @@ bool SaveSettings() {
     if (ok) {
         RememberLastSavedPrefs(prefs);
         gGlobalPrefs->lastPrefUpdate = file::GetModificationTime(path);
+        ResetFileStatesJournal(path);
     }
     WatchedFileSetIgnore(gWatchedSettingsFile, false);
     return ok;
@@ -922,6 +1038,7 @@ static void ReloadSettings(bool force = false) {
 }
 
 void CleanUpSettings() {
+    SettingsJournalClose(&gFileStatesJournal);
     DeleteGlobalPrefs(gGlobalPrefs);
     gGlobalPrefs = nullptr;
 }
@@ -939,6 +1056,25 @@ static void SchedulePrefsReload() {
     uitask::Post(fn, "TaskReloadSettings");
 }
 
+// another process saved only its history changes: show them now rather than
+// at our next full write
+static void SyncFileStatesJournalFromWatcher() {
+    if (!gGlobalPrefs || SyncFileStatesJournal() == 0) {
+        return;
+    }
+    for (MainWindow* win : gWindows) {
+        UpdateFavoritesTree(win);
+        if (win->IsCurrentTabAbout()) {
+            win->RedrawAll(true);
+        }
+    }
+}
+
+static void ScheduleFileStatesJournalSync() {
+    auto fn = MkFunc0Void(SyncFileStatesJournalFromWatcher);
+    uitask::Post(fn, "TaskSyncFileStatesJournal");
+}
+
 void RegisterSettingsForFileChanges() {
     if (!HasPermission(Perm::SavePreferences)) {
         return;
@@ -948,11 +1084,20 @@ void RegisterSettingsForFileChanges() {
     TempStr path = GetSettingsPathTemp();
     auto fn = MkFunc0Void(SchedulePrefsReload);
     gWatchedSettingsFile = FileWatcherSubscribe(path, fn, true);
+
+    SettingsJournal* j = &gFileStatesJournal;
+    if (j->isOpen) {
+        TempStr journalPath = path::JoinTemp(j->dir, j->indexFileName);
+        auto syncFn = MkFunc0Void(ScheduleFileStatesJournalSync);
+        gWatchedFileStatesJournal = FileWatcherSubscribe(journalPath, syncFn, true);
+    }
 }
 
 void UnregisterSettingsForFileChanges() {
     FileWatcherUnsubscribe(gWatchedSettingsFile);
     gWatchedSettingsFile = nullptr;
+    FileWatcherUnsubscribe(gWatchedFileStatesJournal);
+    gWatchedFileStatesJournal = nullptr;
 }
 
 constexpr int kMinFontSize = 9;
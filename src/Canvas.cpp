@@ -7,6 +7,7 @@
 #include "gui/Dpi.h"
 #include "base/File.h"
 #include "base/Timer.h"
+#include "base/Trace.h"
 #include "base/UITask.h"
 #include "base/Win.h"
 #include "base/ScopedWin.h"
@@ -1440,7 +1441,7 @@ static bool StopDraggingAnnotation(MainWindow* win, int x, int y, bool aborted)
         // logf(" new rect: x=%.2f, y=%.2f, dx=%.2f, dy=%.2f\n", r.x, r.y, r.dx, r.dy);
         SetRect(annot, r);
         NotifyAnnotationsChanged(win->CurrentTab()->editAnnotsWindow);
-        MainWindowRerender(win);
+        MainWindowRerenderAnnotations(win);
         ToolbarUpdateStateForWindow(win, true);
     }
     return true;
@@ -1841,7 +1842,7 @@ static void OnMouseMove(MainWindow* win, int x, int y, WPARAM /*key*/) {
                     RectF newRect = CalculateResizedRect(win, x, y);
                     SetRect(annot, newRect);
 
-                    MainWindowRerender(win);
+                    MainWindowRerenderAnnotations(win);
                 } else {
                     Size size = win->annotationBeingMovedSize;
                     DrawMovePattern(win, prevPos, size);
@@ -1967,7 +1968,7 @@ static bool StopAnnotationResize(MainWindow* win, bool aborted) {
     // The annotation has already been updated during mouse move,
     // just notify and update toolbar
     NotifyAnnotationsChanged(win->CurrentTab()->editAnnotsWindow);
-    MainWindowRerender(win);
+    MainWindowRerenderAnnotations(win);
     ToolbarUpdateStateForWindow(win, true);
 
     return true;
@@ -2083,7 +2084,7 @@ static void OnMouseLeftButtonDown(MainWindow* win, int x, int y, WPARAM key) {
     // the click in either case so it doesn't start a drag/selection.
     Annotation* widget = dm->GetWidgetAtPos(pt);
     if (ToggleFormButton(widget)) {
-        MainWindowRerender(win);
+        MainWindowRerenderAnnotations(win);
         win->mouseAction = MouseAction::None;
         return;
     }
@@ -3594,6 +3595,7 @@ void InvalidateCanvasKeyboardFocus(MainWindow* win) {
 }
 
 static void OnPaintDocument(MainWindow* win) {
+    TraceSpan span("paint canvas");
     auto t = TimeGet();
     PAINTSTRUCT ps;
     HDC hdc = BeginPaint(win->hwndCanvas, &ps);
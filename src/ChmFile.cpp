@@ -22,6 +22,10 @@ ChmFile::~ChmFile() {
     str::Free(homePath);
     str::Free(creator);
     str::Free(data);
+    if (dataMap) {
+        file::MemoryUnmap(dataMap);
+        delete dataMap;
+    }
 }
 
 // find an entry by path. CHM path resolution is case-insensitive (the old
@@ -335,14 +339,29 @@ void ChmFile::FixPathCodepage(Str& path, uint& fileCP) {
     }
 }
 
+// CHM files at least this big are memory-mapped instead of read
+constexpr i64 kChmMemoryMapMinFileSize = 64LL * 1024 * 1024;
+
 bool ChmFile::Load(Str path) {
-    data = file::ReadFile(path);
+    const u8* d = nullptr;
+    size_t dLen = 0;
+    dataMap = new file::Mapping();
+    if (file::MemoryMapIfLarge(path, kChmMemoryMapMinFileSize, dataMap)) {
+        d = dataMap->data;
+        dLen = (size_t)dataMap->size;
+    } else {
+        delete dataMap;
+        dataMap = nullptr;
+        data = file::ReadFile(path);
+        d = (const u8*)data.s;
+        dLen = (size_t)data.len;
+    }
     chmCtx = chm_ctx_new(nullptr, nullptr, nullptr, nullptr);
-    if (!chmCtx || !chm_open(chmCtx, (const uint8_t*)data.s, (size_t)data.len)) {
+    if (!chmCtx || !chm_open(chmCtx, (const uint8_t*)d, dLen)) {
         return false;
     }
-    // the data buffer must outlive chmCtx (chm_open doesn't copy it); it does,
-    // it's freed in ~ChmFile after chm_ctx_free
+    // the data buffer (or mapping) must outlive chmCtx (chm_open doesn't copy
+    // it); it does, it's freed in ~ChmFile after chm_ctx_free
     nEntries = chm_get_entries(chmCtx, &entries);
 
     ParseWindowsData();
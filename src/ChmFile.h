@@ -9,6 +9,10 @@ enum class FileType : u8;
 struct chm_ctx;
 struct chm_entry;
 
+namespace file {
+struct Mapping;
+}
+
 struct ChmFile {
     chm_ctx* chmCtx = nullptr;
     // entries and their paths are owned by chmCtx (freed by chm_ctx_free)
@@ -21,7 +25,9 @@ struct ChmFile {
     Str indexPath;
     Str homePath;
     Str creator;
+    // the whole .chm file; large files are memory-mapped (dataMap) instead
     Str data;
+    file::Mapping* dataMap = nullptr;
     uint codepage = 0;
 
     void ParseWindowsData();
@@ -209,6 +209,7 @@ static Str BuildCrashInfoText(Str condStr, Str fileLine, bool isCrash, bool capt
     }
 
     s.Append(StrL("\n-------- Log -----------------\n\n"));
+    FlushLogForCrashReport();
     if (gLogBuf) {
         s.Append(ToStr(*gLogBuf));
     } else {
@@ -641,6 +641,7 @@ DisplayModel::~DisplayModel() {
     pauseRendering = true;
     EngineMupdfCancelHeadingToc(engine);
     EngineMupdfCancelLoadAllAnnotations(engine);
+    EngineMupdfCancelWarmup(engine);
     if (cb) {
         cb->CleanUp(this);
     }
@@ -787,6 +788,8 @@ static DocumentLayoutMargin ToDocumentLayoutMargin(WindowMargin margin) {
 }
 
 static void CopyDocumentLayoutToPageInfo(const DisplayModel* dm, const DocumentLayout& layout) {
+    int firstVisible = 0;
+    int lastVisible = 0;
     for (int pageNo = 1; pageNo <= dm->PageCount(); pageNo++) {
         PageInfo* pageInfo = dm->GetPageInfo(pageNo);
         const DocumentLayoutPage* page = layout.GetPage(pageNo);
@@ -798,6 +801,16 @@ static void CopyDocumentLayoutToPageInfo(const DisplayModel* dm, const DocumentL
         pageInfo->pageOnScreen = page->pageOnScreen;
         pageInfo->zoomReal = page->zoomReal;
         pageInfo->isShown = page->isShown;
+        if (pageInfo->visibleRatio > 0.0) {
+            if (firstVisible == 0) {
+                firstVisible = pageNo;
+            }
+            lastVisible = pageNo;
+        }
+    }
+    // let the engine pre-load the pages we're about to scroll to
+    if (firstVisible > 0) {
+        EngineMupdfWarmupHint(dm->engine, firstVisible, lastVisible);
     }
 }
 
@@ -0,0 +1,215 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// Going to the next / previous file in a folder opens the file from scratch:
+// creating the engine (for a comic book archive that's reading the archive)
+// and then rendering the first page the user sees. When the user reads through
+// a folder (a numbered comic or scan series), we open the file the next step
+// will go to in the background once the current one is shown, and render the
+// page it will open at. The next step then takes both instead of waiting.
+
+#include "base/Base.h"
+#include "base/Pixmap.h"
+#include "base/File.h"
+#include "base/GuessFileType.h"
+#include "base/UITask.h"
+#include "base/Timer.h"
+#include "gui/UIModels.h"
+
+#include "Settings.h"
+#include "GlobalPrefs.h"
+#include "DocController.h"
+#include "EngineBase.h"
+#include "EngineAll.h"
+#include "DisplayModel.h"
+#include "RenderCache.h"
+#include "SumatraPDF.h"
+#include "DocPreload.h"
+
+// a preloaded document is held in memory next to the one that's shown: the
+// engine of a big file can be as big as the file, the page is a screen-sized
+// bitmap. Don't preload what would take more than that
+constexpr i64 kPreloadMaxFileSize = 256 * 1024 * 1024;
+constexpr i64 kPreloadMaxPageBytes = 64 * 1024 * 1024;
+// nor when memory is already tight (in % of physical memory in use)
+constexpr DWORD kPreloadMaxMemoryLoad = 80;
+// let the document that was just opened render its pages first
+constexpr int kPreloadSettleMs = 500;
+
+struct DocPreload {
+    Str path; // owned
+    int pageNo = 1;
+    float zoom = 0;
+    int rotation = 0;
+    FILETIME modTime{};
+    AtomicBool cancelled = 0;
+
+    // set by the preload thread
+    EngineBase* engine = nullptr;
+    Pixmap* page = nullptr;
+    u32 darkModeEpoch = 0;
+
+    // set once the preload thread is done
+    bool done = false;
+    // the engine given to the document load, which the page is adopted for
+    EngineBase* takenEngine = nullptr;
+
+    ~DocPreload() {
+        str::Free(path);
+        SafeEngineRelease(&engine);
+        FreePixmap(page);
+    }
+};
+
+// the current preload, only accessed on the ui thread. A cancelled preload whose
+// thread is still running is deleted by DocPreloadFinished()
+static DocPreload* gDocPreload = nullptr;
+static AtomicInt gDocPreloadThreadsCount = 0;
+
+static bool IsPreloadCancelled(DocPreload* p) {
+    return AtomicBoolGet(&p->cancelled);
+}
+
+static bool PageFitsPreload(EngineBase* engine, DocPreload* p) {
+    if (p->zoom <= 0 || p->pageNo < 1 || p->pageNo > engine->PageCount()) {
+        return false;
+    }
+    RectF r = engine->Transform(engine->PageMediabox(p->pageNo), p->pageNo, p->zoom, p->rotation);
+    i64 nBytes = (i64)r.dx * (i64)r.dy * 4;
+    return nBytes > 0 && nBytes <= kPreloadMaxPageBytes;
+}
+
+static void DocPreloadFinished(DocPreload* p) {
+    if (p != gDocPreload) {
+        delete p;
+        return;
+    }
+    p->done = true;
+    if (!p->engine) {
+        gDocPreload = nullptr;
+        delete p;
+    }
+}
+
+static void DocPreloadThread(DocPreload* p) {
+    AtomicIntInc(&gDangerousThreadCount);
+    // wait in small steps so that a cancel doesn't wait for the whole delay
+    for (int ms = 0; ms < kPreloadSettleMs && !IsPreloadCancelled(p); ms += 50) {
+        Sleep(50);
+    }
+    if (!IsPreloadCancelled(p)) {
+        auto timeStart = TimeGet();
+        bool chmInFixedUI = gGlobalPrefs->chmUI.useFixedPageUI;
+        EngineBase* engine = CreateEngineFromFile(p->path, nullptr, chmInFixedUI);
+        if (engine && engine->PageCount() <= 0) {
+            SafeEngineRelease(&engine);
+        }
+        if (engine && !IsPreloadCancelled(p) && PageFitsPreload(engine, p)) {
+            p->page = gRenderCache->RenderDetachedPage(engine, p->pageNo, p->zoom, p->rotation, &p->darkModeEpoch);
+        }
+        p->engine = engine;
+        logf("DocPreloadThread: '%s' engine: %d, page: %d in %.2f ms\n", p->path, engine ? 1 : 0, p->page ? 1 : 0,
+             TimeSinceInMs(timeStart));
+    }
+    auto fn = MkFunc0<DocPreload>(DocPreloadFinished, p);
+    uitask::Post(fn, "DocPreloadFinished");
+    AtomicIntDec(&gDocPreloadThreadsCount);
+    AtomicIntDec(&gDangerousThreadCount);
+}
+
+void CancelDocPreload() {
+    DocPreload* p = gDocPreload;
+    if (!p) {
+        return;
+    }
+    gDocPreload = nullptr;
+    if (p->done) {
+        delete p;
+        return;
+    }
+    AtomicBoolSet(&p->cancelled, true);
+}
+
+// starts opening args.path in the background, replacing the previous preload
+void StartDocPreload(const DocPreloadArgs& args) {
+    if (!gGlobalPrefs->preloadNextDocument) {
+        // the setting can be turned off while a preload is running
+        CancelDocPreload();
+        return;
+    }
+    DocPreload* p = gDocPreload;
+    if (p && !p->takenEngine && path::IsSame(p->path, args.path)) {
+        return;
+    }
+    CancelDocPreload();
+
+    i64 size = file::GetSize(args.path);
+    if (size <= 0 || size > kPreloadMaxFileSize) {
+        return;
+    }
+    MEMORYSTATUSEX ms{};
+    ms.dwLength = sizeof(ms);
+    if (GlobalMemoryStatusEx(&ms) && ms.dwMemoryLoad >= kPreloadMaxMemoryLoad) {
+        logf("StartDocPreload: not preloading '%s', memory load is %d%%\n", args.path, (int)ms.dwMemoryLoad);
+        return;
+    }
+
+    p = new DocPreload();
+    p->path = str::Dup(args.path);
+    p->pageNo = args.pageNo;
+    p->zoom = args.zoom;
+    p->rotation = args.rotation;
+    p->modTime = file::GetModificationTime(args.path);
+    gDocPreload = p;
+    AtomicIntInc(&gDocPreloadThreadsCount);
+    auto fn = MkFunc0<DocPreload>(DocPreloadThread, p);
+    RunAsync(fn, StrL("DocPreloadThread"));
+}
+
+// Returns the preloaded engine for path (the caller owns it) or nullptr if there
+// isn't one. A preload of another file, one that isn't done yet (the regular
+// load would race it) or of a file changed since is dropped
+EngineBase* TakePreloadedEngine(Str path) {
+    DocPreload* p = gDocPreload;
+    if (!p || !p->done || !p->engine || !path::IsSame(p->path, path)) {
+        CancelDocPreload();
+        return nullptr;
+    }
+    FILETIME modTime = file::GetModificationTime(path);
+    if (CompareFileTime(&modTime, &p->modTime) != 0) {
+        CancelDocPreload();
+        return nullptr;
+    }
+    EngineBase* engine = p->engine;
+    p->engine = nullptr;
+    // the page is kept until AdoptPreloadedPage()
+    p->takenEngine = engine;
+    return engine;
+}
+
+// Once the document loaded with TakePreloadedEngine() is shown in dm, gives the
+// page rendered with it to the render cache (if it's the one dm needs)
+bool AdoptPreloadedPage(DisplayModel* dm) {
+    DocPreload* p = gDocPreload;
+    if (!p || !p->takenEngine) {
+        return false;
+    }
+    gDocPreload = nullptr;
+    bool ok = false;
+    if (dm && p->page && dm->GetEngine() == p->takenEngine) {
+        ok = gRenderCache->AdoptDetachedPage(dm, p->pageNo, p->zoom, p->rotation, p->darkModeEpoch, p->page);
+        p->page = nullptr;
+    }
+    delete p;
+    return ok;
+}
+
+// must be called before gRenderCache is deleted
+void WaitForDocPreload() {
+    CancelDocPreload();
+    while (AtomicIntGet(&gDocPreloadThreadsCount) > 0) {
+        uitask::DrainQueue();
+        Sleep(10);
+    }
+    uitask::DrainQueue();
+}
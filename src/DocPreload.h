@@ -0,0 +1,20 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+struct EngineBase;
+struct DisplayModel;
+
+// the document to open in the background and the page it will be shown at.
+// zoom is the real zoom to render that page at, 0 to only open the document
+struct DocPreloadArgs {
+    Str path;
+    int pageNo = 1;
+    float zoom = 0;
+    int rotation = 0;
+};
+
+void StartDocPreload(const DocPreloadArgs& args);
+EngineBase* TakePreloadedEngine(Str path);
+bool AdoptPreloadedPage(DisplayModel* dm);
+void CancelDocPreload();
+void WaitForDocPreload();
@@ -16,6 +16,7 @@
 #include "MobiDoc.h"
 #include "gui/PlatformFont.h"
 #include "gui/PlatformText.h"
+#include "HtmlStyleSheet.h"
 #include "HtmlFormatter.h"
 #include "EbookFormatter.h"
 
@@ -180,7 +181,7 @@ void EpubFormatter::HandleTagPagebreak(HtmlToken* t) {
         currPage->instructions.Append(DrawInstr::PageMarkerAnchor(str::Dup(textAllocator, attr->val), bbox));
         str::ReplaceWithCopy(&pagePath, attr->val);
         // reset CSS style rules for the new document
-        styleRules.Reset();
+        styleSheet.Reset();
     }
 }
 
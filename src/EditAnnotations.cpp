@@ -3,6 +3,7 @@
 
 #include "base/Base.h"
 #include "base/File.h"
+#include "base/RectIndex.h"
 #include "base/Win.h"
 #include "gui/Dpi.h"
 #include "base/UITask.h"
@@ -291,7 +292,7 @@ void DeleteAnnotationAndUpdateUI(WindowTab* tab, Annotation* annot) {
     // SetSelectedAnnotation only ScheduleRepaint (overlay handles). The page
     // bitmap still has the deleted annot until we re-render.
     if (IsMainWindowValidAndNotClosing(tab->win)) {
-        MainWindowRerender(tab->win);
+        MainWindowRerenderAnnotations(tab->win);
     }
 }
 
@@ -347,7 +348,7 @@ static void DeleteSelectedAnnotation(EditAnnotationsWindow* ew) {
     // SetSelectedAnnotation only ScheduleRepaint (overlay handles). The page
     // bitmap still has the deleted annot until we re-render.
     if (IsMainWindowValidAndNotClosing(ew->tab->win)) {
-        MainWindowRerender(ew->tab->win);
+        MainWindowRerenderAnnotations(ew->tab->win);
     }
 }
 
@@ -974,7 +975,7 @@ static void TextAlignmentSelectionChanged(EditAnnotationsWindow* ew) {
     int newQuadding = idx;
     SetQuadding(annot, newQuadding);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoTextFont(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1004,7 +1005,7 @@ static void TextFontSelectionChanged(EditAnnotationsWindow* ew) {
     Str font = SeqStrByIndex(gFontNames, idx);
     SetDefaultAppearanceTextFont(annot, font);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoTextSize(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1035,7 +1036,7 @@ static void TextFontSizeChanging(EditAnnotationsWindow* ew, Trackbar::PositionCh
     TempStr s = fmt(_TRA("Text Size: %d").s, fontSize);
     ew->staticTextSize->SetText(s);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoTextColor(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1060,7 +1061,7 @@ static void TextColorSelectionChanged(EditAnnotationsWindow* ew) {
     auto col = GetDropDownColor(item);
     SetDefaultAppearanceTextColor(annot, col);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoBorder(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1088,7 +1089,7 @@ static void BorderWidthChanging(EditAnnotationsWindow* ew, Trackbar::PositionCha
     TempStr s = fmt(_TRA("Border: %d").s, borderWidth);
     ew->staticBorder->SetText(s);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoLineStartEnd(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1122,7 +1123,7 @@ static void LineStartSelectionChanged(EditAnnotationsWindow* ew) {
     }
     SetLineStartStyles(annot, start);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void LineEndSelectionChanged(EditAnnotationsWindow* ew) {
@@ -1136,7 +1137,7 @@ static void LineEndSelectionChanged(EditAnnotationsWindow* ew) {
     }
     SetLineEndStyles(annot, end);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoIcon(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1182,7 +1183,7 @@ static void IconSelectionChanged(EditAnnotationsWindow* ew) {
     auto item = ew->dropDownIcon->items[idx];
     SetIconName(annot, item);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoColor(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1214,7 +1215,7 @@ static void ColorSelectionChanged(EditAnnotationsWindow* ew) {
     auto col = GetDropDownColor(item);
     SetColor(annot, col);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoInteriorColor(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1239,7 +1240,7 @@ static void InteriorColorSelectionChanged(EditAnnotationsWindow* ew) {
     auto col = GetDropDownColor(item);
     SetInteriorColor(annot, col);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void DoOpacity(EditAnnotationsWindow* ew, Annotation* annot) {
@@ -1272,7 +1273,7 @@ static void OpacityChanging(EditAnnotationsWindow* ew, Trackbar::PositionChangin
     TempStr s = fmt(_TRA("Opacity: %d").s, opacity);
     ew->staticOpacity->SetText(s);
     EnableSaveIfAnnotationsChanged(ew);
-    MainWindowRerender(ew->tab->win);
+    MainWindowRerenderAnnotations(ew->tab->win);
 }
 
 static void RelayoutEditAnnotationsWindow(EditAnnotationsWindow* ew, int clientDx, int clientDy);
@@ -1686,7 +1687,7 @@ static void ScheduleMainWindowRerender(EditAnnotationsWindow* ew) {
     gMainWindowForRender = win;
     gMainWindowRerenderTimer = SetTimer(win->hwndCanvas, 1, 1000, [](HWND, UINT, UINT_PTR, DWORD) {
         if (IsMainWindowValidAndNotClosing(gMainWindowForRender)) {
-            MainWindowRerender(gMainWindowForRender);
+            MainWindowRerenderAnnotations(gMainWindowForRender);
         }
         gMainWindowRerenderTimer = 0;
     });
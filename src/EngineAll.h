@@ -113,6 +113,8 @@ bool EngineMupdfIsEncrypted(EngineBase* engine);
 bool EngineMupdfHeadingTocPending(EngineBase* engine);
 void EngineMupdfStartHeadingToc(EngineBase* engine, const Func0& onDone);
 void EngineMupdfCancelHeadingToc(EngineBase* engine);
+void EngineMupdfWarmupHint(EngineBase* engine, int firstVisible, int lastVisible);
+void EngineMupdfCancelWarmup(EngineBase* engine);
 Str EngineMupdfGetPassword(EngineBase* engine);
 bool EngineMupdfSaveUpdated(EngineBase* engine, Str path, const ShowErrorCb& showErrorFunc);
 bool EngineMupdfSaveCopy(EngineBase* engine, Str path);
@@ -157,9 +159,20 @@ Annotation* EngineMupdfGetAnnotationAtPos(EngineBase*, int pageNo, PointF pos, A
 Annotation* EngineMupdfGetWidgetAtPos(EngineBase*, int pageNo, PointF pos);
 Annotation* EngineMupdfGetAdjacentWidget(EngineBase*, Annotation* cur, bool forward);
 void EngineMupdfGetFormFieldHighlightRects(EngineBase*, int pageNo, Annotation* skip, Vec<RectF>& out);
+bool EngineMupdfTakeAnnotationDamage(EngineBase*, Vec<int>& pageNos, Vec<RectF>& rects);
 void EngineMupdfSetDisableJavaScript(bool disable);
 float EngineMupdfSetEbookLayoutAspect(float dyOverDx);
 void EngineMupdfSetAllowExternalImages(bool allow);
+void EngineMupdfSetPageCacheBudget(i64 bytes);
+TempStr EngineMupdfPageCacheInfoTemp(EngineBase*);
+struct EngineMupdfCacheStats {
+    i64 bytes = 0;
+    int evictions = 0;
+    i64 evictedBytes = 0;
+    int rebuilds = 0;
+};
+// false if not a mupdf engine or a render holds the caches right now
+bool EngineMupdfGetPageCacheStats(EngineBase*, EngineMupdfCacheStats* out);
 void EngineMupdfToggleCadEnhance(EngineBase* engine);
 bool EngineMupdfCadEnhanceActive(EngineBase* engine);
 void EngineMupdfInvalidateDarkMode(EngineBase* engine);
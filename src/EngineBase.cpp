@@ -8,6 +8,8 @@
 #include "gui/UIModels.h"
 
 #include "EngineBase.h"
+#include "GlyphIndex.h"
+#include "PageStructure.h"
 
 Kind kindPageElementDest = "dest";
 Kind kindPageElementImage = "image";
@@ -417,6 +419,18 @@ EngineBase::~EngineBase() {
         }
         free(pagesText);
     }
+    if (pagesGlyphIndex) {
+        for (int i = 0; i < pageCount; i++) {
+            delete pagesGlyphIndex[i];
+        }
+        free(pagesGlyphIndex);
+    }
+    if (pagesStructure) {
+        for (int i = 0; i < pageCount; i++) {
+            delete pagesStructure[i];
+        }
+        free(pagesStructure);
+    }
     free(pagesTextState);
     str::Free(defaultExt);
     LogArenaStats(StrL("engine"), arena);
@@ -429,7 +443,8 @@ struct TextExtractionThreadData {
 };
 
 static void ExtractTextThread(TextExtractionThreadData* data) {
-    data->engine->GetTextForPage(data->pageNo);
+    // the structure is needed as soon as the page is hovered or clicked
+    data->engine->GetPageStructure(data->pageNo);
     data->engine->ReleaseTextExtractionThreadContext();
     data->engine->Release();
     delete data;
@@ -648,6 +663,79 @@ Str EngineBase::GetTextForPage(int pageNo, int* lenOut, Rect** coordsOut) {
     return ReturnCachedPageText(pt, lenOut, coordsOut);
 }
 
+i64 EngineBase::TextCacheBytes() {
+    ScopedMutex scope(&textCacheLock);
+    if (!pagesText) {
+        return 0;
+    }
+    i64 res = 0;
+    for (int i = 0; i < pageCount; i++) {
+        PageText* pt = &pagesText[i];
+        if (pt->text) {
+            res += (i64)pt->len + 1 + (i64)pt->nCodepoints * sizeof(Rect);
+        }
+        if (pagesStructure && pagesStructure[i]) {
+            res += pagesStructure[i]->Bytes();
+        }
+    }
+    return res;
+}
+
+const GlyphIndex* EngineBase::GetGlyphIndex(int pageNo) {
+    if (pageNo < 1 || pageNo > pageCount) {
+        return nullptr;
+    }
+    int textLen = 0;
+    Rect* coords = nullptr;
+    // extracts the text if needed; it doesn't change after that
+    GetTextForPage(pageNo, &textLen, &coords);
+    {
+        ScopedMutex scope(&textCacheLock);
+        if (!pagesGlyphIndex) {
+            pagesGlyphIndex = AllocArray<GlyphIndex*>(pageCount);
+        }
+        if (pagesGlyphIndex[pageNo - 1]) {
+            return pagesGlyphIndex[pageNo - 1];
+        }
+    }
+    auto* index = new GlyphIndex(coords, textLen);
+    ScopedMutex scope(&textCacheLock);
+    if (pagesGlyphIndex[pageNo - 1]) {
+        // another thread was faster
+        delete index;
+    } else {
+        pagesGlyphIndex[pageNo - 1] = index;
+    }
+    return pagesGlyphIndex[pageNo - 1];
+}
+
+const PageStructure* EngineBase::GetPageStructure(int pageNo) {
+    if (pageNo < 1 || pageNo > pageCount) {
+        return nullptr;
+    }
+    int textLen = 0;
+    Rect* coords = nullptr;
+    Str text = GetTextForPage(pageNo, &textLen, &coords);
+    {
+        ScopedMutex scope(&textCacheLock);
+        if (!pagesStructure) {
+            pagesStructure = AllocArray<PageStructure*>(pageCount);
+        }
+        if (pagesStructure[pageNo - 1]) {
+            return pagesStructure[pageNo - 1];
+        }
+    }
+    auto* ps = BuildPageStructure(text, coords, textLen);
+    ScopedMutex scope(&textCacheLock);
+    if (pagesStructure[pageNo - 1]) {
+        // another thread was faster
+        delete ps;
+    } else {
+        pagesStructure[pageNo - 1] = ps;
+    }
+    return pagesStructure[pageNo - 1];
+}
+
 // number of pages the loaded document contains
 int EngineBase::PageCount() const {
     ReportIf(pageCount < 0);
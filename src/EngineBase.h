@@ -8,6 +8,8 @@ struct RenderedBitmap;
 struct IPageDestination;
 struct TocItem;
 struct PropValue;
+class GlyphIndex;
+struct PageStructure;
 enum class DocProp : u8;
 
 struct ILinkHandler {
@@ -469,6 +471,9 @@ struct RenderPageArgs {
     // dark/recolor rendering profile for View renders (see PdfDarkMode.h);
     // owned by the caller, only valid for the duration of RenderPage()
     const DarkModeProfile* darkProfile = nullptr;
+    // out: bytes of pixels the engine copied or converted after rasterizing
+    // the page (0 when it rendered straight into the returned Pixmap)
+    i64 bytesCopied = 0;
 
     RenderPageArgs(int pageNo, float zoom, int rotation, RectF* pageRect = nullptr,
                    RenderTarget target = RenderTarget::View, AbortCookie** cookie_out = nullptr);
@@ -549,6 +554,14 @@ class EngineBase {
     void RequestTextExtraction(int pageNo);
     Str GetTextForPage(int pageNo, int* lenOut = nullptr, Rect** coordsOut = nullptr);
     bool TryGetTextForPage(int pageNo, int* lenOut = nullptr, Rect** coordsOut = nullptr);
+    // memory held by the cached page text (text and glyph coordinates)
+    i64 TextCacheBytes();
+    // spatial index of the glyphs of the page's text, built the first time
+    // it's needed and kept with the text
+    const GlyphIndex* GetGlyphIndex(int pageNo);
+    // lines of the page's text (see PageStructure.h), built the first time
+    // it's needed (or after background text extraction) and kept with the text
+    const PageStructure* GetPageStructure(int pageNo);
     virtual void ReleaseTextExtractionThreadContext() {}
     // pages where clipping doesn't help are rendered in larger tiles
     virtual bool HasClipOptimizations(int pageNo) = 0;
@@ -623,6 +636,8 @@ class EngineBase {
     // cached text, one entry per page (lazily allocated)
     PageText* pagesText = nullptr;
     TextExtractionState* pagesTextState = nullptr;
+    GlyphIndex** pagesGlyphIndex = nullptr;
+    PageStructure** pagesStructure = nullptr;
     Mutex textCacheLock;
 
     str::Builder errors;
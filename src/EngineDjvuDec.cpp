@@ -19,17 +19,15 @@ extern "C" {
 
 Kind kindEngineDjVu = "engineDjVu";
 
-// if true, files >= kMemoryMapMinFileSize are memory-mapped
-// instead of being read into memory, so opening a multi-GB file doesn't
+// if true, large files are memory-mapped instead of being read into memory
+// (here and in EngineMupdf), so opening a multi-GB file doesn't
 // commit private memory for the whole file: pages come from the OS file
 // cache on demand and can be discarded under memory pressure. Files on
-// network drives are always read into memory: if the connection drops while
+// network or removable drives are always read: if the media goes away while
 // mapped, touching a page raises EXCEPTION_IN_PAGE_ERROR (a crash) instead
 // of failing with an error code.
 bool gMemoryMapLargeFiles = true;
 
-constexpr i64 kMemoryMapMinFileSize = 128LL * 1024 * 1024;
-
 // parses "123", "#123", "# 123"; returns -1 for invalid page
 static int ParseDjvuDecLink(Str link) {
     str::SkipChar(link, '#');
@@ -268,9 +266,7 @@ EngineBase* EngineDjvuDec::Clone() {
 
 bool EngineDjvuDec::Load(Str fileName) {
     SetFilePath(fileName);
-    bool tryMap =
-        gMemoryMapLargeFiles && !path::IsOnNetworkDrive(fileName) && file::GetSize(fileName) >= kMemoryMapMinFileSize;
-    if (tryMap && file::MemoryMap(fileName, &fileMap)) {
+    if (gMemoryMapLargeFiles && file::MemoryMapIfLarge(fileName, file::kMemoryMapMinFileSize, &fileMap)) {
         return FinishLoading();
     }
     fileData = file::ReadFile(fileName);
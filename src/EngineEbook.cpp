@@ -23,6 +23,7 @@
 #include "EbookDoc.h"
 #include "gui/PlatformFont.h"
 #include "gui/PlatformText.h"
+#include "HtmlStyleSheet.h"
 #include "HtmlFormatter.h"
 #include "EbookFormatter.h"
 
@@ -1435,7 +1436,7 @@ void ChmFormatter::HandleTagPagebreak(HtmlToken* t) {
         currPage->instructions.Append(DrawInstr::PageMarkerAnchor(str::Dup(textAllocator, attr->val), bbox));
         str::ReplaceWithCopy(&pagePath, attr->val);
         // reset CSS style rules for the new document
-        styleRules.Reset();
+        styleSheet.Reset();
     }
 }
 
@@ -8,6 +8,7 @@
 #include "base/File.h"
 #include "base/GuessFileType.h"
 #include "base/Pixmap.h"
+#include "base/PixmapResize.h"
 #include "GumboHelpers.h"
 #include "base/JsonParser.h"
 #include "base/Timer.h"
@@ -488,6 +489,12 @@ static uint32_t GetPixmapPixelRgbKey(const Pixmap* pixmap, int x, int y) {
     return rgb & (~0x070707U);
 }
 
+// Lanczos when enlarging or reducing a little, where its sharpness shows; a
+// (cheaper) triangle filter for big reductions, where it doesn't
+static PixmapFilter ImageResizeFilter(int srcDx, int dstDx) {
+    return srcDx >= dstDx * 2 ? PixmapFilter::Bilinear : PixmapFilter::Lanczos3;
+}
+
 // Print and export targets have to be opaque - paper is white, and an exported
 // bitmap has nowhere to get a backdrop from - so their pages are composited onto
 // white here. Only the canvas asks for keepAlpha, because it paints the document
@@ -595,9 +602,7 @@ Pixmap* EngineImages::RenderPage(RenderPageArgs& args) {
         fz_context* ctx = Ctx();
         Pixmap* result = nullptr;
         fz_pixmap* decoded = nullptr;
-        fz_pixmap* scaled = nullptr;
         fz_var(decoded);
-        fz_var(scaled);
         int reqW = mediaScreen.dx > 0 ? mediaScreen.dx : screen.dx;
         int reqH = mediaScreen.dy > 0 ? mediaScreen.dy : screen.dy;
         if (reqW < 1) {
@@ -634,22 +639,24 @@ Pixmap* EngineImages::RenderPage(RenderPageArgs& args) {
         fz_try(ctx) {
             int dw = 0, dh = 0;
             decoded = fz_get_pixmap_from_image(ctx, page->img, subPtr, &ctm, &dw, &dh);
-            if (decoded && (decoded->w != screen.dx || decoded->h != screen.dy)) {
-                scaled = fz_scale_pixmap(ctx, decoded, 0, 0, (float)screen.dx, (float)screen.dy, nullptr);
-            }
         }
         fz_catch(ctx) {
             fz_report_error(ctx);
         }
-        fz_pixmap* final = scaled ? scaled : decoded;
-        if (final) {
-            result = FzPixmapToPixmap(ctx, final);
+        if (decoded) {
+            result = FzPixmapToPixmap(ctx, decoded);
             if (result) {
                 result->hasAlpha = result->format == PixmapFormat::BGRA8;
             }
-        }
-        if (scaled) {
-            fz_drop_pixmap(ctx, scaled);
+            // only JPEGs decode close to the size asked for, everything else
+            // (PNG, TIFF, ...) decodes at full size and is resized here
+            if (result && (result->width != screen.dx || result->height != screen.dy)) {
+                Pixmap* full = result;
+                PixmapResizeArgs resizeArgs;
+                resizeArgs.filter = ImageResizeFilter(full->width, screen.dx);
+                result = ResizePixmap(full, screen.dx, screen.dy, resizeArgs);
+                FreePixmap(full);
+            }
         }
         if (decoded) {
             fz_drop_pixmap(ctx, decoded);
@@ -693,57 +700,29 @@ Pixmap* EngineImages::RenderPage(RenderPageArgs& args) {
         return nullptr;
     }
 
-#if OS_WIN
-    // read before DropPage() below, which can free page->pixmap, i.e. src
-    bool srcHasAlpha = src->format == PixmapFormat::BGRA8;
-
-    // High-quality scale via GDI+ bicubic. The old per-pixel nearest-neighbor
-    // path looked blocky for Pixmap-only formats (HEIC/AVIF/WebP/JXL) whenever
-    // zoom != 100%. Rotation still uses the fallback below (rare for images).
-    if (NormalizeRotation(rotation) == 0 && screen.dx > 0 && screen.dy > 0) {
-        Gdiplus::Bitmap* srcBmp = WrapPixmapGdiplus(src);
-        if (srcBmp) {
-            auto* dstBmp = new Gdiplus::Bitmap(screen.dx, screen.dy, PixelFormat32bppPARGB);
-            if (dstBmp && dstBmp->GetLastStatus() == Gdiplus::Ok) {
-                Gdiplus::Graphics g(dstBmp);
-                g.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
-                // HighQuality/Half offsets samples by -0.5px, so a 1:1 or
-                // integer-scaled image lands a half-pixel off and looks
-                // fuzzy (issue #3434). None keeps the image on the pixel grid.
-                g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeNone);
-                // start transparent, not white: the transparent parts of the
-                // image have to stay transparent so the canvas can put the
-                // document background behind them (#5844)
-                g.Clear(Gdiplus::Color(0, 0, 0, 0));
-                // pageRc is in page-pixel coords; screen is the zoomed dest size.
-                Gdiplus::RectF dest(0, 0, (float)screen.dx, (float)screen.dy);
-                // Bicubic samples outside the source rect. Without a wrap mode
-                // GDI+ treats those samples as transparent, so the edge pixels
-                // composite toward the cleared dest and show as a 1-2px dark
-                // seam when comic pages sit on the black canvas at PageSpacing
-                // 0 0 (issue #6018).
-                Gdiplus::ImageAttributes imgAttrs;
-                imgAttrs.SetWrapMode(Gdiplus::WrapModeTileFlipXY);
-                g.DrawImage(srcBmp, dest, pageRc.x, pageRc.y, pageRc.dx, pageRc.dy, Gdiplus::UnitPixel, &imgAttrs);
-                Pixmap* result = PixmapFromGdiplus(dstBmp);
-                delete dstBmp;
-                delete srcBmp;
-                DropPage(page, false);
-                if (result) {
-                    // PixmapFromGdiplus reads back as straight (not premultiplied) ARGB
-                    result->premultiplied = false;
-                    result->hasAlpha = srcHasAlpha;
-                    return FinishRenderedPage(result, args.keepAlpha);
-                }
-            } else {
-                delete dstBmp;
-                delete srcBmp;
-            }
+    // Pixmap-only formats (HEIC/AVIF/WebP/JXL): nearest-neighbor looked
+    // blocky whenever zoom != 100%. Rotation still uses the fallback below
+    // (rare for images). Taps outside pageRc read the image around it
+    // (clamped at the image's edges), so tiles line up without seams and the
+    // edges don't fade into transparency (issue #6018)
+    RectF imageRc(0, 0, (float)src->width, (float)src->height);
+    if (NormalizeRotation(rotation) == 0 && imageRc.Intersect(pageRc) == pageRc) {
+        PixmapResizeArgs resizeArgs;
+        resizeArgs.filter = ImageResizeFilter((int)pageRc.dx, screen.dx);
+        resizeArgs.srcRect = pageRc;
+        // decoders don't set hasAlpha, but the alpha of an image is meaningful
+        // (the fallback below keeps it too). src is shared, so mark a copy
+        Pixmap srcWithAlpha = *src;
+        srcWithAlpha.hasAlpha = src->format != PixmapFormat::BGR8;
+        Pixmap* result = ResizePixmap(&srcWithAlpha, screen.dx, screen.dy, resizeArgs);
+        if (result) {
+            DropPage(page, false);
+            return FinishRenderedPage(result, args.keepAlpha);
         }
+        logf("EngineImages::RenderPage: ResizePixmap() failed for page %d\n", pageNo);
     }
-#endif
 
-    // Fallback: nearest-neighbor (rotation, non-Windows, or GDI+ failure).
+    // Fallback: nearest-neighbor (rotation, page rect outside the image, OOM).
     Pixmap* result = AllocPixmap(screen.dx, screen.dy, PixmapFormat::BGRA8, true);
     if (!result) {
         DropPage(page, false);
@@ -1299,9 +1278,21 @@ static void AddExifStringProp(Props& propsOut, DocProp docProp, const ExifParser
     }
 }
 
+// the Exif data is near the start of the file: don't read all of a big one
+// to get the properties, map it
+constexpr i64 kExifMemoryMapMinFileSize = 16LL * 1024 * 1024;
+
 TempStr EngineImage::GetPropertyTemp(DocProp prop) {
-    Str data = file::ReadFile(FilePath());
+    file::Mapping m;
+    Str data;
+    bool mapped = gMemoryMapLargeFiles && file::MemoryMapIfLarge(FilePath(), kExifMemoryMapMinFileSize, &m);
+    if (mapped) {
+        data = Str((char*)m.data, (int)std::min(m.size, (i64)INT_MAX));
+    } else {
+        data = file::ReadFile(FilePath());
+    }
     if (len(data) == 0) {
+        str::Free(data);
         return {};
     }
 
@@ -1322,7 +1313,11 @@ TempStr EngineImage::GetPropertyTemp(DocProp prop) {
             res = parser.GetStringProp(ExifProp::Software);
         }
     }
-    str::Free(data);
+    if (mapped) {
+        file::MemoryUnmap(&m);
+    } else {
+        str::Free(data);
+    }
     return res;
 }
 
@@ -9,10 +9,12 @@
 #include "base/File.h"
 #include "base/GuessFileType.h"
 #include "base/Pixmap.h"
+#include "base/RectIndex.h"
 #if OS_WIN
 #include "base/Win.h"
 #endif
 #include "base/Timer.h"
+#include "base/Trace.h"
 #include "base/UITask.h"
 
 extern "C" {
@@ -94,6 +96,14 @@ void EngineMupdfSetAllowExternalImages(bool allow) {
     gAllowExternalImages = allow;
 }
 
+// per-document budget for the page caches (see EngineMupdf::pageCacheBytes),
+// from the PageCacheSizeMB setting. Past it, caches of pages away from the
+// viewport are evicted
+static i64 gPageCacheBudget = 256 * 1024 * 1024;
+void EngineMupdfSetPageCacheBudget(i64 bytes) {
+    gPageCacheBudget = bytes;
+}
+
 EngineMupdf* AsEngineMupdf(EngineBase* engine) {
     if (!engine || !IsOfKind(engine, kindEngineMupdf)) {
         return nullptr;
@@ -419,7 +429,65 @@ static bool IsMupdfLocalFileLink(Str uri, TempStr* pathOut, Str* fragmentOut) {
     return true;
 }
 
-static IPageDestination* NewPageDestinationMupdf(fz_context* ctx, fz_document* doc, fz_link* link,
+// a page arena starts small: most pages have a few links, and one with
+// thousands (an index) grows it by chaining more blocks
+constexpr u64 kPageElementsArenaSize = 64 * 1024;
+constexpr u64 kPageElementsArenaCommitSize = 4 * 1024;
+
+static Arena* GetPageElementsArena(Arena** a, const char* name) {
+    if (!*a) {
+        ArenaParams params = ArenaDefaultParams();
+        params.reserveSize = kPageElementsArenaSize;
+        params.commitSize = kPageElementsArenaCommitSize;
+        params.name = name;
+        *a = ArenaNew(params);
+    }
+    return *a;
+}
+
+// elements of a page (and their destinations) are allocated in one of its
+// arenas, the destinations in the toc (a is nullptr) on the heap
+template <typename T, typename... Args>
+static T* NewPageObject(Arena* a, Args&&... args) {
+    if (a) {
+        return New<T>(a, std::forward<Args>(args)...);
+    }
+    return new T(std::forward<Args>(args)...);
+}
+
+// for elements made with NewPageObject() in an arena: the destructors free the
+// strings they own, the memory goes with the arena
+template <typename T>
+static void DestructPageElements(Vec<T*>& els) {
+    for (T* el : els) {
+        if (el->GetKind() == kindPageElementDest) {
+            auto* pel = (PageElementDestination*)el;
+            if (pel->dest) {
+                pel->dest->~IPageDestination();
+                pel->dest = nullptr;
+            }
+        }
+        el->~T();
+    }
+    els.Reset();
+}
+
+static void FreePageLinks(FzPageInfo* pageInfo) {
+    DestructPageElements(pageInfo->links);
+    DestructPageElements(pageInfo->autoLinks);
+    ArenaDelete(pageInfo->linksArena);
+    pageInfo->linksArena = nullptr;
+    pageInfo->elementsNeedRebuilding = true;
+}
+
+static void FreePageComments(FzPageInfo* pageInfo) {
+    DestructPageElements(pageInfo->comments);
+    ArenaDelete(pageInfo->commentsArena);
+    pageInfo->commentsArena = nullptr;
+    pageInfo->elementsNeedRebuilding = true;
+}
+
+static IPageDestination* NewPageDestinationMupdf(Arena* a, fz_context* ctx, fz_document* doc, fz_link* link,
                                                  fz_outline* outline) {
     ReportIf(link && outline);
     ReportIf(!link && !outline);
@@ -459,13 +527,13 @@ static IPageDestination* NewPageDestinationMupdf(fz_context* ctx, fz_document* d
             // degenerate bare "file:" uri (seen in broken PDFs)
             return nullptr;
         }
-        auto* res = new PageDestinationFile(path, destStr);
+        auto* res = NewPageObject<PageDestinationFile>(a, path, destStr);
         res->rect = FzGetRectF(link);
         return res;
     }
 
     if (IsExternalUrl(uri)) {
-        auto* res = new PageDestinationURL(uri);
+        auto* res = NewPageObject<PageDestinationURL>(a, uri);
         res->rect = FzGetRectF(link);
         return res;
     }
@@ -483,13 +551,13 @@ static IPageDestination* NewPageDestinationMupdf(fz_context* ctx, fz_document* d
         TempStr localPath;
         Str localFragment;
         if (IsMupdfLocalFileLink(uri, &localPath, &localFragment)) {
-            auto* res = new PageDestinationFile(localPath, localFragment);
+            auto* res = NewPageObject<PageDestinationFile>(a, localPath, localFragment);
             res->rect = FzGetRectF(link);
             return res;
         }
     }
 
-    auto* dest = new PageDestinationMupdf(link, outline);
+    auto* dest = NewPageObject<PageDestinationMupdf>(a, link, outline);
     dest->rect = FzGetRectF(link);
     dest->pageNo = pageNo;
     if (pageNo > 0) {
@@ -548,13 +616,13 @@ static Str PdfLinkContents(fz_context* ctx, pdf_document* pdfdoc, pdf_page* pdfp
     return res;
 }
 
-static PageElementDestination* NewLinkDestination(int srcPageNo, fz_context* ctx, fz_document* doc, fz_link* link,
-                                                  fz_outline* outline) {
-    auto* dest = NewPageDestinationMupdf(ctx, doc, link, outline);
+static PageElementDestination* NewLinkDestination(Arena* a, int srcPageNo, fz_context* ctx, fz_document* doc,
+                                                  fz_link* link) {
+    auto* dest = NewPageDestinationMupdf(a, ctx, doc, link, nullptr);
     if (!dest) {
         return nullptr;
     }
-    auto* res = new PageElementDestination(dest);
+    auto* res = NewPageObject<PageElementDestination>(a, dest);
     res->pageNo = srcPageNo;
     res->rect = dest->rect;
     return res;
@@ -574,10 +642,6 @@ RectF ToRectF(fz_rect rect) {
     return RectF::FromXY(rect.x0, rect.y0, rect.x1, rect.y1);
 }
 
-static bool IsPointInRect(fz_rect rect, fz_point pt) {
-    return ToRectF(rect).Contains(PointF(pt.x, pt.y));
-}
-
 static fz_matrix FzCreateViewCtm(fz_rect mediabox, float zoom, int rotation) {
     fz_matrix ctm = fz_pre_scale(fz_rotate((float)rotation), zoom, zoom);
 
@@ -725,6 +789,56 @@ static fz_stream* FzReadFileIfSmall(fz_context* ctx, Str path) {
     return stm;
 }
 
+// fz_stream over a read-only mapping of the whole file: the content comes
+// from the OS file cache instead of being read into our heap, and seeks are
+// pointer arithmetic instead of read() calls through a small buffer
+static int FzMappedFileNext(fz_context*, fz_stream*, size_t) {
+    return EOF;
+}
+
+static void FzMappedFileSeek(fz_context*, fz_stream* stm, int64_t offset, int whence) {
+    auto* m = (file::Mapping*)stm->state;
+    int64_t pos = (int64_t)(stm->rp - m->data);
+    if (whence == 1) {
+        offset += pos;
+    } else if (whence == 2) {
+        offset += m->size;
+    }
+    offset = std::clamp(offset, (int64_t)0, (int64_t)m->size);
+    stm->rp = m->data + offset;
+}
+
+static void FzMappedFileDrop(fz_context*, void* state) {
+    auto* m = (file::Mapping*)state;
+    file::MemoryUnmap(m);
+    delete m;
+}
+
+static fz_stream* FzOpenMappedFileIfLarge(fz_context* ctx, Str path) {
+    if (!gMemoryMapLargeFiles) {
+        return nullptr;
+    }
+    auto* m = new file::Mapping();
+    if (!file::MemoryMapIfLarge(path, file::kMemoryMapMinFileSize, m)) {
+        delete m;
+        return nullptr;
+    }
+    fz_stream* stm = nullptr;
+    fz_try(ctx) {
+        // on failure fz_new_stream() calls FzMappedFileDrop() for us
+        stm = fz_new_stream(ctx, m, FzMappedFileNext, FzMappedFileDrop);
+        stm->seek = FzMappedFileSeek;
+        stm->rp = m->data;
+        stm->wp = m->data + m->size;
+        stm->pos = m->size;
+    }
+    fz_catch(ctx) {
+        stm = nullptr;
+        fz_report_error(ctx);
+    }
+    return stm;
+}
+
 /*
 https://github.com/sumatrapdfreader/sumatrapdf/issues/4514
 Some PDF files have garbage at the beginning, before the %PDF- marker
@@ -777,6 +891,10 @@ static fz_stream* FzOpenOrReadFile(fz_context* ctx, Str path) {
         if (stm) {
             return stm;
         }
+        stm = FzOpenMappedFileIfLarge(ctx, path);
+        if (stm) {
+            return stm;
+        }
     }
 #if OS_WIN
     WCHAR* pathW = CWStrTemp(path);
@@ -1821,6 +1939,41 @@ static Pixmap* NewPixmapFromFzPixmap(fz_context* ctx, fz_pixmap* pixmap, bool pr
 #endif
 }
 
+// The page is rasterized straight into a BGRA8 Pixmap that becomes the result
+// (on Windows a pooled DIB section, see AllocTilePixmap), so there's no
+// conversion or copy between rendering and BlitPixmap. *tileOut is set first,
+// so that the caller's fz_catch frees it if creating the fz_pixmap throws.
+// If it can't be allocated, falls back to an RGB fz_pixmap, which
+// PagePixmapResult() converts.
+static fz_pixmap* NewPagePixmap(fz_context* ctx, fz_irect ibounds, Pixmap** tileOut) {
+    int w = ibounds.x1 - ibounds.x0;
+    int h = ibounds.y1 - ibounds.y0;
+#if OS_WIN
+    *tileOut = AllocTilePixmap(w, h);
+#else
+    *tileOut = AllocPixmap(w, h);
+#endif
+    if (!*tileOut) {
+        return fz_new_pixmap_with_bbox(ctx, fz_device_rgb(ctx), ibounds, nullptr, 1);
+    }
+    return fz_new_pixmap_with_bbox_and_data(ctx, fz_device_bgr(ctx), ibounds, nullptr, 1, (*tileOut)->data);
+}
+
+static Pixmap* PagePixmapResult(fz_context* ctx, fz_pixmap* pix, Pixmap* tile, bool preserveAlpha, i64* bytesCopied) {
+    if (tile) {
+        tile->xres = (float)pix->xres;
+        tile->yres = (float)pix->yres;
+        return tile;
+    }
+    Pixmap* res = NewPixmapFromFzPixmap(ctx, pix, preserveAlpha);
+    if (res) {
+        // converting to BGRA and copying that into the result, or palettizing
+        bool isPalette = res->format == PixmapFormat::Native;
+        *bytesCopied += isPalette ? (i64)res->stride * res->height : 2 * PixmapByteSize(res);
+    }
+    return res;
+}
+
 static TocItem* NewTocItemWithDestination(TocItem* parent, Str title, IPageDestination* dest) {
     auto* res = AllocTocItem(nullptr, title, 0);
     res->parent = parent;
@@ -1890,39 +2043,30 @@ Encore:
     return els[0];
 }
 
-// don't delete the result
-NO_INLINE static IPageElement* FzGetElementAtPos(FzPageInfo* pageInfo, PointF pt) {
-    if (!pageInfo) {
-        return nullptr;
-    }
-    Vec<IPageElement*> res;
+static void AddToElementsIndex(FzPageElementsIndex& idx, IPageElement* el, RectF r) {
+    idx.els.Append(el);
+    RectIndexAdd(idx.rects, r);
+}
+
+static void BuildElementsIndex(FzPageInfo* pageInfo) {
+    auto& idx = pageInfo->elementsIndex;
+    idx.els.Reset();
+    RectIndexReset(idx.rects);
 
+    // in the order in which PickBestElement() prefers them
     for (auto* pel : pageInfo->links) {
-        if (pel->GetRect().Contains(pt)) {
-            res.Append(pel);
-        }
+        AddToElementsIndex(idx, pel, pel->GetRect());
     }
-
     for (auto* pel : pageInfo->autoLinks) {
-        if (pel->GetRect().Contains(pt)) {
-            res.Append(pel);
-        }
+        AddToElementsIndex(idx, pel, pel->GetRect());
     }
-
     for (auto* pel : pageInfo->comments) {
-        if (pel->GetRect().Contains(pt)) {
-            res.Append(pel);
-        }
+        AddToElementsIndex(idx, pel, pel->GetRect());
     }
-
-    fz_point p = {pt.x, pt.y};
     for (auto& img : pageInfo->images) {
-        fz_rect ir = img->rect;
-        if (IsPointInRect(ir, p)) {
-            res.Append(img->imageElement);
-        }
+        AddToElementsIndex(idx, img->imageElement, ToRectF(img->rect));
     }
-    return PickBestElement(res);
+    RectIndexBuild(idx.rects);
 }
 
 static void BuildElementsInfo(FzPageInfo* pageInfo) {
@@ -1951,6 +2095,24 @@ static void BuildElementsInfo(FzPageInfo* pageInfo) {
         els.Append(comment);
     }
     VecReverse(els);
+
+    BuildElementsIndex(pageInfo);
+}
+
+// don't delete the result. Caller must hold pagesLock
+NO_INLINE static IPageElement* FzGetElementAtPos(FzPageInfo* pageInfo, PointF pt) {
+    if (!pageInfo) {
+        return nullptr;
+    }
+    BuildElementsInfo(pageInfo);
+    auto& idx = pageInfo->elementsIndex;
+    Vec<int> found;
+    RectIndexFind(idx.rects, pt, found);
+    Vec<IPageElement*> res;
+    for (int i : found) {
+        res.Append(idx.els[i]);
+    }
+    return PickBestElement(res);
 }
 
 static void FzLinkifyPageText(FzPageInfo* pageInfo, fz_stext_page* stext) {
@@ -1989,9 +2151,9 @@ static void FzLinkifyPageText(FzPageInfo* pageInfo, fz_stext_page* stext) {
             continue;
         }
 
-        // TODO: those leak on xps
-        auto* dest = new PageDestinationURL(uri);
-        auto* pel = new PageElementDestination(dest);
+        Arena* a = GetPageElementsArena(&pageInfo->linksArena, "page links");
+        auto* dest = NewPageObject<PageDestinationURL>(a, uri);
+        auto* pel = NewPageObject<PageElementDestination>(a, dest);
         pel->rect = ToRectF(bbox);
         pageInfo->autoLinks.Append(pel);
     }
@@ -2674,7 +2836,7 @@ static char* LookupNamedJavaScript(fz_context* ctx, pdf_document* doc, Str name)
 // returns null), and pdf_first_annot skips /Link annots, so walk /Annots.
 // Parse the menu strings without executing JS (issue #1198).
 static void AppendJsMenuLinks(fz_context* ctx, pdf_document* doc, pdf_page* pdfpage, int pageNo,
-                              Vec<PageElementDestination*>& links) {
+                              FzPageInfo* pageInfo) {
     if (!ctx || !doc || !pdfpage) {
         return;
     }
@@ -2736,13 +2898,14 @@ static void AppendJsMenuLinks(fz_context* ctx, pdf_document* doc, pdf_page* pdfp
         if (len(items) == 0) {
             continue;
         }
-        auto* dest = new PageDestinationJsMenu();
+        Arena* a = GetPageElementsArena(&pageInfo->linksArena, "page links");
+        auto* dest = NewPageObject<PageDestinationJsMenu>(a);
         dest->items = items;
         dest->rect = ToRectF(rect);
-        auto* pel = new PageElementDestination(dest);
+        auto* pel = NewPageObject<PageElementDestination>(a, dest);
         pel->pageNo = pageNo;
         pel->rect = dest->rect;
-        links.Append(pel);
+        pageInfo->links.Append(pel);
     }
 }
 
@@ -3231,9 +3394,8 @@ EngineMupdf::~EngineMupdf() {
         darkModeEngineCache = nullptr;
     }
     for (FzPageInfo* pi : pages) {
-        DeleteVecMembers(pi->links);
-        DeleteVecMembers(pi->autoLinks);
-        DeleteVecMembers(pi->comments);
+        FreePageLinks(pi);
+        FreePageComments(pi);
         for (FitzPageImageInfo* img : pi->images) {
             if (img && img->image) {
                 fz_drop_image(ctx, img->image);
@@ -3246,9 +3408,8 @@ EngineMupdf::~EngineMupdf() {
         if (pi->retainedLinks) {
             fz_drop_link(ctx, pi->retainedLinks);
         }
-        if (pi->displayList) {
-            fz_drop_display_list(ctx, pi->displayList);
-        }
+        fz_drop_display_list(ctx, pi->contentList);
+        fz_drop_display_list(ctx, pi->annotsList);
         PdfDarkModeInvalidatePage(ctx, pi);
         if (pi->page) {
             fz_drop_page(ctx, pi->page);
@@ -3486,6 +3647,7 @@ static Str PalmDocToHTML(Str path) {
 }
 
 bool EngineMupdf::Load(Str path, PasswordUI* pwdUI) {
+    TraceSpan span("load document");
     bool ok;
     auto* ctx = Ctx();
     ReportIf(FilePath() || _doc);
@@ -3877,6 +4039,7 @@ bool EngineMupdf::LoadFromStream(fz_stream* stm, Str nameHint, PasswordUI* pwdUI
     if (!stm) {
         return false;
     }
+    TraceSpan span("open document");
     // a 3rd-party DLL might have unmasked fp exceptions on this thread, which
     // would crash mupdf on benign NaN comparisons e.g. in pdf_resolve_link_dest()
 #if OS_WIN
@@ -4534,7 +4697,7 @@ TocItem* EngineMupdf::BuildTocTree(TocItem* parent, fz_outline* outline, int& id
         if (isAttachment) {
             dest = DestFromAttachment(this, outline);
         } else {
-            dest = NewPageDestinationMupdf(ctx, _doc, nullptr, outline);
+            dest = NewPageDestinationMupdf(nullptr, ctx, _doc, nullptr, outline);
         }
         TocItem* item = NewTocItemWithDestination(parent, name, dest);
         item->isOpenDefault = outline->is_open;
@@ -5153,8 +5316,8 @@ FzPageInfo* EngineMupdf::GetFzPageInfoFast(int pageNo) {
     return pageInfo;
 }
 
-static IPageElement* NewFzComment(Str comment, int pageNo, RectF rect) {
-    auto* res = new PageElementComment(comment);
+static IPageElement* NewFzComment(Arena* a, Str comment, int pageNo, RectF rect) {
+    auto* res = NewPageObject<PageElementComment>(a, comment);
     res->pageNo = pageNo;
     res->rect = rect;
     return res;
@@ -5214,7 +5377,7 @@ static Str WidgetTooltipTemp(fz_context* ctx, pdf_annot* annot) {
 // Hover tip for an annotation: author and/or contents (issue #5329).
 // FreeText already draws its contents on the page, so the tip is just the author.
 // must be called inside fz_try
-static IPageElement* MakePdfCommentFromPdfAnnot(fz_context* ctx, int pageNo, pdf_annot* annot) {
+static IPageElement* MakePdfCommentFromPdfAnnot(Arena* a, fz_context* ctx, int pageNo, pdf_annot* annot) {
     fz_rect rect = pdf_bound_annot(ctx, annot);
     auto tp = pdf_annot_type(ctx, annot);
     Str contents = NormalizeCommentNewlinesTemp(Str(pdf_annot_contents(ctx, annot)));
@@ -5242,12 +5405,13 @@ static IPageElement* MakePdfCommentFromPdfAnnot(fz_context* ctx, int pageNo, pdf
     if (!s) {
         return nullptr;
     }
-    return NewFzComment(s, pageNo, ToRectF(rect));
+    return NewFzComment(a, s, pageNo, ToRectF(rect));
 }
 
 // must be called inside fz_try
-static void RebuildCommentsFromAnnotationsInner(fz_context* ctx, pdf_annot* annot, int pageNo,
-                                                Vec<IPageElement*>& comments) {
+static void RebuildCommentsFromAnnotationsInner(fz_context* ctx, pdf_annot* annot, FzPageInfo* pageInfo) {
+    int pageNo = pageInfo->pageNo;
+    Vec<IPageElement*>& comments = pageInfo->comments;
     auto tp = pdf_annot_type(ctx, annot);
     Str contents = Str(pdf_annot_contents(ctx, annot)); // don't free
     if (contents.len > 128) {
@@ -5278,12 +5442,13 @@ static void RebuildCommentsFromAnnotationsInner(fz_context* ctx, pdf_annot* anno
 
         logf("attachment: %s, num: %d\n", Str(attname), num);
 
-        auto* dest = new PageDestination();
+        Arena* a = GetPageElementsArena(&pageInfo->commentsArena, "page comments");
+        auto* dest = NewPageObject<PageDestination>(a);
         dest->kind = kindDestinationLaunchEmbedded;
         dest->value = str::Dup(Str(attname));
         dest->embedObjNum = num;
 
-        auto* el = new PageElementDestination(dest);
+        auto* el = NewPageObject<PageElementDestination>(a, dest);
         el->pageNo = pageNo;
         el->rect = ToRectF(rect);
 
@@ -5306,12 +5471,14 @@ static void RebuildCommentsFromAnnotationsInner(fz_context* ctx, pdf_annot* anno
         if (fz_is_empty_rect(rect)) {
             return;
         }
-        comments.Append(NewFzComment(tu, pageNo, ToRectF(rect)));
+        Arena* a = GetPageElementsArena(&pageInfo->commentsArena, "page comments");
+        comments.Append(NewFzComment(a, tu, pageNo, ToRectF(rect)));
         return;
     }
 
     if (tp == PDF_ANNOT_FREE_TEXT || !isEmpty) {
-        auto* comment = MakePdfCommentFromPdfAnnot(ctx, pageNo, annot);
+        Arena* a = GetPageElementsArena(&pageInfo->commentsArena, "page comments");
+        auto* comment = MakePdfCommentFromPdfAnnot(a, ctx, pageNo, annot);
         if (comment) {
             comments.Append(comment);
         }
@@ -5319,7 +5486,7 @@ static void RebuildCommentsFromAnnotationsInner(fz_context* ctx, pdf_annot* anno
 }
 
 static void RebuildCommentsFromAnnotations(fz_context* ctx, FzPageInfo* pageInfo) {
-    DeleteVecMembers(pageInfo->comments);
+    FreePageComments(pageInfo);
 
     // TODO: can use pageInof->annotations
     Vec<IPageElement*>& comments = pageInfo->comments;
@@ -5329,12 +5496,11 @@ static void RebuildCommentsFromAnnotations(fz_context* ctx, FzPageInfo* pageInfo
         return;
     }
     auto* pdfpage = pdf_page_from_fz_page(ctx, page);
-    int pageNo = pageInfo->pageNo;
 
     pdf_annot* annot;
     for (annot = pdf_first_annot(ctx, pdfpage); annot; annot = pdf_next_annot(ctx, annot)) {
         fz_try(ctx) {
-            RebuildCommentsFromAnnotationsInner(ctx, annot, pageNo, comments);
+            RebuildCommentsFromAnnotationsInner(ctx, annot, pageInfo);
         }
         fz_catch(ctx) {
             fz_report_error(ctx);
@@ -5343,7 +5509,7 @@ static void RebuildCommentsFromAnnotations(fz_context* ctx, FzPageInfo* pageInfo
     // form widgets are a separate list from markup annotations
     for (annot = pdf_first_widget(ctx, pdfpage); annot; annot = pdf_next_widget(ctx, annot)) {
         fz_try(ctx) {
-            RebuildCommentsFromAnnotationsInner(ctx, annot, pageNo, comments);
+            RebuildCommentsFromAnnotationsInner(ctx, annot, pageInfo);
         }
         fz_catch(ctx) {
             fz_report_error(ctx);
@@ -5409,6 +5575,85 @@ static fz_stext_page* fz_new_stext_page_from_whole_page(fz_context* ctx, fz_page
     return text;
 }
 
+// must be called with renderLock held
+static void UpdatePageCacheBytes(EngineMupdf* e, FzPageInfo* pi) {
+    fz_context* ctx = e->Ctx();
+    i64 n = (i64)fz_display_list_size(ctx, pi->contentList) + (i64)fz_display_list_size(ctx, pi->annotsList);
+    for (FitzPageImageInfo* img : pi->images) {
+        if (img->image) {
+            n += (i64)fz_image_size(ctx, img->image);
+        }
+    }
+    e->pageCacheBytes += n - pi->cacheBytes;
+    pi->cacheBytes = n;
+}
+
+// everything dropped here is re-created on demand: the display lists by the
+// next render, kept images by FzGetKeptPageImage(), the dark mode analysis by
+// PdfDarkModeGetOrBuildAnalysis(). must be called with pagesLock and renderLock held
+static void EvictPageCaches(EngineMupdf* e, FzPageInfo* pi) {
+    fz_context* ctx = e->Ctx();
+    fz_drop_display_list(ctx, pi->contentList);
+    pi->contentList = nullptr;
+    fz_drop_display_list(ctx, pi->annotsList);
+    pi->annotsList = nullptr;
+    for (FitzPageImageInfo* img : pi->images) {
+        if (img->image) {
+            fz_drop_image(ctx, img->image);
+            img->image = nullptr;
+        }
+    }
+    PdfDarkModeInvalidatePage(ctx, pi);
+    e->pageCacheBytes -= pi->cacheBytes;
+    e->pageCacheEvictedBytes += pi->cacheBytes;
+    e->pageCacheEvictions++;
+    pi->cacheBytes = 0;
+    pi->cacheEvicted = true;
+}
+
+// pages this far around the visible ones keep their caches
+constexpr int kPageCachePinMargin = 2;
+
+static int CmpPageCacheLastUsed(FzPageInfo* const* a, FzPageInfo* const* b) {
+    u64 ua = (*a)->cacheLastUsed;
+    u64 ub = (*b)->cacheLastUsed;
+    return ua < ub ? -1 : (ua > ub ? 1 : 0);
+}
+
+// Gets the page caches back under budget, least recently used pages first.
+// pageNo (the page being used) and the pages around the viewport (as last told
+// by EngineMupdfWarmupHint) are never evicted. Trims to 3/4 of the budget so
+// that the next page rendered doesn't have to do this again.
+// must be called with pagesLock and renderLock held
+static void TrimPageCaches(EngineMupdf* e, int pageNo) {
+    if (e->pageCacheBytes <= gPageCacheBudget) {
+        return;
+    }
+    auto t = TimeGet();
+    int first = AtomicIntGet(&e->warmupFirstPage);
+    int last = AtomicIntGet(&e->warmupLastPage);
+    Vec<FzPageInfo*> lru;
+    for (FzPageInfo* pi : e->pages) {
+        if (!pi || pi->cacheBytes == 0 || pi->pageNo == pageNo) {
+            continue;
+        }
+        bool nearViewport =
+            first > 0 && pi->pageNo >= first - kPageCachePinMargin && pi->pageNo <= last + kPageCachePinMargin;
+        if (!nearViewport) {
+            lru.Append(pi);
+        }
+    }
+    VecSort(lru, CmpPageCacheLastUsed);
+    i64 target = gPageCacheBudget / 4 * 3;
+    for (FzPageInfo* pi : lru) {
+        if (e->pageCacheBytes <= target) {
+            break;
+        }
+        EvictPageCaches(e, pi);
+    }
+    e->pageCacheEvictMs += TimeSinceInMs(t);
+}
+
 // caller must hold pagesLock and renderLock
 static FzPageInfo* GetFzPageInfoLocked(EngineMupdf* e, int pageNo, bool loadQuick, fz_cookie* cookie) {
     auto* ctx = e->Ctx();
@@ -5423,6 +5668,7 @@ static FzPageInfo* GetFzPageInfoLocked(EngineMupdf* e, int pageNo, bool loadQuic
     }
 
     if (!pageInfo->page) {
+        TraceSpan span("parse page", pageNo);
         fz_try(ctx) {
             pageInfo->page = fz_load_page(ctx, e->_doc, pageIdx);
         }
@@ -5472,6 +5718,9 @@ static FzPageInfo* GetFzPageInfoLocked(EngineMupdf* e, int pageNo, bool loadQuic
     ReportIf(pageInfo->pageNo != pageNo);
 
     pageInfo->fullyLoaded = true;
+    // for the links, auto links and images about to be added
+    pageInfo->elementsNeedRebuilding = true;
+    TraceSpan span("page text and links", pageNo);
 
     fz_stext_page* stext = nullptr;
     fz_var(stext);
@@ -5515,7 +5764,8 @@ static FzPageInfo* GetFzPageInfoLocked(EngineMupdf* e, int pageNo, bool loadQuic
         }
     }
     while (link) {
-        auto* pel = NewLinkDestination(pageNo, ctx, e->_doc, link, nullptr);
+        Arena* a = GetPageElementsArena(&pageInfo->linksArena, "page links");
+        auto* pel = NewLinkDestination(a, pageNo, ctx, e->_doc, link);
         if (pel) {
             // a link that goes somewhere in this document has no URL to show,
             // so show the description the PDF gives it, like other viewers do
@@ -5530,7 +5780,7 @@ static FzPageInfo* GetFzPageInfoLocked(EngineMupdf* e, int pageNo, bool loadQuic
 
     if (e->pdfdoc && pdfpage) {
         fz_try(ctx) {
-            AppendJsMenuLinks(ctx, e->pdfdoc, pdfpage, pageNo, pageInfo->links);
+            AppendJsMenuLinks(ctx, e->pdfdoc, pdfpage, pageNo, pageInfo);
         }
         fz_catch(ctx) {
             fz_report_error(ctx);
@@ -5577,7 +5827,14 @@ FzPageInfo* EngineMupdf::GetFzPageInfo(int pageNo, bool loadQuick, fz_cookie* co
     // page-running operations on this specific page run under per-page lock.
     // pagesLock (held above) serializes concurrent fz_load_page on _doc.
     ScopedMutex ctxScope(&renderLock);
-    return GetFzPageInfoLocked(this, pageNo, loadQuick, cookie);
+    FzPageInfo* res = GetFzPageInfoLocked(this, pageNo, loadQuick, cookie);
+    if (res) {
+        // kept images of a full load count against the budget too
+        res->cacheLastUsed = ++pageCacheClock;
+        UpdatePageCacheBytes(this, res);
+        TrimPageCaches(this, pageNo);
+    }
+    return res;
 }
 
 RectF EngineMupdf::PageMediabox(int pageNo) {
@@ -5651,26 +5908,73 @@ void EngineMupdf::GetPdfPageBoxes(int pageNo, Vec<PdfPageBox>& out) {
     }
 }
 
-// returns a kept reference to the cached "View" display list for the page,
-// building+caching it on first call. Caller must fz_drop_display_list when done.
-// must be called with pi->renderLock held (this both protects pi->displayList
-// and serializes the page-running done by fz_new_display_list_from_page).
-static fz_display_list* GetOrBuildPageDisplayList(FzPageInfo* pi, fz_context* ctx) {
-    if (!pi->displayList) {
-        fz_display_list* list = nullptr;
+// like fz_new_display_list_from_page_contents(), for the rest of what
+// fz_run_page() runs
+static fz_display_list* NewAnnotsDisplayList(fz_context* ctx, fz_page* page) {
+    fz_display_list* list = fz_new_display_list(ctx, fz_bound_page(ctx, page));
+    fz_device* dev = nullptr;
+    fz_var(dev);
+    fz_try(ctx) {
+        dev = fz_new_list_device(ctx, list);
+        fz_run_page_annots(ctx, page, dev, fz_identity, nullptr);
+        fz_run_page_widgets(ctx, page, dev, fz_identity, nullptr);
+        fz_close_device(ctx, dev);
+    }
+    fz_always(ctx) {
+        fz_drop_device(ctx, dev);
+    }
+    fz_catch(ctx) {
+        fz_drop_display_list(ctx, list);
+        fz_rethrow(ctx);
+    }
+    return list;
+}
+
+// returns kept references to the cached "View" display lists for the page,
+// building+caching them on first call (annotsList again after an annotation
+// edit dropped it). Caller must fz_drop_display_list both when done.
+// false if either can't be built. must be called with renderLock held (this
+// both protects the lists and serializes the page-running done to build them)
+static bool GetOrBuildPageDisplayLists(EngineMupdf* e, FzPageInfo* pi, fz_context* ctx, fz_display_list** content,
+                                       fz_display_list** annots) {
+    *content = nullptr;
+    *annots = nullptr;
+    pi->cacheLastUsed = ++e->pageCacheClock;
+    if (pi->contentList && pi->annotsList) {
+        *content = fz_keep_display_list(ctx, pi->contentList);
+        *annots = fz_keep_display_list(ctx, pi->annotsList);
+        return true;
+    }
+    TraceSpan span("build display list", pi->pageNo);
+    auto t = TimeGet();
+    if (!pi->contentList) {
+        fz_try(ctx) {
+            pi->contentList = fz_new_display_list_from_page_contents(ctx, pi->page);
+        }
+        fz_catch(ctx) {
+            fz_report_error(ctx);
+        }
+        if (pi->contentList && pi->cacheEvicted) {
+            pi->cacheEvicted = false;
+            e->pageCacheRebuilds++;
+            e->pageCacheRebuildMs += TimeSinceInMs(t);
+        }
+    }
+    if (!pi->annotsList) {
         fz_try(ctx) {
-            list = fz_new_display_list_from_page(ctx, pi->page);
+            pi->annotsList = NewAnnotsDisplayList(ctx, pi->page);
         }
         fz_catch(ctx) {
             fz_report_error(ctx);
-            list = nullptr;
         }
-        pi->displayList = list;
     }
-    if (!pi->displayList) {
-        return nullptr;
+    UpdatePageCacheBytes(e, pi);
+    if (!pi->contentList || !pi->annotsList) {
+        return false;
     }
-    return fz_keep_display_list(ctx, pi->displayList);
+    *content = fz_keep_display_list(ctx, pi->contentList);
+    *annots = fz_keep_display_list(ctx, pi->annotsList);
+    return true;
 }
 
 // Like fz_new_bbox_device(), but bounds what is actually *visible on the page*,
@@ -5960,17 +6264,19 @@ RectF EngineMupdf::PageContentBox(int pageNo, RenderTarget /*target*/) {
     RectF mediabox = pageInfo->mediabox;
 
     fz_rect pagerect;
-    fz_display_list* keptList = nullptr;
+    fz_display_list* contentList = nullptr;
+    fz_display_list* annotsList = nullptr;
+    bool ok;
     {
-        // Hold per-page lock briefly: page bounds + (re-)acquire cached display list.
-        // docLock as well - see the comment in RenderPage: building the list runs
+        // Hold per-page lock briefly: page bounds + (re-)acquire cached display lists.
+        // docLock as well - see the comment in RenderPage: building the lists runs
         // the page's annotations, which a concurrent annotation edit can free.
         ScopedMutex scope(&renderLock);
         ScopedRecursiveMutex docScope(&docLock);
         pagerect = fz_bound_page(ctx, pageInfo->page);
-        keptList = GetOrBuildPageDisplayList(pageInfo, ctx);
+        ok = GetOrBuildPageDisplayLists(this, pageInfo, ctx, &contentList, &annotsList);
     }
-    if (!keptList) {
+    if (!ok) {
         return mediabox;
     }
 
@@ -5981,12 +6287,14 @@ RectF EngineMupdf::PageContentBox(int pageNo, RenderTarget /*target*/) {
     fz_var(dev);
     fz_try(ctx) {
         dev = FzNewContentBBoxDevice(ctx, &rect, pagerect);
-        fz_run_display_list(ctx, keptList, dev, fz_identity, pagerect, &fzcookie);
+        fz_run_display_list(ctx, contentList, dev, fz_identity, pagerect, &fzcookie);
+        fz_run_display_list(ctx, annotsList, dev, fz_identity, pagerect, &fzcookie);
         fz_close_device(ctx, dev);
     }
     fz_always(ctx) {
         fz_drop_device(ctx, dev);
-        fz_drop_display_list(ctx, keptList);
+        fz_drop_display_list(ctx, contentList);
+        fz_drop_display_list(ctx, annotsList);
     }
     fz_catch(ctx) {
         fz_report_error(ctx);
@@ -6285,6 +6593,7 @@ void EngineMupdf::GetBitmapRecolorSkipRects(int pageNo, float zoom, int rotation
     if (!pageInfo->contentImagesCollected) {
         fz_context* ctx = Ctx();
         FzCollectImagesFromPageContent(ctx, pageNo, pageInfo, pageInfo->page, nullptr);
+        UpdatePageCacheBytes(this, pageInfo);
         pageInfo->contentImagesCollected = true;
         pageInfo->darkLegacySkipHash = 0;
     }
@@ -6390,6 +6699,7 @@ static void MarkTransparentBackdropPixmap(Pixmap* pixmap, bool transparentBackdr
 Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
     auto* ctx = Ctx();
     auto pageNo = args.pageNo;
+    TraceSpan span("render page", pageNo);
 
     fz_cookie* fzcookie = nullptr;
     FitzAbortCookie* cookie = nullptr;
@@ -6420,14 +6730,15 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
     // like the AA level, min line width is per-thread-context state
     CadMinLineWidthScope cadMinLineWidth(ctx, zoom, CadEnhanceActive(), cadHairlineVector);
 
-    // The "View" rendering (no Print, no hideAnnotations) is what
-    // fz_new_display_list_from_page produces; safe to cache and re-run lock-free.
+    // The "View" rendering (no Print, no hideAnnotations) is what the cached
+    // content + annotation display lists replay; safe to cache and re-run lock-free.
     bool useCache = (args.target == RenderTarget::View) && !hideAnnotations;
 
     fz_rect pRect;
     fz_matrix ctm;
     fz_irect ibounds;
-    fz_display_list* keptList = nullptr;
+    fz_display_list* contentList = nullptr;
+    fz_display_list* annotsList = nullptr;
 
     {
         // Hold per-page lock while we touch the page (bounds, optional list build).
@@ -6448,11 +6759,10 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
         ibounds = fz_round_rect(fz_transform_rect(pRect, ctm));
 
         if (useCache) {
-            keptList = GetOrBuildPageDisplayList(pageInfo, ctx);
+            GetOrBuildPageDisplayLists(this, pageInfo, ctx, &contentList, &annotsList);
         }
     }
 
-    fz_colorspace* csRgb = fz_device_rgb(ctx);
     fz_pixmap* pix = nullptr;
     fz_device* dev = nullptr;
     Pixmap* pixmap = nullptr;
@@ -6461,14 +6771,17 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
     fz_var(pix);
     fz_var(pixmap);
 
-    if (keptList) {
+    if (contentList) {
         // Display-list replay still decodes shared images (JBIG2 etc.) under
         // the hood, and mupdf's image store races on concurrent decode of the
         // same image -- crashes seen in template_image_compose_opt with use-
         // after-free. Hold renderLock to serialize.
         ScopedMutex rls(&renderLock);
+        // includes dark mode recoloring, which happens during the replay.
+        // Not inside fz_try: a throw would skip the destructor
+        TraceSpan rasterSpan("rasterize", pageNo);
         fz_try(ctx) {
-            pix = fz_new_pixmap_with_bbox(ctx, csRgb, ibounds, nullptr, 1);
+            pix = NewPagePixmap(ctx, ibounds, &pixmap);
             bool objectLevelDark = args.darkProfile && DarkModeProfileUsesObjectLevel(args.darkProfile);
             ClearRenderedPagePixmap(ctx, pix, args, objectLevelDark);
             dev = fz_new_draw_device(ctx, ctm, pix);
@@ -6477,8 +6790,10 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
             }
             DarkModeReplayState replayState{};
             if (objectLevelDark && pdfdoc) {
-                DarkModePageAnalysis* analysis =
-                    PdfDarkModeGetOrBuildAnalysis(ctx, pageInfo, keptList, args.darkProfile->hash, darkModeEngineCache);
+                // analysis only covers the content: it stays valid across annotation
+                // edits and images in annotations fall through to "preserve"
+                DarkModePageAnalysis* analysis = PdfDarkModeGetOrBuildAnalysis(ctx, pageInfo, contentList,
+                                                                               args.darkProfile->hash, darkModeEngineCache);
                 if (analysis) {
                     dev = PdfDarkModeWrapDevice(ctx, dev, analysis, &args.darkProfile->palette, &replayState,
                                                 darkModeEngineCache, args.darkProfile->hash,
@@ -6491,12 +6806,13 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
                 opts.hairlineVector = cadHairlineVector;
                 dev = PdfCadEnhanceWrapDevice(ctx, dev, opts);
             }
-            fz_run_display_list(ctx, keptList, dev, fz_identity, pRect, fzcookie);
+            fz_run_display_list(ctx, contentList, dev, fz_identity, pRect, fzcookie);
+            fz_run_display_list(ctx, annotsList, dev, fz_identity, pRect, fzcookie);
             fz_close_device(ctx, dev);
             if (CadEnhanceActive() && cadRasterDominant) {
                 PdfCadEnhancePixmap(ctx, pix, zoom, true);
             }
-            pixmap = NewPixmapFromFzPixmap(ctx, pix, args.transparentBackdrop);
+            pixmap = PagePixmapResult(ctx, pix, pixmap, args.transparentBackdrop, &args.bytesCopied);
             MarkTransparentBackdropPixmap(pixmap, args.transparentBackdrop);
         }
         fz_always(ctx) {
@@ -6506,7 +6822,8 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
             if (pix) {
                 fz_drop_pixmap(ctx, pix);
             }
-            fz_drop_display_list(ctx, keptList);
+            fz_drop_display_list(ctx, contentList);
+            fz_drop_display_list(ctx, annotsList);
         }
         fz_catch(ctx) {
             fz_report_error(ctx);
@@ -6517,7 +6834,7 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
     }
 
     // Fallback: Print or hideAnnotations (each needs different content/usage,
-    // not what the cached display list captured), or display-list construction
+    // not what the cached display lists captured), or display-list construction
     // failed. Run the page directly under per-page lock.
     ScopedMutex cs(&renderLock);
 
@@ -6529,7 +6846,7 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
     if (pdfdoc) {
         fz_try(ctx) {
             pdfpage = pdf_page_from_fz_page(ctx, page);
-            pix = fz_new_pixmap_with_bbox(ctx, csRgb, ibounds, nullptr, 1);
+            pix = NewPagePixmap(ctx, ibounds, &pixmap);
             ClearRenderedPagePixmap(ctx, pix, args, false);
             dev = fz_new_draw_device(ctx, ctm, pix);
             if (disableAntiAlias) {
@@ -6545,7 +6862,7 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
             if (CadEnhanceActive() && cadRasterDominant) {
                 PdfCadEnhancePixmap(ctx, pix, zoom, true);
             }
-            pixmap = NewPixmapFromFzPixmap(ctx, pix, args.transparentBackdrop);
+            pixmap = PagePixmapResult(ctx, pix, pixmap, args.transparentBackdrop, &args.bytesCopied);
             MarkTransparentBackdropPixmap(pixmap, args.transparentBackdrop);
         }
         fz_always(ctx) {
@@ -6561,7 +6878,7 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
         }
     } else {
         fz_try(ctx) {
-            pix = fz_new_pixmap_with_bbox(ctx, csRgb, ibounds, nullptr, 1);
+            pix = NewPagePixmap(ctx, ibounds, &pixmap);
             ClearRenderedPagePixmap(ctx, pix, args, false);
             dev = fz_new_draw_device(ctx, ctm, pix);
             if (disableAntiAlias) {
@@ -6570,7 +6887,7 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
             fz_run_page_contents(ctx, page, dev, fz_identity, nullptr);
             fz_close_device(ctx, dev);
             fz_drop_device(ctx, dev);
-            pixmap = NewPixmapFromFzPixmap(ctx, pix, args.transparentBackdrop);
+            pixmap = PagePixmapResult(ctx, pix, pixmap, args.transparentBackdrop, &args.bytesCopied);
             MarkTransparentBackdropPixmap(pixmap, args.transparentBackdrop);
         }
         fz_always(ctx) {
@@ -6589,6 +6906,8 @@ Pixmap* EngineMupdf::RenderPage(RenderPageArgs& args) {
 // don't delete the result
 IPageElement* EngineMupdf::GetElementAtPos(int pageNo, PointF pt) {
     FzPageInfo* pageInfo = GetFzPageInfoCanFail(pageNo);
+    // like TryGetElements(): the elements are rebuilt under pagesLock
+    ScopedRecursiveMutex scope(&pagesLock);
     return FzGetElementAtPos(pageInfo, pt);
 }
 
@@ -6600,6 +6919,7 @@ Vec<IPageElement*> EngineMupdf::GetElements(int pageNo) {
         return Vec<IPageElement*>();
     }
 
+    ScopedRecursiveMutex scope(&pagesLock);
     BuildElementsInfo(pageInfo);
     return pageInfo->allElements;
 }
@@ -6916,6 +7236,7 @@ static PageText ExtractPageTextLocked(EngineMupdf* e, FzPageInfo* pageInfo) {
     // runs the whole page, annotations included, and text extraction happens on
     // a background thread while the UI thread can be editing those annotations
     ScopedRecursiveMutex docScope(&e->docLock);
+    TraceSpan span("extract text", pageInfo->pageNo);
     fz_stext_page* stext = nullptr;
     fz_var(stext);
     fz_stext_options opts = NewTextPageOptions();
@@ -8295,6 +8616,220 @@ void EngineMupdfStartLoadAllAnnotations(EngineBase* engine, const Vec<int>& firs
     SafeCloseThreadHandle(&th);
 }
 
+// Background warm-up: while the user isn't scrolling, fully load (links,
+// annotations with their synthesized appearance streams, auto-links, image
+// positions) the pages just past the viewport, so the first paint of a page
+// doesn't pay for pdf_load_page and link resolution on the render thread.
+// Mediaboxes and page labels are already read up front in FinishLoading().
+constexpr int kWarmupIdleMs = 200;
+constexpr int kWarmupPagesAhead = 24;
+constexpr int kWarmupPagesBehind = 4;
+
+enum class WarmupStep {
+    Busy,
+    Loaded,
+    Done,
+};
+
+// next page near [first, last] that isn't fully loaded, in reading order:
+// the visible pages, then the ones after them, then a few before
+// caller must hold pagesLock
+static int NextPageToWarmupLocked(EngineMupdf* e, int first, int last) {
+    int end = std::min(last + kWarmupPagesAhead, e->pageCount);
+    for (int pageNo = first; pageNo <= end; pageNo++) {
+        FzPageInfo* pi = e->pages[pageNo - 1];
+        if (pi && !pi->fullyLoaded) {
+            return pageNo;
+        }
+    }
+    int start = std::max(first - kWarmupPagesBehind, 1);
+    for (int pageNo = first - 1; pageNo >= start; pageNo--) {
+        FzPageInfo* pi = e->pages[pageNo - 1];
+        if (pi && !pi->fullyLoaded) {
+            return pageNo;
+        }
+    }
+    return 0;
+}
+
+// loads at most one page; never waits for a lock a render or text extraction
+// is holding (that's not idle time)
+static WarmupStep WarmupOnePage(EngineMupdf* e, int first, int last) {
+    if (!e->pagesLock.TryLock()) {
+        return WarmupStep::Busy;
+    }
+    if (!e->renderLock.TryLock()) {
+        e->pagesLock.Unlock();
+        return WarmupStep::Busy;
+    }
+    // loading fully runs the page (stext), which reads its annotations
+    if (!e->docLock.TryLock()) {
+        e->renderLock.Unlock();
+        e->pagesLock.Unlock();
+        return WarmupStep::Busy;
+    }
+    int pageNo = NextPageToWarmupLocked(e, first, last);
+    FzPageInfo* pageInfo = pageNo > 0 ? GetFzPageInfoLocked(e, pageNo, false, nullptr) : nullptr;
+    if (pageInfo) {
+        pageInfo->cacheLastUsed = ++e->pageCacheClock;
+        UpdatePageCacheBytes(e, pageInfo);
+    }
+    e->docLock.Unlock();
+    e->renderLock.Unlock();
+    e->pagesLock.Unlock();
+    return pageNo > 0 ? WarmupStep::Loaded : WarmupStep::Done;
+}
+
+// sleeps in short slices so closing the document doesn't wait for us
+static bool WarmupSleep(EngineMupdf* e, int ms) {
+    while (ms > 0) {
+        if (AtomicIntGet(&e->warmupCancel)) {
+            return false;
+        }
+        int n = std::min(ms, 50);
+        SleepInMs(n);
+        ms -= n;
+    }
+    return !AtomicIntGet(&e->warmupCancel);
+}
+
+static void WarmupThread(EngineMupdf* e) {
+    int nLoaded = 0;
+    auto t = TimeGet();
+    while (!AtomicIntGet(&e->warmupCancel)) {
+        // only run after the viewport has been still for a while
+        int seq = AtomicIntGet(&e->warmupHintSeq);
+        if (!WarmupSleep(e, kWarmupIdleMs)) {
+            break;
+        }
+        if (seq != AtomicIntGet(&e->warmupHintSeq)) {
+            continue;
+        }
+        int first = AtomicIntGet(&e->warmupFirstPage);
+        int last = AtomicIntGet(&e->warmupLastPage);
+        WarmupStep step = WarmupStep::Loaded;
+        while (step == WarmupStep::Loaded && !AtomicIntGet(&e->warmupCancel)) {
+            if (seq != AtomicIntGet(&e->warmupHintSeq)) {
+                // scrolled: yield to the renders that will follow
+                break;
+            }
+            step = WarmupOnePage(e, first, last);
+            if (step == WarmupStep::Loaded) {
+                nLoaded++;
+            }
+        }
+        if (step == WarmupStep::Done && seq == AtomicIntGet(&e->warmupHintSeq)) {
+            AtomicIntSet(&e->warmupDoneFirstPage, first);
+            AtomicIntSet(&e->warmupDoneLastPage, last);
+            break;
+        }
+    }
+    e->ReleaseTextExtractionThreadContext();
+    if (nLoaded > 0) {
+        logf("WarmupThread: loaded %d pages in %.2f ms\n", nLoaded, TimeSinceInMs(t));
+    }
+    AtomicIntSet(&e->warmupRunning, 0);
+    AtomicIntDec(&gDangerousThreadCount);
+    e->Release();
+}
+
+// called by DisplayModel whenever the visible pages change; (re)starts the
+// warm-up thread, which waits for the scrolling to stop before loading
+void EngineMupdfWarmupHint(EngineBase* engine, int firstVisible, int lastVisible) {
+    EngineMupdf* e = AsEngineMupdf(engine);
+    if (!e || AtomicIntGet(&e->warmupCancel)) {
+        return;
+    }
+    if (firstVisible < 1 || lastVisible < firstVisible || lastVisible > e->pageCount) {
+        return;
+    }
+    AtomicIntSet(&e->warmupFirstPage, firstVisible);
+    AtomicIntSet(&e->warmupLastPage, lastVisible);
+    AtomicIntInc(&e->warmupHintSeq);
+    if (AtomicIntGet(&e->warmupRunning)) {
+        return;
+    }
+    bool done = firstVisible == AtomicIntGet(&e->warmupDoneFirstPage) &&
+                lastVisible == AtomicIntGet(&e->warmupDoneLastPage);
+    if (done) {
+        return;
+    }
+    AtomicIntSet(&e->warmupRunning, 1);
+    e->AddRef();
+    AtomicIntInc(&gDangerousThreadCount);
+    auto fn = MkFunc0(WarmupThread, e);
+    ThreadHandle th = StartThread(fn, StrL("PageWarmup"));
+    if (!th) {
+        AtomicIntDec(&gDangerousThreadCount);
+        AtomicIntSet(&e->warmupRunning, 0);
+        e->Release();
+        return;
+    }
+    SafeCloseThreadHandle(&th);
+}
+
+// page cache state for the cache-info debug window, empty if not a mupdf engine
+TempStr EngineMupdfPageCacheInfoTemp(EngineBase* engine) {
+    EngineMupdf* e = AsEngineMupdf(engine);
+    if (!e) {
+        return {};
+    }
+    TempStr name = path::GetBaseNameTemp(e->FilePath());
+    // also refreshed from render threads: never wait for a render
+    if (!e->pagesLock.TryLock()) {
+        return fmt("%s: page caches busy\r\n", name);
+    }
+    if (!e->renderLock.TryLock()) {
+        e->pagesLock.Unlock();
+        return fmt("%s: page caches busy\r\n", name);
+    }
+    int nLoaded = 0;
+    int nFullyLoaded = 0;
+    int nCached = 0;
+    for (FzPageInfo* pi : e->pages) {
+        if (!pi || !pi->page) {
+            continue;
+        }
+        nLoaded++;
+        nFullyLoaded += pi->fullyLoaded ? 1 : 0;
+        nCached += pi->cacheBytes > 0 ? 1 : 0;
+    }
+    const double mb = 1024.0 * 1024.0;
+    TempStr res = fmt("%s: %d of %d pages loaded (%d fully), %d with caches: %.2f MB of %.0f MB budget\r\n"
+                      "  evicted %d times (%.2f MB) in %.1f ms, %d pages re-recorded after eviction in %.1f ms\r\n",
+                      name, nLoaded, e->pageCount, nFullyLoaded, nCached, e->pageCacheBytes / mb, gPageCacheBudget / mb,
+                      e->pageCacheEvictions, e->pageCacheEvictedBytes / mb, e->pageCacheEvictMs, e->pageCacheRebuilds,
+                      e->pageCacheRebuildMs);
+    e->renderLock.Unlock();
+    e->pagesLock.Unlock();
+    return res;
+}
+
+bool EngineMupdfGetPageCacheStats(EngineBase* engine, EngineMupdfCacheStats* out) {
+    EngineMupdf* e = AsEngineMupdf(engine);
+    if (!e) {
+        return false;
+    }
+    // asked from the UI thread: don't wait for a render to finish
+    if (!e->renderLock.TryLock()) {
+        return false;
+    }
+    out->bytes = e->pageCacheBytes;
+    out->evictions = e->pageCacheEvictions;
+    out->evictedBytes = e->pageCacheEvictedBytes;
+    out->rebuilds = e->pageCacheRebuilds;
+    e->renderLock.Unlock();
+    return true;
+}
+
+void EngineMupdfCancelWarmup(EngineBase* engine) {
+    EngineMupdf* e = AsEngineMupdf(engine);
+    if (!e) {
+        return;
+    }
+    AtomicIntSet(&e->warmupCancel, 1);
+}
+
 bool EngineMupdfHasUnsavedAnnotations(EngineBase* engine) {
     EngineMupdf* epdf = AsEngineMupdf(engine);
     if (!epdf || !epdf->pdfdoc) {
@@ -8630,6 +9165,12 @@ NO_INLINE void MarkNotificationAsModified(EngineMupdf* e, Annotation* annot, Ann
     } else {
         ReportIf(change != AnnotationChange::Modify);
     }
+    // annot->bounds is still what was last drawn (setters don't refresh it),
+    // GetBounds() updates it to the new state
+    RectF damage = annot->bounds;
+    if (change != AnnotationChange::Remove) {
+        damage = damage.Union(GetBounds(annot));
+    }
     {
         auto* ctx = e->Ctx();
         ScopedRecursiveMutex ctxScope(&e->docLock);
@@ -8637,16 +9178,51 @@ NO_INLINE void MarkNotificationAsModified(EngineMupdf* e, Annotation* annot, Ann
     }
     pageInfo->elementsNeedRebuilding = true;
 
-    // cached display list captured the old annotations; drop it so the next
-    // render rebuilds with the new state.
+    // changing a form field can change the appearance of other fields (radio
+    // button groups, calculated fields), so repaint the whole page for those.
+    // a line or an ink stroke can have an empty bounding box
+    if (annot->type == AnnotationType::Widget || damage.IsEmpty()) {
+        damage = pageInfo->mediabox;
+    } else {
+        // anti-aliased edges spill into the neighboring pixels
+        damage.Inflate(2.f, 2.f);
+    }
+    if (pageInfo->annotsDamage.IsEmpty()) {
+        e->annotsDamagedPages.Append(pageNo);
+    }
+    pageInfo->annotsDamage = pageInfo->annotsDamage.Union(damage);
+
+    // cached annotation display list captured the old annotations; drop it so
+    // the next render re-records it. The content list is unaffected.
     {
         auto* ctx = e->Ctx();
         ScopedMutex rl(&e->renderLock);
-        if (pageInfo->displayList) {
-            fz_drop_display_list(ctx, pageInfo->displayList);
-            pageInfo->displayList = nullptr;
+        fz_drop_display_list(ctx, pageInfo->annotsList);
+        pageInfo->annotsList = nullptr;
+        UpdatePageCacheBytes(e, pageInfo);
+    }
+}
+
+// Pages (and the area of each, in page coordinates) whose annotations changed
+// since the last call. Lets the UI re-render only the tiles an annotation edit
+// touched instead of every visible page.
+bool EngineMupdfTakeAnnotationDamage(EngineBase* engine, Vec<int>& pageNos, Vec<RectF>& rects) {
+    EngineMupdf* epdf = AsEngineMupdf(engine);
+    if (!epdf) {
+        return false;
+    }
+    ScopedRecursiveMutex scope(&epdf->pagesLock);
+    for (int pageNo : epdf->annotsDamagedPages) {
+        FzPageInfo* pageInfo = epdf->pages[pageNo - 1];
+        if (!pageInfo || pageInfo->annotsDamage.IsEmpty()) {
+            continue;
         }
+        pageNos.Append(pageNo);
+        rects.Append(pageInfo->annotsDamage);
+        pageInfo->annotsDamage = {};
     }
+    epdf->annotsDamagedPages.Reset();
+    return len(pageNos) > 0;
 }
 
 // creates Annotation wrapper around pdf_annot
@@ -17,6 +17,14 @@ struct FitzPageImageInfo {
     ~FitzPageImageInfo() { delete imageElement; }
 };
 
+// hit-testing index of a page's elements (see FzGetElementAtPos). els[i] has
+// rects.rects[i]; both are in the order they're tested in (links, autoLinks,
+// comments, images)
+struct FzPageElementsIndex {
+    Vec<IPageElement*> els;
+    RectIndex rects;
+};
+
 struct FzPageInfo {
     int pageNo = 0; // 1-based
     fz_page* page = nullptr;
@@ -39,7 +47,15 @@ struct FzPageInfo {
     // comments are made out of annotations
     Vec<IPageElement*> comments;
 
+    // links and autoLinks (with their destinations) are allocated in
+    // linksArena, comments in commentsArena, which is re-created when they're
+    // rebuilt. Both are created on first use and freed, with everything in
+    // them, by FreePageLinks() / FreePageComments()
+    Arena* linksArena = nullptr;
+    Arena* commentsArena = nullptr;
+
     Vec<IPageElement*> allElements;
+    FzPageElementsIndex elementsIndex;
     bool elementsNeedRebuilding = true;
 
     RectF mediabox;
@@ -55,7 +71,22 @@ struct FzPageInfo {
     // not -- shared images (notably JBIG2 with shared dictionaries) trigger
     // races inside mupdf's image store on concurrent decode. So renderLock
     // is engine-wide, not per-page.
-    fz_display_list* displayList = nullptr;
+    // Recorded as two lists, page content and annotations + widgets (replayed
+    // in that order, like fz_run_page), so that an annotation edit only has to
+    // re-record the (usually tiny) annotsList, not a heavy scanned/vector page.
+    fz_display_list* contentList = nullptr;
+    fz_display_list* annotsList = nullptr;
+    // page area whose annotations changed since the UI last re-rendered it
+    // (union of old and new bounds), see EngineMupdfTakeAnnotationDamage()
+    RectF annotsDamage;
+
+    // bytes held by contentList, annotsList and images[]->image, counted in
+    // EngineMupdf::pageCacheBytes. protected by renderLock
+    i64 cacheBytes = 0;
+    // EngineMupdf::pageCacheClock when the page was last loaded or rendered
+    u64 cacheLastUsed = 0;
+    // caches were evicted; re-recording the display list is the eviction's cost
+    bool cacheEvicted = false;
 
     // smart dark mode (PdfDarkMode*.cpp): cached per-page analysis for the
     // object-level renderer, freed via PdfDarkModeInvalidatePage
@@ -185,6 +216,15 @@ class EngineMupdf : public EngineBase {
     bool annotLoadDone = false;
     Func0 annotLoadDoneCb;
     Vec<int> annotLoadFirstPages;
+    // background warm-up of pages near the viewport (EngineMupdfWarmupHint)
+    AtomicInt warmupCancel = 0;
+    AtomicInt warmupRunning = 0;
+    AtomicInt warmupHintSeq = 0;
+    AtomicInt warmupFirstPage = 0;
+    AtomicInt warmupLastPage = 0;
+    // visible range whose neighborhood the last warm-up finished loading
+    AtomicInt warmupDoneFirstPage = 0;
+    AtomicInt warmupDoneLastPage = 0;
     TocItem* pendingHeadingToc = nullptr;
     int pendingHeadingTocIdCounter = 0;
 
@@ -194,6 +234,20 @@ class EngineMupdf : public EngineBase {
     // used to track "dirty" state of annotations. not perfect because if we add and delete
     // the same annotation, we should be back to 0
     bool modifiedAnnotations = false;
+    // pages with a non-empty FzPageInfo::annotsDamage. protected by pagesLock
+    Vec<int> annotsDamagedPages;
+
+    // per-page caches (display lists, kept images, dark-mode analysis) are
+    // kept within a budget (EngineMupdfSetPageCacheBudget) by evicting those
+    // of the least recently used pages away from the viewport.
+    // protected by renderLock; evicting also needs pagesLock (images)
+    i64 pageCacheBytes = 0;
+    u64 pageCacheClock = 0;
+    int pageCacheEvictions = 0;
+    i64 pageCacheEvictedBytes = 0;
+    double pageCacheEvictMs = 0;
+    int pageCacheRebuilds = 0;
+    double pageCacheRebuildMs = 0;
 
     // smart dark mode: engine-level image feature/processed caches
     DarkModeEngineCache* darkModeEngineCache = nullptr;
@@ -6,6 +6,7 @@
 #include "base/File.h"
 #include "base/GdiPlusUtil.h"
 #include "base/Pixmap.h"
+#include "base/PixmapResize.h"
 
 #include "Settings.h"
 #include "ImageReader.h"
@@ -68,6 +69,64 @@ static bool PixmapIsEmpty(const Pixmap* px) {
     return !px || px->width <= 0 || px->height <= 0 || !px->data;
 }
 
+// The home page draws thumbnails at a DPI-dependent size (and smaller in
+// the list view). Resized copies are made once with ResizePixmap() instead of
+// being stretched by the blit on every paint. Only used on the UI thread.
+struct ScaledThumbnail {
+    FileState* fs = nullptr;
+    const Pixmap* src = nullptr;
+    Pixmap* scaled = nullptr;
+};
+
+constexpr int kMaxScaledThumbnails = 48;
+static Vec<ScaledThumbnail> gScaledThumbnails;
+
+// must be called whenever fs->thumbnail is set: the old one could've been
+// freed and its address re-used by the new one
+static void DropScaledThumbnails(FileState* fs) {
+    for (int i = len(gScaledThumbnails) - 1; i >= 0; i--) {
+        if (gScaledThumbnails[i].fs == fs) {
+            FreePixmap(gScaledThumbnails[i].scaled);
+            gScaledThumbnails.RemoveAt(i);
+        }
+    }
+}
+
+void FreeScaledThumbnails() {
+    for (auto& st : gScaledThumbnails) {
+        FreePixmap(st.scaled);
+    }
+    gScaledThumbnails.Reset();
+}
+
+// fs->thumbnail resized to size, or fs->thumbnail itself if that's not needed
+// or possible. The result is owned by the cache / fs and valid until the
+// thumbnail changes
+Pixmap* GetThumbnailForSize(FileState* fs, Size size) {
+    Pixmap* thumb = LoadThumbnail(fs);
+    if (!thumb || size.IsEmpty() || (thumb->width == size.dx && thumb->height == size.dy)) {
+        return thumb;
+    }
+    for (auto& st : gScaledThumbnails) {
+        if (st.fs == fs && st.src == thumb && st.scaled->width == size.dx && st.scaled->height == size.dy) {
+            return st.scaled;
+        }
+    }
+    // Native (palette) thumbnails can't be read, the blit stretches those
+    Pixmap* scaled = ResizePixmap(thumb, size.dx, size.dy);
+    if (!scaled) {
+        return thumb;
+    }
+    // an opaque BGRA8 thumbnail stays a plain blit
+    scaled->hasAlpha = thumb->hasAlpha;
+    if (len(gScaledThumbnails) >= kMaxScaledThumbnails) {
+        FreePixmap(gScaledThumbnails[0].scaled);
+        gScaledThumbnails.RemoveAt(0);
+    }
+    gScaledThumbnails.Append({fs, thumb, scaled});
+    return scaled;
+}
+
 Pixmap* LoadThumbnail(FileState* fs) {
     if (!fs || len(fs->filePath) == 0) {
         return nullptr;
@@ -91,6 +150,7 @@ Pixmap* LoadThumbnail(FileState* fs) {
         return nullptr;
     }
 
+    DropScaledThumbnails(fs);
     fs->thumbnail = px;
     return fs->thumbnail;
 }
@@ -126,6 +186,7 @@ void SetThumbnail(FileState* fs, Pixmap* bmp) {
         FreePixmap(bmp);
         return;
     }
+    DropScaledThumbnails(fs);
     FreePixmap(fs->thumbnail);
     fs->thumbnail = bmp;
     SaveThumbnail(fs);
@@ -9,6 +9,8 @@ struct Pixmap;
 struct FileState;
 
 Pixmap* LoadThumbnail(FileState* fs);
+Pixmap* GetThumbnailForSize(FileState* fs, Size size);
+void FreeScaledThumbnails();
 bool HasThumbnail(FileState* fs);
 void SetThumbnail(FileState* fs, Pixmap* bmp);
 void SaveThumbnail(FileState* fs);
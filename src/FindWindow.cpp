@@ -25,6 +25,7 @@
 #include "ProgressUpdateUI.h"
 #include "TextSelection.h"
 #include "TextSearch.h"
+#include "TextSearchPattern.h"
 #include "DisplayModel.h"
 #include "SumatraPDF.h"
 #include "MainWindow.h"
@@ -181,6 +182,9 @@ struct FindWindowWnd : WindowBase {
     VirtIconButton* btns[5]{};
     VirtListBox* results = nullptr;
     StrVec filterWords; // search term(s) to highlight in snippets
+    // a /pattern/ search: each row highlights its own match instead
+    bool highlightSnippetMatch = false;
+    StrVec snippetMatchWord; // reused for the match of the row being drawn
     Vec<u8> hlScratch;  // reused highlight mask for DrawMaybeHighlightedText
     // coalesce rapid list selections: only the latest deferred navigation runs
     AtomicInt pendingNavEpoch = 0;
@@ -550,8 +554,9 @@ void FindWindowWnd::RefreshResults(bool allowNavigation) {
     if (len(term) == 0) {
         term = win->findEdit ? win->findEdit->GetTextTemp() : TempStr{};
     }
-    if (len(term) > 0) {
-        filterWords.Append(term);
+    highlightSnippetMatch = len(SearchPatternFromText(term)) > 0;
+    if (len(term) > 0 && !highlightSnippetMatch) {
+        filterWords.Append(SearchLiteralFromText(term));
     }
     results->SetModel(results->model); // the model is live; re-read it
     // keep a result selected so it's visible as you type and Next/Prev have a
@@ -641,8 +646,18 @@ void FindWindowWnd::DrawResultItem(VirtListBox::DrawItemEvent* ev) {
         // number column when the floating window is narrow (issue #5736); it
         // nests, so the outer row clip stays in effect afterwards
         gfx->PushClip(rcSnippet);
-        DrawMaybeHighlightedText(gfx, rcSnippet, fm.snippet, filterWords, hlScratch, colBg, false,
-                                 win->findMatchWholeWord, drawFmt, lb->font, colText);
+        const StrVec* words = &filterWords;
+        bool wholeWord = win->findMatchWholeWord;
+        if (highlightSnippetMatch) {
+            snippetMatchWord.Reset();
+            if (fm.snippetMatchLen > 0) {
+                snippetMatchWord.Append(Str(fm.snippet.s + fm.snippetMatchStart, fm.snippetMatchLen));
+            }
+            words = &snippetMatchWord;
+            wholeWord = false;
+        }
+        DrawMaybeHighlightedText(gfx, rcSnippet, fm.snippet, *words, hlScratch, colBg, false, wholeWord, drawFmt,
+                                 lb->font, colText);
         gfx->PopClip();
     }
 
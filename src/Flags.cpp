@@ -44,7 +44,7 @@ enum class Arg {
     DDE = 76, Pwd = 77, EngineDump = 78, SetColorRange = 79,
     UpgradeFrom = 80, ForTesting = 81, QuickLook = 82, QuickLookAgent = 83,
     WindowPos = 84, DumpExif = 85, DumpChm = 86, Control = 87,
-    UnitTests = 88,
+    UnitTests = 88, Trace = 89,
 };
 
 static SeqStrings gArgNames =
@@ -70,7 +70,7 @@ static SeqStrings gArgNames =
     "dde\0" "pwd\0" "engine-dump\0" "set-color-range\0"
     "upgrade-from\0" "for-testing\0" "quicklook\0" "quicklook-agent\0"
     "window-pos\0" "dump-exif\0" "dump-chm\0" "dbg-control\0"
-    "unit-tests\0";
+    "unit-tests\0" "trace\0";
 // clang-format on
 // @gen-end flags
 
@@ -622,6 +622,10 @@ void ParseFlags(Arena* a, WStr cmdLine, Flags& i, Str toolNames) {
             i.controlPipeName = str::Dup(a, param);
             continue;
         }
+        if (arg == Arg::Trace) {
+            i.tracePath = str::Dup(a, param);
+            continue;
+        }
         if ((arg == Arg::ForwardSearch1 || arg == Arg::ForwardSearch2) && args.AdditionalParam(1)) {
             // -forward-search is for consistency with -inverse-search
             // -fwdsearch is for consistency with -fwdsearch-*
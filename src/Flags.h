@@ -96,6 +96,7 @@ struct Flags {
     // a window a quarter of the screen renders and captures four times faster
     Rect windowPos;
     Str controlPipeName; // -dbg-control <named-pipe>
+    Str tracePath;       // -trace <file.json>, spans for ui.perfetto.dev
     bool testRenderPage = false;
     bool testExtractPage = false;
     int testPageNo = 0;
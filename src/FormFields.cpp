@@ -135,7 +135,7 @@ void CommitFormFieldEdit(bool save) {
     if (win) {
         HwndSetFocus(win->hwndCanvas);
         if (changed) {
-            MainWindowRerender(win);
+            MainWindowRerenderAnnotations(win);
             // refresh the tab's unsaved-changes (red dot) indicator and toolbar
             // state now, otherwise it only updates on the next repaint trigger
             // (tab switch, resize)
@@ -3,7 +3,10 @@
 
 #include "base/Base.h"
 #include "base/Pixmap.h"
+#include "base/File.h"
+#include "base/AppendStore.h"
 #include "base/SettingsUtil.h"
+#include "base/SettingsJournal.h"
 
 #define INCLUDE_SETTINGSSTRUCTS_METADATA
 #include "Settings.h"
@@ -186,6 +189,32 @@ Str SerializeGlobalPrefs(GlobalPrefs* prefs, Str prevData) {
     return serialized;
 }
 
+// GlobalPrefs as SerializeGlobalPrefs() writes them, minus FileStates (and
+// without unknown fields from the settings file)
+// caller has to free()
+Str SerializeGlobalPrefsWithoutFileStates(GlobalPrefs* prefs) {
+    Vec<FileState*>* fileStates = prefs->fileStates;
+    Vec<FileState*> none;
+    prefs->fileStates = &none;
+    Str serialized = SerializeStruct(&gGlobalPrefsInfo, prefs);
+    prefs->fileStates = fileStates;
+    return serialized;
+}
+
+static Str GetFileStateJournalKey(const void* item) {
+    return ((const FileState*)item)->filePath;
+}
+
+static void FreeFileStateJournalItem(void* item) {
+    DeleteFileState((FileState*)item);
+}
+
+void InitFileStatesJournal(SettingsJournal* j) {
+    j->itemInfo = &gFileStateInfo;
+    j->getKey = GetFileStateJournalKey;
+    j->freeItem = FreeFileStateJournalItem;
+}
+
 void DeleteGlobalPrefs(GlobalPrefs* gp) {
     if (!gp) {
         return;
@@ -1,6 +1,8 @@
 /* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
    License: GPLv3 */
 
+struct SettingsJournal;
+
 extern GlobalPrefs* gGlobalPrefs;
 
 bool* FindGlobalPrefsBoolSetting(Str name);
@@ -21,6 +23,9 @@ void DeleteFavorite(Favorite* fav);
 
 GlobalPrefs* NewGlobalPrefs(Str);
 Str SerializeGlobalPrefs(GlobalPrefs* prefs, Str prevData);
+Str SerializeGlobalPrefsWithoutFileStates(GlobalPrefs* prefs);
+// sets up j to journal GlobalPrefs.FileStates (see base/SettingsJournal.h)
+void InitFileStatesJournal(SettingsJournal* j);
 void DeleteGlobalPrefs(GlobalPrefs*);
 
 SessionData* NewSessionData();
@@ -0,0 +1,235 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+
+#include "GlyphIndex.h"
+
+// a glyph covering more cells than that is checked for every point instead
+constexpr int kMaxCellsPerGlyph = 64;
+
+static bool IsValidGlyph(const Rect& r) {
+    return r.x || r.dx;
+}
+
+static Point GlyphCenter(const Rect& r) {
+    return Point(r.x + (r.dx / 2), r.y + (r.dy / 2));
+}
+
+// the same distance FindClosestGlyph() always used
+static uint GlyphDistSq(int x, int y) {
+    return (uint)((x * x) + (y * y));
+}
+
+static int FloorDiv(int a, int b) {
+    int q = a / b;
+    if ((a % b != 0) && (a < 0)) {
+        q--;
+    }
+    return q;
+}
+
+// turns per-cell counts into start offsets; starts has one more entry than cells
+static void CountsToStarts(Vec<int>& starts) {
+    int sum = 0;
+    for (int& n : starts) {
+        int count = n;
+        n = sum;
+        sum += count;
+    }
+}
+
+GlyphIndex::GlyphIndex(const Rect* coords, int nGlyphs) : coords(coords), nGlyphs(nGlyphs) {
+    int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+    int nValid = 0;
+    for (int i = 0; i < nGlyphs; i++) {
+        const Rect& r = coords[i];
+        if (!IsValidGlyph(r)) {
+            continue;
+        }
+        Point c = GlyphCenter(r);
+        x0 = std::min({x0, r.x, c.x});
+        y0 = std::min({y0, r.y, c.y});
+        x1 = std::max({x1, r.x + r.dx, c.x + 1});
+        y1 = std::max({y1, r.y + r.dy, c.y + 1});
+        nValid++;
+    }
+    if (nValid == 0) {
+        return;
+    }
+
+    // about 2 glyph centers per cell
+    i64 dx = std::max(x1 - x0, 1);
+    i64 dy = std::max(y1 - y0, 1);
+    cellSize = std::max((int)sqrt((double)(dx * dy * 2) / nValid), 1);
+    while ((dx / cellSize + 1) * (dy / cellSize + 1) > (i64)nValid * 4 + 16) {
+        cellSize *= 2;
+    }
+    origin = Point(x0, y0);
+    nCols = (int)(dx / cellSize) + 1;
+    nRows = (int)(dy / cellSize) + 1;
+    int nCells = nCols * nRows;
+
+    // two passes over the glyphs: count per cell, then fill
+    VecResize(boxCellStarts, nCells + 1);
+    VecResize(centerCellStarts, nCells + 1);
+    for (int pass = 0; pass < 2; pass++) {
+        Vec<int> boxFill;
+        Vec<int> centerFill;
+        if (pass == 1) {
+            CountsToStarts(boxCellStarts);
+            CountsToStarts(centerCellStarts);
+            VecResize(boxGlyphs, boxCellStarts.Last());
+            VecResize(centerGlyphs, centerCellStarts.Last());
+            boxFill = boxCellStarts;
+            centerFill = centerCellStarts;
+        }
+        for (int i = 0; i < nGlyphs; i++) {
+            const Rect& r = coords[i];
+            if (!IsValidGlyph(r)) {
+                continue;
+            }
+            Point c = GlyphCenter(r);
+            int cell = (CellRow(c.y) * nCols) + CellCol(c.x);
+            if (pass == 0) {
+                centerCellStarts[cell]++;
+            } else {
+                centerGlyphs[centerFill[cell]++] = i;
+            }
+
+            // only a non-empty box can contain a point
+            if (r.dx <= 0 || r.dy <= 0) {
+                continue;
+            }
+            int col0 = CellCol(r.x);
+            int col1 = CellCol(r.x + r.dx - 1);
+            int row0 = CellRow(r.y);
+            int row1 = CellRow(r.y + r.dy - 1);
+            if ((col1 - col0 + 1) * (row1 - row0 + 1) > kMaxCellsPerGlyph) {
+                if (pass == 0) {
+                    bigGlyphs.Append(i);
+                }
+                continue;
+            }
+            for (int row = row0; row <= row1; row++) {
+                for (int col = col0; col <= col1; col++) {
+                    int boxCell = (row * nCols) + col;
+                    if (pass == 0) {
+                        boxCellStarts[boxCell]++;
+                    } else {
+                        boxGlyphs[boxFill[boxCell]++] = i;
+                    }
+                }
+            }
+        }
+    }
+}
+
+int GlyphIndex::CellCol(int x) const {
+    return std::clamp(FloorDiv(x - origin.x, cellSize), 0, nCols - 1);
+}
+
+int GlyphIndex::CellRow(int y) const {
+    return std::clamp(FloorDiv(y - origin.y, cellSize), 0, nRows - 1);
+}
+
+// of the glyphs containing pt, the one with the closest center; -1 if none
+int GlyphIndex::FindOver(Point pt, int xi, int yi) const {
+    int res = -1;
+    uint resDist = 0;
+    auto check = [&](int i) {
+        const Rect& r = coords[i];
+        if (!r.Contains(pt)) {
+            return;
+        }
+        Point c = GlyphCenter(r);
+        uint dist = GlyphDistSq(xi - c.x, yi - c.y);
+        if (res < 0 || dist < resDist || (dist == resDist && i < res)) {
+            res = i;
+            resDist = dist;
+        }
+    };
+    for (int i : bigGlyphs) {
+        check(i);
+    }
+    // the grid covers all boxes, so a point outside of it isn't in any
+    int col = FloorDiv(pt.x - origin.x, cellSize);
+    int row = FloorDiv(pt.y - origin.y, cellSize);
+    if (col < 0 || col >= nCols || row < 0 || row >= nRows) {
+        return res;
+    }
+    int cell = (row * nCols) + col;
+    for (int k = boxCellStarts[cell]; k < boxCellStarts[cell + 1]; k++) {
+        check(boxGlyphs[k]);
+    }
+    return res;
+}
+
+int GlyphIndex::FindClosest(double x, double y) const {
+    if (nCols == 0) {
+        return -1;
+    }
+    // FindClosestGlyph() tested containment with the point converted to
+    // float first and measured distances from the truncated doubles
+    Point pt = ToPoint(PointF((float)x, (float)y));
+    int xi = (int)x;
+    int yi = (int)y;
+    int res = FindOver(pt, xi, yi);
+    if (res >= 0) {
+        return res;
+    }
+
+    // search rings of cells around the point's (clamped) cell until no cell
+    // further out can have a closer center
+    uint resDist = UINT_MAX;
+    int col = CellCol(xi);
+    int row = CellRow(yi);
+    for (int ring = 0;; ring++) {
+        int row0 = std::max(row - ring, 0);
+        int row1 = std::min(row + ring, nRows - 1);
+        int col0 = std::max(col - ring, 0);
+        int col1 = std::min(col + ring, nCols - 1);
+        for (int r = row0; r <= row1; r++) {
+            bool wholeRow = (r == row - ring) || (r == row + ring);
+            for (int c = col0; c <= col1; c++) {
+                if (!wholeRow && c != col - ring && c != col + ring) {
+                    // only the ring's outline, the inside was searched before
+                    c = col + ring - 1;
+                    continue;
+                }
+                int cell = (r * nCols) + c;
+                for (int k = centerCellStarts[cell]; k < centerCellStarts[cell + 1]; k++) {
+                    int i = centerGlyphs[k];
+                    Point center = GlyphCenter(coords[i]);
+                    uint dist = GlyphDistSq(xi - center.x, yi - center.y);
+                    if (dist < resDist || (dist == resDist && res >= 0 && i < res)) {
+                        res = i;
+                        resDist = dist;
+                    }
+                }
+            }
+        }
+
+        // how far any center in a cell outside the searched box must be
+        i64 minDist = INT64_MAX;
+        if (col - ring > 0) {
+            minDist = std::min(minDist, (i64)xi - (origin.x + (i64)(col - ring) * cellSize) + 1);
+        }
+        if (col + ring < nCols - 1) {
+            minDist = std::min(minDist, (origin.x + (i64)(col + ring + 1) * cellSize) - xi);
+        }
+        if (row - ring > 0) {
+            minDist = std::min(minDist, (i64)yi - (origin.y + (i64)(row - ring) * cellSize) + 1);
+        }
+        if (row + ring < nRows - 1) {
+            minDist = std::min(minDist, (origin.y + (i64)(row + ring + 1) * cellSize) - yi);
+        }
+        if (minDist == INT64_MAX) {
+            // searched all cells
+            return res;
+        }
+        if (res >= 0 && minDist > 0 && (u64)minDist * (u64)minDist > resDist) {
+            return res;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// Finds the glyph of a page closest to a point without looking at every
+// glyph (the canvas asks on every mouse move to pick the cursor). Glyphs are
+// bucketed into a uniform grid twice: by the cells their box covers, to find
+// the glyphs a point is over, and by the cell of their center, to find the
+// closest one by searching rings of cells around the point.
+class GlyphIndex {
+    // the page text's coords, which live as long as the engine
+    const Rect* coords = nullptr;
+    int nGlyphs = 0;
+
+    Point origin;
+    int cellSize = 1;
+    int nCols = 0;
+    int nRows = 0;
+    // glyphs of cell i are boxGlyphs[boxCellStarts[i] .. boxCellStarts[i + 1]]
+    Vec<int> boxCellStarts;
+    Vec<int> boxGlyphs;
+    Vec<int> centerCellStarts;
+    Vec<int> centerGlyphs;
+    // glyphs whose box covers too many cells to be bucketed by it
+    Vec<int> bigGlyphs;
+
+    int CellCol(int x) const;
+    int CellRow(int y) const;
+    int FindOver(Point pt, int xi, int yi) const;
+
+  public:
+    GlyphIndex(const Rect* coords, int nGlyphs);
+
+    // The index of the glyph a forward selection starting at (x, y) would be
+    // anchored to, before adjusting for the point being over the glyph's
+    // right half: of the glyphs whose box contains the point, the one whose
+    // center is closest, otherwise the closest of all. Ties go to the lowest
+    // index and glyphs with !x && !dx are ignored. -1 if there are none.
+    int FindClosest(double x, double y) const;
+};
@@ -149,6 +149,14 @@ static void GumboFreeWrapper(void* /*userdata*/, void* ptr) {
     free(ptr);
 }
 
+static void* GumboArenaAlloc(void* userdata, size_t size) {
+    Arena* a = (Arena*)userdata;
+    return a->Push(std::max<u64>(size, 1), 8, false);
+}
+static void GumboArenaFree(void* /*userdata*/, void* /*ptr*/) {
+    // freed all at once when the arena is reset
+}
+
 GumboOptions GumboMakeOptions() {
     GumboOptions opts{};
     opts.allocator = GumboMallocWrapper;
@@ -171,3 +179,9 @@ GumboOptions GumboMakeXmlFragmentOptions() {
     opts.fragment_namespace = GUMBO_NAMESPACE_SVG;
     return opts;
 }
+
+void GumboUseArena(GumboOptions& opts, Arena* a) {
+    opts.allocator = GumboArenaAlloc;
+    opts.deallocator = GumboArenaFree;
+    opts.userdata = a;
+}
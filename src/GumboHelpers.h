@@ -22,3 +22,6 @@ TempStr GumboTextContentTemp(const GumboNode* node);
 // extern because it's awkward to import across the libsumatrapdf.dll boundary.
 GumboOptions GumboMakeOptions();
 GumboOptions GumboMakeXmlFragmentOptions();
+// Makes gumbo allocate from a. Frees are no-ops: the whole parse is freed
+// with a->Reset() / ArenaDelete(a), so don't call gumbo_destroy_output_iter()
+void GumboUseArena(GumboOptions& opts, Arena* a);
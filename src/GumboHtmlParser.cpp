@@ -435,14 +435,52 @@ static ptrdiff_t PosOfSource(Str html, Str p) {
 
 GumboHtmlParser::GumboHtmlParser(Str s) : html(s) {
     opts = GumboMakeXmlFragmentOptions();
-    output = gumbo_parse_with_options(&opts, html.s, (size_t)html.len);
-    BuildEvents();
+    arena = ArenaNew();
+    GumboUseArena(opts, arena);
+
+    // EbookDoc / EngineEbook start every spine item / CHM topic with this.
+    // They're whole html documents, so parsing them separately only drops
+    // the tags a previous one left open, which HtmlFormatter closes anyway
+    Str marker = StrL("<pagebreak page_path=");
+    chunkStarts.Append(0);
+    ptrdiff_t off = 0;
+    for (;;) {
+        int idx = str::IndexOf(Str(html.s + off, html.len - (int)off), marker);
+        if (idx < 0) {
+            break;
+        }
+        off += idx;
+        if (off > 0) {
+            chunkStarts.Append(off);
+        }
+        off += marker.len;
+    }
+    ParseChunk(0);
 }
 
 GumboHtmlParser::~GumboHtmlParser() {
-    if (output) {
-        gumbo_destroy_output_iter(&opts, output);
+    // frees output
+    ArenaDelete(arena);
+}
+
+void GumboHtmlParser::ParseChunk(int idx) {
+    if (idx == chunkIdx) {
+        return;
     }
+    events.Reset();
+    eventIdx = 0;
+    output = nullptr;
+    arena->Reset();
+    chunkIdx = idx;
+    int nChunks = len(chunkStarts);
+    if (idx >= nChunks) {
+        return;
+    }
+    ptrdiff_t start = chunkStarts[idx];
+    ptrdiff_t end = (idx + 1 < nChunks) ? chunkStarts[idx + 1] : html.len;
+    // the pieces gumbo returns point into html, so offsets stay relative to it
+    output = gumbo_parse_with_options(&opts, html.s + start, (size_t)(end - start));
+    BuildEvents();
 }
 
 void GumboHtmlParser::BuildEvents() {
@@ -549,6 +587,20 @@ void GumboHtmlParser::SetCurrPosOff(ptrdiff_t off) {
     off = std::max<ptrdiff_t>(off, 0);
     off = std::min<ptrdiff_t>(off, html.len);
 
+    // the last chunk starting at or before off
+    int lo = 0;
+    int hi = len(chunkStarts) - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (chunkStarts[mid] <= off) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    ParseChunk(lo);
+
+    // if nothing in this chunk is at or after off, Next() moves to the next one
     textStartOff = -1;
     eventIdx = (size_t)len(events);
     for (int i = 0; i < len(events); i++) {
@@ -570,8 +622,11 @@ int GumboHtmlParser::PosOf(Str p) const {
 }
 
 HtmlToken* GumboHtmlParser::Next() {
-    if (eventIdx >= (size_t)len(events)) {
-        return nullptr;
+    while (eventIdx >= (size_t)len(events)) {
+        if (chunkIdx + 1 >= len(chunkStarts)) {
+            return nullptr;
+        }
+        ParseChunk(chunkIdx + 1);
     }
     Event& ev = events[(int)eventIdx++];
     return TokenFromEvent(ev);
@@ -48,6 +48,9 @@ struct HtmlToken {
     AttrInfo attrInfo;
 };
 
+// Parses a concatenated ebook one spine item / topic at a time, so only
+// one chunk's parse tree is in memory. A token's node is only valid until
+// the next call to Next() or SetCurrPosOff()
 class GumboHtmlParser {
     struct Event {
         HtmlToken::TokenType type = HtmlToken::Error;
@@ -61,12 +64,20 @@ class GumboHtmlParser {
     Str html;
     GumboOptions opts{};
     GumboOutput* output = nullptr;
+    // gumbo's allocations for the chunk being parsed, reset for the next one
+    Arena* arena = nullptr;
+    // offsets in html of the parts parsed one at a time: the start and every
+    // <pagebreak page_path="..." page_marker /> (a spine item or a CHM topic)
+    Vec<ptrdiff_t> chunkStarts;
+    int chunkIdx = -1;
+    // events of chunk chunkIdx, offsets are into html
     Vec<Event> events;
     size_t eventIdx = 0;
     ptrdiff_t textStartOff = -1;
 
     HtmlToken currToken{};
 
+    void ParseChunk(int idx);
     void BuildEvents();
     HtmlToken* TokenFromEvent(Event& ev);
 
@@ -2060,7 +2060,7 @@ static void DrawHomeListRow(Gfx* gfx, ThumbnailLayout& thumb, const StrVec& filt
     if (thumbImg) {
         Size szThumb(thumbImg->width, thumbImg->height);
         Rect thumbDst = FitRectInRect(szThumb, thumbBox);
-        gfx->DrawPixmap(thumbImg, thumbDst);
+        gfx->DrawPixmap(GetThumbnailForSize(fs, thumbDst.Size()), thumbDst);
         thumb.szThumb = szThumb;
     }
     Str path = fs->filePath;
@@ -2117,7 +2117,7 @@ static void DrawHomeThumbnail(Gfx* gfx, ThumbnailLayout& thumb, const StrVec& fi
         gfx->PushClip(page);
         // note: we used to invert bitmaps in dark theme but that doesn't
         // make sense for thumbnails
-        gfx->DrawPixmap(thumbImg, page);
+        gfx->DrawPixmap(GetThumbnailForSize(fs, page.Size()), page);
         gfx->PopClip();
     }
     DrawHomeRoundedOutline(gfx, page, 10, ThemeWindowTextColor(), kThumbsBorderDx);
@@ -5,7 +5,7 @@
 #include "base/Dict.h"
 #include "base/HtmlTags.h"
 #include "base/Pixmap.h"
-#include "base/CssParser.h"
+#include "base/Trace.h"
 
 #include "GumboHelpers.h"
 #include "GumboHtmlParser.h"
@@ -13,6 +13,7 @@
 
 #include "gui/PlatformFont.h"
 #include "gui/PlatformText.h"
+#include "HtmlStyleSheet.h"
 #include "HtmlFormatter.h"
 
 #if OS_WIN
@@ -117,52 +118,6 @@ DrawInstr DrawInstr::PageMarkerAnchor(::Str s, RectF bbox) {
     return di;
 }
 
-// parses size in the form "1em", "3pt" or "15px"
-static void ParseSizeWithUnit(Str s, float* size, StyleRule::Unit* unit) {
-    if (!str::IsNull(str::Parse(s, "%fem", size))) {
-        *unit = StyleRule::em;
-    } else if (!str::IsNull(str::Parse(s, "%fin", size))) {
-        *unit = StyleRule::pt;
-        *size *= 72; // 1 inch is 72 points
-    } else if (!str::IsNull(str::Parse(s, "%fpt", size))) {
-        *unit = StyleRule::pt;
-    } else if (!str::IsNull(str::Parse(s, "%fpx", size))) {
-        *unit = StyleRule::px;
-    } else {
-        *unit = StyleRule::inherit;
-    }
-}
-
-StyleRule StyleRule::Parse(CssPullParser* parser) {
-    StyleRule rule;
-    const CssProperty* prop;
-    while ((prop = parser->NextProperty()) != nullptr) {
-        if (prop->type == Css_Text_Align) {
-            rule.textAlign = FindAlignAttr(prop->s);
-        } else if (prop->type == Css_Text_Indent) {
-            ParseSizeWithUnit(prop->s, &rule.textIndent, &rule.textIndentUnit);
-        } else if (prop->type == Css_Padding_Left) {
-            ParseSizeWithUnit(prop->s, &rule.textIndent, &rule.textIndentUnit);
-        }
-    }
-    return rule;
-}
-
-StyleRule StyleRule::Parse(Str s) {
-    CssPullParser parser(s);
-    return Parse(&parser);
-}
-
-void StyleRule::Merge(StyleRule& source) {
-    if (source.textAlign != AlignAttr::NotFound) {
-        textAlign = source.textAlign;
-    }
-    if (source.textIndentUnit != StyleRule::inherit) {
-        textIndent = source.textIndent;
-        textIndentUnit = source.textIndentUnit;
-    }
-}
-
 HtmlFormatter::HtmlFormatter(HtmlFormatterArgs* args)
     : pageDx(args->pageDx), pageDy(args->pageDy), textAllocator(args->textAllocator) {
     currReparseIdx = args->reparseIdx;
@@ -1090,45 +1045,9 @@ void HtmlFormatter::HandleTagPre(HtmlToken* t) {
     }
 }
 
-StyleRule* HtmlFormatter::FindStyleRule(HtmlTag tag, Str clazz) {
-    u32 classHash = MurmurHash2(clazz);
-    for (int i = 0; i < len(styleRules); i++) {
-        StyleRule& rule = styleRules[i];
-        if (tag == rule.tag && classHash == rule.classHash) {
-            return &rule;
-        }
-    }
-    return nullptr;
-}
-
 StyleRule HtmlFormatter::ComputeStyleRule(HtmlToken* t) {
-    StyleRule rule;
-    // get style rules ordered by specificity
-    StyleRule* prevRule = FindStyleRule(Tag_Body, Str());
-    if (prevRule) {
-        rule.Merge(*prevRule);
-    }
-    prevRule = FindStyleRule(Tag_Any, Str());
-    if (prevRule) {
-        rule.Merge(*prevRule);
-    }
-    prevRule = FindStyleRule(t->tag, Str());
-    if (prevRule) {
-        rule.Merge(*prevRule);
-    }
-    // TODO: support multiple class names
     AttrInfo* attr = t->GetAttrByName(StrL("class"));
-    if (attr) {
-        Str clazz = attr->val;
-        prevRule = FindStyleRule(Tag_Any, clazz);
-        if (prevRule) {
-            rule.Merge(*prevRule);
-        }
-        prevRule = FindStyleRule(t->tag, clazz);
-        if (prevRule) {
-            rule.Merge(*prevRule);
-        }
-    }
+    StyleRule rule = styleSheet.Compute(t->tag, attr ? attr->val : Str());
     attr = t->GetAttrByName(StrL("style"));
     if (attr) {
         StyleRule newRule = StyleRule::Parse(attr->val);
@@ -1138,25 +1057,7 @@ StyleRule HtmlFormatter::ComputeStyleRule(HtmlToken* t) {
 }
 
 void HtmlFormatter::ParseStyleSheet(Str data) {
-    CssPullParser parser(data);
-    while (parser.NextRule()) {
-        StyleRule rule = StyleRule::Parse(&parser);
-        const CssSelector* sel;
-        while ((sel = parser.NextSelector()) != nullptr) {
-            if (Tag_NotFound == sel->tag) {
-                continue;
-            }
-            Str clazz = sel->clazz;
-            StyleRule* prevRule = FindStyleRule(sel->tag, clazz);
-            if (prevRule) {
-                prevRule->Merge(rule);
-            } else {
-                rule.tag = sel->tag;
-                rule.classHash = MurmurHash2(clazz);
-                styleRules.Append(rule);
-            }
-        }
-    }
+    styleSheet.Parse(data);
 }
 
 void HtmlFormatter::HandleTagStyle(HtmlToken* t) {
@@ -1476,6 +1377,7 @@ static bool IsEmptyPage(HtmlPage* p) {
 // or more pages, which we remeber and send to the caller
 // if we detect accumulated pages.
 HtmlPage* HtmlFormatter::Next(bool skipEmptyPages) {
+    TraceSpan span("layout page", pageCount + 1);
     AtomicIntInc(&gAllowAllocFailure);
     AutoCall decAllowAlloc(AtomicIntDec, &gAllowAllocFailure);
 
@@ -1523,6 +1425,7 @@ HtmlPage* HtmlFormatter::Next(bool skipEmptyPages) {
 
 // convenience method to format the whole html
 Vec<HtmlPage*>* HtmlFormatter::FormatAllPages(bool skipEmptyPages) {
+    TraceSpan span("layout all pages");
     Vec<HtmlPage*>* pages = new Vec<HtmlPage*>();
     for (HtmlPage* pd = Next(skipEmptyPages); pd; pd = Next(skipEmptyPages)) {
         pages->Append(pd);
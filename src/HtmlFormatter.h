@@ -13,7 +13,8 @@ class Graphics;
 #endif
 
 // PlatformFont / PlatformFontStyle live in gui/PlatformFont.h and the text
-// measuring API in gui/PlatformText.h; include them before this header
+// measuring API in gui/PlatformText.h; include them and HtmlStyleSheet.h
+// before this header
 
 // Layout information for a given page is a list of
 // draw instructions that define what to draw and where.
@@ -71,31 +72,6 @@ struct DrawInstr {
     static DrawInstr PageMarkerAnchor(::Str s, RectF bbox);
 };
 
-class CssPullParser;
-
-struct StyleRule {
-    HtmlTag tag = Tag_NotFound;
-    u32 classHash = 0;
-
-    enum Unit {
-        px,
-        pt,
-        em,
-        inherit
-    };
-
-    float textIndent = 0;
-    Unit textIndentUnit = inherit;
-    AlignAttr textAlign = AlignAttr::NotFound;
-
-    StyleRule() = default;
-
-    void Merge(StyleRule& source);
-
-    static StyleRule Parse(CssPullParser* parser);
-    static StyleRule Parse(::Str s);
-};
-
 struct DrawStyle {
     PlatformFont* font = nullptr;
     AlignAttr align{AlignAttr::NotFound};
@@ -211,7 +187,6 @@ struct HtmlFormatter {
     void RevertStyleChange();
 
     void ParseStyleSheet(::Str data);
-    StyleRule* FindStyleRule(HtmlTag tag, ::Str clazz);
     StyleRule ComputeStyleRule(HtmlToken* t);
 
     void AppendInstr(const DrawInstr& di);
@@ -278,7 +253,7 @@ struct HtmlFormatter {
     Vec<HtmlTag> tagNesting;
     bool keepTagNesting = false;
     // set from CSS and to be checked by the individual tag handlers
-    Vec<StyleRule> styleRules;
+    HtmlStyleSheet styleSheet;
 
     // isntructions for the current line
     Vec<DrawInstr> currLineInstr;
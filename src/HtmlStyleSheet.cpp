@@ -0,0 +1,196 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "base/HtmlTags.h"
+#include "base/CssParser.h"
+
+#include "HtmlStyleSheet.h"
+
+// parses size in the form "1em", "3pt" or "15px"
+static void ParseSizeWithUnit(Str s, float* size, StyleRule::Unit* unit) {
+    if (!str::IsNull(str::Parse(s, "%fem", size))) {
+        *unit = StyleRule::em;
+    } else if (!str::IsNull(str::Parse(s, "%fin", size))) {
+        *unit = StyleRule::pt;
+        *size *= 72; // 1 inch is 72 points
+    } else if (!str::IsNull(str::Parse(s, "%fpt", size))) {
+        *unit = StyleRule::pt;
+    } else if (!str::IsNull(str::Parse(s, "%fpx", size))) {
+        *unit = StyleRule::px;
+    } else {
+        *unit = StyleRule::inherit;
+    }
+}
+
+StyleRule StyleRule::Parse(CssPullParser* parser) {
+    StyleRule rule;
+    const CssProperty* prop;
+    while ((prop = parser->NextProperty()) != nullptr) {
+        if (prop->type == Css_Text_Align) {
+            rule.textAlign = FindAlignAttr(prop->s);
+        } else if (prop->type == Css_Text_Indent) {
+            ParseSizeWithUnit(prop->s, &rule.textIndent, &rule.textIndentUnit);
+        } else if (prop->type == Css_Padding_Left) {
+            ParseSizeWithUnit(prop->s, &rule.textIndent, &rule.textIndentUnit);
+        }
+    }
+    return rule;
+}
+
+StyleRule StyleRule::Parse(Str s) {
+    CssPullParser parser(s);
+    return Parse(&parser);
+}
+
+void StyleRule::Merge(const StyleRule& source) {
+    if (source.textAlign != AlignAttr::NotFound) {
+        textAlign = source.textAlign;
+    }
+    if (source.textIndentUnit != StyleRule::inherit) {
+        textIndent = source.textIndent;
+        textIndentUnit = source.textIndentUnit;
+    }
+}
+
+static u32 StyleKeyHash(HtmlTag tag, u32 classHash) {
+    return classHash ^ ((u32)tag * 0x9e3779b1);
+}
+
+// hash tables are arrays of (index + 1) into the values, 0 for an empty
+// slot. Their size is a power of 2 and they're kept at most half full
+static void ClearHashTable(Vec<int>& table, int size) {
+    VecResize(table, size);
+    for (int& idx : table) {
+        idx = 0;
+    }
+}
+
+static void HashTableInsert(Vec<int>& table, u32 hash, int idx) {
+    int mask = len(table) - 1;
+    int slot = (int)(hash & (u32)mask);
+    while (table[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    table[slot] = idx + 1;
+}
+
+void HtmlStyleSheet::GrowRuleIdx() {
+    ClearHashTable(ruleIdx, std::max(len(ruleIdx) * 2, 64));
+    for (int i = 0; i < len(rules); i++) {
+        HashTableInsert(ruleIdx, StyleKeyHash(rules[i].tag, rules[i].classHash), i);
+    }
+}
+
+StyleRule* HtmlStyleSheet::Find(HtmlTag tag, u32 classHash) {
+    if (len(ruleIdx) == 0) {
+        return nullptr;
+    }
+    int mask = len(ruleIdx) - 1;
+    int slot = (int)(StyleKeyHash(tag, classHash) & (u32)mask);
+    while (ruleIdx[slot] != 0) {
+        StyleRule& rule = rules[ruleIdx[slot] - 1];
+        if (rule.tag == tag && rule.classHash == classHash) {
+            return &rule;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+StyleRule* HtmlStyleSheet::Find(HtmlTag tag, Str clazz) {
+    return Find(tag, MurmurHash2(clazz));
+}
+
+void HtmlStyleSheet::Parse(Str css) {
+    CssPullParser parser(css);
+    while (parser.NextRule()) {
+        StyleRule rule = StyleRule::Parse(&parser);
+        const CssSelector* sel;
+        while ((sel = parser.NextSelector()) != nullptr) {
+            if (Tag_NotFound == sel->tag) {
+                continue;
+            }
+            u32 classHash = MurmurHash2(sel->clazz);
+            StyleRule* prevRule = Find(sel->tag, classHash);
+            if (prevRule) {
+                prevRule->Merge(rule);
+                continue;
+            }
+            rule.tag = sel->tag;
+            rule.classHash = classHash;
+            rules.Append(rule);
+            if (len(rules) * 2 > len(ruleIdx)) {
+                GrowRuleIdx();
+            } else {
+                HashTableInsert(ruleIdx, StyleKeyHash(rule.tag, classHash), len(rules) - 1);
+            }
+        }
+    }
+    // rules were added or changed
+    computed.Reset();
+    computedIdx.Reset();
+}
+
+void HtmlStyleSheet::Reset() {
+    rules.Reset();
+    ruleIdx.Reset();
+    computed.Reset();
+    computedIdx.Reset();
+}
+
+static void MergeIfFound(StyleRule& dst, StyleRule* rule) {
+    if (rule) {
+        dst.Merge(*rule);
+    }
+}
+
+StyleRule HtmlStyleSheet::Compute(HtmlTag tag, Str classAttr) {
+    StyleRule res;
+    if (len(rules) == 0) {
+        return res;
+    }
+    u32 classAttrHash = MurmurHash2(classAttr);
+    u32 hash = StyleKeyHash(tag, classAttrHash);
+    if (len(computedIdx) > 0) {
+        int mask = len(computedIdx) - 1;
+        for (int slot = (int)(hash & (u32)mask); computedIdx[slot] != 0; slot = (slot + 1) & mask) {
+            Computed& c = computed[computedIdx[slot] - 1];
+            if (c.tag == tag && c.classAttrHash == classAttrHash) {
+                return c.rule;
+            }
+        }
+    }
+
+    // ordered by specificity
+    u32 noClassHash = MurmurHash2(Str());
+    MergeIfFound(res, Find(Tag_Body, noClassHash));
+    MergeIfFound(res, Find(Tag_Any, noClassHash));
+    MergeIfFound(res, Find(tag, noClassHash));
+    for (HtmlTag classTag : {Tag_Any, tag}) {
+        int off = 0;
+        while (off < classAttr.len) {
+            while (off < classAttr.len && str::IsWs(classAttr.s[off])) {
+                off++;
+            }
+            int start = off;
+            while (off < classAttr.len && !str::IsWs(classAttr.s[off])) {
+                off++;
+            }
+            if (off > start) {
+                MergeIfFound(res, Find(classTag, Str(classAttr.s + start, off - start)));
+            }
+        }
+    }
+
+    computed.Append({tag, classAttrHash, res});
+    if (len(computed) * 2 > len(computedIdx)) {
+        ClearHashTable(computedIdx, std::max(len(computedIdx) * 2, 64));
+        for (int i = 0; i < len(computed); i++) {
+            HashTableInsert(computedIdx, StyleKeyHash(computed[i].tag, computed[i].classAttrHash), i);
+        }
+    } else {
+        HashTableInsert(computedIdx, hash, len(computed) - 1);
+    }
+    return res;
+}
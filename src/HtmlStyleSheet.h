@@ -0,0 +1,58 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// include base/HtmlTags.h before this header
+
+class CssPullParser;
+
+struct StyleRule {
+    HtmlTag tag = Tag_NotFound;
+    u32 classHash = 0;
+
+    enum Unit {
+        px,
+        pt,
+        em,
+        inherit
+    };
+
+    float textIndent = 0;
+    Unit textIndentUnit = inherit;
+    AlignAttr textAlign = AlignAttr::NotFound;
+
+    StyleRule() = default;
+
+    void Merge(const StyleRule& source);
+
+    static StyleRule Parse(CssPullParser* parser);
+    static StyleRule Parse(Str s);
+};
+
+// CSS rules of a document, indexed by (tag, class). Ebooks can have
+// stylesheets with thousands of class rules and every tag needs its style,
+// so the merged style of each (tag, class attribute) is remembered too
+class HtmlStyleSheet {
+    // a hash table of (index + 1) into rules (0 if empty), a power of 2 in size
+    Vec<int> ruleIdx;
+
+    struct Computed {
+        HtmlTag tag;
+        u32 classAttrHash;
+        StyleRule rule;
+    };
+    Vec<Computed> computed;
+    Vec<int> computedIdx;
+
+    void GrowRuleIdx();
+
+  public:
+    Vec<StyleRule> rules;
+
+    void Parse(Str css);
+    void Reset();
+    StyleRule* Find(HtmlTag tag, u32 classHash);
+    StyleRule* Find(HtmlTag tag, Str clazz);
+    // the rules for body, *, tag, each .class and each tag.class in the
+    // space separated classAttr, merged in that order
+    StyleRule Compute(HtmlTag tag, Str classAttr);
+};
@@ -44,6 +44,7 @@
 #include "RefHover.h"
 #include "WindowTab.h"
 #include "TableOfContents.h"
+#include "TocFilter.h"
 #include "StressTesting.h"
 #include "uia/Provider.h"
 
@@ -197,6 +198,7 @@ MainWindow::~MainWindow() {
     delete tocLayout;
     delete tocRoot;
     delete tocFilteredTree;
+    delete tocFilterIndex;
     if (favTreeView) {
         delete favTreeView->treeModel;
     }
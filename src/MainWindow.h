@@ -28,6 +28,7 @@ struct VirtButton;
 struct TabsCtrl;
 struct TocTree;
 struct TocItem;
+class TocFilterIndex;
 struct FindBarWnd;
 struct FindWindowWnd;
 struct ToolbarVirt;
@@ -51,6 +52,9 @@ struct FindMatch {
     int endPage = 0;
     int endGlyph = 0;
     Str snippet; // UTF-8, owned (freed when findMatches is rebuilt)
+    // bytes of snippet that are the match
+    int snippetMatchStart = 0;
+    int snippetMatchLen = 0;
 };
 
 // factor by how large the non-maximized caption should be in relation to the tabbar
@@ -216,6 +220,11 @@ struct MainWindow {
     Edit* tocFilterEdit = nullptr;
     TreeView* tocTreeView = nullptr;
     TocTree* tocFilteredTree = nullptr;
+    // case-folded titles of tocFilterToc, built the first time it's filtered;
+    // tocFilterItems[i] is the item at index i of tocFilterIndex
+    TocFilterIndex* tocFilterIndex = nullptr;
+    TocTree* tocFilterToc = nullptr;
+    Vec<TocItem*> tocFilterItems;
     // VBox(label, filter edit, tree); owns those three controls and lays them
     // out in hwndTocBox
     ILayout* tocLayout = nullptr;
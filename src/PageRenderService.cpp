@@ -94,7 +94,7 @@ static void ClearCache(PageRenderServiceData* data) {
 // Add the result only if it fits the fixed memory budget. Protect the new
 // entry while evicting older LRU entries so a useful visible result survives.
 static bool AddToCache(PageRenderServiceData* data, PageRenderKey key, Pixmap* pixmap) {
-    i64 bytes = PixmapByteSize(pixmap);
+    i64 bytes = PixmapAllocatedBytes(pixmap);
     if (bytes <= 0 || bytes > data->maxBytes) {
         FreePixmap(pixmap);
         return false;
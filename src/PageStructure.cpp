@@ -0,0 +1,259 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+
+#include "PageStructure.h"
+
+PageStructure::~PageStructure() {
+    wstr::Free(text);
+    wstr::Free(cleanText);
+    free(cleanCoords);
+}
+
+int PageStructure::LineOf(int glyph) const {
+    // the last line starting at or before glyph
+    int lo = 0;
+    int hi = len(lines) - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (lines[mid].start <= glyph) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+i64 PageStructure::Bytes() const {
+    i64 res = sizeof(PageStructure);
+    res += ((i64)text.len + 1 + cleanText.len + 1) * sizeof(WCHAR);
+    res += (i64)cleanText.len * sizeof(Rect);
+    res += (i64)lines.cap * sizeof(PageLine);
+    return res;
+}
+
+static bool IsLineBreak(WCHAR c, const Rect& r) {
+    // some whitespace (e.g. spaces with FZ_STEXT_ACCURATE_BBOXES) can also have
+    // empty boxes and doesn't end a line (issue #5712)
+    return c == L'\n' && !r.x && !r.dx;
+}
+
+PageStructure* BuildPageStructure(Str text, const Rect* coords, int nGlyphs) {
+    if (!coords) {
+        nGlyphs = 0;
+    }
+    auto* res = new PageStructure();
+    WCHAR* dst = AllocArray<WCHAR>(nGlyphs + 1);
+    int byteIdx = 0;
+    for (int i = 0; i < nGlyphs; i++) {
+        int n = 0;
+        int rune = Utf8CodepointAtByte(text, byteIdx, &n);
+        dst[i] = rune > 0xffff ? L'?' : (WCHAR)rune;
+        byteIdx += n > 0 ? n : 1;
+    }
+    res->text = WStr(dst, nGlyphs);
+
+    PageLine line;
+    for (int i = 0; i < nGlyphs; i++) {
+        const Rect& r = coords[i];
+        if (IsLineBreak(dst[i], r)) {
+            line.end = i;
+            res->lines.Append(line);
+            line = PageLine();
+            line.start = i + 1;
+            continue;
+        }
+        if (r.x || r.dx) {
+            line.bbox = line.bbox.IsEmpty() ? r : line.bbox.Union(r);
+        }
+    }
+    line.end = nGlyphs;
+    res->lines.Append(line);
+
+    if (nGlyphs > 0) {
+        // strip the watermark on the raw glyphs first (its true height is only
+        // visible before normalization), then normalize the survivors
+        WCHAR* cleanText = AllocArrayTemp<WCHAR>(nGlyphs);
+        Rect* strippedCoords = AllocArrayTemp<Rect>(nGlyphs);
+        int cleanLen = StripWatermarkGlyphs(res->text, coords, cleanText, strippedCoords);
+        WCHAR* clean = AllocArray<WCHAR>(cleanLen + 1);
+        memcpy(clean, cleanText, (size_t)cleanLen * sizeof(WCHAR));
+        res->cleanText = WStr(clean, cleanLen);
+        res->cleanCoords = AllocArray<Rect>(std::max(cleanLen, 1));
+        NormalizeGlyphLines(strippedCoords, res->cleanCoords, cleanLen);
+    }
+    return res;
+}
+
+// Snap glyphs to text lines and rewrite each glyph's y/dy to its line's
+// top/height. mupdf returns tight per-glyph ink boxes, so glyphs on one
+// visual line have *different* tops (a period or comma sits well below a
+// capital, an ascender above it). Every line heuristic below treats
+// coords[i].y as the line's position (grouping by y±tol), which a stray
+// low-topped glyph from an adjacent line defeats — e.g. the trailing "."
+// of the previous bibliography entry landing inside the destination band and
+// hijacking the entry-start search. The glyph *baseline* (y + dy) is stable
+// across a line (a digit and a period share it), so cluster by baseline and
+// flatten each line to a uniform top-aligned row — the shape the detectors
+// assume. `out` must have room for glyphCount rects; aliasing `coords` is not
+// allowed.
+void NormalizeGlyphLines(const Rect* coords, Rect* out, int glyphCount) {
+    if (!coords || !out || glyphCount <= 0) {
+        return;
+    }
+    constexpr int kBaselineTolPt = 4;
+    constexpr int kMaxLines = 4096;
+    int* lineBaseline = AllocArrayTemp<int>(kMaxLines);
+    int* lineTop = AllocArrayTemp<int>(kMaxLines);
+    int* lineBottom = AllocArrayTemp<int>(kMaxLines);
+    int* lineId = AllocArrayTemp<int>(glyphCount);
+    int nLines = 0;
+    for (int i = 0; i < glyphCount; i++) {
+        int bl = coords[i].y + coords[i].dy;
+        int best = -1;
+        int bestDist = kBaselineTolPt + 1;
+        for (int L = 0; L < nLines; L++) {
+            int dist = bl - lineBaseline[L];
+            if (dist < 0) {
+                dist = -dist;
+            }
+            if (dist < bestDist) {
+                bestDist = dist;
+                best = L;
+            }
+        }
+        if (best < 0) {
+            // new line (or, on the unlikely line overflow, fold into line 0)
+            if (nLines < kMaxLines) {
+                best = nLines++;
+                lineBaseline[best] = bl;
+                lineTop[best] = coords[i].y;
+                lineBottom[best] = bl;
+            } else {
+                best = 0;
+            }
+        } else {
+            lineTop[best] = std::min(coords[i].y, lineTop[best]);
+            lineBottom[best] = std::max(bl, lineBottom[best]);
+        }
+        lineId[i] = best;
+    }
+    for (int i = 0; i < glyphCount; i++) {
+        out[i] = coords[i];
+        int L = lineId[i];
+        out[i].y = lineTop[L];
+        out[i].dy = lineBottom[L] - lineTop[L];
+    }
+}
+
+// Drop diagonal draft / "under review" watermark glyphs from a page's *raw*
+// glyph arrays before any box detection. A watermark stamp is set far larger
+// than body text and, being rotated, sits roughly one glyph per baseline —
+// each on a sparse row — whereas a heading or title is a horizontal run of
+// same-baseline glyphs. Removing it up front keeps a 2-column gutter empty and
+// the entry bounds tight, instead of special-casing oversized glyphs in every
+// scan. Run this on the engine's raw coords *before* NormalizeGlyphLines:
+// normalization clusters by baseline (±4pt) and could fold a watermark glyph
+// into a body line, hiding its true height.
+//
+// `outText`/`outCoords` are caller-allocated with room for glyphCount entries;
+// returns the number of glyphs kept (written to the front of the out arrays).
+// Remove diagonal draft / "under review" watermark glyphs (oversized + sitting
+// on sparse baselines) from a page's raw glyph arrays, so 2-column gutter and
+// entry-bound detection see clean text. Run on the engine's raw coords *before*
+// NormalizeGlyphLines. `outText`/`outCoords` need room for glyphCount entries;
+// returns the kept-glyph count, written to the front of the out arrays.
+int StripWatermarkGlyphs(WStr text, const Rect* coords, WCHAR* outText, Rect* outCoords) {
+    int n = text.len;
+    if (n <= 0 || !coords || !outText || !outCoords) {
+        return 0;
+    }
+    // Typical body glyph height = the most common dy (the watermark, a heading,
+    // and any super/subscripts are all minorities). Histogram over non-space
+    // glyph heights and take the mode.
+    constexpr int kMaxHistogramGlyphHeight = 4096;
+    int maxDy = 0;
+    for (int i = 0; i < n; i++) {
+        if (coords[i].dy > maxDy && coords[i].dy <= kMaxHistogramGlyphHeight) {
+            maxDy = coords[i].dy;
+        }
+    }
+    int modeDy = 0;
+    if (maxDy > 0) {
+        int* hist = AllocArrayTemp<int>(maxDy + 1);
+        if (hist) {
+            for (int i = 0; i < n; i++) {
+                WCHAR c = text.s[i];
+                if (c == L' ' || c == L'\t' || c == L'\n' || c == L'\r') {
+                    continue;
+                }
+                int d = coords[i].dy;
+                if (d > 0 && d <= maxDy) {
+                    hist[d]++;
+                }
+            }
+            int modeCount = 0;
+            for (int d = 1; d <= maxDy; d++) {
+                if (hist[d] > modeCount) {
+                    modeCount = hist[d];
+                    modeDy = d;
+                }
+            }
+        }
+    }
+
+    // Only strip when there's a stable body height to compare against, and only
+    // glyphs clearly taller than it (1.5x) — well above tall "[" labels / caps.
+    constexpr int kMinBodyDy = 4;
+    bool canStrip = modeDy >= kMinBodyDy;
+    int hgtThresh = modeDy + (modeDy / 2); // 1.5 * modeDy
+    constexpr int kBaselineTolPt = 4;
+    constexpr int kMinRowGlyphs = 3; // a real text row has at least this many
+
+    int outLen = 0;
+    for (int i = 0; i < n; i++) {
+        WCHAR c = text.s[i];
+        bool isSpace = (c == L' ' || c == L'\t' || c == L'\n' || c == L'\r');
+        bool drop = false;
+        if (canStrip && !isSpace && coords[i].dy > hgtThresh) {
+            // Sparse-row test: count non-space glyphs sharing this glyph's
+            // baseline (y+dy, stable across a visual line) AND of comparable
+            // height. A rotated watermark glyph stands nearly alone on its
+            // baseline; a heading is a dense row of same-size glyphs. Requiring
+            // *similar height* also catches a watermark glyph whose baseline
+            // happens to coincide with a body line — it's then the lone tall
+            // glyph on a row of small body text, not one of a tall row.
+            int bl = coords[i].y + coords[i].dy;
+            int hi = coords[i].dy;
+            int rowGlyphs = 0;
+            for (int j = 0; j < n; j++) {
+                WCHAR cj = text.s[j];
+                if (cj == L' ' || cj == L'\t' || cj == L'\n' || cj == L'\r') {
+                    continue;
+                }
+                if (abs((coords[j].y + coords[j].dy) - bl) > kBaselineTolPt) {
+                    continue;
+                }
+                if (abs(coords[j].dy - hi) * 2 > hi) { // height differs by > 50%
+                    continue;
+                }
+                rowGlyphs++;
+                if (rowGlyphs >= kMinRowGlyphs) {
+                    break;
+                }
+            }
+            if (rowGlyphs < kMinRowGlyphs) {
+                drop = true;
+            }
+        }
+        if (drop) {
+            continue;
+        }
+        outText[outLen] = c;
+        outCoords[outLen] = coords[i];
+        outLen++;
+    }
+    return outLen;
+}
@@ -0,0 +1,49 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// Line structure of a page's text, derived once from the engine's text and
+// glyph coords and kept with them (see EngineBase::GetPageStructure) so that
+// text selection, read aloud and ref hover don't each re-derive it from the
+// raw glyphs on every click or hover. Engine-independent so it can be tested
+// with synthetic glyph arrays.
+
+struct PageLine {
+    // glyphs [start, end); the line break glyph after the line (if any) is at end
+    int start = 0;
+    int end = 0;
+    // union of the line's non-empty glyph boxes; empty for blank lines
+    Rect bbox;
+};
+
+struct PageStructure {
+    // one WCHAR per glyph of the page text (codepoints above U+FFFF become '?')
+    WStr text;
+    // lines as the text breaks them: by '\n' glyphs with an empty box. There's
+    // a line after every break, so there's always at least one
+    Vec<PageLine> lines;
+    // text and coords with watermark glyphs removed and glyph boxes flattened
+    // to their line (StripWatermarkGlyphs + NormalizeGlyphLines), the shape
+    // RefHover's region detectors expect
+    WStr cleanText;
+    Rect* cleanCoords = nullptr;
+
+    PageStructure() = default;
+    ~PageStructure();
+
+    // index in lines of the line glyph is in. A line break glyph belongs to
+    // the line it ends, glyph == text.len to the last line
+    int LineOf(int glyph) const;
+    i64 Bytes() const;
+};
+
+PageStructure* BuildPageStructure(Str text, const Rect* coords, int nGlyphs);
+
+// Flatten per-glyph ink boxes to uniform top-aligned line rows. mupdf reports
+// tight per-glyph boxes whose tops vary within a line; the detectors below key
+// off coords[i].y as a line coordinate, so callers must pass coords through
+// this first (grouping by baseline = y+dy). `out` needs textLen rects and must
+// not alias `coords`. Synthetic top-aligned input is left effectively
+// unchanged (each line already has a single top).
+void NormalizeGlyphLines(const Rect* coords, Rect* out, int glyphCount);
+
+int StripWatermarkGlyphs(WStr text, const Rect* coords, WCHAR* outText, Rect* outCoords);
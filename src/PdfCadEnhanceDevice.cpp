@@ -373,11 +373,15 @@ void PdfCadEnhancePixmap(fz_context* ctx, fz_pixmap* pix, float zoom, bool raste
     if (!pix || !rasterDominant) {
         return;
     }
-    // we read s[0], s[1], s[2] as R, G, B, so anything else (e.g. CMYK, which
-    // also passes an n >= 3 test) would be misinterpreted
-    if (!fz_colorspace_is_rgb(ctx, pix->colorspace)) {
+    // we read s[0], s[1], s[2] as R, G, B (or B, G, R when rendering straight
+    // into a BGRA tile), so anything else (e.g. CMYK, which also passes an
+    // n >= 3 test) would be misinterpreted
+    bool isBgr = pix->colorspace && fz_colorspace_type(ctx, pix->colorspace) == FZ_COLORSPACE_BGR;
+    if (!isBgr && !fz_colorspace_is_rgb(ctx, pix->colorspace)) {
         return;
     }
+    int ri = isBgr ? 2 : 0;
+    int bi = isBgr ? 0 : 2;
 
     float expansion = zoom > 0.01f ? 1.f / zoom : 1.f;
     float blend = CadEnhanceBlendForExpansion(expansion);
@@ -387,9 +391,9 @@ void PdfCadEnhancePixmap(fz_context* ctx, fz_pixmap* pix, float zoom, bool raste
     int n = pix->n;
     for (int y = 0; y < pix->h; y++) {
         for (int x = 0; x < pix->w; x++) {
-            float fr = (float)s[0] / 255.f;
+            float fr = (float)s[ri] / 255.f;
             float fg = (float)s[1] / 255.f;
-            float fb = (float)s[2] / 255.f;
+            float fb = (float)s[bi] / 255.f;
             if (fr > 0.96f && fg > 0.96f && fb > 0.96f) {
                 s += n;
                 continue;
@@ -409,9 +413,9 @@ void PdfCadEnhancePixmap(fz_context* ctx, fz_pixmap* pix, float zoom, bool raste
                 outB *= factor;
             }
 
-            s[0] = CadClampByte(outR * 255.f);
+            s[ri] = CadClampByte(outR * 255.f);
             s[1] = CadClampByte(outG * 255.f);
-            s[2] = CadClampByte(outB * 255.f);
+            s[bi] = CadClampByte(outB * 255.f);
             s += n;
         }
         s += pix->stride - ((size_t)pix->w * n);
@@ -162,6 +162,17 @@ void MapRgbToDarkThemeOklab(float r, float g, float b, const DarkModePalette& pa
 
 float PdfDarkModeOklabDistance(float r1, float g1, float b1, float r2, float g2, float b2);
 
+// Best picks AVX2 or SSE2 at runtime; the others exist for tests and benchmarks
+enum class PdfDarkModeSimd {
+    Best,
+    Sse2,
+    Scalar,
+};
+
+void PdfDarkModeRgb8ToOklab(const u8* rgb, int n, float* outL, float* outA, float* outB,
+                            PdfDarkModeSimd simd = PdfDarkModeSimd::Best);
+void PdfDarkModeOklabDistanceRgb8(const u8* rgb, int n, float refR, float refG, float refB, float* outDist);
+
 bool PdfDarkModeShouldBlendLightBackground(const DarkImageAnalysis& analysis);
 
 void PdfDarkModeRemapScanPixel(float r, float g, float b, const DarkImageAnalysis& analysis,
@@ -2,6 +2,8 @@
    License: GPLv3 */
 
 #include "base/Base.h"
+#include "base/RectIndex.h"
+#include "base/Trace.h"
 #include "gui/UIModels.h"
 
 extern "C" {
@@ -418,6 +420,7 @@ DarkModePageAnalysis* PdfDarkModeGetOrBuildAnalysis(fz_context* ctx, FzPageInfo*
         return pageInfo->darkModeAnalysis;
     }
     PdfDarkModeInvalidatePage(ctx, pageInfo);
+    TraceSpan span("dark mode analysis", pageInfo->pageNo);
 
     DarkModeOptions options = PdfDarkModeCurrentOptions();
     auto* analysis = new DarkModePageAnalysis();
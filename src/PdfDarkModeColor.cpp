@@ -158,13 +158,17 @@ bool PdfDarkModeUsesObjectLevel() {
     return GetPdfDarkModeRenderer() == PdfDarkModeRenderer::ObjectLevelDevice;
 }
 
-void PdfDarkModeClearPixmapToThemeBackground(fz_context* /*ctx*/, fz_pixmap* pix, const DarkModePalette& palette) {
+void PdfDarkModeClearPixmapToThemeBackground(fz_context* ctx, fz_pixmap* pix, const DarkModePalette& palette) {
     if (!pix || !pix->samples) {
         return;
     }
     byte rb = (byte)lroundf(palette.bgR * 255.f);
     byte gb = (byte)lroundf(palette.bgG * 255.f);
     byte bb = (byte)lroundf(palette.bgB * 255.f);
+    // tiles are rendered straight into BGRA
+    if (pix->colorspace && fz_colorspace_type(ctx, pix->colorspace) == FZ_COLORSPACE_BGR) {
+        std::swap(rb, bb);
+    }
     int w = pix->w;
     int h = pix->h;
     int n = pix->n;
@@ -182,6 +186,118 @@ void PdfDarkModeClearPixmapToThemeBackground(fz_context* /*ctx*/, fz_pixmap* pix
     }
 }
 
+static void ConvertSamplesToRgb(fz_context* ctx, fz_colorspace* cs, int components, const u8* px, float* outRgb) {
+    float conv[FZ_MAX_COLORS] = {};
+    float srcRgb[FZ_MAX_COLORS] = {};
+    for (int c = 0; c < components && c < FZ_MAX_COLORS; c++) {
+        conv[c] = (float)px[c] / 255.f;
+    }
+    fz_convert_color(ctx, cs, conv, fz_device_rgb(ctx), srcRgb, cs, fz_default_color_params);
+    outRgb[0] = srcRgb[0];
+    outRgb[1] = srcRgb[1];
+    outRgb[2] = srcRgb[2];
+}
+
+void PdfDarkModeInitPixmapReader(fz_context* ctx, fz_pixmap* pix, DarkPixmapReader* rd) {
+    rd->ctx = ctx;
+    rd->pix = pix;
+    rd->cs = (pix && pix->colorspace) ? pix->colorspace : fz_device_rgb(ctx);
+    rd->components = fz_colorspace_n(ctx, rd->cs);
+    rd->layout = DarkPixelLayout::Convert;
+    if (rd->cs == fz_device_rgb(ctx)) {
+        rd->layout = DarkPixelLayout::Rgb;
+    } else if (rd->cs == fz_device_bgr(ctx)) {
+        rd->layout = DarkPixelLayout::Bgr;
+    } else if (rd->components == 1) {
+        for (int i = 0; i < 256; i++) {
+            u8 v = (u8)i;
+            ConvertSamplesToRgb(ctx, rd->cs, 1, &v, rd->table + (i * 3));
+        }
+        rd->layout = DarkPixelLayout::Table;
+    }
+}
+
+void PdfDarkModeReadPixel(const DarkPixmapReader& rd, int x, int y, float* outR, float* outG, float* outB) {
+    fz_pixmap* pix = rd.pix;
+    if (!pix || !pix->samples || x < 0 || y < 0 || x >= pix->w || y >= pix->h) {
+        *outR = *outG = *outB = 0.f;
+        return;
+    }
+    const u8* px = pix->samples + ((size_t)y * pix->stride) + ((size_t)x * pix->n);
+    switch (rd.layout) {
+        case DarkPixelLayout::Rgb:
+            *outR = (float)px[0] / 255.f;
+            *outG = (float)px[1] / 255.f;
+            *outB = (float)px[2] / 255.f;
+            return;
+        case DarkPixelLayout::Bgr:
+            *outR = (float)px[2] / 255.f;
+            *outG = (float)px[1] / 255.f;
+            *outB = (float)px[0] / 255.f;
+            return;
+        case DarkPixelLayout::Table: {
+            const float* rgb = rd.table + (px[0] * 3);
+            *outR = rgb[0];
+            *outG = rgb[1];
+            *outB = rgb[2];
+            return;
+        }
+        default: {
+            float rgb[3];
+            ConvertSamplesToRgb(rd.ctx, rd.cs, rd.components, px, rgb);
+            *outR = rgb[0];
+            *outG = rgb[1];
+            *outB = rgb[2];
+            return;
+        }
+    }
+}
+
+void PdfDarkModeReadPixelRgb8(const DarkPixmapReader& rd, int x, int y, u8* outRgb) {
+    fz_pixmap* pix = rd.pix;
+    if (rd.layout == DarkPixelLayout::Rgb && pix && pix->samples && x >= 0 && y >= 0 && x < pix->w && y < pix->h) {
+        const u8* px = pix->samples + ((size_t)y * pix->stride) + ((size_t)x * pix->n);
+        outRgb[0] = px[0];
+        outRgb[1] = px[1];
+        outRgb[2] = px[2];
+        return;
+    }
+    float r, g, b;
+    PdfDarkModeReadPixel(rd, x, y, &r, &g, &b);
+    outRgb[0] = (u8)limitValue((int)lroundf(r * 255.f), 0, 255);
+    outRgb[1] = (u8)limitValue((int)lroundf(g * 255.f), 0, 255);
+    outRgb[2] = (u8)limitValue((int)lroundf(b * 255.f), 0, 255);
+}
+
+static u32 RemapMemoKey(const u8* rgb, u32* slotOut) {
+    u32 key = (((u32)rgb[0] << 16) | ((u32)rgb[1] << 8) | (u32)rgb[2]) + 1;
+    *slotOut = (key * 2654435761u) >> (32 - kDarkRemapMemoBits);
+    return key;
+}
+
+bool PdfDarkModeRemapMemoLookup(const DarkRgbRemapMemo* memo, const u8* rgb, u8* outRgb) {
+    u32 slot;
+    u32 key = RemapMemoKey(rgb, &slot);
+    if (memo->keys[slot] != key) {
+        return false;
+    }
+    const u8* v = memo->values + (slot * 3);
+    outRgb[0] = v[0];
+    outRgb[1] = v[1];
+    outRgb[2] = v[2];
+    return true;
+}
+
+void PdfDarkModeRemapMemoStore(DarkRgbRemapMemo* memo, const u8* rgb, const u8* remapped) {
+    u32 slot;
+    u32 key = RemapMemoKey(rgb, &slot);
+    memo->keys[slot] = key;
+    u8* v = memo->values + (slot * 3);
+    v[0] = remapped[0];
+    v[1] = remapped[1];
+    v[2] = remapped[2];
+}
+
 DarkModeOptions PdfDarkModeCurrentOptions() {
     DarkModeOptions opts;
     if (PdfDarkModeUsesObjectLevel()) {
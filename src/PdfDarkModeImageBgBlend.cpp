@@ -37,30 +37,19 @@ static float SmoothStep(float e0, float e1, float x) {
     return t * t * (3.f - (2.f * t));
 }
 
-static void ReadPixmapPixel(fz_context* ctx, fz_pixmap* pix, int x, int y, float* outR, float* outG, float* outB,
-                            float* outA) {
-    *outR = *outG = *outB = 0.f;
-    *outA = 1.f;
-    if (!pix || !pix->samples || x < 0 || y < 0 || x >= pix->w || y >= pix->h) {
-        return;
-    }
-    fz_colorspace* cs = pix->colorspace ? pix->colorspace : fz_device_rgb(ctx);
-    fz_colorspace* rgb = fz_device_rgb(ctx);
-    int n = pix->n;
-    int components = fz_colorspace_n(ctx, cs);
-    unsigned char* px = pix->samples + ((size_t)y * pix->stride) + ((size_t)x * n);
-    float conv[FZ_MAX_COLORS] = {};
-    float srcRgb[FZ_MAX_COLORS] = {};
-    for (int c = 0; c < components && c < FZ_MAX_COLORS; c++) {
-        conv[c] = (float)px[c] / 255.f;
-    }
-    fz_convert_color(ctx, cs, conv, rgb, srcRgb, cs, fz_default_color_params);
-    *outR = srcRgb[0];
-    *outG = srcRgb[1];
-    *outB = srcRgb[2];
-    if (pix->alpha && n > components) {
-        *outA = (float)px[components] / 255.f;
+static float ReadPixmapAlpha(const DarkPixmapReader& rd, int x, int y) {
+    fz_pixmap* pix = rd.pix;
+    if (!pix || !pix->samples || !pix->alpha || pix->n <= rd.components || x < 0 || y < 0 || x >= pix->w ||
+        y >= pix->h) {
+        return 1.f;
     }
+    unsigned char* px = pix->samples + ((size_t)y * pix->stride) + ((size_t)x * pix->n);
+    return (float)px[rd.components] / 255.f;
+}
+
+static u8 ToByte(float v) {
+    int i = (int)lroundf(v * 255.f);
+    return (u8)limitValue(i, 0, 255);
 }
 
 static void RemapForegroundPixel(float r, float g, float b, const DarkModePalette& palette, float* outR, float* outG,
@@ -146,9 +135,10 @@ static void BlurMaskBox3(float* mask, int maskW, int maskH) {
     free(tmp);
 }
 
-static bool BuildEdgeConnectedBgMask(fz_context* ctx, fz_pixmap* src, float bgR, float bgG, float bgB, float* outFgConf,
+static bool BuildEdgeConnectedBgMask(const DarkPixmapReader& rd, float bgR, float bgG, float bgB, float* outFgConf,
                                      int maskW, int maskH) {
-    if (!src || !outFgConf || maskW <= 0 || maskH <= 0) {
+    fz_pixmap* src = rd.pix;
+    if (!src || !outFgConf || maskW <= 0 || maskH <= 0 || maskW > kMaxMaskDim) {
         return false;
     }
 
@@ -170,6 +160,10 @@ static bool BuildEdgeConnectedBgMask(fz_context* ctx, fz_pixmap* src, float bgR,
     const float bgDistHard = 0.055f;
     const float bgDistSoft = 0.11f;
 
+    // gather a row of samples, then get their OKLab distances in one batch
+    u8 rowRgb[kMaxMaskDim * 3];
+    float rowAlpha[kMaxMaskDim];
+    float rowDist[kMaxMaskDim];
     for (int my = 0; my < maskH; my++) {
         int sy = (my * src->h) / maskH;
         if (sy >= src->h) {
@@ -180,15 +174,18 @@ static bool BuildEdgeConnectedBgMask(fz_context* ctx, fz_pixmap* src, float bgR,
             if (sx >= src->w) {
                 sx = src->w - 1;
             }
-            float r, g, b, a;
-            ReadPixmapPixel(ctx, src, sx, sy, &r, &g, &b, &a);
-            if (a < 0.08f) {
+            PdfDarkModeReadPixelRgb8(rd, sx, sy, rowRgb + (mx * 3));
+            rowAlpha[mx] = ReadPixmapAlpha(rd, sx, sy);
+        }
+        PdfDarkModeOklabDistanceRgb8(rowRgb, maskW, bgR, bgG, bgB, rowDist);
+        for (int mx = 0; mx < maskW; mx++) {
+            if (rowAlpha[mx] < 0.08f) {
                 bgScore[(my * maskW) + mx] = 1.f;
                 continue;
             }
-            float lum = (0.2126f * r) + (0.7152f * g) + (0.0722f * b);
-            float dist = PdfDarkModeOklabDistance(r, g, b, bgR, bgG, bgB);
-            float score = 1.f - SmoothStep(bgDistHard, bgDistSoft, dist);
+            const u8* px = rowRgb + (mx * 3);
+            float lum = ((0.2126f * px[0]) + (0.7152f * px[1]) + (0.0722f * px[2])) / 255.f;
+            float score = 1.f - SmoothStep(bgDistHard, bgDistSoft, rowDist[mx]);
             if (lum < 0.50f) {
                 score *= SmoothStep(0.50f, 0.38f, lum);
             }
@@ -286,15 +283,26 @@ fz_pixmap* PdfDarkModeProcessLightBackgroundPixmap(fz_context* ctx, fz_pixmap* s
     if (!fgMask) {
         return nullptr;
     }
-    if (!BuildEdgeConnectedBgMask(ctx, src, bgR, bgG, bgB, fgMask, maskW, maskH)) {
+    DarkPixmapReader rd;
+    PdfDarkModeInitPixmapReader(ctx, src, &rd);
+    if (!BuildEdgeConnectedBgMask(rd, bgR, bgG, bgB, fgMask, maskW, maskH)) {
         free(fgMask);
         return nullptr;
     }
 
     fz_colorspace* cs = src->colorspace ? src->colorspace : fz_device_rgb(ctx);
+    // device RGB/BGR output is written directly, so remaps can be memoized per 8-bit color
+    bool directRgb = rd.layout == DarkPixelLayout::Rgb || rd.layout == DarkPixelLayout::Bgr;
+    bool bgr = rd.layout == DarkPixelLayout::Bgr;
+    DarkRgbRemapMemo* memo = nullptr;
     fz_pixmap* dst = nullptr;
     fz_var(dst);
+    fz_var(memo);
     fz_try(ctx) {
+        if (directRgb) {
+            memo = AllocStruct<DarkRgbRemapMemo>();
+            directRgb = memo != nullptr;
+        }
         dst = fz_new_pixmap(ctx, cs, src->w, src->h, src->seps, 1);
         fz_clear_pixmap_with_value(ctx, dst, 0x00);
 
@@ -308,8 +316,7 @@ fz_pixmap* PdfDarkModeProcessLightBackgroundPixmap(fz_context* ctx, fz_pixmap* s
                 float u = src->w > 1 ? (float)x / (float)(src->w - 1) : 0.f;
                 float fgConf = SampleMaskBilinear(fgMask, maskW, maskH, u, v);
 
-                float r, g, b, a;
-                ReadPixmapPixel(ctx, src, x, y, &r, &g, &b, &a);
+                float a = ReadPixmapAlpha(rd, x, y);
                 unsigned char* px = dst->samples + ((size_t)y * dst->stride) + ((size_t)x * n);
 
                 if (fgConf < 0.04f || a < 0.02f) {
@@ -322,6 +329,39 @@ fz_pixmap* PdfDarkModeProcessLightBackgroundPixmap(fz_context* ctx, fz_pixmap* s
                     continue;
                 }
 
+                if (dst->alpha) {
+                    int av = (int)lroundf(a * fgConf * 255.f);
+                    av = limitValue(av, 0, 255);
+                    px[components] = (unsigned char)av;
+                }
+
+                if (directRgb) {
+                    const unsigned char* spx = src->samples + ((size_t)y * src->stride) + ((size_t)x * src->n);
+                    u8 in[3] = {spx[0], spx[1], spx[2]};
+                    if (bgr) {
+                        std::swap(in[0], in[2]);
+                    }
+                    u8 out[3];
+                    if (!PdfDarkModeRemapMemoLookup(memo, in, out)) {
+                        float nr, ng, nb;
+                        RemapForegroundPixel((float)in[0] / 255.f, (float)in[1] / 255.f, (float)in[2] / 255.f,
+                                             palette, &nr, &ng, &nb);
+                        out[0] = ToByte(nr);
+                        out[1] = ToByte(ng);
+                        out[2] = ToByte(nb);
+                        PdfDarkModeRemapMemoStore(memo, in, out);
+                    }
+                    if (bgr) {
+                        std::swap(out[0], out[2]);
+                    }
+                    px[0] = out[0];
+                    px[1] = out[1];
+                    px[2] = out[2];
+                    continue;
+                }
+
+                float r, g, b;
+                PdfDarkModeReadPixel(rd, x, y, &r, &g, &b);
                 float nr, ng, nb;
                 RemapForegroundPixel(r, g, b, palette, &nr, &ng, &nb);
 
@@ -329,20 +369,14 @@ fz_pixmap* PdfDarkModeProcessLightBackgroundPixmap(fz_context* ctx, fz_pixmap* s
                 float back[FZ_MAX_COLORS] = {};
                 fz_convert_color(ctx, rgb, outRgb, cs, back, cs, fz_default_color_params);
                 for (int c = 0; c < components && c < FZ_MAX_COLORS; c++) {
-                    int vpx = (int)lroundf(back[c] * 255.f);
-                    vpx = limitValue(vpx, 0, 255);
-                    px[c] = (unsigned char)vpx;
-                }
-                if (dst->alpha) {
-                    int av = (int)lroundf(a * fgConf * 255.f);
-                    av = limitValue(av, 0, 255);
-                    px[components] = (unsigned char)av;
+                    px[c] = ToByte(back[c]);
                 }
             }
         }
     }
     fz_always(ctx) {
         free(fgMask);
+        free(memo);
     }
     fz_catch(ctx) {
         if (dst) {
@@ -16,30 +16,17 @@ static constexpr int kMaxImageSamples = 1000;
 static constexpr int kGridBlocks = 10;
 static constexpr int kColorBuckets = 4096;
 
-static void SamplePixmapRgb(fz_context* ctx, fz_pixmap* pix, int x, int y, float* outR, float* outG, float* outB,
+static void SamplePixmapRgb(const DarkPixmapReader& rd, int x, int y, float* outR, float* outG, float* outB,
                             float* outA) {
-    *outR = *outG = *outB = 0.f;
     *outA = 1.f;
+    PdfDarkModeReadPixel(rd, x, y, outR, outG, outB);
+    fz_pixmap* pix = rd.pix;
     if (!pix || !pix->samples || x < 0 || y < 0 || x >= pix->w || y >= pix->h) {
         return;
     }
-    fz_colorspace* cs = pix->colorspace ? pix->colorspace : fz_device_rgb(ctx);
-    fz_colorspace* rgb = fz_device_rgb(ctx);
-    int n = pix->n;
-    int stride = (int)pix->stride;
-    unsigned char* px = pix->samples + ((size_t)y * stride) + ((size_t)x * n);
-    float conv[FZ_MAX_COLORS] = {};
-    float srcRgb[FZ_MAX_COLORS] = {};
-    int components = fz_colorspace_n(ctx, cs);
-    for (int c = 0; c < components && c < FZ_MAX_COLORS; c++) {
-        conv[c] = (float)px[c] / 255.f;
-    }
-    fz_convert_color(ctx, cs, conv, rgb, srcRgb, cs, fz_default_color_params);
-    *outR = srcRgb[0];
-    *outG = srcRgb[1];
-    *outB = srcRgb[2];
-    if (pix->alpha && n > components) {
-        *outA = (float)px[components] / 255.f;
+    if (pix->alpha && pix->n > rd.components) {
+        unsigned char* px = pix->samples + ((size_t)y * pix->stride) + ((size_t)x * pix->n);
+        *outA = (float)px[rd.components] / 255.f;
     }
 }
 
@@ -67,6 +54,8 @@ static bool PdfDarkModeExtractFeatures(fz_context* ctx, fz_image* image, float p
         if (!pix || !pix->samples || pix->w <= 0 || pix->h <= 0) {
             fz_throw(ctx, FZ_ERROR_GENERIC, "empty image pixmap");
         }
+        DarkPixmapReader rd;
+        PdfDarkModeInitPixmapReader(ctx, pix, &rd);
 
         int buckets[kColorBuckets] = {};
         int n = 0;
@@ -98,7 +87,7 @@ static bool PdfDarkModeExtractFeatures(fz_context* ctx, fz_image* image, float p
                 for (int y = y0; y < y1 && n < kMaxImageSamples; y += stepY) {
                     for (int x = x0; x < x1 && n < kMaxImageSamples; x += stepX) {
                         float r, g, b, a;
-                        SamplePixmapRgb(ctx, pix, x, y, &r, &g, &b, &a);
+                        SamplePixmapRgb(rd, x, y, &r, &g, &b, &a);
                         if (a < 0.08f) {
                             transparent++;
                             n++;
@@ -179,7 +168,7 @@ static bool PdfDarkModeExtractFeatures(fz_context* ctx, fz_image* image, float p
                 return;
             }
             float r, g, b, a;
-            SamplePixmapRgb(ctx, pix, x, y, &r, &g, &b, &a);
+            SamplePixmapRgb(rd, x, y, &r, &g, &b, &a);
             if (a < 0.08f) {
                 return;
             }
@@ -8,6 +8,7 @@ extern "C" {
 }
 
 #include "PdfDarkMode.h"
+#include "PdfDarkModeInternal.h"
 
 struct PdfDarkModeImageSampleStats {
     int significantBuckets = 0;
@@ -17,28 +18,6 @@ struct PdfDarkModeImageSampleStats {
     bool valid = false;
 };
 
-static void SamplePixmapRgb(fz_context* ctx, fz_pixmap* pix, int x, int y, float* outR, float* outG, float* outB) {
-    if (!pix || !pix->samples || x < 0 || y < 0 || x >= pix->w || y >= pix->h) {
-        *outR = *outG = *outB = 0.f;
-        return;
-    }
-    fz_colorspace* cs = pix->colorspace ? pix->colorspace : fz_device_rgb(ctx);
-    fz_colorspace* rgb = fz_device_rgb(ctx);
-    int n = pix->n;
-    int stride = (int)pix->stride;
-    unsigned char* px = pix->samples + ((size_t)y * stride) + ((size_t)x * n);
-    float conv[FZ_MAX_COLORS] = {};
-    float srcRgb[FZ_MAX_COLORS] = {};
-    int components = fz_colorspace_n(ctx, cs);
-    for (int c = 0; c < components && c < FZ_MAX_COLORS; c++) {
-        conv[c] = (float)px[c] / 255.f;
-    }
-    fz_convert_color(ctx, cs, conv, rgb, srcRgb, cs, fz_default_color_params);
-    *outR = srcRgb[0];
-    *outG = srcRgb[1];
-    *outB = srcRgb[2];
-}
-
 static PdfDarkModeImageSampleStats PdfDarkModeSampleImageStats(fz_context* ctx, fz_image* image) {
     PdfDarkModeImageSampleStats stats;
     if (!ctx || !image) {
@@ -61,6 +40,8 @@ static PdfDarkModeImageSampleStats PdfDarkModeSampleImageStats(fz_context* ctx,
         if (!pix || !pix->samples || pix->w <= 0 || pix->h <= 0) {
             fz_throw(ctx, FZ_ERROR_GENERIC, "empty image pixmap");
         }
+        DarkPixmapReader rd;
+        PdfDarkModeInitPixmapReader(ctx, pix, &rd);
 
         int buckets[4096] = {};
         int n = 0;
@@ -74,7 +55,7 @@ static PdfDarkModeImageSampleStats PdfDarkModeSampleImageStats(fz_context* ctx,
         for (int y = 0; y < pix->h; y += stepY) {
             for (int x = 0; x < pix->w; x += stepX) {
                 float r, g, b;
-                SamplePixmapRgb(ctx, pix, x, y, &r, &g, &b);
+                PdfDarkModeReadPixel(rd, x, y, &r, &g, &b);
                 int ri = (int)lroundf(r * 255.f);
                 int gi = (int)lroundf(g * 255.f);
                 int bi = (int)lroundf(b * 255.f);
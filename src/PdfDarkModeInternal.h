@@ -60,4 +60,40 @@ fz_pixmap* PdfDarkModeProcessScanPixmap(fz_context* ctx, fz_pixmap* src, const D
 fz_image* PdfDarkModeGetCachedShade(fz_context* ctx, DarkModePageAnalysis* analysis, fz_shade* shade, fz_matrix ctm,
                                     float alpha, fz_irect bounds, const DarkModePalette& palette);
 
+// Reads 8-bit pixmap samples as sRGB. Device RGB/BGR samples are used as is and
+// single-channel colorspaces go through a 256-entry table, so only CMYK and
+// other multi-channel colorspaces pay for fz_convert_color per pixel.
+enum class DarkPixelLayout {
+    Convert,
+    Rgb,
+    Bgr,
+    Table,
+};
+
+struct DarkPixmapReader {
+    fz_context* ctx = nullptr;
+    fz_pixmap* pix = nullptr;
+    fz_colorspace* cs = nullptr;
+    int components = 0;
+    DarkPixelLayout layout = DarkPixelLayout::Convert;
+    float table[256 * 3];
+};
+
+void PdfDarkModeInitPixmapReader(fz_context* ctx, fz_pixmap* pix, DarkPixmapReader* rd);
+void PdfDarkModeReadPixel(const DarkPixmapReader& rd, int x, int y, float* outR, float* outG, float* outB);
+void PdfDarkModeReadPixelRgb8(const DarkPixmapReader& rd, int x, int y, u8* outRgb);
+
+// Images repeat a limited set of colors (paper, ink and their anti-aliasing
+// ramps), so per-pixel recoloring remembers recent 8-bit RGB remaps in a
+// direct-mapped table. Allocate zeroed.
+constexpr int kDarkRemapMemoBits = 12;
+
+struct DarkRgbRemapMemo {
+    u32 keys[1 << kDarkRemapMemoBits]; // rgb + 1, 0 for an empty slot
+    u8 values[(1 << kDarkRemapMemoBits) * 3];
+};
+
+bool PdfDarkModeRemapMemoLookup(const DarkRgbRemapMemo* memo, const u8* rgb, u8* outRgb);
+void PdfDarkModeRemapMemoStore(DarkRgbRemapMemo* memo, const u8* rgb, const u8* remapped);
+
 void PdfDarkModeClearPixmapToThemeBackground(fz_context* ctx, fz_pixmap* pix, const DarkModePalette& palette);
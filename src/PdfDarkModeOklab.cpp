@@ -2,6 +2,24 @@
    License: GPLv3 */
 
 #include "base/Base.h"
+#if OS_WIN
+#include "base/Win.h"
+#endif
+
+#if IS_INTEL_64 || IS_INTEL_32
+#include <immintrin.h>
+#define OKLAB_SIMD 1
+#else
+#define OKLAB_SIMD 0
+#endif
+
+// clang-cl and gcc only allow AVX2 intrinsics in functions compiled for AVX2;
+// cl.exe allows them anywhere
+#if OKLAB_SIMD && (COMPILER_CLANG || COMPILER_GCC)
+#define OKLAB_AVX2_FUNC __attribute__((target("avx2")))
+#else
+#define OKLAB_AVX2_FUNC
+#endif
 
 #include "PdfDarkMode.h"
 
@@ -77,11 +95,40 @@ static float OklabChroma(const OklabColor& lab) {
     return sqrtf((lab.a * lab.a) + (lab.b * lab.b));
 }
 
+// image recoloring maps every pixel against the same palette so remember the
+// palette's OKLab values instead of converting text and bg colors per call
+struct PaletteOklabCache {
+    float textR = -1.f, textG = -1.f, textB = -1.f;
+    float bgR = -1.f, bgG = -1.f, bgB = -1.f;
+    OklabColor text;
+    OklabColor bg;
+};
+
+static thread_local PaletteOklabCache gPaletteOklab;
+
+static const PaletteOklabCache& GetPaletteOklab(const DarkModePalette& palette) {
+    PaletteOklabCache& c = gPaletteOklab;
+    bool same = c.textR == palette.textR && c.textG == palette.textG && c.textB == palette.textB &&
+                c.bgR == palette.bgR && c.bgG == palette.bgG && c.bgB == palette.bgB;
+    if (!same) {
+        c.textR = palette.textR;
+        c.textG = palette.textG;
+        c.textB = palette.textB;
+        c.bgR = palette.bgR;
+        c.bgG = palette.bgG;
+        c.bgB = palette.bgB;
+        c.text = SrgbToOklab(palette.textR, palette.textG, palette.textB);
+        c.bg = SrgbToOklab(palette.bgR, palette.bgG, palette.bgB);
+    }
+    return c;
+}
+
 // OKLab perceptual remap for SmartDark text/vector colors (Phase 2).
 void MapRgbToDarkThemeOklab(float r, float g, float b, const DarkModePalette& palette, float* outRgb) {
     OklabColor src = SrgbToOklab(r, g, b);
-    OklabColor text = SrgbToOklab(palette.textR, palette.textG, palette.textB);
-    OklabColor bg = SrgbToOklab(palette.bgR, palette.bgG, palette.bgB);
+    const PaletteOklabCache& pal = GetPaletteOklab(palette);
+    const OklabColor& text = pal.text;
+    const OklabColor& bg = pal.bg;
 
     // Monotone lightness remap in OKLab; preserve hue via a/b direction.
     float outL = text.L + (src.L * (bg.L - text.L));
@@ -124,3 +171,205 @@ float PdfDarkModeOklabDistance(float r1, float g1, float b1, float r2, float g2,
     float db = a.b - c.b;
     return sqrtf((dL * dL) + (da * da) + (db * db));
 }
+
+//--- batched 8-bit sRGB -> OKLab
+
+// pixmap samples are 8-bit so the sRGB transfer curve is a table lookup
+static const float* Srgb8ToLinearTable() {
+    static float* table = [] {
+        static float t[256];
+        for (int i = 0; i < 256; i++) {
+            t[i] = SrgbToLinear((float)i / 255.f);
+        }
+        return t;
+    }();
+    return table;
+}
+
+// cbrtf() is a libm call per channel and doesn't vectorize. An exponent / 3
+// bit trick is within ~4% and each Newton step squares the error, so three
+// steps reach float precision on the [0, 1] range OKLab works with.
+// The SIMD kernels below do the same steps in the same order.
+static float FastCbrt(float x) {
+    if (x <= 0.f) {
+        return 0.f;
+    }
+    u32 bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits = (u32)((float)bits * (1.f / 3.f)) + 0x2a514067;
+    float y;
+    memcpy(&y, &bits, sizeof(y));
+    for (int i = 0; i < 3; i++) {
+        y = ((2.f * y) + (x / (y * y))) * (1.f / 3.f);
+    }
+    return y;
+}
+
+static void LinearToOklab(float lr, float lg, float lb, float* outL, float* outA, float* outB) {
+    float l = (0.4122214708f * lr) + (0.5363325363f * lg) + (0.0514459929f * lb);
+    float m = (0.2119034982f * lr) + (0.6806995451f * lg) + (0.1073969566f * lb);
+    float s = (0.0883024619f * lr) + (0.2817188376f * lg) + (0.6299787005f * lb);
+
+    l = FastCbrt(l);
+    m = FastCbrt(m);
+    s = FastCbrt(s);
+
+    *outL = (0.2104542553f * l) + (0.7936177850f * m) - (0.0040720468f * s);
+    *outA = (1.9779984951f * l) - (2.4285922050f * m) + (0.4505937099f * s);
+    *outB = (0.0259040371f * l) + (0.7827717662f * m) - (0.8086757660f * s);
+}
+
+static void Rgb8ToOklabScalar(const u8* rgb, int n, float* outL, float* outA, float* outB) {
+    const float* lin = Srgb8ToLinearTable();
+    for (int i = 0; i < n; i++) {
+        const u8* px = rgb + ((size_t)i * 3);
+        LinearToOklab(lin[px[0]], lin[px[1]], lin[px[2]], &outL[i], &outA[i], &outB[i]);
+    }
+}
+
+#if OKLAB_SIMD
+
+static __m128 FastCbrtSse2(__m128 x) {
+    __m128 third = _mm_set1_ps(1.f / 3.f);
+    __m128 positive = _mm_cmpgt_ps(x, _mm_setzero_ps());
+    // clamp so that the division below can't produce NaN for x <= 0
+    __m128 xs = _mm_max_ps(x, _mm_set1_ps(1e-30f));
+    __m128i bits = _mm_castps_si128(xs);
+    bits = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(bits), third));
+    bits = _mm_add_epi32(bits, _mm_set1_epi32(0x2a514067));
+    __m128 y = _mm_castsi128_ps(bits);
+    for (int i = 0; i < 3; i++) {
+        __m128 twoY = _mm_add_ps(y, y);
+        y = _mm_mul_ps(_mm_add_ps(twoY, _mm_div_ps(xs, _mm_mul_ps(y, y))), third);
+    }
+    return _mm_and_ps(y, positive);
+}
+
+static __m128 Dot3Sse2(__m128 x, __m128 y, __m128 z, float c0, float c1, float c2) {
+    __m128 v = _mm_mul_ps(_mm_set1_ps(c0), x);
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(c1), y));
+    return _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(c2), z));
+}
+
+static void Rgb8ToOklabSse2(const u8* rgb, int n, float* outL, float* outA, float* outB) {
+    const float* lin = Srgb8ToLinearTable();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const u8* px = rgb + ((size_t)i * 3);
+        __m128 lr = _mm_setr_ps(lin[px[0]], lin[px[3]], lin[px[6]], lin[px[9]]);
+        __m128 lg = _mm_setr_ps(lin[px[1]], lin[px[4]], lin[px[7]], lin[px[10]]);
+        __m128 lb = _mm_setr_ps(lin[px[2]], lin[px[5]], lin[px[8]], lin[px[11]]);
+
+        __m128 l = FastCbrtSse2(Dot3Sse2(lr, lg, lb, 0.4122214708f, 0.5363325363f, 0.0514459929f));
+        __m128 m = FastCbrtSse2(Dot3Sse2(lr, lg, lb, 0.2119034982f, 0.6806995451f, 0.1073969566f));
+        __m128 s = FastCbrtSse2(Dot3Sse2(lr, lg, lb, 0.0883024619f, 0.2817188376f, 0.6299787005f));
+
+        _mm_storeu_ps(outL + i, Dot3Sse2(l, m, s, 0.2104542553f, 0.7936177850f, -0.0040720468f));
+        _mm_storeu_ps(outA + i, Dot3Sse2(l, m, s, 1.9779984951f, -2.4285922050f, 0.4505937099f));
+        _mm_storeu_ps(outB + i, Dot3Sse2(l, m, s, 0.0259040371f, 0.7827717662f, -0.8086757660f));
+    }
+    Rgb8ToOklabScalar(rgb + ((size_t)i * 3), n - i, outL + i, outA + i, outB + i);
+}
+
+OKLAB_AVX2_FUNC static __m256 FastCbrtAvx2(__m256 x) {
+    __m256 third = _mm256_set1_ps(1.f / 3.f);
+    __m256 positive = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ);
+    __m256 xs = _mm256_max_ps(x, _mm256_set1_ps(1e-30f));
+    __m256i bits = _mm256_castps_si256(xs);
+    bits = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(bits), third));
+    bits = _mm256_add_epi32(bits, _mm256_set1_epi32(0x2a514067));
+    __m256 y = _mm256_castsi256_ps(bits);
+    for (int i = 0; i < 3; i++) {
+        __m256 twoY = _mm256_add_ps(y, y);
+        y = _mm256_mul_ps(_mm256_add_ps(twoY, _mm256_div_ps(xs, _mm256_mul_ps(y, y))), third);
+    }
+    return _mm256_and_ps(y, positive);
+}
+
+OKLAB_AVX2_FUNC static __m256 Dot3Avx2(__m256 x, __m256 y, __m256 z, float c0, float c1, float c2) {
+    __m256 v = _mm256_mul_ps(_mm256_set1_ps(c0), x);
+    v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(c1), y));
+    return _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(c2), z));
+}
+
+OKLAB_AVX2_FUNC static void Rgb8ToOklabAvx2(const u8* rgb, int n, float* outL, float* outA, float* outB) {
+    const float* lin = Srgb8ToLinearTable();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const u8* px = rgb + ((size_t)i * 3);
+        // gathers are slower than scalar table loads on many CPUs
+        __m256 lr = _mm256_setr_ps(lin[px[0]], lin[px[3]], lin[px[6]], lin[px[9]], lin[px[12]], lin[px[15]],
+                                   lin[px[18]], lin[px[21]]);
+        __m256 lg = _mm256_setr_ps(lin[px[1]], lin[px[4]], lin[px[7]], lin[px[10]], lin[px[13]], lin[px[16]],
+                                   lin[px[19]], lin[px[22]]);
+        __m256 lb = _mm256_setr_ps(lin[px[2]], lin[px[5]], lin[px[8]], lin[px[11]], lin[px[14]], lin[px[17]],
+                                   lin[px[20]], lin[px[23]]);
+
+        __m256 l = FastCbrtAvx2(Dot3Avx2(lr, lg, lb, 0.4122214708f, 0.5363325363f, 0.0514459929f));
+        __m256 m = FastCbrtAvx2(Dot3Avx2(lr, lg, lb, 0.2119034982f, 0.6806995451f, 0.1073969566f));
+        __m256 s = FastCbrtAvx2(Dot3Avx2(lr, lg, lb, 0.0883024619f, 0.2817188376f, 0.6299787005f));
+
+        _mm256_storeu_ps(outL + i, Dot3Avx2(l, m, s, 0.2104542553f, 0.7936177850f, -0.0040720468f));
+        _mm256_storeu_ps(outA + i, Dot3Avx2(l, m, s, 1.9779984951f, -2.4285922050f, 0.4505937099f));
+        _mm256_storeu_ps(outB + i, Dot3Avx2(l, m, s, 0.0259040371f, 0.7827717662f, -0.8086757660f));
+    }
+    Rgb8ToOklabSse2(rgb + ((size_t)i * 3), n - i, outL + i, outA + i, outB + i);
+}
+
+static bool CpuHasAvx2() {
+#if OS_WIN
+    return (CpuID() & kCpuAVX2) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+using Rgb8ToOklabFn = void (*)(const u8* rgb, int n, float* outL, float* outA, float* outB);
+
+static Rgb8ToOklabFn PickRgb8ToOklab(PdfDarkModeSimd simd) {
+#if OKLAB_SIMD
+    if (simd == PdfDarkModeSimd::Best && CpuHasAvx2()) {
+        return Rgb8ToOklabAvx2;
+    }
+    if (simd != PdfDarkModeSimd::Scalar) {
+        return Rgb8ToOklabSse2;
+    }
+#endif
+    return Rgb8ToOklabScalar;
+}
+
+// converts n packed 8-bit sRGB pixels (3 bytes each) to OKLab. Uses AVX2 or
+// SSE2 on x86/x64; results match the scalar path to within float rounding
+void PdfDarkModeRgb8ToOklab(const u8* rgb, int n, float* outL, float* outA, float* outB, PdfDarkModeSimd simd) {
+    if (!rgb || n <= 0) {
+        return;
+    }
+    if (simd == PdfDarkModeSimd::Best) {
+        static Rgb8ToOklabFn best = PickRgb8ToOklab(PdfDarkModeSimd::Best);
+        best(rgb, n, outL, outA, outB);
+        return;
+    }
+    PickRgb8ToOklab(simd)(rgb, n, outL, outA, outB);
+}
+
+// OKLab distance of n packed 8-bit sRGB pixels to (refR, refG, refB); batched
+// equivalent of PdfDarkModeOklabDistance() for background masks
+void PdfDarkModeOklabDistanceRgb8(const u8* rgb, int n, float refR, float refG, float refB, float* outDist) {
+    constexpr int kBatch = 256;
+    float L[kBatch];
+    float A[kBatch];
+    float B[kBatch];
+    OklabColor ref = SrgbToOklab(refR, refG, refB);
+    for (int start = 0; start < n; start += kBatch) {
+        int count = std::min(kBatch, n - start);
+        PdfDarkModeRgb8ToOklab(rgb + ((size_t)start * 3), count, L, A, B);
+        for (int i = 0; i < count; i++) {
+            float dL = L[i] - ref.L;
+            float da = A[i] - ref.a;
+            float db = B[i] - ref.b;
+            outDist[start + i] = sqrtf((dL * dL) + (da * da) + (db * db));
+        }
+    }
+}
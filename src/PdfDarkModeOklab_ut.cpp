@@ -5,6 +5,7 @@
 
 #include "PdfDarkMode.h"
 
+#include "base/Timer.h"
 #include "base/UtAssert.h"
 
 static float SrgbToLinear(float c) {
@@ -89,4 +90,102 @@ void PdfDarkModeOklab_UnitTests() {
     utassert(PdfDarkModeOklabDistance(1.f, 1.f, 1.f, 1.f, 1.f, 1.f) < 0.001f);
     utassert(PdfDarkModeOklabDistance(1.f, 1.f, 1.f, 0.f, 0.f, 0.f) > 0.15f);
     utassert(PdfDarkModeOklabDistance(0.95f, 0.93f, 0.88f, 0.97f, 0.95f, 0.90f) < 0.06f);
+
+    // batched kernels: every SIMD level matches the scalar path and the
+    // approximated cube root stays close to the cbrtf() based distance.
+    // 1021 pixels is not a multiple of 4 or 8 so the tails are covered too
+    const int kPixels = 1021;
+    u8* rgb = AllocArray<u8>(kPixels * 3);
+    float* L[3];
+    float* A[3];
+    float* B[3];
+    for (int i = 0; i < kPixels * 3; i++) {
+        rgb[i] = (u8)((i * 97) + (i / 3));
+    }
+    rgb[0] = rgb[1] = rgb[2] = 0;
+    PdfDarkModeSimd levels[3] = {PdfDarkModeSimd::Scalar, PdfDarkModeSimd::Sse2, PdfDarkModeSimd::Best};
+    for (int k = 0; k < 3; k++) {
+        L[k] = AllocArray<float>(kPixels);
+        A[k] = AllocArray<float>(kPixels);
+        B[k] = AllocArray<float>(kPixels);
+        PdfDarkModeRgb8ToOklab(rgb, kPixels, L[k], A[k], B[k], levels[k]);
+    }
+    float maxDiff = 0.f;
+    for (int k = 1; k < 3; k++) {
+        for (int i = 0; i < kPixels; i++) {
+            maxDiff = std::max(maxDiff, fabsf(L[k][i] - L[0][i]));
+            maxDiff = std::max(maxDiff, fabsf(A[k][i] - A[0][i]));
+            maxDiff = std::max(maxDiff, fabsf(B[k][i] - B[0][i]));
+        }
+    }
+    utassert(maxDiff < 1e-5f);
+    utassert(fabsf(L[0][0]) < 1e-5f);
+
+    float* dist = AllocArray<float>(kPixels);
+    PdfDarkModeOklabDistanceRgb8(rgb, kPixels, palette.bgR, palette.bgG, palette.bgB, dist);
+    maxDiff = 0.f;
+    for (int i = 0; i < kPixels; i++) {
+        const u8* px = rgb + (i * 3);
+        float ref = PdfDarkModeOklabDistance((float)px[0] / 255.f, (float)px[1] / 255.f, (float)px[2] / 255.f,
+                                             palette.bgR, palette.bgG, palette.bgB);
+        maxDiff = std::max(maxDiff, fabsf(dist[i] - ref));
+    }
+    utassert(maxDiff < 1e-4f);
+
+    free(dist);
+    for (int k = 0; k < 3; k++) {
+        free(L[k]);
+        free(A[k]);
+        free(B[k]);
+    }
+    free(rgb);
+}
+
+// test_util.exe -bench-oklab
+void PdfDarkModeOklab_Benchmark() {
+    const int kPixels = 1 << 20;
+    const int kRuns = 20;
+    u8* rgb = AllocArray<u8>(kPixels * 3);
+    float* L = AllocArray<float>(kPixels);
+    float* A = AllocArray<float>(kPixels);
+    float* B = AllocArray<float>(kPixels);
+    u32 seed = 1;
+    for (int i = 0; i < kPixels * 3; i++) {
+        seed = (seed * 1664525) + 1013904223;
+        rgb[i] = (u8)(seed >> 24);
+    }
+
+    struct {
+        PdfDarkModeSimd simd;
+        const char* name;
+    } levels[] = {
+        {PdfDarkModeSimd::Scalar, "scalar"},
+        {PdfDarkModeSimd::Sse2, "sse2"},
+        {PdfDarkModeSimd::Best, "best"},
+    };
+    for (auto& level : levels) {
+        auto t = TimeGet();
+        for (int i = 0; i < kRuns; i++) {
+            PdfDarkModeRgb8ToOklab(rgb, kPixels, L, A, B, level.simd);
+        }
+        double ms = TimeSinceInMs(t);
+        double mpx = ((double)kPixels * kRuns) / (ms * 1000.0);
+        printf("rgb8 -> oklab %-6s: %.2f ms, %.1f Mpixels/s\n", level.name, ms / kRuns, mpx);
+    }
+
+    // the pre-batching per-pixel path for comparison
+    auto t = TimeGet();
+    float sum = 0.f;
+    for (int i = 0; i < kPixels; i++) {
+        const u8* px = rgb + (i * 3);
+        sum += PdfDarkModeOklabDistance((float)px[0] / 255.f, (float)px[1] / 255.f, (float)px[2] / 255.f, 0.f, 0.f,
+                                        0.f);
+    }
+    double ms = TimeSinceInMs(t);
+    printf("per-pixel distance    : %.2f ms, %.1f Mpixels/s (%.1f)\n", ms, (double)kPixels / (ms * 1000.0), sum);
+
+    free(rgb);
+    free(L);
+    free(A);
+    free(B);
 }
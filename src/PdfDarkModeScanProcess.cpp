@@ -36,29 +36,9 @@ static float SmoothStep(float e0, float e1, float x) {
     return t * t * (3.f - (2.f * t));
 }
 
-static void ReadPixmapRgb(fz_context* ctx, fz_pixmap* pix, int x, int y, float* outR, float* outG, float* outB) {
-    *outR = *outG = *outB = 0.f;
-    if (!pix || !pix->samples || x < 0 || y < 0 || x >= pix->w || y >= pix->h) {
-        return;
-    }
-    fz_colorspace* cs = pix->colorspace ? pix->colorspace : fz_device_rgb(ctx);
-    fz_colorspace* rgb = fz_device_rgb(ctx);
-    int n = pix->n;
-    int components = fz_colorspace_n(ctx, cs);
-    unsigned char* px = pix->samples + ((size_t)y * pix->stride) + ((size_t)x * n);
-    float conv[FZ_MAX_COLORS] = {};
-    float srcRgb[FZ_MAX_COLORS] = {};
-    for (int c = 0; c < components && c < FZ_MAX_COLORS; c++) {
-        conv[c] = (float)px[c] / 255.f;
-    }
-    fz_convert_color(ctx, cs, conv, rgb, srcRgb, cs, fz_default_color_params);
-    *outR = srcRgb[0];
-    *outG = srcRgb[1];
-    *outB = srcRgb[2];
-}
-
-static PixelColor EstimatePaperFromPixmap(fz_context* ctx, fz_pixmap* pix, const DarkImageAnalysis& analysis) {
+static PixelColor EstimatePaperFromPixmap(const DarkPixmapReader& rd, const DarkImageAnalysis& analysis) {
     PixelColor paper = analysis.estimatedBackground;
+    fz_pixmap* pix = rd.pix;
     if (!pix || pix->w <= 0 || pix->h <= 0) {
         return paper;
     }
@@ -77,7 +57,7 @@ static PixelColor EstimatePaperFromPixmap(fz_context* ctx, fz_pixmap* pix, const
             return;
         }
         float r, g, b;
-        ReadPixmapRgb(ctx, pix, x, y, &r, &g, &b);
+        PdfDarkModeReadPixel(rd, x, y, &r, &g, &b);
         rs[n] = r;
         gs[n] = g;
         bs[n] = b;
@@ -205,6 +185,76 @@ static void WritePixmapRgb(fz_context* ctx, fz_pixmap* pix, int x, int y, float
     }
 }
 
+static u8 ToByte(float v) {
+    int i = (int)lroundf(v * 255.f);
+    return (u8)limitValue(i, 0, 255);
+}
+
+static void RemapScanRgb8(DarkRgbRemapMemo* memo, const u8* rgb, const DarkImageAnalysis& analysis,
+                          const DarkModePalette& palette, u8* outRgb) {
+    if (PdfDarkModeRemapMemoLookup(memo, rgb, outRgb)) {
+        return;
+    }
+    float nr, ng, nb;
+    PdfDarkModeRemapScanPixel((float)rgb[0] / 255.f, (float)rgb[1] / 255.f, (float)rgb[2] / 255.f, analysis, palette,
+                              &nr, &ng, &nb);
+    outRgb[0] = ToByte(nr);
+    outRgb[1] = ToByte(ng);
+    outRgb[2] = ToByte(nb);
+    PdfDarkModeRemapMemoStore(memo, rgb, outRgb);
+}
+
+static void RemapScanRgbPixmap(fz_pixmap* pix, bool bgr, const DarkImageAnalysis& analysis,
+                               const DarkModePalette& palette) {
+    DarkRgbRemapMemo* memo = AllocStruct<DarkRgbRemapMemo>();
+    if (!memo) {
+        return;
+    }
+    int n = pix->n;
+    for (int y = 0; y < pix->h; y++) {
+        u8* px = pix->samples + ((size_t)y * pix->stride);
+        for (int x = 0; x < pix->w; x++, px += n) {
+            u8 rgb[3] = {px[0], px[1], px[2]};
+            if (bgr) {
+                std::swap(rgb[0], rgb[2]);
+            }
+            u8 out[3];
+            RemapScanRgb8(memo, rgb, analysis, palette, out);
+            if (bgr) {
+                std::swap(out[0], out[2]);
+            }
+            px[0] = out[0];
+            px[1] = out[1];
+            px[2] = out[2];
+        }
+    }
+    free(memo);
+}
+
+// single-channel scans (the common case for books) have only 256 possible
+// inputs: remap each once and apply the table
+static void RemapScanTablePixmap(fz_context* ctx, const DarkPixmapReader& rd, const DarkImageAnalysis& analysis,
+                                 const DarkModePalette& palette) {
+    fz_pixmap* pix = rd.pix;
+    fz_colorspace* rgb = fz_device_rgb(ctx);
+    u8 lut[256];
+    for (int i = 0; i < 256; i++) {
+        const float* src = rd.table + (i * 3);
+        float out[FZ_MAX_COLORS] = {};
+        PdfDarkModeRemapScanPixel(src[0], src[1], src[2], analysis, palette, &out[0], &out[1], &out[2]);
+        float back[FZ_MAX_COLORS] = {};
+        fz_convert_color(ctx, rgb, out, rd.cs, back, rd.cs, fz_default_color_params);
+        lut[i] = ToByte(back[0]);
+    }
+    int n = pix->n;
+    for (int y = 0; y < pix->h; y++) {
+        u8* px = pix->samples + ((size_t)y * pix->stride);
+        for (int x = 0; x < pix->w; x++, px += n) {
+            px[0] = lut[px[0]];
+        }
+    }
+}
+
 // Phase 5: returns processed pixmap for FullPageScan, or nullptr to fall back.
 fz_pixmap* PdfDarkModeProcessScanPixmap(fz_context* ctx, fz_pixmap* src, const DarkImageAnalysis& analysis,
                                         const DarkModePalette& palette) {
@@ -218,20 +268,34 @@ fz_pixmap* PdfDarkModeProcessScanPixmap(fz_context* ctx, fz_pixmap* src, const D
         return nullptr;
     }
 
+    DarkPixmapReader rd;
+    PdfDarkModeInitPixmapReader(ctx, src, &rd);
     DarkImageAnalysis work = analysis;
-    work.estimatedBackground = EstimatePaperFromPixmap(ctx, src, analysis);
+    work.estimatedBackground = EstimatePaperFromPixmap(rd, analysis);
 
     fz_pixmap* dst = fz_new_pixmap(ctx, src->colorspace, src->w, src->h, src->seps, src->alpha);
     fz_copy_pixmap_rect(ctx, dst, src, fz_make_irect(0, 0, src->w, src->h), nullptr);
+    rd.pix = dst;
 
-    for (int y = 0; y < dst->h; y++) {
-        for (int x = 0; x < dst->w; x++) {
-            float r, g, b;
-            ReadPixmapRgb(ctx, dst, x, y, &r, &g, &b);
-            float nr, ng, nb;
-            PdfDarkModeRemapScanPixel(r, g, b, work, palette, &nr, &ng, &nb);
-            WritePixmapRgb(ctx, dst, x, y, nr, ng, nb);
-        }
+    switch (rd.layout) {
+        case DarkPixelLayout::Rgb:
+        case DarkPixelLayout::Bgr:
+            RemapScanRgbPixmap(dst, rd.layout == DarkPixelLayout::Bgr, work, palette);
+            break;
+        case DarkPixelLayout::Table:
+            RemapScanTablePixmap(ctx, rd, work, palette);
+            break;
+        default:
+            for (int y = 0; y < dst->h; y++) {
+                for (int x = 0; x < dst->w; x++) {
+                    float r, g, b;
+                    PdfDarkModeReadPixel(rd, x, y, &r, &g, &b);
+                    float nr, ng, nb;
+                    PdfDarkModeRemapScanPixel(r, g, b, work, palette, &nr, &ng, &nb);
+                    WritePixmapRgb(ctx, dst, x, y, nr, ng, nb);
+                }
+            }
+            break;
     }
     return dst;
 }
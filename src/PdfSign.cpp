@@ -9,6 +9,7 @@
 
 #include "base/Base.h"
 #include "base/File.h"
+#include "base/RectIndex.h"
 #include "base/ScopedWin.h"
 
 #ifndef WIN32_LEAN_AND_MEAN
@@ -5,6 +5,7 @@
 #include "gui/Dpi.h"
 #include "base/File.h"
 #include "base/Win.h"
+#include "base/UITask.h"
 
 #include "gui/UIModels.h"
 #include "gui/Layout.h"
@@ -32,6 +33,7 @@
 #include "Flags.h"
 #include "DisplayModel.h"
 #include "Theme.h"
+#include "TextExport.h"
 
 #include "DarkMode_win.h"
 
@@ -357,13 +359,73 @@ void ShowPdfBakeDialog(MainWindow* win) {
 
 // --- Extract PDF Text dialog ---
 
+struct ExtractTextJob;
+
 struct PdfExtractTextDialog : PdfToolDialog {
     Edit* pagesEdit = nullptr;
+    // set while a background export is running
+    ExtractTextJob* job = nullptr;
+
+    ~PdfExtractTextDialog() override;
     bool Create(MainWindow* win, WindowTab* tab);
     void DoIt(VirtMouseEvent* ev = nullptr) override;
+    void OnExportProgress(int percent);
+    void OnExportFinished(bool ok, Str destPath);
+};
+
+// Text export of a non-PDF document, running on a background thread. Closing
+// the dialog cancels it; the job itself is freed on the ui thread once the
+// export thread is done, so it can outlive the dialog.
+struct ExtractTextJob {
+    PdfExtractTextDialog* dlg = nullptr;
+    TextExportArgs args;
+    AtomicBool cancel = 0;
+    // last percentage posted to the ui, to post ~100 updates instead of one per page
+    int lastPercent = -1;
+    bool ok = false;
 };
 
-static bool ExtractTextViaEngine(PdfExtractTextDialog* dlg, Str destPath, Str pages) {
+struct ExtractTextProgressData {
+    ExtractTextJob* job = nullptr;
+    int percent = 0;
+};
+
+static void ExtractTextProgressOnUIThread(ExtractTextProgressData* d) {
+    if (d->job->dlg) {
+        d->job->dlg->OnExportProgress(d->percent);
+    }
+    delete d;
+}
+
+static void ExtractTextOnProgress(ExtractTextJob* job, TextExportProgress* progress) {
+    int percent = progress->pagesTotal > 0 ? (progress->pagesDone * 100) / progress->pagesTotal : 100;
+    if (percent == job->lastPercent) {
+        return;
+    }
+    job->lastPercent = percent;
+    auto data = new ExtractTextProgressData();
+    data->job = job;
+    data->percent = percent;
+    uitask::Post(MkFunc0(ExtractTextProgressOnUIThread, data), "ExtractTextProgress");
+}
+
+static void ExtractTextFinishedOnUIThread(ExtractTextJob* job) {
+    if (job->dlg) {
+        job->dlg->OnExportFinished(job->ok, job->args.destPath);
+    }
+    job->args.engine->Release();
+    str::Free(job->args.destPath);
+    delete job;
+}
+
+static void ExtractTextThread(ExtractTextJob* job) {
+    job->ok = ExportDocumentText(&job->args);
+    uitask::Post(MkFunc0(ExtractTextFinishedOnUIThread, job), "ExtractTextFinished");
+}
+
+// pages are extracted in parallel and streamed to destPath on a background
+// thread; the dialog shows progress and is closed when it's done
+static bool StartExtractTextViaEngine(PdfExtractTextDialog* dlg, Str destPath, Str pages) {
     MainWindow* win = dlg->win;
     if (!win || !win->ctrl) {
         return false;
@@ -381,20 +443,59 @@ static bool ExtractTextViaEngine(PdfExtractTextDialog* dlg, Str destPath, Str pa
     if (!ParsePageRanges(pages, ranges)) {
         return false;
     }
-    str::Builder text;
+
+    auto job = new ExtractTextJob();
     for (auto& range : ranges) {
         int start = std::max(range.start, 1);
         int end = std::min(range.end, pageCount);
         for (int pageNo = start; pageNo <= end; pageNo++) {
-            PageText pt = engine->ExtractPageText(pageNo);
-            if (pt.text) {
-                text.Append(Str(pt.text.s));
-                text.AppendChar('\n');
-            }
-            FreePageText(&pt);
+            job->args.pages.Append(pageNo);
         }
     }
-    return file::WriteFile(destPath, ToStr(text));
+    engine->AddRef();
+    job->dlg = dlg;
+    job->args.engine = engine;
+    job->args.destPath = str::Dup(destPath);
+    job->args.cancel = &job->cancel;
+    job->args.cbProgress = MkFunc1(ExtractTextOnProgress, job);
+    ThreadHandle th = StartThread(MkFunc0(ExtractTextThread, job), StrL("ExtractTextThread"));
+    if (!th) {
+        engine->Release();
+        str::Free(job->args.destPath);
+        delete job;
+        return false;
+    }
+    SafeCloseThreadHandle(&th);
+    dlg->job = job;
+    dlg->actionBtn->SetIsEnabled(false);
+    return true;
+}
+
+PdfExtractTextDialog::~PdfExtractTextDialog() {
+    if (job) {
+        job->dlg = nullptr;
+        AtomicBoolSet(&job->cancel, true);
+    }
+}
+
+void PdfExtractTextDialog::OnExportProgress(int percent) {
+    TempStr title = fmt("%s - %d%%", _TRA("Extract Text From PDF"), percent);
+    HwndSetText(hwnd, title);
+}
+
+void PdfExtractTextDialog::OnExportFinished(bool ok, Str destPath) {
+    job = nullptr;
+    if (ok) {
+        logf("PdfExtractTextDoIt: extracted successfully\n");
+        TempStr path = str::DupTemp(destPath);
+        Close();
+        OpenPathInDefaultFileManager(path);
+        return;
+    }
+    logf("PdfExtractTextDoIt: failed to extract text via engine\n");
+    actionBtn->SetIsEnabled(true);
+    HwndSetText(hwnd, _TRA("Extract Text From PDF"));
+    MessageBoxWarning(hwnd, StrL("Failed to extract text."), _TRA("Extract Text"));
 }
 
 void PdfExtractTextDialog::DoIt(VirtMouseEvent*) {
@@ -404,7 +505,7 @@ void PdfExtractTextDialog::DoIt(VirtMouseEvent*) {
     }
 
     TempStr pages = pagesEdit->GetTextTemp();
-    if (len(pages) == 0) {
+    if (len(pages) == 0 || job) {
         return;
     }
 
@@ -420,8 +521,12 @@ void PdfExtractTextDialog::DoIt(VirtMouseEvent*) {
         fz_set_optind(0);
         ok = muconvert_main(argc, argv) == 0;
     } else {
-        // use engine text extraction for other formats (DjVu, etc.)
-        ok = ExtractTextViaEngine(this, destPath, pages);
+        // use engine text extraction for other formats (DjVu, etc.). It runs in
+        // the background and reports back in OnExportFinished()
+        ok = StartExtractTextViaEngine(this, destPath, pages);
+        if (ok) {
+            return;
+        }
     }
 
     if (ok) {
@@ -0,0 +1,201 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "base/Timer.h"
+
+#include "PerfStats.h"
+
+// latencies < 1, 2, 4 ... 4096 ms, the last bucket is everything slower
+constexpr int kLatencyBuckets = 14;
+// handling a message for longer than this is a stall the user can notice
+constexpr double kUiStallMs = 50;
+constexpr double kUiLongStallMs = 250;
+
+struct PerfRenderStats {
+    i64 count = 0;
+    i64 aborted = 0;
+    i64 latencyMsSum = 0;
+    i64 latencyMsMax = 0;
+    i64 renderMsSum = 0;
+    i64 hist[kLatencyBuckets]{};
+};
+
+struct PerfLoadStats {
+    i64 count = 0;
+    double lastMs = 0;
+    double maxMs = 0;
+    double msSum = 0;
+};
+
+struct PerfStats {
+    // process start or the last reset
+    TimeStamp since = TimeGet();
+    PerfRenderStats render[(int)PerfRender::Count];
+    i64 tiles = 0;
+    i64 tileBytes = 0;
+    i64 tileBytesCopied = 0;
+    i64 tileBytesRecolored = 0;
+    i64 cacheHits = 0;
+    i64 cacheMisses = 0;
+    i64 cacheEvictions = 0;
+    i64 cacheEvictedBytes = 0;
+    i64 findPages = 0;
+    i64 findBytes = 0;
+    double findMs = 0;
+    PerfLoadStats load[(int)PerfLoadPhase::Count];
+    bool waitingForFirstTile = false;
+    TimeStamp loadStart;
+};
+
+// recorded from render, search and load threads
+static Mutex gPerfMutex;
+static PerfStats gPerf;
+
+// the UI thread records one per message, so these don't take the lock
+static i64 gUiMessages = 0;
+static i64 gUiStalls = 0;
+static i64 gUiLongStalls = 0;
+static double gUiMaxMs = 0;
+
+static const Str gRenderKindNames[] = {StrL("visible"), StrL("predictive"), StrL("other")};
+static const Str gLoadPhaseNames[] = {StrL("engine"), StrL("controller"), StrL("finish"), StrL("firstTile")};
+static_assert(dimof(gRenderKindNames) == (int)PerfRender::Count);
+static_assert(dimof(gLoadPhaseNames) == (int)PerfLoadPhase::Count);
+
+static int LatencyBucket(int ms) {
+    int bucket = 0;
+    while (bucket < kLatencyBuckets - 1 && ms >= (1 << bucket)) {
+        bucket++;
+    }
+    return bucket;
+}
+
+void PerfRecordRender(PerfRender kind, int latencyMs, int renderMs, bool aborted) {
+    latencyMs = std::max(latencyMs, 0);
+    ScopedMutex lock(&gPerfMutex);
+    PerfRenderStats& rs = gPerf.render[(int)kind];
+    if (aborted) {
+        rs.aborted++;
+        return;
+    }
+    rs.count++;
+    rs.latencyMsSum += latencyMs;
+    rs.latencyMsMax = std::max(rs.latencyMsMax, (i64)latencyMs);
+    rs.renderMsSum += std::max(renderMs, 0);
+    rs.hist[LatencyBucket(latencyMs)]++;
+}
+
+void PerfRecordTile(i64 bytes, i64 bytesCopied, i64 recoloredBytes) {
+    ScopedMutex lock(&gPerfMutex);
+    gPerf.tiles++;
+    gPerf.tileBytes += bytes;
+    gPerf.tileBytesCopied += bytesCopied;
+    gPerf.tileBytesRecolored += recoloredBytes;
+}
+
+void PerfRecordCacheLookup(bool hit) {
+    ScopedMutex lock(&gPerfMutex);
+    if (hit) {
+        gPerf.cacheHits++;
+    } else {
+        gPerf.cacheMisses++;
+    }
+}
+
+void PerfRecordCacheEviction(i64 bytes) {
+    ScopedMutex lock(&gPerfMutex);
+    gPerf.cacheEvictions++;
+    gPerf.cacheEvictedBytes += bytes;
+}
+
+void PerfRecordFindPage(int nBytes, double ms) {
+    ScopedMutex lock(&gPerfMutex);
+    gPerf.findPages++;
+    gPerf.findBytes += nBytes;
+    gPerf.findMs += ms;
+}
+
+static void RecordLoadPhaseLocked(PerfLoadPhase phase, double ms) {
+    PerfLoadStats& ls = gPerf.load[(int)phase];
+    ls.count++;
+    ls.lastMs = ms;
+    ls.maxMs = std::max(ls.maxMs, ms);
+    ls.msSum += ms;
+}
+
+void PerfRecordLoadPhase(PerfLoadPhase phase, double ms) {
+    ScopedMutex lock(&gPerfMutex);
+    RecordLoadPhaseLocked(phase, ms);
+}
+
+void PerfLoadStarted() {
+    ScopedMutex lock(&gPerfMutex);
+    gPerf.loadStart = TimeGet();
+    gPerf.waitingForFirstTile = true;
+}
+
+void PerfTilePainted() {
+    ScopedMutex lock(&gPerfMutex);
+    if (!gPerf.waitingForFirstTile) {
+        return;
+    }
+    gPerf.waitingForFirstTile = false;
+    RecordLoadPhaseLocked(PerfLoadPhase::FirstTile, TimeSinceInMs(gPerf.loadStart));
+}
+
+void PerfRecordUiMessage(double ms) {
+    gUiMessages++;
+    if (ms >= kUiStallMs) {
+        gUiStalls++;
+    }
+    if (ms >= kUiLongStallMs) {
+        gUiLongStalls++;
+    }
+    gUiMaxMs = std::max(gUiMaxMs, ms);
+}
+
+void PerfStatsReset() {
+    {
+        ScopedMutex lock(&gPerfMutex);
+        gPerf = PerfStats();
+    }
+    gUiMessages = 0;
+    gUiStalls = 0;
+    gUiLongStalls = 0;
+    gUiMaxMs = 0;
+}
+
+void PerfStatsAppend(str::Builder& out) {
+    ScopedMutex lock(&gPerfMutex);
+    out.Append(fmt("since ms=%.0f\n", TimeSinceInMs(gPerf.since)));
+    for (int i = 0; i < (int)PerfRender::Count; i++) {
+        PerfRenderStats& rs = gPerf.render[i];
+        double avgMs = rs.count > 0 ? (double)rs.latencyMsSum / (double)rs.count : 0;
+        double renderAvgMs = rs.count > 0 ? (double)rs.renderMsSum / (double)rs.count : 0;
+        out.Append(fmt("render kind=%s count=%lld aborted=%lld avgMs=%.1f maxMs=%lld renderAvgMs=%.1f hist=",
+                       gRenderKindNames[i], rs.count, rs.aborted, avgMs, rs.latencyMsMax, renderAvgMs));
+        for (int b = 0; b < kLatencyBuckets; b++) {
+            out.Append(fmt(b == 0 ? "%lld" : ",%lld", rs.hist[b]));
+        }
+        out.AppendChar('\n');
+    }
+    out.Append(fmt("tiles count=%lld bytes=%lld copiedBytes=%lld recoloredBytes=%lld\n", gPerf.tiles, gPerf.tileBytes,
+                   gPerf.tileBytesCopied, gPerf.tileBytesRecolored));
+    out.Append(fmt("cache hits=%lld misses=%lld evictions=%lld evictedBytes=%lld\n", gPerf.cacheHits,
+                   gPerf.cacheMisses, gPerf.cacheEvictions, gPerf.cacheEvictedBytes));
+    double mbPerSec = 0;
+    if (gPerf.findMs > 0) {
+        mbPerSec = ((double)gPerf.findBytes / (1024.0 * 1024.0)) / (gPerf.findMs / 1000.0);
+    }
+    out.Append(fmt("find pages=%lld bytes=%lld ms=%.1f mbPerSec=%.1f\n", gPerf.findPages, gPerf.findBytes,
+                   gPerf.findMs, mbPerSec));
+    for (int i = 0; i < (int)PerfLoadPhase::Count; i++) {
+        PerfLoadStats& ls = gPerf.load[i];
+        double avgMs = ls.count > 0 ? ls.msSum / (double)ls.count : 0;
+        out.Append(fmt("load phase=%s count=%lld lastMs=%.1f avgMs=%.1f maxMs=%.1f\n", gLoadPhaseNames[i], ls.count,
+                       ls.lastMs, avgMs, ls.maxMs));
+    }
+    out.Append(fmt("ui messages=%lld stalls=%lld longStalls=%lld maxMs=%.1f\n", gUiMessages, gUiStalls,
+                   gUiLongStalls, gUiMaxMs));
+}
@@ -0,0 +1,48 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// Performance counters a test harness reads with -dbg-control's GetPerfStats:
+// how long render requests wait, how the render cache does, how fast search
+// scans page text, how long the phases of loading a document take and how
+// often the UI thread stalls. Recording is cheap, so they're always on.
+
+enum class PerfRender {
+    // a tile of a page that is (nearly) visible
+    Visible = 0,
+    // a page rendered ahead of scrolling
+    Predictive,
+    // thumbnails, previews: a page rect instead of a tile
+    Other,
+    Count,
+};
+
+enum class PerfLoadPhase {
+    // opening the file and parsing enough to know the pages
+    Engine = 0,
+    // creating the DisplayModel / controller
+    Controller,
+    // putting the document into its tab
+    Finish,
+    // from the start of a load to the first tile painted from the render cache
+    FirstTile,
+    Count,
+};
+
+// latencyMs: from the request to the rendered bitmap; renderMs: of that, rendering
+void PerfRecordRender(PerfRender kind, int latencyMs, int renderMs, bool aborted);
+// a rendered tile of bytes, of which the engine copied / converted
+// bytesCopied after rendering, and recoloredBytes were recolored in place
+void PerfRecordTile(i64 bytes, i64 bytesCopied, i64 recoloredBytes);
+void PerfRecordCacheLookup(bool hit);
+void PerfRecordCacheEviction(i64 bytes);
+void PerfRecordFindPage(int nBytes, double ms);
+void PerfRecordLoadPhase(PerfLoadPhase phase, double ms);
+// arms PerfLoadPhase::FirstTile, which PerfTilePainted() records
+void PerfLoadStarted();
+void PerfTilePainted();
+// UI thread only: time spent handling one message
+void PerfRecordUiMessage(double ms);
+
+void PerfStatsReset();
+// "key=value" lines, one per group of counters
+void PerfStatsAppend(str::Builder& out);
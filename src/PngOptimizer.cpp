@@ -5,15 +5,37 @@
 #include "base/File.h"
 #include "base/Pixmap.h"
 #include "base/Timer.h"
+#include "base/Win.h"
 
 #include "zopflipng/zopflipng_lib.h"
 #include "zopflipng/lodepng/lodepng.h"
 
 #include "PngOptimizer.h"
 
-// zopfli is slow (roughly a second or more per MB of PNG) so don't try to
-// optimize huge files; typical screenshots are well under this
+// zopfli is slow (roughly a second or more per MB of PNG on one core, the
+// blocks of a file are compressed on all cores) so don't try to optimize huge
+// files; typical screenshots are well under this. What zopflipng needs is
+// about 3.5 times the size of the decoded pixels (the image, its filtered
+// versions and their deflate state), so that's limited too
+#if IS_INTEL_32
 constexpr int kMaxPngSizeToOptimize = 16 * 1024 * 1024;
+constexpr i64 kMaxPngPixelBytesToOptimize = 64LL * 1024 * 1024;
+#else
+constexpr int kMaxPngSizeToOptimize = 64 * 1024 * 1024;
+constexpr i64 kMaxPngPixelBytesToOptimize = 256LL * 1024 * 1024;
+#endif
+
+// the blocks optimized at the same time, on different threads, need about 40
+// bytes for each of their bytes. They're at most 1 MB together (zopfli's master
+// block) so this rarely limits the threads, but don't count on it
+#if IS_INTEL_32
+constexpr size_t kZopfliThreadsMemory = 32 * 1024 * 1024;
+#else
+constexpr size_t kZopfliThreadsMemory = 128 * 1024 * 1024;
+#endif
+
+// files waiting for OptimizePngQueueThread(); more than that are left as they are
+constexpr int kMaxQueuedPngs = 1024;
 
 // After optimizing we insert this tEXt chunk ("Software" keyword + text, the
 // standard PNG way of naming the producing program) directly after IHDR, so
@@ -49,6 +71,34 @@ static bool IsPngWithIhdr(const u8* d, int n) {
     return n >= kMarkerOffset && memcmp(d, hdr, sizeof(hdr)) == 0;
 }
 
+static u32 ReadU32BE(const u8* p) {
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3];
+}
+
+// size of the decoded pixels of the PNG in d, from its IHDR, or -1
+static i64 PngPixelBytes(const u8* d, int n) {
+    if (!IsPngWithIhdr(d, n)) {
+        return -1;
+    }
+    i64 w = ReadU32BE(d + 16);
+    i64 h = ReadU32BE(d + 20);
+    int bitDepth = d[24];
+    int colorType = d[25];
+    // samples per pixel by color type: gray, -, rgb, palette, gray + alpha, -, rgba
+    static const int samples[] = {1, 0, 3, 1, 2, 0, 4};
+    if (colorType >= (int)dimof(samples) || samples[colorType] == 0) {
+        return -1;
+    }
+    i64 bitsPerRow = w * samples[colorType] * bitDepth;
+    return h * ((bitsPerRow + 7) / 8);
+}
+
+// zopflipng would need too much memory for it
+static bool IsPngTooBigToOptimize(const u8* d, int n) {
+    i64 pixelBytes = PngPixelBytes(d, n);
+    return pixelBytes < 0 || pixelBytes > kMaxPngPixelBytesToOptimize;
+}
+
 // true if the PNG data in d was produced by us (has our marker chunk after IHDR)
 static bool HasOptimizedMarker(const u8* d, int n) {
     if (n < kMarkerOffset + kMarkerChunkSize || !IsPngWithIhdr(d, n)) {
@@ -59,6 +109,14 @@ static bool HasOptimizedMarker(const u8* d, int n) {
     return memcmp(d + kMarkerOffset, chunk, kMarkerChunkSize) == 0;
 }
 
+static void InitZopfliPngOptions(CZopfliPNGOptions* opts) {
+    CZopfliPNGSetDefaults(opts);
+    // the blocks of the deflate stream are optimized in parallel, with the
+    // same result as on a single thread
+    opts->num_threads = CpuCoreCount();
+    opts->max_threads_memory = kZopfliThreadsMemory;
+}
+
 // Losslessly recompress the PNG file at path with zopflipng and replace it if
 // the result is smaller. The new content is written to a temp file which is
 // then atomically swapped in, so anyone reading the file concurrently (e.g.
@@ -68,7 +126,7 @@ static void OptimizePngFile(Str path) {
     auto timeStart = TimeGet();
     Str d = file::ReadFile(path);
     int nOrig = len(d);
-    if (nOrig == 0 || nOrig > kMaxPngSizeToOptimize) {
+    if (nOrig == 0 || nOrig > kMaxPngSizeToOptimize || IsPngTooBigToOptimize((const u8*)d.s, nOrig)) {
         str::Free(d);
         return;
     }
@@ -78,7 +136,7 @@ static void OptimizePngFile(Str path) {
         return;
     }
     CZopfliPNGOptions opts;
-    CZopfliPNGSetDefaults(&opts);
+    InitZopfliPngOptions(&opts);
     unsigned char* out = nullptr;
     size_t outSize = 0;
     int err = CZopfliPNGOptimize((const unsigned char*)d.s, (size_t)nOrig, &opts, 0, &out, &outSize);
@@ -134,14 +192,75 @@ static void OptimizePngFile(Str path) {
          sepSaved, savedPercent, secs);
 }
 
-struct OptimizePngData {
+// All files to optimize go through one queue served by one thread: a zopfli
+// run already keeps all cores busy, running several files at once would only
+// add memory. The queue is ordered by file size, smallest first, so that e.g.
+// the pages of a batch export aren't stuck behind a big screenshot.
+struct PngToOptimize {
     Str path;
+    i64 size = 0;
 };
 
-static void OptimizePngThread(OptimizePngData* d) {
-    OptimizePngFile(d->path);
-    str::Free(d->path);
-    delete d;
+static Mutex gPngQueueMutex;
+static Vec<PngToOptimize> gPngQueue;
+static bool gPngQueueThreadRunning = false;
+
+static bool PopSmallestPng(PngToOptimize* res) {
+    ScopedMutex lock(&gPngQueueMutex);
+    if (len(gPngQueue) == 0) {
+        gPngQueueThreadRunning = false;
+        return false;
+    }
+    *res = gPngQueue[0];
+    gPngQueue.RemoveAt(0);
+    return true;
+}
+
+static void OptimizePngQueueThread() {
+    PngToOptimize png;
+    while (PopSmallestPng(&png)) {
+        OptimizePngFile(png.path);
+        str::Free(png.path);
+    }
+}
+
+// returns false if the file is already queued, too big or the queue is full
+static bool QueuePng(Str path) {
+    i64 size = file::GetSize(path);
+    if (size <= 0 || size > kMaxPngSizeToOptimize) {
+        return false;
+    }
+    ScopedMutex lock(&gPngQueueMutex);
+    int n = len(gPngQueue);
+    if (n >= kMaxQueuedPngs) {
+        logf("QueuePng: queue is full, not optimizing '%s'\n", path);
+        return false;
+    }
+    int idx = 0;
+    for (int i = 0; i < n; i++) {
+        if (path::IsSame(gPngQueue[i].path, path)) {
+            return false;
+        }
+        if (gPngQueue[i].size <= size) {
+            idx = i + 1;
+        }
+    }
+    PngToOptimize png;
+    png.path = str::Dup(path);
+    png.size = size;
+    gPngQueue.InsertAt(idx, png);
+    return true;
+}
+
+static void StartPngQueueThread() {
+    {
+        ScopedMutex lock(&gPngQueueMutex);
+        if (gPngQueueThreadRunning || len(gPngQueue) == 0) {
+            return;
+        }
+        gPngQueueThreadRunning = true;
+    }
+    RunAsync(MkFunc0Void(OptimizePngQueueThread), StrL("OptimizePngQueueThread"));
 }
 
 // Optimize the PNG file at path on a background thread. Does nothing if path
@@ -151,43 +270,21 @@ void OptimizePngFileAsync(Str path) {
     if (!str::EndsWithI(path, StrL(".png"))) {
         return;
     }
-    auto* d = new OptimizePngData();
-    d->path = str::Dup(path);
-    RunAsync(MkFunc0(OptimizePngThread, d), StrL("OptimizePngThread"));
+    QueuePng(path);
+    StartPngQueueThread();
 }
 
-struct OptimizePngFilesData {
-    StrVec paths;
-};
-
-static void OptimizePngFilesThread(OptimizePngFilesData* d) {
-    int n = len(d->paths);
-    for (int i = 0; i < n; i++) {
-        Str p = d->paths[i];
-        if (str::EndsWithI(p, StrL(".png"))) {
-            OptimizePngFile(p);
-        }
-    }
-    delete d;
-}
-
-// Same as OptimizePngFileAsync for each .png path, one after another on a
-// single background thread so converting many pages does not spawn one
-// zopfli thread per file
+// Same as OptimizePngFileAsync for each .png path; converting many pages
+// queues them all for the same background thread
 void OptimizePngFilesAsync(const StrVec& paths) {
-    auto* d = new OptimizePngFilesData();
     int n = len(paths);
     for (int i = 0; i < n; i++) {
         Str p = paths[i];
         if (str::EndsWithI(p, StrL(".png"))) {
-            d->paths.Append(p);
+            QueuePng(p);
         }
     }
-    if (len(d->paths) == 0) {
-        delete d;
-        return;
-    }
-    RunAsync(MkFunc0(OptimizePngFilesThread, d), StrL("OptimizePngFilesThread"));
+    StartPngQueueThread();
 }
 
 // Pack pixmap pixels as tightly packed RGBA8 for lodepng_encode32.
@@ -240,11 +337,11 @@ static Str OptimizePngBytesOwned(Str png) {
     if (nOrig == 0) {
         return {};
     }
-    if (nOrig > kMaxPngSizeToOptimize) {
+    if (nOrig > kMaxPngSizeToOptimize || IsPngTooBigToOptimize((const u8*)png.s, nOrig)) {
         return str::Dup(png);
     }
     CZopfliPNGOptions opts;
-    CZopfliPNGSetDefaults(&opts);
+    InitZopfliPngOptions(&opts);
     unsigned char* out = nullptr;
     size_t outSize = 0;
     int err = CZopfliPNGOptimize((const unsigned char*)png.s, (size_t)nOrig, &opts, 0, &out, &outSize);
@@ -10,6 +10,7 @@
 #include "GlobalPrefs.h"
 #include "DocController.h"
 #include "EngineBase.h"
+#include "PageStructure.h"
 #include "DisplayModel.h"
 #include "TextSelection.h"
 
@@ -302,57 +303,20 @@ bool ReadAloudGetViewportStart(DisplayModel* dm, int* startPageOut, int* startGl
             firstVisiblePage = pageNo;
         }
 
-        Rect* coords = nullptr;
-        int textLen = 0;
-        Str text = engine->GetTextForPage(pageNo, &textLen, &coords);
-        if (!text) {
+        const PageStructure* ps = engine->GetPageStructure(pageNo);
+        if (!ps) {
             continue;
         }
-
-        int g = 0;
-        int byteIdx = 0;
-        while (g < textLen) {
-            while (g < textLen) {
-                int nextByte = byteIdx;
-                int c = Utf8CodepointNext(text, nextByte);
-                if (!IsLineBreakGlyph(coords, g, c)) {
-                    break;
-                }
-                byteIdx = nextByte;
-                g++;
-            }
-            if (g >= textLen) {
-                break;
-            }
-
-            int lineStart = g;
-            while (g < textLen) {
-                int nextByte = byteIdx;
-                int c = Utf8CodepointNext(text, nextByte);
-                if (IsLineBreakGlyph(coords, g, c)) {
-                    break;
-                }
-                byteIdx = nextByte;
-                g++;
-            }
-
-            Rect lineBbox;
-            for (int i = lineStart; i < g; i++) {
-                Rect r = coords[i];
-                if (r.x || r.dx) {
-                    lineBbox = lineBbox.IsEmpty() ? r : lineBbox.Union(r);
-                }
-            }
-            if (lineBbox.IsEmpty()) {
+        for (const PageLine& line : ps->lines) {
+            if (line.bbox.IsEmpty()) {
                 continue;
             }
-
-            Rect screenLine = dm->CvtToScreen(pageNo, ToRectF(lineBbox));
+            Rect screenLine = dm->CvtToScreen(pageNo, ToRectF(line.bbox));
             if (!screenLine.Intersect(viewArea).IsEmpty()) {
                 logf("ReadAloud: GetViewportStart: found visible line at page %d glyph %d (screenLine=%d,%d %dx%d)\n",
-                     pageNo, lineStart, screenLine.x, screenLine.y, screenLine.dx, screenLine.dy);
+                     pageNo, line.start, screenLine.x, screenLine.y, screenLine.dx, screenLine.dy);
                 *startPageOut = pageNo;
-                *startGlyphOut = lineStart;
+                *startGlyphOut = line.start;
                 return true;
             }
         }
@@ -29,7 +29,6 @@ bool RefHoverIsLiveState(RefHoverState* s);
 void RefHoverRegisterLiveState(RefHoverState* s);
 void RefHoverUnregisterLiveState(RefHoverState* s);
 void RefHoverDropQueuedRender(RefHoverState* s);
-TempWStr RefHoverPageTextToWStrTemp(Str text);
 
 bool RefHoverPopupCreate(RefHoverState* s, HWND hwndCanvas);
 
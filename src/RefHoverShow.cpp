@@ -8,6 +8,7 @@
 
 #include "DocController.h"
 #include "EngineBase.h"
+#include "PageStructure.h"
 #include "RefHoverDetect.h"
 #include "RefHoverInternal.h"
 #include "RefHoverText.h"
@@ -57,24 +58,10 @@ void RefHoverOnTimer(RefHoverState* s, HWND hwndCanvas, EngineBase* engine, floa
     if (useLinkZoom) {
         region = RectF{0.f, destY, mediabox.dx, mediabox.dy - destY};
     } else {
-        Rect* coords = nullptr;
-        int textLen = 0;
-        Str textUtf8 = engine->GetTextForPage(destPage, &textLen, &coords);
-        TempWStr text = RefHoverPageTextToWStrTemp(textUtf8);
-        WCHAR* cleanText = nullptr;
-        Rect* cleanCoords = nullptr;
-        Rect* normCoords = coords;
-        if (coords && len(text) > 0) {
-            // Strip the page watermark on the raw glyphs first (its true height
-            // is only visible pre-normalization), then normalize the survivors
-            // so the detectors below see clean, baseline-flattened text.
-            cleanText = AllocArrayTemp<WCHAR>(textLen);
-            cleanCoords = AllocArrayTemp<Rect>(textLen);
-            int cleanLen = StripWatermarkGlyphs(text, coords, cleanText, cleanCoords);
-            text = WStr(cleanText, cleanLen);
-            normCoords = AllocArrayTemp<Rect>(cleanLen);
-            NormalizeGlyphLines(cleanCoords, normCoords, cleanLen);
-        }
+        // watermark-stripped, line-normalized text, derived once per page
+        const PageStructure* ps = engine->GetPageStructure(destPage);
+        WStr text = ps ? ps->cleanText : WStr();
+        Rect* normCoords = ps ? ps->cleanCoords : nullptr;
         region = DetectEquationBox(text, normCoords, mediabox, destX, destY);
         if (region.dx <= 0.f || region.dy <= 0.f) {
             region = DetectEntryBox(text, normCoords, mediabox, destX, destY, &continuation);
@@ -12,22 +12,17 @@
 
 #include "DocController.h"
 #include "EngineBase.h"
+#include "PageStructure.h"
 #include "RefHoverInternal.h"
 #include "RefHoverText.h"
 #include "RefHoverTextDetect.h"
 
-TempWStr RefHoverPageTextToWStrTemp(Str text) {
-    int nCodepoints = Utf8CodepointCount(text);
-    WCHAR* dst = AllocArrayTemp<WCHAR>(nCodepoints + 1);
-    int byteIdx = 0;
-    for (int i = 0; i < nCodepoints; i++) {
-        int n = 0;
-        int rune = Utf8CodepointAtByte(text, byteIdx, &n);
-        dst[i] = rune > 0xffff ? L'?' : (WCHAR)rune;
-        byteIdx += n > 0 ? n : 1;
-    }
-    dst[nCodepoints] = 0;
-    return WStr(dst, nCodepoints);
+// the page's text as one WCHAR per glyph, which the detectors work on;
+// converted once per page and kept with the page text
+static WStr GetPageTextW(EngineBase* engine, int pageNo, int* lenOut, Rect** coordsOut) {
+    engine->GetTextForPage(pageNo, lenOut, coordsOut);
+    const PageStructure* ps = engine->GetPageStructure(pageNo);
+    return ps ? ps->text : WStr();
 }
 
 // === Plain-text citation lookup cache ===
@@ -113,8 +108,7 @@ static bool DetectCitationAtCursor(EngineBase* engine, int srcPage, Point pagePo
     out->year = 0;
     int textLen = 0;
     Rect* coords = nullptr;
-    Str textUtf8 = engine->GetTextForPage(srcPage, &textLen, &coords);
-    TempWStr text = RefHoverPageTextToWStrTemp(textUtf8);
+    WStr text = GetPageTextW(engine, srcPage, &textLen, &coords);
     return DetectCitationInPageText(text, coords, textLen, pagePos, &out->surname, &out->year, srcRectOut);
 }
 
@@ -139,8 +133,7 @@ static bool FindReferenceLocation(EngineBase* engine, int srcPage, Str surname,
     for (int p = pageCount; p >= srcPage; p--) {
         int textLen = 0;
         Rect* coords = nullptr;
-        Str textUtf8 = engine->GetTextForPage(p, &textLen, &coords);
-        TempWStr text = RefHoverPageTextToWStrTemp(textUtf8);
+        WStr text = GetPageTextW(engine, p, &textLen, &coords);
         float x = 0, y = 0;
         if (FindSurnameInPageText(text, coords, textLen, surnameW, year, &x, &y)) {
             *destPageOut = p;
@@ -207,8 +200,7 @@ static bool LookupOrSearchNumeric(RefHoverState* s, EngineBase* engine, int srcP
     for (int p = pageCount; p >= srcPage; p--) {
         int textLen = 0;
         Rect* coords = nullptr;
-        Str textUtf8 = engine->GetTextForPage(p, &textLen, &coords);
-        TempWStr text = RefHoverPageTextToWStrTemp(textUtf8);
+        WStr text = GetPageTextW(engine, p, &textLen, &coords);
         float x = 0, y = 0;
         if (FindNumericReferenceInPageText(text, coords, textLen, num, &x, &y)) {
             destPage = p;
@@ -254,8 +246,7 @@ bool RefHoverTryPlainText(RefHoverState* s, EngineBase* engine, int srcPage, Poi
     {
         int textLen = 0;
         Rect* coords = nullptr;
-        Str textUtf8 = engine->GetTextForPage(srcPage, &textLen, &coords);
-        TempWStr text = RefHoverPageTextToWStrTemp(textUtf8);
+        WStr text = GetPageTextW(engine, srcPage, &textLen, &coords);
         int num = 0;
         if (DetectNumericCitationInPageText(text, coords, textLen, pagePos, &num, &srcRect)) {
             if (LookupOrSearchNumeric(s, engine, srcPage, num, destPageOut, destXOut, destYOut)) {
@@ -335,8 +326,7 @@ float RefHoverResolveDestYFromSourceText(EngineBase* engine, int srcPage, RectF
     }
     int srcLen = 0;
     Rect* srcCoords = nullptr;
-    Str srcTextUtf8 = engine->GetTextForPage(srcPage, &srcLen, &srcCoords);
-    TempWStr srcText = RefHoverPageTextToWStrTemp(srcTextUtf8);
+    WStr srcText = GetPageTextW(engine, srcPage, &srcLen, &srcCoords);
     if (!srcText || srcLen <= 0 || !srcCoords) {
         return -1.f;
     }
@@ -405,8 +395,7 @@ float RefHoverResolveDestYFromSourceText(EngineBase* engine, int srcPage, RectF
 
     int destLen = 0;
     Rect* destCoords = nullptr;
-    Str destTextUtf8 = engine->GetTextForPage(destPage, &destLen, &destCoords);
-    TempWStr destText = RefHoverPageTextToWStrTemp(destTextUtf8);
+    WStr destText = GetPageTextW(engine, destPage, &destLen, &destCoords);
     if (!destText || destLen <= 0 || !destCoords) {
         return -1.f;
     }
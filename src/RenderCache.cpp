@@ -9,6 +9,7 @@
 #include "base/File.h"
 #include "base/UITask.h"
 #include "base/Timer.h"
+#include "base/Trace.h"
 
 #include "gui/UIModels.h"
 #include "gui/Layout.h"
@@ -22,10 +23,12 @@
 #include "SumatraConfig.h"
 #include "DocController.h"
 #include "EngineBase.h"
+#include "EngineAll.h"
 #include "PdfDarkMode.h"
 #include "DisplayModel.h"
 #include "Canvas.h"
 #include "RenderCache.h"
+#include "PerfStats.h"
 
 // CONSERVE_MEMORY sets the compile-time default for gConserveMemory. When defined,
 // cached page bitmaps for non-visible pages are freed aggressively. Undefining it
@@ -43,6 +46,23 @@ static DWORD WINAPI RenderCacheThread(LPVOID data);
 static bool gShowTileLayout = false;
 int gMaxRenderThreads = 8;
 
+// once the render threads have had nothing to do for this long, the pixmap
+// pool (see PixmapPool.cpp) keeps only a few tiles for the next scroll, and
+// none when memory is tight
+constexpr DWORD kTrimPixmapPoolAfterMs = 3000;
+constexpr i64 kIdlePixmapPoolBytes = 16 * 1024 * 1024;
+constexpr DWORD kHighMemoryLoad = 85; // in % of physical memory in use
+
+static void TrimPixmapPoolOnIdle() {
+    i64 maxBytes = kIdlePixmapPoolBytes;
+    MEMORYSTATUSEX ms{};
+    ms.dwLength = sizeof(ms);
+    if (GlobalMemoryStatusEx(&ms) && ms.dwMemoryLoad >= kHighMemoryLoad) {
+        maxBytes = 0;
+    }
+    TrimPixmapPool(maxBytes);
+}
+
 // Whether to run the bitmap recolor pass when no dark profile applies.
 // Only MuPDF-rendered documents (PDF, XPS, EPUB, MOBI, FB2, HTML, etc.) and
 // DjVu are recolored; image/comic/native-ebook engines keep original pixels.
@@ -232,6 +252,16 @@ bool RenderCache::DropCacheEntryIfNotUsed(BitmapCacheEntry* entry) {
     return DropCacheEntry(entry);
 }
 
+// drops entry if nobody is painting from it, counting it as an eviction
+static bool EvictCacheEntry(RenderCache* rc, BitmapCacheEntry* entry) {
+    i64 bytes = entry->bitmap ? PixmapAllocatedBytes(entry->bitmap) : 0;
+    bool didDrop = rc->DropCacheEntryIfNotUsed(entry);
+    if (didDrop) {
+        PerfRecordCacheEviction(bytes);
+    }
+    return didDrop;
+}
+
 static bool FreeIfFull(RenderCache* rc, const PageRenderRequest& req) {
     int n = rc->cacheCount;
     if (n < MAX_BITMAPS_CACHED) {
@@ -243,7 +273,7 @@ static bool FreeIfFull(RenderCache* rc, const PageRenderRequest& req) {
     for (int i = 0; i < n; i++) {
         auto* entry = rc->cache[i];
         if (entry->dm == dm && !dm->PageVisibleNearby(entry->pageNo)) {
-            bool didDrop = rc->DropCacheEntryIfNotUsed(entry);
+            bool didDrop = EvictCacheEntry(rc, entry);
             if (didDrop) {
                 return true;
             }
@@ -260,7 +290,7 @@ static bool FreeIfFull(RenderCache* rc, const PageRenderRequest& req) {
             // in a different window, but it's harder to detect
             continue;
         }
-        bool didDrop = rc->DropCacheEntryIfNotUsed(entry);
+        bool didDrop = EvictCacheEntry(rc, entry);
         if (didDrop) {
             return true;
         }
@@ -731,6 +761,8 @@ bool RenderCache::Render(DisplayModel* dm, int pageNo, int rotation, float zoom,
         newRequest->tile = *tile;
     } else if (pageRect) {
         newRequest->pageRect = *pageRect;
+        // a reused slot might still have the tile of an earlier request
+        newRequest->tile = TilePosition();
     } else {
         CrashMe();
     }
@@ -1048,11 +1080,101 @@ void RenderCache::AbortCurrentRequest(int threadIdx) {
     UpdateRenderInfo();
 }
 
+// what the render threads ask the engine for: the page composited over the
+// canvas background, in the dark mode profile in force. args.darkProfile
+// points to darkProfile
+static void SetViewRenderArgs(EngineBase* engine, RenderPageArgs& args, DarkModeProfile& darkProfile) {
+    // the canvas paints the document background before drawing the page,
+    // so a page with transparency composites over it (#5844)
+    args.keepAlpha = true;
+    args.transparentBackdrop = ShowTransparencyGrid();
+    BuildViewDarkModeProfile(engine, &darkProfile);
+    if (darkProfile.mode != PageColorMode::Normal) {
+        args.darkProfile = &darkProfile;
+    }
+}
+
+// runs the bitmap recolor pass on a tile rendered with args, where the
+// document's colors follow the theme. Returns the number of bytes recolored
+static i64 RecolorTile(RenderCache* cache, EngineBase* engine, const RenderPageArgs& args, Pixmap* bmp) {
+    const DarkModeProfile* profile = args.darkProfile;
+    bool recolor;
+    if (profile) {
+        // object-level smart dark renders themed output directly
+        recolor = DarkModeProfileUsesLegacyPostProcess(profile);
+    } else {
+        recolor = ShouldUpdateBitmapColorsLegacy(engine, cache);
+    }
+    if (!recolor || bmp->hasAlpha) {
+        return 0;
+    }
+    bool preserve = profile && profile->mode == PageColorMode::PreserveImages && profile->preservePdfImages;
+    Vec<Rect> skipRects;
+    Vec<Rect>* skipRectsPtr = nullptr;
+    if (preserve) {
+        Size bmpSize(bmp->width, bmp->height);
+        engine->GetBitmapRecolorSkipRects(args.pageNo, args.zoom, args.rotation, *args.pageRect, bmpSize, skipRects);
+        FinalizeTileSkipRects(skipRects, bmpSize);
+        if (len(skipRects) > 0) {
+            skipRectsPtr = &skipRects;
+        }
+    }
+    Color textCol = profile ? profile->foreground : cache->textColor;
+    Color bgCol = profile ? profile->pageBackground : cache->backgroundColor;
+    Color linkCol = profile ? profile->linkColor : cache->linkColor;
+    RecolorPixmap(bmp, textCol, bgCol, linkCol, skipRectsPtr);
+    return PixmapByteSize(bmp);
+}
+
+// Renders the whole page as tile 0 (the only tile when a page isn't split)
+// at zoom / rotation, outside of the queue and without a DisplayModel: the
+// document preloader renders the first page of a document before it's shown.
+// *epochOut gets the colors it was rendered with, for AdoptDetachedPage()
+Pixmap* RenderCache::RenderDetachedPage(EngineBase* engine, int pageNo, float zoom, int rotation, u32* epochOut) {
+    u32 epoch = darkModeEpoch;
+    rotation = NormalizeRotation(rotation);
+    RectF pageRect = GetTileRectUser(engine, pageNo, rotation, zoom, TilePosition(0, 0, 0));
+    RenderPageArgs args(pageNo, zoom, rotation, &pageRect, RenderTarget::View);
+    DarkModeProfile darkProfile;
+    SetViewRenderArgs(engine, args, darkProfile);
+    MaskFpExceptions();
+    Pixmap* bmp = engine->RenderPage(args);
+    if (!bmp) {
+        return nullptr;
+    }
+    RecolorTile(this, engine, args, bmp);
+    *epochOut = epoch;
+    return bmp;
+}
+
+// Caches a page from RenderDetachedPage() for dm, if dm shows it as a single
+// tile at that zoom and rotation and the colors haven't changed since.
+// Takes ownership of bmp
+bool RenderCache::AdoptDetachedPage(DisplayModel* dm, int pageNo, float zoom, int rotation, u32 epoch, Pixmap* bmp) {
+    TilePosition tile(0, 0, 0);
+    rotation = NormalizeRotation(rotation);
+    bool fits = dm && dm->ValidPageNo(pageNo) && epoch == darkModeEpoch && dm->GetZoomReal(pageNo) == zoom &&
+                NormalizeRotation(dm->GetRotation()) == rotation && GetTileRes(dm, pageNo) == 0;
+    if (!fits || Exists(dm, pageNo, rotation, zoom, &tile)) {
+        FreePixmap(bmp);
+        return false;
+    }
+    PageRenderRequest req;
+    req.dm = dm;
+    req.pageNo = pageNo;
+    req.rotation = rotation;
+    req.zoom = zoom;
+    req.tile = tile;
+    Add(req, bmp);
+    return true;
+}
+
 static DWORD WINAPI RenderCacheThread(LPVOID data) {
     auto* td = (RenderThreadData*)data;
     RenderCache* cache = td->cache;
     int threadIdx = td->threadIdx;
     delete td;
+    SetThreadName(fmt("RenderCacheThread %d", threadIdx));
 
     PageRenderRequest req;
     Pixmap* bmp;
@@ -1069,7 +1191,11 @@ static DWORD WINAPI RenderCacheThread(LPVOID data) {
                 ScopedRecursiveMutex scope(&cache->requestAccess);
                 cache->idleThreads++;
             }
-            DWORD waitResult = WaitForSingleObject(cache->startRendering, INFINITE);
+            DWORD waitResult = WaitForSingleObject(cache->startRendering, kTrimPixmapPoolAfterMs);
+            if (WAIT_TIMEOUT == waitResult) {
+                TrimPixmapPoolOnIdle();
+                waitResult = WaitForSingleObject(cache->startRendering, INFINITE);
+            }
             {
                 ScopedRecursiveMutex scope(&cache->requestAccess);
                 cache->idleThreads--;
@@ -1100,23 +1226,26 @@ static DWORD WINAPI RenderCacheThread(LPVOID data) {
         EngineBase* engine = req.dm->GetEngine();
 
         RenderPageArgs args(req.pageNo, req.zoom, req.rotation, &req.pageRect, RenderTarget::View, &req.abortCookie);
-        // the canvas paints the document background before drawing the page,
-        // so a page with transparency composites over it (#5844)
-        args.keepAlpha = true;
-        args.transparentBackdrop = ShowTransparencyGrid();
         DarkModeProfile darkProfile;
-        BuildViewDarkModeProfile(engine, &darkProfile);
-        if (darkProfile.mode != PageColorMode::Normal) {
-            args.darkProfile = &darkProfile;
-        }
+        SetViewRenderArgs(engine, args, darkProfile);
         // a previous render might have run a 3rd-party WIC codec that unmasked
         // fp exceptions on this thread, which would crash mupdf float math
         MaskFpExceptions();
+        PerfRender perfKind = PerfRender::Visible;
+        if (req.predictiveOriginPageNo != 0) {
+            perfKind = PerfRender::Predictive;
+        } else if (req.tile.res == INVALID_TILE_RES) {
+            perfKind = PerfRender::Other;
+        }
         auto timeStart = TimeGet();
-        bmp = engine->RenderPage(args);
+        {
+            TraceSpan span("render tile", req.pageNo);
+            bmp = engine->RenderPage(args);
+        }
         if (req.abort || req.darkModeEpoch != cache->darkModeEpoch) {
             // aborted or colors changed mid-render - discard result
             FreePixmap(bmp);
+            PerfRecordRender(perfKind, 0, 0, true);
             continue;
         }
         auto durMs = TimeSinceInMs(timeStart);
@@ -1129,40 +1258,18 @@ static DWORD WINAPI RenderCacheThread(LPVOID data) {
         req.errorCode = bmp ? 0 : 1;
 
         if (bmp) {
-            const DarkModeProfile* profile = args.darkProfile;
-            bool recolor;
-            if (profile) {
-                // object-level smart dark renders themed output directly
-                recolor = DarkModeProfileUsesLegacyPostProcess(profile);
-            } else {
-                recolor = ShouldUpdateBitmapColorsLegacy(engine, cache);
-            }
-            if (recolor && !bmp->hasAlpha) {
-                bool preserve = profile && profile->mode == PageColorMode::PreserveImages && profile->preservePdfImages;
-                Vec<Rect> skipRects;
-                Vec<Rect>* skipRectsPtr = nullptr;
-                if (preserve) {
-                    Size bmpSize(bmp->width, bmp->height);
-                    engine->GetBitmapRecolorSkipRects(req.pageNo, req.zoom, req.rotation, req.pageRect, bmpSize,
-                                                      skipRects);
-                    FinalizeTileSkipRects(skipRects, bmpSize);
-                    if (len(skipRects) > 0) {
-                        skipRectsPtr = &skipRects;
-                    }
-                }
-                Color textCol = profile ? profile->foreground : cache->textColor;
-                Color bgCol = profile ? profile->pageBackground : cache->backgroundColor;
-                Color linkCol = profile ? profile->linkColor : cache->linkColor;
-                RecolorPixmap(bmp, textCol, bgCol, linkCol, skipRectsPtr);
-            }
+            i64 recoloredBytes = RecolorTile(cache, engine, args, bmp);
             if (req.abort || req.darkModeEpoch != cache->darkModeEpoch) {
                 // colors changed while recoloring - discard result
                 FreePixmap(bmp);
                 req.bmp = nullptr;
+                PerfRecordRender(perfKind, 0, 0, true);
                 continue;
             }
+            PerfRecordTile(PixmapByteSize(bmp), args.bytesCopied, recoloredBytes);
             cache->Add(req, bmp);
             req.bmp = nullptr; // ownership transferred to cache
+            PerfRecordRender(perfKind, (int)(GetTickCount64() - req.timestamp), (int)durMs, false);
         }
 
         ReportIf(!req.renderFinishedCb.IsValid());
@@ -1181,6 +1288,7 @@ int RenderCache::PaintTile(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, T
     float zoom = dm->GetZoomReal(pageNo);
     BitmapCacheEntry* entry = Find(dm, pageNo, dm->GetRotation(), zoom, &tile);
     int renderDelay = 0;
+    PerfRecordCacheLookup(entry != nullptr);
 
     if (!entry) {
         if (!isRemoteSession) {
@@ -1227,6 +1335,7 @@ int RenderCache::PaintTile(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, T
         source.dy = (int)((float)bounds.dy * factor);
     }
     BlitPixmapRegion(renderedBmp, hdc, target, source);
+    PerfTilePainted();
 
     if (gShowTileLayout) {
         HPEN pen = CreatePen(PS_SOLID, 1, kColYellow);
@@ -1354,13 +1463,28 @@ int RenderCache::Paint(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, PageI
     return renderDelayMin;
 }
 
+i64 RenderCache::CacheBytes(int* nEntriesOut) {
+    ScopedRecursiveMutex scope(&cacheAccess);
+    i64 res = 0;
+    for (int i = 0; i < cacheCount; i++) {
+        BitmapCacheEntry* e = cache[i];
+        if (e->bitmap) {
+            res += PixmapAllocatedBytes(e->bitmap);
+        }
+    }
+    if (nEntriesOut) {
+        *nEntriesOut = cacheCount;
+    }
+    return res;
+}
+
 void RenderCache::LogCacheSize() {
     ScopedRecursiveMutex scope(&cacheAccess);
     i64 size = 0;
     for (int i = 0; i < cacheCount; i++) {
         BitmapCacheEntry* e = cache[i];
         if (e->bitmap) {
-            i64 bs = PixmapByteSize(e->bitmap);
+            i64 bs = PixmapAllocatedBytes(e->bitmap);
             size += bs;
         }
     }
@@ -1667,7 +1791,7 @@ void RenderCache::RecordCacheChange(bool isAdd, BitmapCacheEntry* entry) {
     ci.zoom = entry->zoom;
     ci.rotation = entry->rotation;
     ci.tile = entry->tile;
-    ci.bytes = entry->bitmap ? PixmapByteSize(entry->bitmap) : 0;
+    ci.bytes = entry->bitmap ? PixmapAllocatedBytes(entry->bitmap) : 0;
     ci.timestamp = GetTickCount64();
     SetDmFileName(entry->dm, ci.fileName, dimof(ci.fileName));
     cacheHistoryNext = (cacheHistoryNext + 1) % kCacheHistorySize;
@@ -1697,12 +1821,32 @@ void RenderCache::SerializeCacheState(str::Builder& s) {
     for (int i = 0; i < cacheCount; i++) {
         BitmapCacheEntry* e = cache[i];
         if (e->bitmap) {
-            totalBytes += PixmapByteSize(e->bitmap);
+            totalBytes += PixmapAllocatedBytes(e->bitmap);
         }
     }
     s.Append(fmt("Cache: %d / %d entries, %s total\r\n\r\n", cacheCount, MAX_BITMAPS_CACHED,
                  FormatCacheBytesTemp(totalBytes)));
 
+    // per-document page caches (display lists etc.) of the documents with tiles
+    Vec<EngineBase*> engines;
+    for (int i = 0; i < cacheCount; i++) {
+        EngineBase* engine = cache[i]->dm ? cache[i]->dm->GetEngine() : nullptr;
+        if (engine && !engines.Contains(engine)) {
+            engines.Append(engine);
+        }
+    }
+    bool hasPageCacheInfo = false;
+    for (EngineBase* engine : engines) {
+        TempStr info = EngineMupdfPageCacheInfoTemp(engine);
+        if (info.len > 0) {
+            s.Append(info);
+            hasPageCacheInfo = true;
+        }
+    }
+    if (hasPageCacheInfo) {
+        s.Append(StrL("\r\n"));
+    }
+
     if (cacheHistoryCount > 0) {
         s.Append(fmt("Recent %d changes:\r\n", cacheHistoryCount));
         int idx = cacheHistoryNext - 1;
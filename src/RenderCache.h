@@ -228,6 +228,9 @@ struct RenderCache {
     bool GetNextRequest(PageRenderRequest* req, int threadIdx);
     void Add(PageRenderRequest& req, Pixmap* bmp);
 
+    Pixmap* RenderDetachedPage(EngineBase* engine, int pageNo, float zoom, int rotation, u32* epochOut);
+    bool AdoptDetachedPage(DisplayModel* dm, int pageNo, float zoom, int rotation, u32 epoch, Pixmap* bmp);
+
     USHORT GetTileRes(DisplayModel* dm, int pageNo) const;
     USHORT GetMaxTileRes(DisplayModel* dm, int pageNo, int rotation);
     bool ReduceTileSize();
@@ -252,6 +255,7 @@ struct RenderCache {
     int PaintTile(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, TilePosition tile, Rect tileOnScreen,
                   bool renderMissing, bool* renderOutOfDateCue, bool* renderedReplacement);
     void LogCacheSize();
+    i64 CacheBytes(int* nEntriesOut = nullptr);
 
     void RecordFinishedRequest(PageRenderRequest* req);
     void SerializeQueueState(str::Builder& s);
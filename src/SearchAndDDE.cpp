@@ -961,8 +961,25 @@ void InvalidateFindForDocumentChange(MainWindow* win) {
     }
 }
 
-// build a one-line "...context match context..." snippet (UTF-8) around a match
-static TempStr BuildSnippet(EngineBase* engine, const FindMatch& m) {
+// where byte off of s ends up after str::NormalizeWSInPlace(s)
+static int NormalizedWSOffset(Str s, int off) {
+    int dst = 0;
+    bool addedSpace = true;
+    for (int src = 0; src < off; src++) {
+        if (!str::IsWs(s.s[src])) {
+            dst++;
+            addedSpace = false;
+        } else if (!addedSpace) {
+            dst++;
+            addedSpace = true;
+        }
+    }
+    return dst;
+}
+
+// build a one-line "...context match context..." snippet (UTF-8) around a match.
+// Sets m.snippetMatchStart / m.snippetMatchLen to where the match is in it
+static TempStr BuildSnippet(EngineBase* engine, FindMatch& m) {
     int textLen = 0;
     Str pageText = engine->GetTextForPage(m.startPage, &textLen);
     if (!pageText) {
@@ -975,8 +992,14 @@ static TempStr BuildSnippet(EngineBase* engine, const FindMatch& m) {
     int from = std::max(0, mStart - kCtx);
     int to = std::min(textLen, mEnd + kCtx);
     TempStr sub = str::DupTemp(Utf8SliceByCodepoints(pageText, from, to - from));
+    int hlStart = NormalizedWSOffset(sub, len(Utf8SliceByCodepoints(pageText, from, mStart - from)));
+    int hlEnd = NormalizedWSOffset(sub, len(Utf8SliceByCodepoints(pageText, from, mEnd - from)));
     sub.len -= str::NormalizeWSInPlace(sub);
-    return fmt("%s%s%s", Str(from > 0 ? "..." : ""), sub, Str(to < textLen ? "..." : ""));
+    Str prefix = from > 0 ? StrL("...") : StrL("");
+    hlEnd = std::min(hlEnd, len(sub));
+    m.snippetMatchStart = len(prefix) + hlStart;
+    m.snippetMatchLen = std::max(0, hlEnd - hlStart);
+    return fmt("%s%s%s", prefix, sub, Str(to < textLen ? "..." : ""));
 }
 
 struct CountThreadData {
@@ -762,6 +762,13 @@ struct GlobalPrefs {
     // file picker), or sumatrapdf (Navigate Files in Folder). Toggled by
     // Settings / SumatraPDF File Picker
     Str filePicker;
+    // if true, going to the next or previous file in a folder also starts
+    // loading the file after it in the background, so that the following
+    // step doesn't wait for it to load
+    bool preloadNextDocument;
+    // memory, in MB, that a PDF document can use to cache the contents of its
+    // pages. Past it, the caches of the pages furthest from the view are freed
+    int pageCacheSizeMB;
     // if true, a document will be reloaded automatically whenever it's
     // changed (currently doesn't work for documents shown in the ebook UI)
     bool reloadModifiedDocuments;
@@ -1914,6 +1921,8 @@ static const FieldInfo gGlobalPrefsFields[] = {
     {offsetof(GlobalPrefs, homePageSortByFrequentlyRead), SettingType::Bool, false},
     {offsetof(GlobalPrefs, homePageViewMode), SettingType::String, (intptr_t)"thumbnails"},
     {offsetof(GlobalPrefs, filePicker), SettingType::String, (intptr_t)""},
+    {offsetof(GlobalPrefs, preloadNextDocument), SettingType::Bool, true},
+    {offsetof(GlobalPrefs, pageCacheSizeMB), SettingType::Int, 256},
     {offsetof(GlobalPrefs, reloadModifiedDocuments), SettingType::Bool, true},
     {offsetof(GlobalPrefs, rememberOpenedFiles), SettingType::Bool, true},
     {offsetof(GlobalPrefs, rememberStatePerDocument), SettingType::Bool, true},
@@ -2048,26 +2057,26 @@ static const FieldInfo gGlobalPrefsFields[] = {
 };
 static const StructInfo gGlobalPrefsInfo = {
     sizeof(GlobalPrefs),
-    147,
+    149,
     gGlobalPrefsFields,
     "\0\0DefaultDisplayMode\0DefaultZoom\0DisableJavaScript\0AllowExternalImages\0EnableTeXEnhancements\0EscToExit\0Ful"
     "lPathInTitle\0InverseSearchCmdLine\0LazyLoading\0MainWindowBackground\0NoHomeTab\0HomePageSortByFrequentlyRead\0Ho"
-    "mePageViewMode\0FilePicker\0ReloadModifiedDocuments\0RememberOpenedFiles\0RememberStatePerDocument\0RestoreSession"
-    "\0ReuseInstance\0ShowMenubar\0ShowMenubarWithTabs\0ShowTips\0CustomColors\0ShowToolbar\0Toolbar\0ToolbarPosition\0"
-    "SearchUIFloating\0ShowFavorites\0SortFavoritesByName\0ShowToc\0SidebarOnRight\0ShowLinks\0HighlightFormFields\0Cli"
-    "ckEdgeToTurnPage\0DisableLinks\0ExplorerQuickLook\0RememberViewOffsetOnPageTurn\0MouseWheelTurnsPage\0ShowDocument"
-    "FocusIndicator\0ShowAnnotationNotification\0ShowTocPageNumbers\0ShowStartPage\0SidebarDx\0Scrollbars\0ScrollbarInS"
-    "inglePage\0SmoothScroll\0ScrollLineAmount\0PaddingAfterLastPage\0IgnoreDestinationZoom\0HighlightLinkDestination\0"
-    "CitationHoverDelay\0ReadAloudVoiceId\0ReadAloudSpeed\0FastScrollOverScrollbar\0PreventSleepInFullscreen\0TabWidth"
-    "\0Theme\0LastLightTheme\0LastDarkTheme\0DocumentColorsFollowTheme\0TocDy\0ToolbarCustomLayout\0ToolbarShowReadAlou"
-    "d\0ToolbarSize\0TreeFontName\0TreeFontSize\0UIFontSize\0DisableAntiAlias\0EngineeringDrawingEnhance\0DisableAutoLi"
-    "nks\0UseSysColors\0UseTabs\0SelectionToolbar\0SelectionToolbarLayout\0TabsMru\0CtrlTabSimple\0ZoomLevels\0ZoomIncr"
-    "ement\0\0FixedPageUI\0\0EBookUI\0\0ComicBookUI\0\0ImageUI\0\0ChmUI\0\0MarkdownUI\0\0HtmlUI\0\0ClaudeCode\0\0GrokBu"
-    "ild\0\0CodexBuild\0\0AntiGravity\0\0AIChatSidebarDx\0\0TranslateToLang\0TranslateFromLang\0TranslateEngine\0\0Anno"
-    "tations\0\0ExternalViewers\0\0ForwardSearch\0\0PrinterDefaults\0\0Fullscreen\0\0SelectionHandlers\0\0Shortcuts\0\0"
-    "Themes\0\0TabGroups\0\0CustomScreenDPI\0\0\0DefaultPasswords\0UiLanguage\0VersionToSkip\0WindowState\0WindowPos\0S"
-    "earchUIWindowPos\0HelpWindowPos\0AnnotationsWindowSize\0FileStates\0SessionData\0ReopenOnce\0TimeOfLastUpdateCheck"
-    "\0OpenCountWeek\0PropWinPos\0CheckForUpdates\0\0",
+    "mePageViewMode\0FilePicker\0PreloadNextDocument\0PageCacheSizeMB\0ReloadModifiedDocuments\0RememberOpenedFiles\0Re"
+    "memberStatePerDocument\0RestoreSession\0ReuseInstance\0ShowMenubar\0ShowMenubarWithTabs\0ShowTips\0CustomColors\0S"
+    "howToolbar\0Toolbar\0ToolbarPosition\0SearchUIFloating\0ShowFavorites\0SortFavoritesByName\0ShowToc\0SidebarOnRigh"
+    "t\0ShowLinks\0HighlightFormFields\0ClickEdgeToTurnPage\0DisableLinks\0ExplorerQuickLook\0RememberViewOffsetOnPageT"
+    "urn\0MouseWheelTurnsPage\0ShowDocumentFocusIndicator\0ShowAnnotationNotification\0ShowTocPageNumbers\0ShowStartPag"
+    "e\0SidebarDx\0Scrollbars\0ScrollbarInSinglePage\0SmoothScroll\0ScrollLineAmount\0PaddingAfterLastPage\0IgnoreDesti"
+    "nationZoom\0HighlightLinkDestination\0CitationHoverDelay\0ReadAloudVoiceId\0ReadAloudSpeed\0FastScrollOverScrollba"
+    "r\0PreventSleepInFullscreen\0TabWidth\0Theme\0LastLightTheme\0LastDarkTheme\0DocumentColorsFollowTheme\0TocDy\0Too"
+    "lbarCustomLayout\0ToolbarShowReadAloud\0ToolbarSize\0TreeFontName\0TreeFontSize\0UIFontSize\0DisableAntiAlias\0Eng"
+    "ineeringDrawingEnhance\0DisableAutoLinks\0UseSysColors\0UseTabs\0SelectionToolbar\0SelectionToolbarLayout\0TabsMru"
+    "\0CtrlTabSimple\0ZoomLevels\0ZoomIncrement\0\0FixedPageUI\0\0EBookUI\0\0ComicBookUI\0\0ImageUI\0\0ChmUI\0\0Markdow"
+    "nUI\0\0HtmlUI\0\0ClaudeCode\0\0GrokBuild\0\0CodexBuild\0\0AntiGravity\0\0AIChatSidebarDx\0\0TranslateToLang\0Trans"
+    "lateFromLang\0TranslateEngine\0\0Annotations\0\0ExternalViewers\0\0ForwardSearch\0\0PrinterDefaults\0\0Fullscreen"
+    "\0\0SelectionHandlers\0\0Shortcuts\0\0Themes\0\0TabGroups\0\0CustomScreenDPI\0\0\0DefaultPasswords\0UiLanguage\0Ve"
+    "rsionToSkip\0WindowState\0WindowPos\0SearchUIWindowPos\0HelpWindowPos\0AnnotationsWindowSize\0FileStates\0SessionD"
+    "ata\0ReopenOnce\0TimeOfLastUpdateCheck\0OpenCountWeek\0PropWinPos\0CheckForUpdates\0\0",
     "\0\0default layout of pages. valid values: automatic, single page, facing, book view, continuous, continuous "
     "facing, continuous book view, page aspect. page aspect (3.7+): first open of a PDF, XPS, DjVu or PostScript file "
     "uses page 1 — taller than wide is continuous + fit width, wider than tall is single page + fit page; a remembered "
@@ -2082,50 +2091,53 @@ static const StructInfo gGlobalPrefsInfo = {
     "to the Light theme; the default #80fff200 is a marker meaning \"use the theme's color\", so setting any other "
     "value also colorizes the toolbar and sidebars\0if true, doesn't open Home tab\0if true, the home page lists "
     "documents by how often they've been opened (the pre-3.6 behavior); if false, the most recently opened come "
-    "first\0valid values: thumbnails, list\0valid values: (empty), os, sumatrapdf\0if true, a document will be "
-    "reloaded automatically whenever it's changed (currently doesn't work for documents shown in the ebook UI)\0if "
-    "true, remember which documents were opened and their display settings\0if true, store display settings for each "
-    "document separately (i.e. everything after UseDefaultState in FileStates)\0if true and SessionData isn't empty, "
-    "that session will be restored at startup\0if true, open documents in the already running SumatraPDF instead of "
-    "starting a new one\0if true, show the menu bar (F9 toggles it; the choice is remembered across sessions)\0if "
-    "true, show the menu bar when using tabs (useTabs = true)\0if true, show tips on the home page\0up to 13 custom "
-    "colors for the background color picker, separated by space (e.g. '#ff0000 #00ff00 #0000ff')\0legacy bool for "
-    "toolbar; if Toolbar is empty, derived as show/hide (internal; use Toolbar instead)\0toolbar mode: show (pinned), "
-    "hide (no toolbar), overlay (toolbar floats over the page, sized to its natural width and centered, only shown "
-    "when the mouse is near it). if empty, derived from ShowToolbar\0where the toolbar is placed: top or bottom "
-    "(applies to both show and overlay modes)\0if true, the find UI is a floating, movable window with a results list "
-    "instead of the compact toolbar overlay\0if true, show the Favorites sidebar\0if true, favorites within each file "
-    "are sorted alphabetically by name (or page label); if false (the default), they are sorted by page number\0if "
-    "true, show the table of contents (Bookmarks) sidebar when the document has one\0if true, put the bookmarks / "
-    "favorites sidebar on the right of the window (left is the default; right-to-left UI languages already put it on "
-    "the right)\0if true, draw a blue border around links in the document\0if true, highlight empty fillable PDF form "
-    "fields in pale blue so they are easy to find\0if true, a click (not a drag) on the left fifth of the page area "
-    "goes to the previous page and a click on the right fifth goes to the next page (reversed in manga / right-to-left "
-    "mode). Links, annotations and presentation-mode clicks are unchanged\0if true, document links are ignored so you "
-    "can select and read (useful for drawings with many links); if false, clicking a link follows it\0if true, Space "
-    "in File Explorer (or on the desktop) previews the selected file in a popup window, like macOS Quick Look. Esc or "
-    "Space closes it; Left / Right open the previous / next file in the folder. Starts a small background helper at "
-    "logon so it works even when SumatraPDF is not open\0if true, next/previous page keeps the same view position on "
-    "the page instead of jumping to the top (useful when zoomed in on similarly sized pages)\0if true, one mouse-wheel "
-    "notch goes to the next / previous page instead of scrolling; combine with RememberViewOffsetOnPageTurn to read "
-    "zoomed-in pages without touching the keyboard. Alt + wheel still scrolls, Shift + wheel scrolls horizontally and "
-    "Ctrl + wheel zooms\0if true, draw a focus ring around the document when it has keyboard focus (Tab to the page "
-    "area)\0if true, show a tip when hovering an annotation (e.g. \"Highlight annotation. Ctrl+click to edit.\")\0if "
-    "true, show page numbers (labels) right-aligned on bookmark / table-of-contents entries\0if true, show a list of "
-    "frequently read documents when no document is loaded\0width of the favorites / bookmarks sidebar in screen "
-    "pixels, as last resized (0 means the default)\0scrollbar mode: windows (standard Windows scrollbar), smart "
-    "(overlay scrollbar with auto-hide), overlay (always visible overlay scrollbar), hidden (no scrollbars)\0if true, "
-    "show a scrollbar in single page mode as well\0if true, smooth mouse-wheel and arrow-key scrolling (exponential "
-    "chase of the target; continuous input stays fluid)\0distance, in screen pixels at 96 DPI, scrolled by an "
-    "arrow-key press or one mouse-wheel line; values below 1 use 16\0if true, continuous view has extra scroll room "
-    "after the last page so you can scroll the end of the document to the top of the window\0if true, going to a "
-    "destination (clicking a bookmark or a link inside the document) keeps the current zoom instead of applying the "
-    "zoom the destination asks for; it still goes to the page and the position. Same as Adobe Reader's 'forbid the "
-    "change of the current zoom factor during execution of Go to Destination actions'\0if true, following an internal "
-    "link or bookmark flashes a highlight at the destination so you can see where you landed (a bibliography entry, "
-    "figure, or named destination). The color and fade match ForwardSearch. Off when the destination is only a page "
-    "with no position\0how long an internal-document link has to be hovered, in milliseconds, before a popup rendering "
-    "the destination region (citation entry, figure, footnote) appears. -1 (the default) disables the popup; set a "
+    "first\0valid values: thumbnails, list\0valid values: (empty), os, sumatrapdf\0if true, going to the next or "
+    "previous file in a folder also starts loading the file after it in the background, so that the following step "
+    "doesn't wait for it to load\0memory, in MB, that a PDF document can use to cache the contents of its pages. Past "
+    "it, the caches of the pages furthest from the view are freed\0if true, a document will be reloaded automatically "
+    "whenever it's changed (currently doesn't work for documents shown in the ebook UI)\0if true, remember which "
+    "documents were opened and their display settings\0if true, store display settings for each document separately "
+    "(i.e. everything after UseDefaultState in FileStates)\0if true and SessionData isn't empty, that session will be "
+    "restored at startup\0if true, open documents in the already running SumatraPDF instead of starting a new one\0if "
+    "true, show the menu bar (F9 toggles it; the choice is remembered across sessions)\0if true, show the menu bar "
+    "when using tabs (useTabs = true)\0if true, show tips on the home page\0up to 13 custom colors for the background "
+    "color picker, separated by space (e.g. '#ff0000 #00ff00 #0000ff')\0legacy bool for toolbar; if Toolbar is empty, "
+    "derived as show/hide (internal; use Toolbar instead)\0toolbar mode: show (pinned), hide (no toolbar), overlay "
+    "(toolbar floats over the page, sized to its natural width and centered, only shown when the mouse is near it). if "
+    "empty, derived from ShowToolbar\0where the toolbar is placed: top or bottom (applies to both show and overlay "
+    "modes)\0if true, the find UI is a floating, movable window with a results list instead of the compact toolbar "
+    "overlay\0if true, show the Favorites sidebar\0if true, favorites within each file are sorted alphabetically by "
+    "name (or page label); if false (the default), they are sorted by page number\0if true, show the table of contents "
+    "(Bookmarks) sidebar when the document has one\0if true, put the bookmarks / favorites sidebar on the right of the "
+    "window (left is the default; right-to-left UI languages already put it on the right)\0if true, draw a blue border "
+    "around links in the document\0if true, highlight empty fillable PDF form fields in pale blue so they are easy to "
+    "find\0if true, a click (not a drag) on the left fifth of the page area goes to the previous page and a click on "
+    "the right fifth goes to the next page (reversed in manga / right-to-left mode). Links, annotations and "
+    "presentation-mode clicks are unchanged\0if true, document links are ignored so you can select and read (useful "
+    "for drawings with many links); if false, clicking a link follows it\0if true, Space in File Explorer (or on the "
+    "desktop) previews the selected file in a popup window, like macOS Quick Look. Esc or Space closes it; Left / "
+    "Right open the previous / next file in the folder. Starts a small background helper at logon so it works even "
+    "when SumatraPDF is not open\0if true, next/previous page keeps the same view position on the page instead of "
+    "jumping to the top (useful when zoomed in on similarly sized pages)\0if true, one mouse-wheel notch goes to the "
+    "next / previous page instead of scrolling; combine with RememberViewOffsetOnPageTurn to read zoomed-in pages "
+    "without touching the keyboard. Alt + wheel still scrolls, Shift + wheel scrolls horizontally and Ctrl + wheel "
+    "zooms\0if true, draw a focus ring around the document when it has keyboard focus (Tab to the page area)\0if true, "
+    "show a tip when hovering an annotation (e.g. \"Highlight annotation. Ctrl+click to edit.\")\0if true, show page "
+    "numbers (labels) right-aligned on bookmark / table-of-contents entries\0if true, show a list of frequently read "
+    "documents when no document is loaded\0width of the favorites / bookmarks sidebar in screen pixels, as last "
+    "resized (0 means the default)\0scrollbar mode: windows (standard Windows scrollbar), smart (overlay scrollbar "
+    "with auto-hide), overlay (always visible overlay scrollbar), hidden (no scrollbars)\0if true, show a scrollbar in "
+    "single page mode as well\0if true, smooth mouse-wheel and arrow-key scrolling (exponential chase of the target; "
+    "continuous input stays fluid)\0distance, in screen pixels at 96 DPI, scrolled by an arrow-key press or one "
+    "mouse-wheel line; values below 1 use 16\0if true, continuous view has extra scroll room after the last page so "
+    "you can scroll the end of the document to the top of the window\0if true, going to a destination (clicking a "
+    "bookmark or a link inside the document) keeps the current zoom instead of applying the zoom the destination asks "
+    "for; it still goes to the page and the position. Same as Adobe Reader's 'forbid the change of the current zoom "
+    "factor during execution of Go to Destination actions'\0if true, following an internal link or bookmark flashes a "
+    "highlight at the destination so you can see where you landed (a bibliography entry, figure, or named "
+    "destination). The color and fade match ForwardSearch. Off when the destination is only a page with no "
+    "position\0how long an internal-document link has to be hovered, in milliseconds, before a popup rendering the "
+    "destination region (citation entry, figure, footnote) appears. -1 (the default) disables the popup; set a "
     "positive value like 300 to enable it\0voice id for Read Aloud text-to-speech; empty or unset means system "
     "default. Voice ids match those used internally by the Read Aloud Voice menu (WinRT voice id or SAPI token "
     "id)\0playback speed multiplier for Read Aloud text-to-speech (0.5 .. 3.0), 1 is normal speed; can also be changed "
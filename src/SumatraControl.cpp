@@ -54,6 +54,7 @@
 #include "EutlTrust.h"
 #include "CommandPalette.h"
 #include "PdfTools.h"
+#include "PerfStats.h"
 
 extern bool gIsStartup;
 TempStr FindHistoryResultTemp(int* exitCodeOut);
@@ -587,6 +588,43 @@ static TempStr DocumentFontListResultTemp(int* exitCodeOut) {
     return finish(fmt("OK fonts=%s", fonts), 0);
 }
 
+// A test resets the counters, does what it measures (open a file, scroll,
+// search) and then checks what that cost, e.g. the time to the first tile.
+static TempStr PerfStatsResultTemp(Str action, int* exitCodeOut) {
+    if (!action || str::EqI(action, StrL("get"))) {
+        // report only
+    } else if (str::EqI(action, StrL("reset"))) {
+        PerfStatsReset();
+    } else {
+        *exitCodeOut = 1;
+        return fmt("ERROR unknown-action action=%s\n", action);
+    }
+    str::Builder out;
+    out.Append(StrL("OK\n"));
+    PerfStatsAppend(out);
+
+    // memory held right now, for the document in the first window. -1 if not
+    // known: not a mupdf document, or a render has its caches
+    int nCached = 0;
+    i64 renderCacheBytes = gRenderCache ? gRenderCache->CacheBytes(&nCached) : 0;
+    i64 textCacheBytes = -1;
+    EngineMupdfCacheStats pageCache;
+    pageCache.bytes = -1;
+    MainWindow* win = len(gWindows) > 0 ? gWindows[0] : nullptr;
+    DisplayModel* dm = win ? win->AsFixed() : nullptr;
+    EngineBase* engine = dm ? dm->GetEngine() : nullptr;
+    if (engine) {
+        textCacheBytes = engine->TextCacheBytes();
+        EngineMupdfGetPageCacheStats(engine, &pageCache);
+    }
+    out.Append(fmt("memory renderCacheBytes=%lld renderCacheEntries=%d textCacheBytes=%lld pageCacheBytes=%lld "
+                   "pageCacheEvictions=%d pageCacheRebuilds=%d\n",
+                   renderCacheBytes, nCached, textCacheBytes, pageCache.bytes, pageCache.evictions,
+                   pageCache.rebuilds));
+    *exitCodeOut = 0;
+    return ToStrTemp(out);
+}
+
 enum class ControlCmd : u16 {
     Ping = 1,
     Quit = 2,
@@ -655,6 +693,7 @@ enum class ControlCmd : u16 {
     TestSelectionToolbar = 73,
     TestMarkupAnnots = 74,
     TestCmykImageSave = 75,
+    GetPerfStats = 76,
 };
 
 enum class ControlArgType : u16 {
@@ -1448,6 +1487,14 @@ static void ExecuteControlRequest(ControlRequest* req) {
             break;
         }
 
+        case ControlCmd::GetPerfStats: {
+            Str action = StringArg(req, 0);
+            int exitCode = 0;
+            Str res = PerfStatsResultTemp(action, &exitCode);
+            AppendTestResult(req, exitCode, res);
+            break;
+        }
+
         case ControlCmd::TestSelectionToolbar: {
             AppendTestResult(req, 0, SelectionToolbarLayoutDumpTemp());
             break;
@@ -39,10 +39,41 @@ static HANDLE hLogPipe = INVALID_HANDLE_VALUE;
 static Mutex gPipeMutex;
 
 Str gLogFilePath;
+// kept open: opening, flushing and closing the file for every line was the
+// most expensive part of logging. Guarded by gLogMutex
+static HANDLE hLogFile = INVALID_HANDLE_VALUE;
 
 // 1 MB - 128 to stay under 1 MB even after appending (an estimate)
 constexpr int kMaxLogBuf = (1024 * 1024) - 128;
 
+// After StartAsyncLogging() log() doesn't write anything itself: it pushes the
+// message on gLogPending and returns. LogWriterThread() takes all pending
+// messages at once and writes them to the sinks (gLogBuf, console, file, pipe)
+// with one file write per batch. Threads that log a lot (rendering, search)
+// then neither wait for each other nor for the disk
+struct LogMsg {
+    LogMsg* next;
+    int len;
+    char s[1];
+};
+
+// a lock-free stack, newest first. Producers push with a compare-exchange,
+// the consumer takes the whole stack with an exchange (so no ABA problem)
+static AtomicPtr gLogPending = nullptr;
+static AtomicInt gLogPendingBytes = 0;
+// when the writer can't keep up we drop messages instead of using more memory
+constexpr int kMaxLogPendingBytes = 4 * 1024 * 1024;
+static AtomicInt gLogDropped = 0;
+static AtomicBool gLogAsync = false;
+static AtomicBool gLogWriterShouldExit = false;
+static HANDLE gLogWakeEvent = nullptr;
+static ThreadHandle gLogWriterThread = nullptr;
+
+// what goes to the file and the pipe is collected here first. Static so that
+// flushing during crash handling doesn't allocate. Guarded by gLogMutex
+static char gLogBatch[64 * 1024];
+static int gLogBatchLen = 0;
+
 static LARGE_INTEGER lastPipeOpenTryTime = {};
 
 static void maybeOpenLogPipe() {
@@ -102,31 +133,38 @@ static void logToPipe(Str s) {
     gPipeMutex.Unlock();
 }
 
-void log(Str s) {
-    bool skipLog = gSkipDuplicateLines && gLogBuf && str::Contains(*gLogBuf, s);
-
-    if (!skipLog) {
-        // in reduced logging mode, we do want to log to at least the debugger
-        if (gLogToDebugger || IsDebuggerPresent() || gReducedLogging) {
-            OutputDebugStringA(s.s);
-        }
-    }
-    if (gDestroyedLogging) {
+// must hold gLogMutex
+static void logToFile(Str s) {
+    if (!gLogFilePath) {
         return;
     }
-    if (gReducedLogging) {
-        // if the pipe already connected, do log to it even if disabled
-        // we do want easy logging, just want to reduce doing stuff
-        // that can break crash handling
-        if (gLogToPipe && IsValidHandle(hLogPipe)) {
-            logToPipe(s);
+    if (!IsValidHandle(hLogFile)) {
+        DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+        hLogFile = CreateFileW(CWStrTemp(gLogFilePath), FILE_APPEND_DATA, share, nullptr, OPEN_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (!IsValidHandle(hLogFile)) {
+            return;
         }
+    }
+    // not buffered by us: once WriteFile() returns, the data survives a crash
+    DWORD cbWritten = 0;
+    WriteFile(hLogFile, s.s, (DWORD)s.len, &cbWritten, nullptr);
+}
+
+// must hold gLogMutex
+static void FlushLogBatch() {
+    if (gLogBatchLen == 0) {
         return;
     }
-    gLogMutex.Lock();
+    Str s(gLogBatch, gLogBatchLen);
+    logToFile(s);
+    logToPipe(s);
+    gLogBatchLen = 0;
+}
 
-    AtomicIntInc(&gAllowAllocFailure);
-    AutoCall decAllowAlloc(AtomicIntDec, &gAllowAllocFailure);
+// must hold gLogMutex
+static void logToSinks(Str s) {
+    bool skipLog = gSkipDuplicateLines && gLogBuf && str::Contains(*gLogBuf, s);
 
     if (!gLogBuf) {
         gLogAllocator = ArenaNew();
@@ -139,8 +177,6 @@ void log(Str s) {
         }
     }
 
-    size_t n = (size_t)s.len;
-
     // when skipping, we skip buf (crash reports) and console
     // but write to file and logview
     if (!skipLog) {
@@ -151,18 +187,189 @@ void log(Str s) {
         LogConsole(s);
     }
 
-    if (gLogFilePath) {
-        auto* f = fopen(gLogFilePath.s, "a");
-        if (f != nullptr) {
-            fwrite(s.s, 1, n, f);
-            fflush(f);
-            fclose(f);
+    if (gLogBatchLen + s.len > sizeofi(gLogBatch)) {
+        FlushLogBatch();
+    }
+    if (s.len > sizeofi(gLogBatch)) {
+        logToFile(s);
+        logToPipe(s);
+        return;
+    }
+    memcpy(gLogBatch + gLogBatchLen, s.s, (size_t)s.len);
+    gLogBatchLen += s.len;
+}
+
+static void PushLogMsg(Str s) {
+    if (AtomicIntAdd(&gLogPendingBytes, s.len) > kMaxLogPendingBytes) {
+        AtomicIntAdd(&gLogPendingBytes, -s.len);
+        AtomicIntInc(&gLogDropped);
+        return;
+    }
+    auto msg = (LogMsg*)malloc(sizeof(LogMsg) + (size_t)s.len);
+    if (!msg) {
+        AtomicIntAdd(&gLogPendingBytes, -s.len);
+        AtomicIntInc(&gLogDropped);
+        return;
+    }
+    msg->len = s.len;
+    memcpy(msg->s, s.s, (size_t)s.len);
+    msg->s[s.len] = 0;
+    void* head;
+    do {
+        head = AtomicPtrGet(&gLogPending);
+        msg->next = (LogMsg*)head;
+    } while (InterlockedCompareExchangePointer(&gLogPending, msg, head) != head);
+    // the writer empties the stack before it waits, so it only needs
+    // waking up for the first message
+    if (!head) {
+        SetEvent(gLogWakeEvent);
+    }
+}
+
+// writes out all pending messages, oldest first. During crash handling
+// messages are not freed: the heap might be what's broken.
+// Must hold gLogMutex
+static void DrainPendingLog() {
+    auto msg = (LogMsg*)AtomicPtrExchange(&gLogPending, nullptr);
+    LogMsg* oldest = nullptr;
+    while (msg) {
+        LogMsg* next = msg->next;
+        msg->next = oldest;
+        oldest = msg;
+        msg = next;
+    }
+
+    AtomicIntInc(&gAllowAllocFailure);
+    AutoCall decAllowAlloc(AtomicIntDec, &gAllowAllocFailure);
+
+    bool canFree = !gReducedLogging;
+    msg = oldest;
+    while (msg) {
+        LogMsg* next = msg->next;
+        logToSinks(Str(msg->s, msg->len));
+        AtomicIntAdd(&gLogPendingBytes, -msg->len);
+        if (canFree) {
+            free(msg);
         }
+        msg = next;
     }
-    logToPipe(s);
+    int nDropped = AtomicIntGet(&gLogDropped);
+    if (nDropped > 0) {
+        AtomicIntAdd(&gLogDropped, -nDropped);
+        char buf[64];
+        int n = snprintf(buf, sizeof(buf), "log: dropped %d messages\n", nDropped);
+        logToSinks(Str(buf, n));
+    }
+    FlushLogBatch();
+}
+
+static void LogWriterThread() {
+    for (;;) {
+        WaitForSingleObject(gLogWakeEvent, INFINITE);
+        if (AtomicBoolGet(&gLogWriterShouldExit)) {
+            break;
+        }
+        // during crash handling FlushLogForCrashReport() takes over
+        if (gReducedLogging) {
+            continue;
+        }
+        gLogMutex.Lock();
+        DrainPendingLog();
+        gLogMutex.Unlock();
+    }
+}
+
+void log(Str s) {
+    bool skipLog = gSkipDuplicateLines && gLogBuf && str::Contains(*gLogBuf, s);
+
+    if (!skipLog) {
+        // in reduced logging mode, we do want to log to at least the debugger
+        if (gLogToDebugger || IsDebuggerPresent() || gReducedLogging) {
+            OutputDebugStringA(s.s);
+        }
+    }
+    if (gDestroyedLogging) {
+        return;
+    }
+    if (gReducedLogging) {
+        // if the pipe already connected, do log to it even if disabled
+        // we do want easy logging, just want to reduce doing stuff
+        // that can break crash handling
+        if (gLogToPipe && IsValidHandle(hLogPipe)) {
+            logToPipe(s);
+        }
+        return;
+    }
+    if (!s) {
+        return;
+    }
+    if (AtomicBoolGet(&gLogAsync)) {
+        PushLogMsg(s);
+        return;
+    }
+
+    gLogMutex.Lock();
+    AtomicIntInc(&gAllowAllocFailure);
+    logToSinks(s);
+    FlushLogBatch();
+    AtomicIntDec(&gAllowAllocFailure);
     gLogMutex.Unlock();
 }
 
+// from now on log() only queues messages and a thread writes them out
+void StartAsyncLogging() {
+    if (gLogWriterThread || gDestroyedLogging) {
+        return;
+    }
+    gLogWakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!gLogWakeEvent) {
+        return;
+    }
+    gLogWriterThread = StartThread(MkFunc0Void(LogWriterThread), StrL("LogWriterThread"));
+    if (!gLogWriterThread) {
+        SafeCloseHandle(&gLogWakeEvent);
+        return;
+    }
+    AtomicBoolSet(&gLogAsync, true);
+}
+
+static void StopAsyncLogging() {
+    if (!gLogWriterThread) {
+        return;
+    }
+    // messages logged from now on are written by log() itself
+    AtomicBoolSet(&gLogAsync, false);
+    AtomicBoolSet(&gLogWriterShouldExit, true);
+    SetEvent(gLogWakeEvent);
+    WaitForSingleObject(gLogWriterThread, INFINITE);
+    SafeCloseHandle(&gLogWriterThread);
+    SafeCloseHandle(&gLogWakeEvent);
+    FlushLog();
+}
+
+// writes out what's been queued so far
+void FlushLog() {
+    gLogMutex.Lock();
+    DrainPendingLog();
+    gLogMutex.Unlock();
+}
+
+// Called before the log is added to a crash report. A crashed thread might
+// hold gLogMutex forever, so we only wait a bit for it
+void FlushLogForCrashReport() {
+    if (!gLogWriterThread) {
+        return;
+    }
+    for (int i = 0; i < 50; i++) {
+        if (gLogMutex.TryLock()) {
+            DrainPendingLog();
+            gLogMutex.Unlock();
+            return;
+        }
+        Sleep(10);
+    }
+}
+
 void StartLogToFile(Str path, bool removeIfExists) {
     ReportIf(gLogFilePath);
     gLogFilePath = str::Dup(path);
@@ -173,6 +380,7 @@ void StartLogToFile(Str path, bool removeIfExists) {
 }
 
 bool WriteCurrentLogToFile(Str path) {
+    FlushLog();
     if (!gLogBuf) return false;
     Str slice = ToStr(*gLogBuf);
     if (len(slice) == 0) {
@@ -191,12 +399,14 @@ bool WriteCurrentLogToFile(Str path) {
 }
 
 void DestroyLogging() {
+    StopAsyncLogging();
     gDestroyedLogging = true;
     gLogMutex.Lock();
     delete gLogBuf;
     gLogBuf = nullptr;
     ArenaDelete(gLogAllocator);
     gLogAllocator = nullptr;
+    SafeCloseHandle(&hLogFile);
     gLogMutex.Unlock();
     str::FreePtr(&gLogFilePath);
     FileWatcherSetSkipPath(Str());
@@ -7,6 +7,9 @@ extern bool gLogToPipe;
 extern Str gLogAppName;
 extern Str gLogFilePath;
 void StartLogToFile(Str path, bool removeIfExists);
+void StartAsyncLogging();
+void FlushLog();
+void FlushLogForCrashReport();
 bool WriteCurrentLogToFile(Str path);
 void DestroyLogging();
 void LogParentProcessChain();
\ No newline at end of file
@@ -78,6 +78,7 @@
 #include "ExternalViewers.h"
 #include "Favorites.h"
 #include "FileThumbnails.h"
+#include "DocPreload.h"
 #include "Menu.h"
 #include "ImageReader.h"
 #include "PngOptimizer.h"
@@ -122,6 +123,7 @@
 #include "ReadAloudPlaybackBar.h"
 #include "ExplorerQuickLook.h"
 #include "SumatraLog.h"
+#include "PerfStats.h"
 
 using Gdiplus::Graphics;
 using Gdiplus::Pen;
@@ -325,7 +327,9 @@ LoadArgs* LoadArgs::Clone() {
     res->noSavePrefs = this->noSavePrefs;
     res->onFinished = this->onFinished;
     res->hwndPwdParent = this->hwndPwdParent;
+    // the clone takes over the engine, both would release it
     res->engine = this->engine;
+    this->engine = nullptr;
     res->initialDisplayMode = this->initialDisplayMode;
     res->initialZoom = this->initialZoom;
     res->ebookLayoutAspect = this->ebookLayoutAspect;
@@ -647,6 +651,7 @@ void BeginDocumentLoad(Str file) {
         return;
     }
     gFilesLoading.Append(path::NormalizeTemp(file));
+    PerfLoadStarted();
 }
 
 void EndDocumentLoad(Str file) {
@@ -2011,6 +2016,7 @@ DocController* CreateControllerForEngineOrFile(EngineBase* engine, Str path, Pas
     // TODO: sniff file content only once
     if (!engine) {
         engine = CreateEngineFromFile(path, pwdUI, chmInFixedUI);
+        PerfRecordLoadPhase(PerfLoadPhase::Engine, TimeSinceInMs(timeStart));
     }
     if (!engine) {
         // as a last resort, try to open as chm file
@@ -2026,9 +2032,11 @@ DocController* CreateControllerForEngineOrFile(EngineBase* engine, Str path, Pas
         SafeEngineRelease(&engine);
         return nullptr;
     }
+    auto timeCtrl = TimeGet();
     DocController* ctrl = new DisplayModel(engine, win->cbHandler);
     ReportIf(!ctrl || !ctrl->AsFixed() || ctrl->AsChm());
     VerifyController(ctrl, path);
+    PerfRecordLoadPhase(PerfLoadPhase::Controller, TimeSinceInMs(timeCtrl));
     gMostRecentlyOpenedDoc = ctrl;
     return ctrl;
 }
@@ -4071,7 +4079,9 @@ static void LoadDocumentAsyncFinish(LoadDocumentAsyncData* d) {
         return;
     }
     args->activateExisting = false;
+    auto timeStart = TimeGet();
     LoadDocumentFinish(args);
+    PerfRecordLoadPhase(PerfLoadPhase::Finish, TimeSinceInMs(timeStart));
     args->onFinished.Call(true);
 }
 
@@ -4143,7 +4153,9 @@ static void LoadDocumentAsync(LoadDocumentAsyncData* d) {
     HwndPasswordUI pwdUI(args->hwndPwdParent);
     bool chmInFixedUI = gGlobalPrefs->chmUI.useFixedPageUI;
     if (!engine) {
+        auto timeStart = TimeGet();
         engine = CreateEngineFromFile(path, &pwdUI, chmInFixedUI);
+        PerfRecordLoadPhase(PerfLoadPhase::Engine, TimeSinceInMs(timeStart));
     }
     if (engine && engine->pageCount <= 0) {
         // same guard as CreateControllerForEngineOrFile
@@ -4557,7 +4569,9 @@ MainWindow* LoadDocument(LoadArgs* args) {
         }
     }
     args->ctrl = ctrl;
+    auto timeFinish = TimeGet();
     MainWindow* result = LoadDocumentFinish(args);
+    PerfRecordLoadPhase(PerfLoadPhase::Finish, TimeSinceInMs(timeFinish));
     EndDocumentLoad(path);
     return result;
 }
@@ -4815,6 +4829,23 @@ void MainWindowRerender(MainWindow* win, bool includeNonClientArea) {
     }
 }
 
+// after an annotation edit: only the tiles the edited annotations cover (old
+// and new position) are re-rendered, the rest of the page and other pages keep
+// their tiles
+void MainWindowRerenderAnnotations(MainWindow* win) {
+    DisplayModel* dm = win->AsFixed();
+    if (!dm) {
+        return;
+    }
+    Vec<int> pageNos;
+    Vec<RectF> rects;
+    EngineMupdfTakeAnnotationDamage(dm->GetEngine(), pageNos, rects);
+    for (int i = 0; i < len(pageNos); i++) {
+        gRenderCache->Invalidate(dm, pageNos[i], rects[i]);
+    }
+    win->RedrawAll(true);
+}
+
 static void RerenderEverything() {
     for (auto* win : gWindows) {
         // rerender the currently displayed tab right away
@@ -6785,9 +6816,10 @@ static bool IsAtDocumentBottom(MainWindow* win) {
     return false;
 }
 
-// next openable file after the current tab's path (no wrap), or empty if none.
-// outN/outM are 1-based index of the next file and total count when non-null.
-static TempStr PeekNextFileInFolderTemp(MainWindow* win, int* outN = nullptr, int* outM = nullptr) {
+// next (or previous) openable file after the current tab's path (no wrap), or
+// empty if none. outN/outM are 1-based index of that file and total count when
+// non-null.
+static TempStr PeekFileInFolderTemp(MainWindow* win, bool forward, int* outN = nullptr, int* outM = nullptr) {
     if (outN) {
         *outN = 0;
     }
@@ -6811,20 +6843,51 @@ static TempStr PeekNextFileInFolderTemp(MainWindow* win, int* outN = nullptr, in
         return {};
     }
     int idx = files->Find(path);
-    if (idx < 0 || idx + 1 >= nFiles) {
-        return {}; // no wrap: already last
+    int next = idx + (forward ? 1 : -1);
+    if (idx < 0 || next < 0 || next >= nFiles) {
+        return {}; // no wrap: already last (or first)
     }
-    Str next = files->At(idx + 1);
-    if (!file::Exists(next)) {
+    Str nextPath = files->At(next);
+    if (!file::Exists(nextPath)) {
         return {};
     }
     if (outN) {
-        *outN = idx + 2; // 1-based index of the next file
+        *outN = next + 1; // 1-based index of the next file
     }
     if (outM) {
         *outM = nFiles;
     }
-    return str::DupTemp(next);
+    return str::DupTemp(nextPath);
+}
+
+// Opens the file the next step in that direction goes to in the background, so
+// that reading through a folder doesn't wait for each file to load (see
+// DocPreload.cpp). The page it opens at is rendered at the current zoom: in a
+// series of files the pages are the same size
+static void PreloadNextFileInFolder(MainWindow* win, bool forward) {
+    TempStr path = PeekFileInFolderTemp(win, forward);
+    if (!path) {
+        return;
+    }
+    // browser views switch pages without loading, ebooks lay out to the window
+    // and mshtml CHM can't load on a thread
+    FileType kind = GuessFileTypeFromName(path);
+    bool isChm = !gGlobalPrefs->chmUI.useFixedPageUI && ChmModel::IsSupportedFileType(kind);
+    if (ShouldUseBrowserView(kind) || IsEbookFileType(kind) || isChm) {
+        return;
+    }
+    DocPreloadArgs args;
+    args.path = path;
+    DisplayModel* dm = win->AsFixed();
+    if (dm) {
+        FileState* fs = FileHistoryFindByPath(path);
+        if (fs && gGlobalPrefs->rememberStatePerDocument && !fs->useDefaultState) {
+            args.pageNo = fs->pageNo;
+        }
+        args.zoom = dm->GetZoomReal(dm->CurrentPageNo());
+        args.rotation = dm->GetRotation();
+    }
+    StartDocPreload(args);
 }
 
 void DismissNextFileScrollHint(MainWindow* win) {
@@ -6842,10 +6905,12 @@ static void MaybeShowNextFileScrollHint(MainWindow* win) {
         return;
     }
     int n = 0, m = 0;
-    TempStr nextPath = PeekNextFileInFolderTemp(win, &n, &m);
+    TempStr nextPath = PeekFileInFolderTemp(win, true, &n, &m);
     if (!nextPath) {
         return;
     }
+    // the user is likely to go there next
+    PreloadNextFileInFolder(win, true);
     TempStr name = path::GetBaseNameTemp(nextPath);
     // (Kbd/(Key/...)): key-cap of the bound shortcut; filename and "browse" open
     // the navigate-files dialog (see ParseTip for (Kbd/)/(Key/) markup).
@@ -6911,6 +6976,8 @@ static void OnNextPrevFileInFolderLoaded(NextPrevFileInFolderData* d, bool ok) {
         if (d->pathToDelete) {
             DeleteFileFromDiskAndHistory(d->pathToDelete);
         }
+        AdoptPreloadedPage(win->AsFixed());
+        PreloadNextFileInFolder(win, d->forward);
         HwndRepaintNow(win->tabsCtrl->hwnd);
         return;
     }
@@ -7019,6 +7086,7 @@ static void OpenNextPrevFileInFolder(MainWindow* win, bool forward, Str pathToDe
     d->pathToDelete = str::Dup(pathToDelete);
     LoadArgs args(path, win);
     args.forceReuse = true;
+    args.engine = TakePreloadedEngine(path);
     args.onFinished = MkFunc1<NextPrevFileInFolderData, bool>(OnNextPrevFileInFolderLoaded, d);
     StartLoadDocument(&args);
 }
@@ -9099,7 +9167,7 @@ static Annotation* MakeAnnotationsFromSelection(WindowTab* tab, AnnotCreateArgs*
         CopySelectionToClipboard(win);
     }
     DeleteOldSelectionInfo(win, true);
-    MainWindowRerender(win);
+    MainWindowRerenderAnnotations(win);
     ToolbarUpdateStateForWindow(win, true);
     return annot;
 }
@@ -12329,7 +12397,7 @@ static LRESULT FrameOnCommand(MainWindow* win, HWND hwnd, UINT msg, WPARAM wp, L
         case AnnotationType::Squiggly:
         case AnnotationType::StrikeOut:
         case AnnotationType::Underline: {
-            MainWindowRerender(win);
+            MainWindowRerenderAnnotations(win);
             ToolbarUpdateStateForWindow(win, false);
             return 0;
         }
@@ -14717,6 +14785,7 @@ TempStr WindowStateDuringLoadResultTemp(int* exitCodeOut) {
 void ShutdownCleanup() {
     TtsRelease();
     FreeHomePageTips();
+    FreeScaledThumbnails();
     DestroySvgPixmapIconsCache();
     DisconnectLastDragDataObject();
 
@@ -17,6 +17,8 @@
 #include "base/UITask.h"
 #include "base/Win.h"
 #include "base/LzmaSimpleArchive.h"
+#include "base/Trace.h"
+#include "base/Timer.h"
 
 #include "SumatraConfig.h"
 
@@ -36,6 +38,7 @@
 #include "Accelerators.h"
 #include "PdfSync.h"
 #include "RenderCache.h"
+#include "DocPreload.h"
 #include "PdfDarkMode.h"
 #include "ProgressUpdateUI.h"
 #include "TextSelection.h"
@@ -75,6 +78,7 @@
 #include "SumatraControl.h"
 #include "ExplorerQuickLook.h"
 #include "SumatraLog.h"
+#include "PerfStats.h"
 
 // return false if failed in a way that should abort the app
 static NO_INLINE bool MaybeMakePluginWindow(MainWindow* win, HWND hwndParent) {
@@ -855,7 +859,9 @@ static int RunMessageLoop() {
             continue;
         }
         TranslateMessage(&msg);
+        auto timeStart = TimeGet();
         DispatchMessage(&msg);
+        PerfRecordUiMessage(TimeSinceInMs(timeStart));
         ResetTempArenaWithLogging();
     }
 
@@ -1861,6 +1867,8 @@ static void testLogf() {
 
 // in mupdf_load_system_font.c
 extern "C" void destroy_system_font_list();
+extern "C" void set_system_font_cache_path(const char* path);
+extern "C" void start_system_font_index();
 extern void DeleteManualBrowserWindow();
 
 extern "C" {
@@ -2256,6 +2264,10 @@ int APIENTRY WinMain(_In_ HINSTANCE /*hInstance*/, _In_opt_ HINSTANCE /*hPrevIns
     ParseFlags(GetPermArena(), GetCommandLineW(), flags, Str(gToolNames));
     gCli = &flags;
     gForTesting = flags.forTesting;
+    if (flags.tracePath) {
+        TraceStart();
+        SetThreadName(StrL("ui"));
+    }
     InstallSumatraCrashHandler(flags.forTesting || flags.controlPipeName);
 
     ScopedOle ole;
@@ -2557,6 +2569,14 @@ int APIENTRY WinMain(_In_ HINSTANCE /*hInstance*/, _In_opt_ HINSTANCE /*hPrevIns
     }
     FileWatcherInit();
 
+    // the names of installed fonts, for documents that don't embed theirs.
+    // Built in the background from the index saved by the previous run
+    {
+        TempStr fontIndexPath = GetPathInAppDataDirTemp(StrL("fontindex.dat"));
+        set_system_font_cache_path(CStrTemp(fontIndexPath));
+        start_system_font_index();
+    }
+
     if (flags.testRenderPage) {
         TestRenderPage(flags);
         ShutdownCommon();
@@ -2936,6 +2956,8 @@ ContinueOpenWindow:
     }
 
     StartSumatraControl(flags.controlPipeName);
+    // render, search and file watcher threads log from hot paths
+    StartAsyncLogging();
 
     // on by default in debug builds; release builds can opt in by calling
     // StartUiHangDetector() themselves
@@ -2958,6 +2980,13 @@ Exit:
     LogArenaStats(StrL("temp arena"), GetTempArena());
     LogArenaStats(StrL("perm arena"), gPermArena);
 
+    if (flags.tracePath) {
+        // spans still open on other threads are left out
+        TraceStop();
+        TraceWriteJson(flags.tracePath);
+    }
+
+    FlushLog();
     // don't shell-open the log for -for-testing automation runs: it spawns a
     // stray editor window per run (and, depending on the .txt association,
     // could even launch another non-testing SumatraPDF that saves settings)
@@ -2990,6 +3019,7 @@ Exit:
         // note: this intentionally skips freeing engines/windows, so leak
         // trackers will report everything still allocated
         log(StrL("fast exit: skipping cleanup, leak reports are expected\n"));
+        FlushLog();
         ::ExitProcess(exitCode);
     }
 
@@ -3027,6 +3057,7 @@ Exit:
     // must run before uitask::Destroy() (these deletes are queued as ui tasks)
     // and before gRenderCache goes away (the waiting threads use it)
     WaitForPendingControllerDeletes();
+    WaitForDocPreload();
 
     PlatformFontDestroy();
     uitask::Destroy();
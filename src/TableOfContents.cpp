@@ -36,6 +36,7 @@
 #include "Accelerators.h"
 #include "Theme.h"
 #include "FilterHighlightDraw.h"
+#include "TocFilter.h"
 
 static void LayoutTocContainer(MainWindow* win);
 
@@ -373,6 +374,13 @@ static void GoToTocTreeItem(MainWindow* win, TreeItem ti, bool allowExternal) {
     }
 }
 
+static void ResetTocFilterIndex(MainWindow* win) {
+    delete win->tocFilterIndex;
+    win->tocFilterIndex = nullptr;
+    win->tocFilterToc = nullptr;
+    win->tocFilterItems.Reset();
+}
+
 void ClearTocBox(MainWindow* win) {
     if (!win->tocLoaded) {
         return;
@@ -389,6 +397,7 @@ void ClearTocBox(MainWindow* win) {
     // clear filter state
     delete win->tocFilteredTree;
     win->tocFilteredTree = nullptr;
+    ResetTocFilterIndex(win);
     if (win->tocFilterEdit) {
         win->tocFilterEdit->SetText(StrL(""));
     }
@@ -630,7 +639,14 @@ static void UpdateDocTocExpansionStateRecur(TreeView* treeView, Vec<int>& tocSta
             // isOpenToggled is not kept in sync
             // TODO: keep toggle state on TocItem in sync
             // by subscribing to the right notifications
-            bool isExpanded = treeView->IsExpanded((TreeItem)tocItem);
+            // Items under a never expanded parent aren't inserted yet and
+            // TreeView::IsExpanded() would insert them, so they keep the
+            // state the tree was loaded with
+            bool isExpanded = tocItem->IsExpanded();
+            HTREEITEM hi = (HTREEITEM)treeView->treeModel->GetUserData((TreeItem)tocItem);
+            if (hi) {
+                isExpanded = (TreeView_GetItemState(treeView->hwnd, hi, TVIS_EXPANDED) & TVIS_EXPANDED) != 0;
+            }
             bool wasToggled = isExpanded != tocItem->isOpenDefault;
             if (wasToggled) {
                 tocState.Append(tocItem->id);
@@ -825,7 +841,9 @@ static void TocCollapseAll(TreeView* tv) {
     TocExpandToLevel(tv, 1);
     HWND hwnd = tv->hwnd;
     HTREEITEM root = TreeView_GetRoot(hwnd);
-    if (root && !TreeView_GetNextSibling(hwnd, root) && TreeView_GetChild(hwnd, root)) {
+    // children of collapsed rows are only inserted when expanded, so this
+    // can't check TreeView_GetChild() (expanding a row without any is a no-op)
+    if (root && !TreeView_GetNextSibling(hwnd, root)) {
         TreeView_Expand(hwnd, root, TVE_EXPAND);
     }
 }
@@ -1101,6 +1119,7 @@ void LoadTocTree(MainWindow* win) {
     // null out currToc first so that SetText("") callback doesn't use stale pointer
     delete win->tocFilteredTree;
     win->tocFilteredTree = nullptr;
+    ResetTocFilterIndex(win);
     tab->currToc = nullptr;
     if (win->tocFilterEdit) {
         win->tocFilterEdit->SetText(StrL(""));
@@ -1628,60 +1647,81 @@ void UnsubclassToc(MainWindow* win) {
     }
 }
 
-// Append a TocItem linked list onto resultFirst/resultLast (updates last).
-static void AppendTocSiblingList(TocItem*& resultFirst, TocItem*& resultLast, TocItem* list) {
-    if (!list) {
-        return;
-    }
-    if (!resultFirst) {
-        resultFirst = list;
-    } else {
-        resultLast->next = list;
+// above that many matches the filtered tree starts collapsed, so that only
+// the top level rows have to be inserted into the tree view
+constexpr int kMaxTocMatchesExpanded = 5000;
+
+static void BuildTocFilterIndex(MainWindow* win, TocTree* toc) {
+    ResetTocFilterIndex(win);
+    auto* index = new TocFilterIndex();
+    // pre-order walk: index order is document order
+    struct Pending {
+        TocItem* item;
+        int parentIdx;
+    };
+    Vec<Pending> toVisit;
+    if (toc->root) {
+        toVisit.Append({toc->root->child, -1});
     }
-    resultLast = list;
-    while (resultLast->next) {
-        resultLast = resultLast->next;
+    while (len(toVisit) > 0) {
+        Pending p = toVisit.Pop();
+        if (!p.item) {
+            continue;
+        }
+        int idx = index->Add(p.item->title, p.parentIdx);
+        win->tocFilterItems.Append(p.item);
+        // the next sibling is visited after the subtree of this item
+        toVisit.Append({p.item->next, p.parentIdx});
+        toVisit.Append({p.item->child, idx});
     }
+    win->tocFilterIndex = index;
+    win->tocFilterToc = toc;
 }
 
-// Recursively build a filtered copy of the TocItem tree.
-// Multi-word filter (command palette style): every word must appear in the
-// item's own title to keep that node. Non-matching ancestors are omitted and
+// Builds a filtered copy of the tree from the items matching every word of
+// the filter (command palette style). Non-matching ancestors are omitted and
 // matching descendants are promoted so only fully-matching rows are shown.
 // Returns nullptr if nothing matches.
-static TocItem* FilterTocItemRec(TocItem* item, const StrVec& words) {
-    if (!item) {
+static TocItem* BuildFilteredTocItems(MainWindow* win) {
+    TocFilterIndex* index = win->tocFilterIndex;
+    int n = len(index->matches);
+    if (n == 0) {
         return nullptr;
     }
-    TocItem* resultFirst = nullptr;
-    TocItem* resultLast = nullptr;
-    for (TocItem* si = item; si; si = si->next) {
-        TocItem* filteredChildren = FilterTocItemRec(si->child, words);
-        bool titleMatches = si->title && FilterMatches(si->title, words);
-        if (titleMatches) {
-            // keep this node; only fully-matching children stay nested under it
-            auto* copy = AllocTocItem(nullptr, si->title, si->pageNo);
-            copy->id = si->id;
-            copy->fontFlags = si->fontFlags;
-            copy->color = si->color;
-            copy->dest = si->dest;
-            copy->destNotOwned = true;
-            copy->isOpenDefault = true;
-            copy->isOpenToggled = false;
-            copy->child = filteredChildren;
-            for (TocItem* c = copy->child; c; c = c->next) {
-                c->parent = copy;
-            }
-            AppendTocSiblingList(resultFirst, resultLast, copy);
-        } else if (filteredChildren) {
-            // title does not match every word: drop this node, promote children
-            for (TocItem* c = filteredChildren; c; c = c->next) {
-                c->parent = nullptr;
-            }
-            AppendTocSiblingList(resultFirst, resultLast, filteredChildren);
+    bool isOpen = n <= kMaxTocMatchesExpanded;
+    // TreeView populates Root()'s children only (the root itself is invisible).
+    // Promoted matches become siblings, so wrap them in a dummy root, same
+    // shape every engine uses for the unfiltered TocTree.
+    auto* wrapRoot = AllocTocItem(nullptr, {}, 0);
+    Vec<TocItem*> copies;
+    // for each copy, its last child so far (to keep the document order)
+    Vec<TocItem*> lastChild;
+    TocItem* lastTopLevel = nullptr;
+    for (int i = 0; i < n; i++) {
+        TocItem* si = win->tocFilterItems[index->matches[i]];
+        auto* copy = AllocTocItem(nullptr, si->title, si->pageNo);
+        copy->id = si->id;
+        copy->fontFlags = si->fontFlags;
+        copy->color = si->color;
+        copy->dest = si->dest;
+        copy->destNotOwned = true;
+        copy->isOpenDefault = isOpen;
+        copy->isOpenToggled = false;
+        copies.Append(copy);
+        lastChild.Append(nullptr);
+
+        int parentIdx = index->matchParents[i];
+        TocItem** prevSibling = parentIdx < 0 ? &lastTopLevel : &lastChild[parentIdx];
+        TocItem* parent = parentIdx < 0 ? wrapRoot : copies[parentIdx];
+        copy->parent = parent;
+        if (*prevSibling) {
+            (*prevSibling)->next = copy;
+        } else {
+            parent->child = copy;
         }
+        *prevSibling = copy;
     }
-    return resultFirst;
+    return wrapRoot;
 }
 
 static void ApplyTocFilter(MainWindow* win, Str filter) {
@@ -1699,30 +1739,21 @@ static void ApplyTocFilter(MainWindow* win, Str filter) {
     TreeView* treeView = win->tocTreeView;
     TocTree* origTree = tab->currToc;
 
-    StrVec words;
-    if (filter) {
-        SplitFilterToWords(filter, words);
+    if (!win->tocFilterIndex || win->tocFilterToc != origTree) {
+        BuildTocFilterIndex(win, origTree);
     }
-    if (len(words) == 0) {
+    if (!win->tocFilterIndex->SetQuery(filter)) {
         // restore original tree
         SetInitialExpandState(origTree->root, tab->tocState);
         treeView->SetTreeModel(origTree);
         return;
     }
 
-    TocItem* filteredItems = FilterTocItemRec(origTree->root, words);
-    if (!filteredItems) {
+    TocItem* wrapRoot = BuildFilteredTocItems(win);
+    if (!wrapRoot) {
         treeView->Clear();
         return;
     }
-    // TreeView populates Root()'s children only (the root itself is invisible).
-    // Promote-filter returns a sibling list of matching items, so wrap them in
-    // a dummy root — same shape every engine uses for the unfiltered TocTree.
-    auto* wrapRoot = AllocTocItem(nullptr, {}, 0);
-    wrapRoot->child = filteredItems;
-    for (TocItem* c = filteredItems; c; c = c->next) {
-        c->parent = wrapRoot;
-    }
     auto* filteredTree = new TocTree(wrapRoot);
     win->tocFilteredTree = filteredTree;
     treeView->SetTreeModel(filteredTree);
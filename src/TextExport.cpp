@@ -0,0 +1,206 @@
+/* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "base/File.h"
+#include "base/Timer.h"
+#include "base/Win.h"
+
+#include "DocProperties.h"
+#include "gui/UIModels.h"
+#include "EngineBase.h"
+#include "TextExport.h"
+
+// workers don't start a page more than this far ahead of the writer, which
+// bounds how much extracted text waits in memory for a slow earlier page
+constexpr int kTextExportWindow = 64;
+constexpr int kMaxTextExportThreads = 8;
+// buffered text is written out in chunks of about this size
+constexpr int kTextExportFlushSize = 1024 * 1024;
+
+struct TextExportJob {
+    TextExportArgs* args = nullptr;
+    Mutex mutex;
+    ConditionVariable cond;
+    // indexes into args->pages
+    int nextToExtract = 0;
+    int nextToWrite = 0;
+    int workersRunning = 0;
+    bool stopping = false;
+    Str slots[kTextExportWindow];
+    bool slotReady[kTextExportWindow] = {};
+};
+
+struct TextExportWorker {
+    TextExportJob* job = nullptr;
+    EngineBase* engine = nullptr;
+};
+
+static void TextExportThread(TextExportWorker* w) {
+    TextExportJob* job = w->job;
+    int nPages = len(job->args->pages);
+    while (true) {
+        job->mutex.Lock();
+        while (!job->stopping && job->nextToExtract < nPages &&
+               job->nextToExtract >= job->nextToWrite + kTextExportWindow) {
+            job->cond.Wait(&job->mutex);
+        }
+        bool done = job->stopping || job->nextToExtract >= nPages;
+        int idx = done ? -1 : job->nextToExtract++;
+        job->mutex.Unlock();
+        if (done) {
+            break;
+        }
+
+        PageText pt = w->engine->ExtractPageText(job->args->pages[idx]);
+        Str text = pt.text;
+        pt.text = {};
+        FreePageText(&pt);
+
+        ScopedMutex lock(&job->mutex);
+        int slot = idx % kTextExportWindow;
+        job->slots[slot] = text;
+        job->slotReady[slot] = true;
+        job->cond.WakeAll();
+    }
+    w->engine->ReleaseTextExtractionThreadContext();
+
+    ScopedMutex lock(&job->mutex);
+    job->workersRunning--;
+    job->cond.WakeAll();
+}
+
+static bool IsCancelled(TextExportArgs* args) {
+    return args->cancel && AtomicBoolGet(args->cancel);
+}
+
+// takes the text of page idx once a worker has extracted it. Returns false if
+// all workers are gone before that
+static bool TakePageText(TextExportJob* job, int idx, Str* textOut) {
+    ScopedMutex lock(&job->mutex);
+    int slot = idx % kTextExportWindow;
+    while (!job->slotReady[slot] && job->workersRunning > 0) {
+        job->cond.Wait(&job->mutex);
+    }
+    if (!job->slotReady[slot]) {
+        return false;
+    }
+    *textOut = job->slots[slot];
+    job->slots[slot] = {};
+    job->slotReady[slot] = false;
+    job->nextToWrite = idx + 1;
+    job->cond.WakeAll();
+    return true;
+}
+
+static bool WriteExportedText(TextExportJob* job, file::FileHandle h) {
+    TextExportArgs* args = job->args;
+    int nPages = len(args->pages);
+    TextExportProgress progress;
+    progress.pagesTotal = nPages;
+    str::Builder buf;
+    for (int idx = 0; idx < nPages; idx++) {
+        if (IsCancelled(args)) {
+            logf("ExportDocumentText: cancelled after %d of %d pages\n", idx, nPages);
+            return false;
+        }
+        Str text;
+        if (!TakePageText(job, idx, &text)) {
+            return false;
+        }
+        if (text) {
+            buf.Append(text);
+            buf.AppendChar('\n');
+            str::Free(text);
+        }
+        if (buf.len >= kTextExportFlushSize) {
+            if (!file::WriteAll(h, ToStr(buf))) {
+                logf("ExportDocumentText: write failed: %s\n", file::LastErrorTemp());
+                return false;
+            }
+            buf.Reset();
+        }
+        progress.pagesDone = idx + 1;
+        args->cbProgress.Call(&progress);
+    }
+    return file::WriteAll(h, ToStr(buf));
+}
+
+bool ExportDocumentText(TextExportArgs* args) {
+    EngineBase* engine = args->engine;
+    if (!engine || !args->destPath) {
+        return false;
+    }
+    int nPages = len(args->pages);
+    file::FileHandle h = file::OpenWrite(args->destPath);
+    if (h == file::kInvalidFileHandle) {
+        logf("ExportDocumentText: failed to create '%s'\n", args->destPath);
+        return false;
+    }
+
+    int nThreads = args->nThreads > 0 ? args->nThreads : CpuCoreCount();
+    nThreads = std::min(nThreads, kMaxTextExportThreads);
+    nThreads = std::max(std::min(nThreads, nPages), 1);
+
+    // each worker gets its own engine so that extraction doesn't serialize on
+    // the document's locks; if cloning isn't possible, share the original
+    auto job = new TextExportJob();
+    job->args = args;
+    TextExportWorker workers[kMaxTextExportThreads];
+    int nWorkers = 0;
+    for (int i = 0; i < nThreads; i++) {
+        EngineBase* clone = engine->Clone();
+        if (!clone) {
+            break;
+        }
+        workers[nWorkers].job = job;
+        workers[nWorkers].engine = clone;
+        nWorkers++;
+    }
+    if (nWorkers == 0) {
+        engine->AddRef();
+        workers[0].job = job;
+        workers[0].engine = engine;
+        nWorkers = 1;
+    }
+
+    auto timeStart = TimeGet();
+    for (int i = 0; i < nWorkers; i++) {
+        job->mutex.Lock();
+        job->workersRunning++;
+        job->mutex.Unlock();
+        auto fn = MkFunc0(TextExportThread, &workers[i]);
+        ThreadHandle th = StartThread(fn, StrL("TextExportThread"));
+        if (!th) {
+            ScopedMutex lock(&job->mutex);
+            job->workersRunning--;
+            continue;
+        }
+        SafeCloseThreadHandle(&th);
+    }
+
+    bool ok = WriteExportedText(job, h);
+
+    job->mutex.Lock();
+    job->stopping = true;
+    job->cond.WakeAll();
+    while (job->workersRunning > 0) {
+        job->cond.Wait(&job->mutex);
+    }
+    job->mutex.Unlock();
+
+    for (Str& s : job->slots) {
+        str::Free(s);
+    }
+    for (int i = 0; i < nWorkers; i++) {
+        workers[i].engine->Release();
+    }
+    delete job;
+    file::Close(h);
+    if (!ok) {
+        file::Delete(args->destPath);
+    }
+    logf("ExportDocumentText: %d pages on %d threads in %.2f ms, ok: %d\n", nPages, nWorkers, TimeSinceInMs(timeStart),
+         (int)ok);
+    return ok;
+}
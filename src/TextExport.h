@@ -0,0 +1,28 @@
+/* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// Writes the text of a document's pages to a file. Pages are extracted in
+// parallel on cloned engines and written in page order as they complete, so
+// memory use is bounded by a small reorder window, not by the document size.
+
+struct TextExportProgress {
+    int pagesDone = 0;
+    int pagesTotal = 0;
+};
+
+using TextExportProgressCb = Func1<TextExportProgress*>;
+
+struct TextExportArgs {
+    EngineBase* engine = nullptr;
+    Str destPath;
+    // pages to export, in output order
+    Vec<int> pages;
+    // 0 means one thread per core
+    int nThreads = 0;
+    // when set (from any thread) the export stops at the next page and fails
+    AtomicBool* cancel = nullptr;
+    // called on the exporting thread after each page is written
+    TextExportProgressCb cbProgress;
+};
+
+bool ExportDocumentText(TextExportArgs* args);
@@ -2,6 +2,8 @@
    License: GPLv3 */
 
 #include "base/Base.h"
+#include "base/Trace.h"
+#include "base/Timer.h"
 
 #include "DocController.h"
 #include "gui/UIModels.h"
@@ -9,6 +11,8 @@
 #include "ProgressUpdateUI.h"
 #include "TextSelection.h"
 #include "TextSearch.h"
+#include "TextSearchPattern.h"
+#include "PerfStats.h"
 
 // Fetch page text for search. When *abortSearch is set, the caller should stop
 // immediately (search was cancelled while engine locks were contended).
@@ -27,6 +31,7 @@ static Str GetTextForPageForSearch(EngineBase* engine, int pageNo, int* lenOut,
             }
             return {};
         }
+        TraceSpan span("search: get page text", pageNo);
         return engine->GetTextForPage(pageNo, lenOut);
     }
     return engine->GetTextForPage(pageNo, lenOut);
@@ -68,6 +73,10 @@ void TextSearch::Clear() {
     str::FreePtr(&lastText);
     findTextLen = 0;
     anchorLen = 0;
+    anchorUnits.Reset();
+    delete pattern;
+    pattern = nullptr;
+    patternMatchesValid = false;
     Reset();
 }
 
@@ -108,6 +117,15 @@ void TextSearch::SetText(Str text) {
 
     this->Clear();
     this->lastText = str::Dup(searchText);
+    // //text/ is a plain search for /text/ (a trailing space still marks a word end)
+    Str noEndSpace = searchText;
+    if (str::EndsWith(noEndSpace, StrL(" "))) {
+        noEndSpace.len--;
+    }
+    this->plainText = SearchLiteralFromText(noEndSpace).s != noEndSpace.s;
+    if (this->plainText) {
+        searchText = Str(searchText.s + 1, searchText.len - 1);
+    }
     this->findText = str::Dup(searchText);
     this->findTextLen = Utf8CodepointCount(this->findText);
 
@@ -148,6 +166,7 @@ void TextSearch::SetText(Str text) {
         this->findText.len--;
         this->findTextLen--;
     }
+    UpdatePattern();
 
     markAllPagesNonSkip(pagesToSkip);
 }
@@ -157,6 +176,11 @@ void TextSearch::SetMatchCase(bool newMatchCase) {
         return;
     }
     this->matchCase = newMatchCase;
+    anchorUnits.Reset();
+    if (pattern) {
+        // the pattern is compiled for folded or unfolded units
+        UpdatePattern();
+    }
 
     markAllPagesNonSkip(pagesToSkip);
 }
@@ -251,7 +275,10 @@ void TextSearch::SetDirection(TextSearch::Direction direction) {
         return;
     }
     forward = fwd;
-    if (findText) {
+    if (pattern && result.len > 0) {
+        // pattern matches vary in length: continue from the current match
+        findIndex = fwd ? endGlyph : startGlyph;
+    } else if (findText) {
         int n = findTextLen;
         if (fwd) {
             findIndex += n;
@@ -276,49 +303,6 @@ void TextSearch::SetLastResult(TextSelection* sel) {
     forward = true;
 }
 
-#if !OS_WIN
-static int FoldCaseWCharPortable(int c) {
-    if (c >= L'A' && c <= L'Z') {
-        return c + 32;
-    }
-    if (c >= 0x00C0 && c <= 0x00DE && c != 0x00D7) {
-        return c + 32;
-    }
-    if (c >= 0x0410 && c <= 0x042F) {
-        return c + 32;
-    }
-    if (c == 0x0401) {
-        return 0x0451;
-    }
-    if ((c >= 0x0391 && c <= 0x03A1) || (c >= 0x03A3 && c <= 0x03AB)) {
-        return c + 32;
-    }
-    return (int)towlower((wint_t)c);
-}
-#endif
-
-// Locale-independent Unicode case folding for search. CharLowerW folds accented
-// letters (e.g. É->é, Ş->ş) regardless of the CRT locale, unlike towlower() or
-// the ASCII-only fast paths we used before.
-static int FoldCaseForSearch(int c) {
-    // U+0130 (İ, Latin capital I with dot above) lowercases to 'i' under
-    // standard Unicode case folding, but CharLowerW only does this under a
-    // Turkish system locale and otherwise leaves it unchanged -- so searching
-    // "ibradı" wouldn't find "İbradı" on non-Turkish systems (issue #5597).
-    // Fold it explicitly so search is case-insensitive regardless of locale.
-    if (c == 0x0130) {
-        return L'i';
-    }
-    if (c > 0 && c <= 0xffff) {
-#if OS_WIN
-        return (WCHAR)(uintptr_t)CharLowerW((LPWSTR)(uintptr_t)c);
-#else
-        return FoldCaseWCharPortable(c);
-#endif
-    }
-    return c;
-}
-
 // German ß (sharp s, U+00DF) is spelled "ss" and the two are often used
 // interchangeably, so for case-insensitive search we treat ß as equivalent to
 // "ss" (issue #933). Fold first so capital ẞ (U+1E9E) and case differences work.
@@ -329,152 +313,6 @@ static bool IsLatinS(int c) {
     return c != 0 && FoldCaseForSearch(c) == L's';
 }
 
-// Compare needle `n` against haystack `h` for a single search "unit", case-
-// folded, treating ß as equivalent to "ss". On a match returns true and reports
-// how many codepoints were consumed from each side (1:1 normally, but 1:2 / 2:1 for
-// the ß <-> ss equivalence). Safe to call at a string end (reads at most h[1]
-// / n[1], which is the NUL terminator at worst).
-static bool MatchSearchUnit(Str h, int hLen, int hIdx, int hByteIdx, Str n, int nLen, int nIdx, int nByteIdx, int& hAdv,
-                            int& nAdv, int& hByteAdv, int& nByteAdv) {
-    hAdv = nAdv = hByteAdv = nByteAdv = 0;
-    if (hIdx >= hLen || nIdx >= nLen) {
-        return false;
-    }
-    int hNextByte = hByteIdx;
-    int hc = Utf8CodepointNext(h, hNextByte);
-    int nNextByte = nByteIdx;
-    int nc = Utf8CodepointNext(n, nNextByte);
-    // ß in the needle matches "ss" in the text
-    if (IsSharpS(nc) && hIdx + 1 < hLen && IsLatinS(hc)) {
-        int hAfterNextByte = hNextByte;
-        int hNextChar = Utf8CodepointNext(h, hAfterNextByte);
-        if (IsLatinS(hNextChar)) {
-            hAdv = 2;
-            nAdv = 1;
-            hByteAdv = hAfterNextByte - hByteIdx;
-            nByteAdv = nNextByte - nByteIdx;
-            return true;
-        }
-    }
-    // "ss" in the needle matches ß in the text
-    if (nIdx + 1 < nLen && IsLatinS(nc) && IsSharpS(hc)) {
-        int nAfterNextByte = nNextByte;
-        int nNextChar = Utf8CodepointNext(n, nAfterNextByte);
-        if (IsLatinS(nNextChar)) {
-            hAdv = 1;
-            nAdv = 2;
-            hByteAdv = hNextByte - hByteIdx;
-            nByteAdv = nAfterNextByte - nByteIdx;
-            return true;
-        }
-    }
-    // everything else (including ß~ß and ss~ss) matches one-to-one
-    if (FoldCaseForSearch(hc) == FoldCaseForSearch(nc)) {
-        hAdv = 1;
-        nAdv = 1;
-        hByteAdv = hNextByte - hByteIdx;
-        nByteAdv = nNextByte - nByteIdx;
-        return true;
-    }
-    return false;
-}
-
-static int StrStrFoldCase(Str haystack, int haystackLen, int startOff, Str needle, int needleLen) {
-    if (!haystack || !needle) {
-        return startOff;
-    }
-    int byteIdx = Utf8CodepointToByteIndex(haystack, startOff);
-    for (int i = startOff; i < haystackLen; i++) {
-        int hIdx = i;
-        int hByteIdx = byteIdx;
-        int nIdx = 0;
-        int nByteIdx = 0;
-        bool isMatch = true;
-        while (nIdx < needleLen) {
-            if (hIdx >= haystackLen) {
-                isMatch = false;
-                break;
-            }
-            int hAdv, nAdv, hByteAdv, nByteAdv;
-            if (!MatchSearchUnit(haystack, haystackLen, hIdx, hByteIdx, needle, needleLen, nIdx, nByteIdx, hAdv, nAdv,
-                                 hByteAdv, nByteAdv)) {
-                isMatch = false;
-                break;
-            }
-            hIdx += hAdv;
-            nIdx += nAdv;
-            hByteIdx += hByteAdv;
-            nByteIdx += nByteAdv;
-        }
-        if (isMatch) {
-            return i;
-        }
-        Utf8CodepointNext(haystack, byteIdx);
-    }
-    return -1;
-}
-
-static bool StartsWithAtByte(Str text, int byteIdx, Str prefix) {
-    return text && prefix && byteIdx >= 0 && byteIdx + prefix.len <= text.len &&
-           memcmp(text.s + byteIdx, prefix.s, prefix.len) == 0;
-}
-
-static int StrRStr(Str text, int textLen, int endOff, Str needle, int needleLen) {
-    if (!text || !needle || endOff <= 0 || endOff > textLen) {
-        return -1;
-    }
-    if (needleLen <= 0 || needleLen > endOff) {
-        return -1;
-    }
-    int result = -1;
-    int byteIdx = 0;
-    for (int i = 0; i <= endOff - needleLen; i++) {
-        if (StartsWithAtByte(text, byteIdx, needle)) {
-            result = i;
-        }
-        Utf8CodepointNext(text, byteIdx);
-    }
-    return result;
-}
-
-static int StrRStrFoldCase(Str text, int textLen, int endOff, Str needle, int needleLen) {
-    if (!text || !needle || endOff <= 0 || endOff > textLen) {
-        return -1;
-    }
-    // ß <-> ss makes the matched length variable, so scan forward within
-    // [start, end) and remember the last start position that matches.
-    int result = -1;
-    int byteIdx = 0;
-    for (int i = 0; i < endOff; i++) {
-        int hIdx = i;
-        int hByteIdx = byteIdx;
-        int nIdx = 0;
-        int nByteIdx = 0;
-        bool isMatch = true;
-        while (nIdx < needleLen) {
-            if (hIdx >= endOff) {
-                isMatch = false;
-                break;
-            }
-            int hAdv, nAdv, hByteAdv, nByteAdv;
-            if (!MatchSearchUnit(text, textLen, hIdx, hByteIdx, needle, needleLen, nIdx, nByteIdx, hAdv, nAdv, hByteAdv,
-                                 nByteAdv)) {
-                isMatch = false;
-                break;
-            }
-            hIdx += hAdv;
-            nIdx += nAdv;
-            hByteIdx += hByteAdv;
-            nByteIdx += nByteAdv;
-        }
-        if (isMatch) {
-            result = i;
-        }
-        Utf8CodepointNext(text, byteIdx);
-    }
-    return result;
-}
-
 // try to match "findText" from "start" with whitespace tolerance
 // (ignore all whitespace except after alphanumeric characters)
 TextSearch::PageAndOffset TextSearch::MatchEnd(int startOff) const {
@@ -629,20 +467,121 @@ TextSearch::PageAndOffset TextSearch::MatchEnd(int startOff) const {
     return {currentPage, endIdx};
 }
 
-static int StrStr(Str haystack, int haystackLen, int startOff, Str needle, int needleLen) {
-    if (!haystack || len(needle) == 0) {
+// builds searchText for pageText if it's for another page. Returns true if
+// it did
+bool TextSearch::UpdateSearchText() {
+    bool fold = !matchCase;
+    SearchPageText& st = searchText;
+    if (st.pageNo == findPage && st.text == pageText.s && st.textLen == pageTextLen && st.folded == fold) {
+        return false;
+    }
+    BuildSearchUnits(pageText, pageTextLen, fold, st.units);
+    st.pageNo = findPage;
+    st.text = pageText.s;
+    st.textLen = pageTextLen;
+    st.folded = fold;
+    return true;
+}
+
+// Where the anchor (the start of the search text) matches next in pageText: the
+// first match at or after startOff going forward, the last one before startOff
+// going backward. -1 if there's none
+int TextSearch::FindAnchor(int startOff) {
+    bool fold = !matchCase;
+    UpdateSearchText();
+    const SearchPageText& st = searchText;
+    if (len(anchorUnits) != anchorLen) {
+        BuildSearchUnits(anchor, anchorLen, fold, anchorUnits);
+    }
+    if (!pageText) {
         return -1;
     }
-    int byteIdx = Utf8CodepointToByteIndex(haystack, startOff);
-    for (int i = startOff; i <= haystackLen - needleLen; i++) {
-        if (StartsWithAtByte(haystack, byteIdx, needle)) {
-            return i;
+    return FindSearchUnits(st.units.els, len(st.units), anchorUnits.els, len(anchorUnits), startOff, forward, fold);
+}
+
+// compiles the pattern of a /pattern/ search text, if it is one. A pattern
+// that doesn't compile matches nothing
+void TextSearch::UpdatePattern() {
+    delete pattern;
+    pattern = nullptr;
+    patternMatchesValid = false;
+    if (plainText) {
+        return;
+    }
+    Str patternText = SearchPatternFromText(findText);
+    if (!patternText) {
+        return;
+    }
+    pattern = new SearchPattern();
+    if (!pattern->Compile(patternText, !matchCase)) {
+        logf("TextSearch: can't search for '%s': %s\n", patternText, pattern->error);
+    }
+}
+
+// like FindAnchor() but for a whole match of the pattern, whose end is set in
+// endOut. All matches in a page are found in one go, when first needed
+int TextSearch::FindPatternMatch(int startOff, int* endOut) {
+    if (UpdateSearchText() || !patternMatchesValid) {
+        patternMatches.Reset();
+        pattern->FindAll(searchText.units.els, len(searchText.units), patternMatches);
+        patternMatchesValid = true;
+    }
+    const u32* units = searchText.units.els;
+    int nUnits = len(searchText.units);
+    int nMatches = len(patternMatches) / 2;
+    // the first match starting at or after startOff
+    int lo = 0;
+    int hi = nMatches;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (patternMatches[mid * 2] < startOff) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    int step = forward ? 1 : -1;
+    for (int i = forward ? lo : lo - 1; i >= 0 && i < nMatches; i += step) {
+        int start = patternMatches[i * 2];
+        int end = patternMatches[i * 2 + 1];
+        if (matchWordStart && start > 0 && isWordChar((int)units[start - 1]) && isWordChar((int)units[start])) {
+            continue;
+        }
+        if (matchWordEnd && end < nUnits && isWordChar((int)units[end - 1]) && isWordChar((int)units[end])) {
+            continue;
         }
-        Utf8CodepointNext(haystack, byteIdx);
+        *endOut = end;
+        return start;
     }
     return -1;
 }
 
+// FindTextInPage() for a pattern. Pattern matches don't continue on the next page
+bool TextSearch::FindPatternInPage(int pageNo, PageAndOffset* finalGlyph) {
+    for (;;) {
+        if (WasCanceled(progressCb)) {
+            return false;
+        }
+        int end = 0;
+        int found = FindPatternMatch(findIndex, &end);
+        if (found < 0) {
+            return false;
+        }
+        searchHitStartAt = pageNo;
+        StartAt(pageNo, found);
+        SelectUpTo(pageNo, end);
+        findIndex = forward ? end : found;
+
+        // try again if the found text is completely outside the page's mediabox
+        if (result.len != 0) {
+            if (finalGlyph) {
+                *finalGlyph = {pageNo, end};
+            }
+            return true;
+        }
+    }
+}
+
 static int GetNextIndex(int textLen, int offset, bool forward) {
     int idx = offset + (forward ? 0 : -1);
     if (idx < 0 || idx >= textLen) {
@@ -658,10 +597,14 @@ bool TextSearch::FindTextInPage(int pageNo, TextSearch::PageAndOffset* finalGlyp
     if (!pageNo) {
         pageNo = findPage;
     }
+    TraceSpan span("search: match page", pageNo);
     // According to my analysis of 69912675c766b6325f38036913dcf0505a00be36, when we
     // get here with pageNo != 0 the findText has already been set so I didn't add
     // a findText = engine->GetTextForPage(findPage) here.
     findPage = pageNo;
+    if (pattern) {
+        return FindPatternInPage(pageNo, finalGlyph);
+    }
 
     int found = -1;
     PageAndOffset fg;
@@ -672,18 +615,8 @@ bool TextSearch::FindTextInPage(int pageNo, TextSearch::PageAndOffset* finalGlyp
             }
             if (!anchor) {
                 found = GetNextIndex(pageTextLen, findIndex, forward);
-            } else if (forward) {
-                if (matchCase) {
-                    found = StrStr(pageText, pageTextLen, findIndex, anchor, anchorLen);
-                } else {
-                    found = StrStrFoldCase(pageText, pageTextLen, findIndex, anchor, anchorLen);
-                }
             } else {
-                if (matchCase) {
-                    found = StrRStr(pageText, pageTextLen, findIndex, anchor, anchorLen);
-                } else {
-                    found = StrRStrFoldCase(pageText, pageTextLen, findIndex, anchor, anchorLen);
-                }
+                found = FindAnchor(findIndex);
             }
             if (found < 0) {
                 return false;
@@ -748,7 +681,10 @@ bool TextSearch::FindStartingAtPage(int pageNo) {
             findIndex = 0;
         }
         PageAndOffset r;
-        if (!FindTextInPage(pageNo, &r)) {
+        auto timeStart = TimeGet();
+        bool found = FindTextInPage(pageNo, &r);
+        PerfRecordFindPage(pageTextLen, TimeSinceInMs(timeStart));
+        if (!found) {
             pagesToSkip[pageNo - 1] = true;
             pageNo += next;
             continue;
@@ -773,6 +709,7 @@ bool TextSearch::FindStartingAtPage(int pageNo) {
 }
 
 TextSel* TextSearch::FindFirst(int page, Str text) {
+    TraceSpan span("search: find first", page);
     SetText(text);
 
     if (FindStartingAtPage(page)) {
@@ -820,6 +757,7 @@ TextSel* TextSearch::FindFirstOnPage(int pageNo, Str text) {
 }
 
 TextSel* TextSearch::FindNext() {
+    TraceSpan span("search: find next");
     ReportIf(!findText);
     if (!findText) {
         return nullptr;
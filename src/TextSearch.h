@@ -1,6 +1,19 @@
 /* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
    License: GPLv3 */
 
+class SearchPattern;
+
+// The text of the page being searched as one unit per glyph (unit i is glyph i
+// of the page), case folded for a case insensitive search. It's built once per
+// page, so that finding the next match doesn't decode and fold the text again
+struct SearchPageText {
+    int pageNo = 0;
+    const char* text = nullptr;
+    int textLen = 0;
+    bool folded = false;
+    Vec<u32> units;
+};
+
 struct TextSearch : public TextSelection {
     enum class Direction : bool {
         Backward = false,
@@ -56,6 +69,11 @@ struct TextSearch : public TextSelection {
     bool FindTextInPage(int pageNo, PageAndOffset* finalGlyph);
     bool FindStartingAtPage(int pageNo);
     PageAndOffset MatchEnd(int startOff) const;
+    bool UpdateSearchText();
+    int FindAnchor(int startOff);
+    void UpdatePattern();
+    int FindPatternMatch(int startOff, int* endOut);
+    bool FindPatternInPage(int pageNo, PageAndOffset* finalGlyph);
 
     void Clear();
     void Reset();
@@ -64,6 +82,18 @@ struct TextSearch : public TextSelection {
     int pageTextLen = 0;
     int findIndex = 0;
 
+    SearchPageText searchText;
+    // anchor in the same form as searchText.units, built on first use
+    Vec<u32> anchorUnits;
+
+    // set when the search text is a /pattern/ (see SearchPatternFromText())
+    SearchPattern* pattern = nullptr;
+    // set when the search text is an escaped //text/, searched for as /text/
+    bool plainText = false;
+    // start and end of the pattern's matches in searchText
+    Vec<int> patternMatches;
+    bool patternMatchesValid = false;
+
     Str lastText;
     int nPages = 0;
     Vec<bool> pagesToSkip;
@@ -0,0 +1,1221 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+
+#if IS_INTEL_64 || IS_INTEL_32
+#include <emmintrin.h>
+#define SEARCH_SIMD 1
+#else
+#define SEARCH_SIMD 0
+#endif
+
+#include "TextSearchPattern.h"
+
+#if !OS_WIN
+static int FoldCaseWCharPortable(int c) {
+    if (c >= L'A' && c <= L'Z') {
+        return c + 32;
+    }
+    if (c >= 0x00C0 && c <= 0x00DE && c != 0x00D7) {
+        return c + 32;
+    }
+    if (c >= 0x0410 && c <= 0x042F) {
+        return c + 32;
+    }
+    if (c == 0x0401) {
+        return 0x0451;
+    }
+    if ((c >= 0x0391 && c <= 0x03A1) || (c >= 0x03A3 && c <= 0x03AB)) {
+        return c + 32;
+    }
+    return (int)towlower((wint_t)c);
+}
+#endif
+
+// Locale-independent Unicode case folding for search. CharLowerW folds accented
+// letters (e.g. É->é, Ş->ş) regardless of the CRT locale, unlike towlower() or
+// the ASCII-only fast paths we used before.
+int FoldCaseForSearch(int c) {
+    // U+0130 (İ, Latin capital I with dot above) lowercases to 'i' under
+    // standard Unicode case folding, but CharLowerW only does this under a
+    // Turkish system locale and otherwise leaves it unchanged -- so searching
+    // "ibradı" wouldn't find "İbradı" on non-Turkish systems (issue #5597).
+    // Fold it explicitly so search is case-insensitive regardless of locale.
+    if (c == 0x0130) {
+        return L'i';
+    }
+    if (c > 0 && c <= 0xffff) {
+#if OS_WIN
+        return (WCHAR)(uintptr_t)CharLowerW((LPWSTR)(uintptr_t)c);
+#else
+        return FoldCaseWCharPortable(c);
+#endif
+    }
+    return c;
+}
+
+u32 FoldUnitForSearch(int c) {
+    // most text is ASCII, which CharLowerW folds the same way
+    if (c < 0x80) {
+        return (c >= 'A' && c <= 'Z') ? (u32)(c + 32) : (u32)c;
+    }
+    return (u32)FoldCaseForSearch(c);
+}
+
+// decodes textLen glyphs of text into units, case folded if fold
+void BuildSearchUnits(Str text, int textLen, bool fold, Vec<u32>& units) {
+    VecResize(units, textLen);
+    int byteIdx = 0;
+    for (int i = 0; i < textLen; i++) {
+        int c = Utf8CodepointNext(text, byteIdx);
+        units[i] = fold ? FoldUnitForSearch(c) : (u32)c;
+    }
+}
+
+constexpr u32 kSharpS = 0x00DF;
+
+// Does needle n match at h[i] without going past hLimit? For folded units ß
+// matches "ss" and the other way around (issue #933), in the same order the
+// match used to be tried codepoint by codepoint. The ß lookahead may look at
+// h[hLimit], up to hLen, like it always did
+static bool UnitsMatchAt(const u32* h, int hLen, int hLimit, int i, const u32* n, int nLen, bool folded) {
+    int hIdx = i;
+    int nIdx = 0;
+    while (nIdx < nLen) {
+        if (hIdx >= hLimit) {
+            return false;
+        }
+        u32 hc = h[hIdx];
+        u32 nc = n[nIdx];
+        if (folded) {
+            // ß in the needle matches "ss" in the text
+            if (nc == kSharpS && hc == 's' && hIdx + 1 < hLen && h[hIdx + 1] == 's') {
+                hIdx += 2;
+                nIdx += 1;
+                continue;
+            }
+            // "ss" in the needle matches ß in the text
+            if (nc == 's' && hc == kSharpS && nIdx + 1 < nLen && n[nIdx + 1] == 's') {
+                hIdx += 1;
+                nIdx += 2;
+                continue;
+            }
+        }
+        if (hc != nc) {
+            return false;
+        }
+        hIdx++;
+        nIdx++;
+    }
+    return true;
+}
+
+// Candidates for where a match can start: units equal to c0 or c0Alt, followed
+// by c1 if checkC1. ß <-> ss makes the first units of a match vary, see
+// MakeUnitFilter()
+struct UnitFilter {
+    u32 c0 = 0;
+    u32 c0Alt = 0;
+    u32 c1 = 0;
+    bool checkC1 = false;
+};
+
+static UnitFilter MakeUnitFilter(const u32* n, int nLen, bool folded) {
+    UnitFilter f;
+    f.c0 = f.c0Alt = n[0];
+    bool sharpS = folded && (n[0] == 's' || n[0] == kSharpS);
+    if (sharpS) {
+        // ß matches "ss", "ss" matches ß: the next text unit isn't known
+        if (n[0] == kSharpS) {
+            f.c0Alt = 's';
+        } else if (nLen > 1 && n[1] == 's') {
+            f.c0Alt = kSharpS;
+        }
+        return f;
+    }
+    if (nLen > 1 && !(folded && (n[1] == 's' || n[1] == kSharpS))) {
+        f.c1 = n[1];
+        f.checkC1 = true;
+    }
+    return f;
+}
+
+static bool IsCandidate(const u32* h, int hLen, int i, const UnitFilter& f) {
+    return (h[i] == f.c0 || h[i] == f.c0Alt) && (!f.checkC1 || (i + 1 < hLen && h[i + 1] == f.c1));
+}
+
+// first candidate in [start, end) or -1
+static int NextCandidate(const u32* h, int hLen, int start, int end, const UnitFilter& f) {
+    int i = start;
+#if SEARCH_SIMD
+    // 4 units at a time; with checkC1 the units after them are compared too
+    __m128i v0 = _mm_set1_epi32((int)f.c0);
+    __m128i v0Alt = _mm_set1_epi32((int)f.c0Alt);
+    __m128i v1 = _mm_set1_epi32((int)f.c1);
+    int last = std::min(end, hLen - 1) - 4;
+    if (!f.checkC1) {
+        last = end - 4;
+    }
+    for (; i <= last; i += 4) {
+        __m128i units = _mm_loadu_si128((const __m128i*)(h + i));
+        __m128i eq = _mm_or_si128(_mm_cmpeq_epi32(units, v0), _mm_cmpeq_epi32(units, v0Alt));
+        if (f.checkC1) {
+            eq = _mm_and_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(h + i + 1)), v1));
+        }
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        for (int k = 0; mask != 0 && k < 4; k++) {
+            if (mask & (1 << k)) {
+                return i + k;
+            }
+        }
+    }
+#endif
+    for (; i < end; i++) {
+        if (IsCandidate(h, hLen, i, f)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// last candidate in [start, end) or -1
+static int PrevCandidate(const u32* h, int hLen, int start, int end, const UnitFilter& f) {
+    int i = end;
+#if SEARCH_SIMD
+    __m128i v0 = _mm_set1_epi32((int)f.c0);
+    __m128i v0Alt = _mm_set1_epi32((int)f.c0Alt);
+    __m128i v1 = _mm_set1_epi32((int)f.c1);
+    if (f.checkC1 && i > hLen - 1) {
+        // the unit after the last one is compared one by one
+        for (; i > hLen - 1 && i > start; i--) {
+            if (IsCandidate(h, hLen, i - 1, f)) {
+                return i - 1;
+            }
+        }
+    }
+    for (; i - 4 >= start; i -= 4) {
+        __m128i units = _mm_loadu_si128((const __m128i*)(h + i - 4));
+        __m128i eq = _mm_or_si128(_mm_cmpeq_epi32(units, v0), _mm_cmpeq_epi32(units, v0Alt));
+        if (f.checkC1) {
+            eq = _mm_and_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(h + i - 3)), v1));
+        }
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        for (int k = 3; mask != 0 && k >= 0; k--) {
+            if (mask & (1 << k)) {
+                return i - 4 + k;
+            }
+        }
+    }
+#endif
+    for (; i > start; i--) {
+        if (IsCandidate(h, hLen, i - 1, f)) {
+            return i - 1;
+        }
+    }
+    return -1;
+}
+
+// Where needle n matches in h: the first match at or after startOff going
+// forward, the last one ending at startOff at the latest going backward. -1 if
+// there's none
+int FindSearchUnits(const u32* h, int hLen, const u32* n, int nLen, int startOff, bool forward, bool folded) {
+    if (hLen == 0 || nLen == 0) {
+        return -1;
+    }
+    UnitFilter filter = MakeUnitFilter(n, nLen, folded);
+    if (forward) {
+        // with ß <-> ss a match can be shorter than the needle
+        int end = folded ? hLen : hLen - nLen + 1;
+        int i = std::max(startOff, 0);
+        while (i < end) {
+            i = NextCandidate(h, hLen, i, end, filter);
+            if (i < 0) {
+                return -1;
+            }
+            if (UnitsMatchAt(h, hLen, hLen, i, n, nLen, folded)) {
+                return i;
+            }
+            i++;
+        }
+        return -1;
+    }
+    if (startOff <= 0 || startOff > hLen) {
+        return -1;
+    }
+    int end = folded ? startOff : startOff - nLen + 1;
+    int hLimit = folded ? startOff : hLen;
+    while (end > 0) {
+        int i = PrevCandidate(h, hLen, 0, end, filter);
+        if (i < 0) {
+            return -1;
+        }
+        if (UnitsMatchAt(h, hLen, hLimit, i, n, nLen, folded)) {
+            return i;
+        }
+        end = i;
+    }
+    return -1;
+}
+
+static bool IsEscapedLiteral(Str text) {
+    return len(text) >= 3 && str::StartsWith(text, StrL("//")) && text.s[len(text) - 1] == '/';
+}
+
+Str SearchPatternFromText(Str text) {
+    if (len(text) < 3 || text.s[0] != '/' || text.s[len(text) - 1] != '/') {
+        return {};
+    }
+    if (IsEscapedLiteral(text)) {
+        return {};
+    }
+    return Str(text.s + 1, len(text) - 2);
+}
+
+Str SearchLiteralFromText(Str text) {
+    if (IsEscapedLiteral(text)) {
+        return Str(text.s + 1, len(text) - 1);
+    }
+    return text;
+}
+
+constexpr u32 kMaxUnit = 0x10FFFF;
+// x{m,n} is expanded into copies of x
+constexpr int kMaxRepeat = 1000;
+constexpr int kMaxRepeatsPerAtom = 8;
+constexpr int kMaxGroupDepth = 100;
+constexpr int kMaxNfaStates = 20000;
+// the DFA cache is thrown away and built again when it gets bigger than this
+// (in transitions, states * classes)
+constexpr int kMaxDfaCells = 1 << 21;
+
+// a range of units, hi included
+struct UnitRange {
+    u32 lo;
+    u32 hi;
+};
+
+static int CmpUnitRange(const UnitRange* a, const UnitRange* b) {
+    if (a->lo != b->lo) {
+        return a->lo < b->lo ? -1 : 1;
+    }
+    return a->hi < b->hi ? -1 : (a->hi > b->hi ? 1 : 0);
+}
+
+static int CmpU32(const u32* a, const u32* b) {
+    return *a < *b ? -1 : (*a > *b ? 1 : 0);
+}
+
+static int CmpInt(const int* a, const int* b) {
+    return *a - *b;
+}
+
+// sorts and merges overlapping and adjacent ranges
+static void NormalizeRanges(Vec<UnitRange>& ranges) {
+    VecSort(ranges, CmpUnitRange);
+    int n = 0;
+    for (UnitRange r : ranges) {
+        if (n > 0 && r.lo <= ranges[n - 1].hi + 1) {
+            ranges[n - 1].hi = std::max(ranges[n - 1].hi, r.hi);
+            continue;
+        }
+        ranges[n++] = r;
+    }
+    VecResize(ranges, n);
+}
+
+// ranges must be normalized
+static void InvertRanges(Vec<UnitRange>& ranges) {
+    Vec<UnitRange> res;
+    u32 next = 0;
+    for (UnitRange r : ranges) {
+        if (r.lo > next) {
+            res.Append({next, r.lo - 1});
+        }
+        next = r.hi + 1;
+    }
+    if (next <= kMaxUnit) {
+        res.Append({next, kMaxUnit});
+    }
+    ranges = res;
+}
+
+// same as isWordChar() in TextSelection.cpp
+static bool IsPatternWordChar(int c) {
+#if OS_WIN
+    return (c > 0 && c <= 0xffff && IsCharAlphaNumericW((WCHAR)c)) || c == '_';
+#else
+    return (c > 0 && c <= 0xffff && iswalnum((wint_t)c)) || c == '_';
+#endif
+}
+
+enum class PatternNodeKind : u8 {
+    Empty,
+    Set,
+    Seq, // children
+    Alt, // children
+    Star,
+    Plus,
+    Quest,
+};
+
+// a is the set for Set, the first of children for Seq and Alt and the repeated
+// node for Star, Plus and Quest. n is the number of children
+struct PatternNode {
+    PatternNodeKind kind;
+    int a;
+    int n;
+};
+
+// the units a Set node matches
+struct PatternSet {
+    int first;
+    int n;
+};
+
+struct PatternParser {
+    Str s;
+    int pos = 0;
+    bool fold = false;
+    const char* error = nullptr;
+    int depth = 0;
+
+    Vec<PatternNode> nodes;
+    Vec<int> children;
+    // of all sets
+    Vec<UnitRange> ranges;
+    Vec<PatternSet> sets;
+    // the set being built
+    Vec<UnitRange> setRanges;
+    Vec<UnitRange> wordRanges;
+
+    int Parse();
+    int ParseAlt();
+    int ParseSeq();
+    int ParseRepeat();
+    int ParseAtom();
+    int ParseClass();
+    bool ParseEscape(bool inClass, u32* cOut);
+    bool ParseCount(int* mOut, int* nOut);
+    int NextChar();
+
+    int AddNode(PatternNodeKind kind, int a, int n);
+    int AddList(PatternNodeKind kind, const Vec<int>& items);
+    void AddRange(u32 lo, u32 hi);
+    void AddShorthand(char c);
+    int EndSet(bool negate);
+    int CharNode(u32 c);
+    bool Fail(const char* msg);
+};
+
+bool PatternParser::Fail(const char* msg) {
+    if (!error) {
+        error = msg;
+    }
+    return false;
+}
+
+int PatternParser::NextChar() {
+    return Utf8CodepointNext(s, pos);
+}
+
+int PatternParser::AddNode(PatternNodeKind kind, int a, int n) {
+    nodes.Append({kind, a, n});
+    return len(nodes) - 1;
+}
+
+int PatternParser::AddList(PatternNodeKind kind, const Vec<int>& items) {
+    if (len(items) == 0) {
+        return AddNode(PatternNodeKind::Empty, 0, 0);
+    }
+    if (len(items) == 1) {
+        return items[0];
+    }
+    int first = len(children);
+    children.Append(items);
+    return AddNode(kind, first, len(items));
+}
+
+// with fold the units are case folded, so the set has to have the case folded
+// form of everything in it
+void PatternParser::AddRange(u32 lo, u32 hi) {
+    setRanges.Append({lo, hi});
+    if (!fold) {
+        return;
+    }
+    u32 end = std::min(hi, (u32)0xffff);
+    for (u32 c = lo; c <= end; c++) {
+        u32 f = FoldUnitForSearch((int)c);
+        if (f < lo || f > hi) {
+            setRanges.Append({f, f});
+        }
+    }
+}
+
+// \d, \s, \w and their negations
+void PatternParser::AddShorthand(char c) {
+    Vec<UnitRange> r;
+    switch (c) {
+        case 'd':
+        case 'D':
+            r.Append({'0', '9'});
+            break;
+        case 's':
+        case 'S':
+            r.Append({'\t', '\r'});
+            r.Append({' ', ' '});
+            break;
+        default:
+            if (len(wordRanges) == 0) {
+                for (int i = 1; i <= 0xffff; i++) {
+                    if (!IsPatternWordChar(i)) {
+                        continue;
+                    }
+                    int n = len(wordRanges);
+                    if (n > 0 && wordRanges[n - 1].hi + 1 == (u32)i) {
+                        wordRanges[n - 1].hi = i;
+                    } else {
+                        wordRanges.Append({(u32)i, (u32)i});
+                    }
+                }
+            }
+            r = wordRanges;
+            break;
+    }
+    if (c >= 'A' && c <= 'Z') {
+        InvertRanges(r);
+    }
+    for (UnitRange ur : r) {
+        AddRange(ur.lo, ur.hi);
+    }
+}
+
+int PatternParser::EndSet(bool negate) {
+    NormalizeRanges(setRanges);
+    if (negate) {
+        InvertRanges(setRanges);
+    }
+    PatternSet set = {len(ranges), len(setRanges)};
+    ranges.Append(setRanges);
+    setRanges.Reset();
+    sets.Append(set);
+    return AddNode(PatternNodeKind::Set, len(sets) - 1, 0);
+}
+
+int PatternParser::CharNode(u32 c) {
+    setRanges.Reset();
+    if (c == ' ') {
+        // like in a plain text search, a space matches any whitespace, which
+        // includes the line breaks of the page text
+        AddShorthand('s');
+    } else {
+        AddRange(c, c);
+    }
+    return EndSet(false);
+}
+
+// \t, \n, \r, \xHH, \uHHHH or an escaped non-alphanumeric character
+bool PatternParser::ParseEscape(bool inClass, u32* cOut) {
+    if (pos >= len(s)) {
+        return Fail("pattern ends with \\");
+    }
+    int c = NextChar();
+    switch (c) {
+        case 't':
+            *cOut = '\t';
+            return true;
+        case 'n':
+            *cOut = '\n';
+            return true;
+        case 'r':
+            *cOut = '\r';
+            return true;
+        case 'x':
+        case 'u': {
+            int nDigits = c == 'x' ? 2 : 4;
+            u32 v = 0;
+            for (int i = 0; i < nDigits; i++) {
+                int d = pos < len(s) ? s.s[pos] : 0;
+                int n = -1;
+                if (d >= '0' && d <= '9') {
+                    n = d - '0';
+                } else if (d >= 'a' && d <= 'f') {
+                    n = d - 'a' + 10;
+                } else if (d >= 'A' && d <= 'F') {
+                    n = d - 'A' + 10;
+                }
+                if (n < 0) {
+                    return Fail("invalid \\x or \\u escape");
+                }
+                v = v * 16 + n;
+                pos++;
+            }
+            *cOut = v;
+            return true;
+        }
+        default:
+            break;
+    }
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+        // \b, back references etc. can't be matched by a DFA
+        return Fail(inClass ? "unsupported escape in [ ]" : "unsupported escape");
+    }
+    *cOut = (u32)c;
+    return true;
+}
+
+static bool IsShorthand(Str s, int pos) {
+    if (pos + 1 >= len(s) || s.s[pos] != '\\') {
+        return false;
+    }
+    char c = s.s[pos + 1];
+    return c == 'd' || c == 'D' || c == 's' || c == 'S' || c == 'w' || c == 'W';
+}
+
+// after the [
+int PatternParser::ParseClass() {
+    bool negate = pos < len(s) && s.s[pos] == '^';
+    if (negate) {
+        pos++;
+    }
+    setRanges.Reset();
+    bool first = true;
+    for (;;) {
+        if (pos >= len(s)) {
+            Fail("missing ]");
+            return -1;
+        }
+        // ']' right after '[' or '[^' is a literal
+        if (s.s[pos] == ']' && !first) {
+            pos++;
+            break;
+        }
+        first = false;
+        if (IsShorthand(s, pos)) {
+            AddShorthand(s.s[pos + 1]);
+            pos += 2;
+            continue;
+        }
+        u32 lo = (u32)NextChar();
+        if (lo == '\\' && !ParseEscape(true, &lo)) {
+            return -1;
+        }
+        u32 hi = lo;
+        if (pos + 1 < len(s) && s.s[pos] == '-' && s.s[pos + 1] != ']') {
+            pos++;
+            hi = (u32)NextChar();
+            if (hi == '\\' && !ParseEscape(true, &hi)) {
+                return -1;
+            }
+            if (hi < lo) {
+                Fail("invalid range in [ ]");
+                return -1;
+            }
+        }
+        AddRange(lo, hi);
+    }
+    return EndSet(negate);
+}
+
+// after the {. {m}, {m,} (n is -1) or {m,n}. Returns false, without moving
+// pos, if it isn't one of them, which makes the { a literal
+bool PatternParser::ParseCount(int* mOut, int* nOut) {
+    int p = pos;
+    auto parseNum = [&](int* v) {
+        int start = p;
+        *v = 0;
+        while (p < len(s) && s.s[p] >= '0' && s.s[p] <= '9') {
+            *v = std::min(*v * 10 + (s.s[p] - '0'), kMaxRepeat + 1);
+            p++;
+        }
+        return p > start;
+    };
+    int m, n;
+    if (!parseNum(&m)) {
+        return false;
+    }
+    n = m;
+    if (p < len(s) && s.s[p] == ',') {
+        p++;
+        if (!parseNum(&n)) {
+            n = -1;
+        }
+    }
+    if (p >= len(s) || s.s[p] != '}') {
+        return false;
+    }
+    pos = p + 1;
+    *mOut = m;
+    *nOut = n;
+    return true;
+}
+
+int PatternParser::ParseAtom() {
+    int c = NextChar();
+    switch (c) {
+        case '(': {
+            if (pos + 1 < len(s) && s.s[pos] == '?' && s.s[pos + 1] == ':') {
+                pos += 2;
+            } else if (pos < len(s) && s.s[pos] == '?') {
+                Fail("unsupported (? group");
+                return -1;
+            }
+            if (++depth > kMaxGroupDepth) {
+                Fail("too many nested groups");
+                return -1;
+            }
+            int node = ParseAlt();
+            depth--;
+            if (node < 0) {
+                return -1;
+            }
+            if (pos >= len(s) || s.s[pos] != ')') {
+                Fail("missing )");
+                return -1;
+            }
+            pos++;
+            return node;
+        }
+        case '[':
+            return ParseClass();
+        case '.':
+            setRanges.Reset();
+            setRanges.Append({'\n', '\n'});
+            return EndSet(true);
+        case '^':
+        case '$':
+            Fail("^ and $ aren't supported");
+            return -1;
+        case '*':
+        case '+':
+        case '?':
+            Fail("nothing to repeat");
+            return -1;
+        case '\\': {
+            if (IsShorthand(s, pos - 1)) {
+                setRanges.Reset();
+                AddShorthand(s.s[pos]);
+                pos++;
+                return EndSet(false);
+            }
+            u32 esc = 0;
+            if (!ParseEscape(false, &esc)) {
+                return -1;
+            }
+            return CharNode(esc);
+        }
+        default:
+            return CharNode((u32)c);
+    }
+}
+
+int PatternParser::ParseRepeat() {
+    int atom = ParseAtom();
+    // each one nests the atom deeper, which the NFA is built from recursively
+    int nRepeats = 0;
+    while (atom >= 0 && pos < len(s)) {
+        char c = s.s[pos];
+        if ((c == '*' || c == '+' || c == '?' || c == '{') && ++nRepeats > kMaxRepeatsPerAtom) {
+            Fail("too many repeats");
+            return -1;
+        }
+        if (c == '*' || c == '+' || c == '?') {
+            pos++;
+            PatternNodeKind kind = c == '*' ? PatternNodeKind::Star
+                                   : c == '+' ? PatternNodeKind::Plus
+                                              : PatternNodeKind::Quest;
+            atom = AddNode(kind, atom, 0);
+            continue;
+        }
+        if (c != '{') {
+            break;
+        }
+        pos++;
+        int m, n;
+        if (!ParseCount(&m, &n)) {
+            pos--;
+            break;
+        }
+        if (m > kMaxRepeat || n > kMaxRepeat) {
+            Fail("repeat count is too big");
+            return -1;
+        }
+        if (n >= 0 && n < m) {
+            Fail("invalid repeat count");
+            return -1;
+        }
+        // x{2,4} is xxx?x? and x{2,} is xxx*
+        Vec<int> items;
+        for (int i = 0; i < m; i++) {
+            items.Append(atom);
+        }
+        if (n < 0) {
+            items.Append(AddNode(PatternNodeKind::Star, atom, 0));
+        } else if (n > m) {
+            int opt = AddNode(PatternNodeKind::Quest, atom, 0);
+            for (int i = m; i < n; i++) {
+                items.Append(opt);
+            }
+        }
+        atom = AddList(PatternNodeKind::Seq, items);
+    }
+    return atom;
+}
+
+int PatternParser::ParseSeq() {
+    Vec<int> items;
+    while (pos < len(s) && s.s[pos] != '|' && s.s[pos] != ')') {
+        int node = ParseRepeat();
+        if (node < 0) {
+            return -1;
+        }
+        items.Append(node);
+    }
+    return AddList(PatternNodeKind::Seq, items);
+}
+
+int PatternParser::ParseAlt() {
+    Vec<int> items;
+    for (;;) {
+        int node = ParseSeq();
+        if (node < 0) {
+            return -1;
+        }
+        items.Append(node);
+        if (pos >= len(s) || s.s[pos] != '|') {
+            break;
+        }
+        pos++;
+    }
+    return AddList(PatternNodeKind::Alt, items);
+}
+
+int PatternParser::Parse() {
+    int root = ParseAlt();
+    if (root >= 0 && pos < len(s)) {
+        Fail("unmatched )");
+        return -1;
+    }
+    return error ? -1 : root;
+}
+
+enum class NfaKind : u8 {
+    Char,
+    Split,
+    Match,
+};
+
+// Char goes to out on a unit in set, Split goes to both out and out1
+struct NfaState {
+    NfaKind kind;
+    int set;
+    int out;
+    int out1;
+};
+
+constexpr int kDfaUnknown = -2;
+constexpr int kDfaDead = -1;
+
+// The NFA of the pattern (Thompson's construction) and the DFA built from it
+// on demand. A DFA state is the sorted list of the Char and Match NFA states
+// the NFA can be in
+struct SearchPattern::Dfa {
+    Vec<NfaState> nfa;
+    int nfaStart = 0;
+    // matches can start anywhere: the NFA start is added to every state
+    bool unanchored = false;
+    int nClasses = 0;
+    int wordsPerSet = 0;
+    // per set, a bit per class
+    Vec<u64> setBits;
+
+    Vec<int> stateNfa;
+    // stateNfa[stateFirst[i], stateFirst[i+1]) is DFA state i
+    Vec<int> stateFirst;
+    Vec<bool> accepting;
+    // per state and class, kDfaUnknown until computed
+    Vec<int> next;
+    // DFA state + 1 by a hash of its NFA states, 0 is empty
+    Vec<int> hashSlots;
+    int start = kDfaUnknown;
+
+    Vec<int> mark;
+    int markGen = 0;
+    Vec<int> stack;
+    Vec<int> work;
+
+    int AddNfa(NfaKind kind, int set, int out, int out1);
+    int Compile(const PatternParser& p, int node, int next, bool reverse);
+    void AddClosure(int q);
+    int AddState();
+    int Start();
+    int Step(int s, int cls);
+    bool IsAccepting(int s) const;
+    void Flush();
+};
+
+int SearchPattern::Dfa::AddNfa(NfaKind kind, int set, int out, int out1) {
+    if (len(nfa) >= kMaxNfaStates) {
+        return -1;
+    }
+    nfa.Append({kind, set, out, out1});
+    return len(nfa) - 1;
+}
+
+// Compiles node into states that continue to next, returns the state they start
+// at or -1 if the NFA gets too big. With reverse the NFA matches the reversed
+// text. Written in continuation passing style, nodes used in several places
+// (by x{m,n}) get separate states
+int SearchPattern::Dfa::Compile(const PatternParser& p, int node, int next, bool reverse) {
+    if (next < 0) {
+        return -1;
+    }
+    const PatternNode& n = p.nodes[node];
+    switch (n.kind) {
+        case PatternNodeKind::Empty:
+            return next;
+        case PatternNodeKind::Set:
+            return AddNfa(NfaKind::Char, n.a, next, -1);
+        case PatternNodeKind::Seq:
+            for (int i = 0; i < n.n; i++) {
+                int child = reverse ? p.children[n.a + i] : p.children[n.a + n.n - 1 - i];
+                next = Compile(p, child, next, reverse);
+                if (next < 0) {
+                    return -1;
+                }
+            }
+            return next;
+        case PatternNodeKind::Alt: {
+            int res = Compile(p, p.children[n.a + n.n - 1], next, reverse);
+            for (int i = n.n - 2; i >= 0 && res >= 0; i--) {
+                int alt = Compile(p, p.children[n.a + i], next, reverse);
+                res = alt < 0 ? -1 : AddNfa(NfaKind::Split, -1, alt, res);
+            }
+            return res;
+        }
+        case PatternNodeKind::Quest: {
+            int body = Compile(p, n.a, next, reverse);
+            return body < 0 ? -1 : AddNfa(NfaKind::Split, -1, body, next);
+        }
+        case PatternNodeKind::Star:
+        case PatternNodeKind::Plus: {
+            int split = AddNfa(NfaKind::Split, -1, -1, next);
+            int body = Compile(p, n.a, split, reverse);
+            if (body < 0) {
+                return -1;
+            }
+            nfa[split].out = body;
+            return n.kind == PatternNodeKind::Star ? split : body;
+        }
+    }
+    return -1;
+}
+
+// adds the Char and Match states reachable from q without consuming a unit
+void SearchPattern::Dfa::AddClosure(int q) {
+    stack.Append(q);
+    while (len(stack) > 0) {
+        q = stack.Last();
+        stack.RemoveLast();
+        if (mark[q] == markGen) {
+            continue;
+        }
+        mark[q] = markGen;
+        const NfaState& st = nfa[q];
+        if (st.kind == NfaKind::Split) {
+            stack.Append(st.out1);
+            stack.Append(st.out);
+            continue;
+        }
+        work.Append(q);
+    }
+}
+
+static u32 HashNfaStates(const int* states, int n) {
+    u32 h = 2166136261u;
+    for (int i = 0; i < n; i++) {
+        h = (h ^ (u32)states[i]) * 16777619u;
+    }
+    return h;
+}
+
+void SearchPattern::Dfa::Flush() {
+    stateNfa.Reset();
+    stateFirst.Reset();
+    stateFirst.Append(0);
+    accepting.Reset();
+    next.Reset();
+    hashSlots.Reset();
+    start = kDfaUnknown;
+}
+
+// the DFA state for the NFA states in work, added if it's new
+int SearchPattern::Dfa::AddState() {
+    VecSort(work, CmpInt);
+    int n = len(work);
+    u32 h = HashNfaStates(work.els, n);
+    int nStates = len(accepting);
+    int nSlots = len(hashSlots);
+    for (int i = 0; nSlots > 0 && i < nSlots; i++) {
+        int slot = (int)((h + (u32)i) & (u32)(nSlots - 1));
+        int s = hashSlots[slot] - 1;
+        if (s < 0) {
+            break;
+        }
+        int first = stateFirst[s];
+        if (stateFirst[s + 1] - first == n && memcmp(stateNfa.els + first, work.els, n * sizeof(int)) == 0) {
+            return s;
+        }
+    }
+
+    if (nStates * 2 >= nSlots) {
+        // keep the table at most half full
+        int newSlots = std::max(nSlots * 2, 64);
+        hashSlots.Reset();
+        VecResize(hashSlots, newSlots);
+        for (int s = 0; s < nStates; s++) {
+            int first = stateFirst[s];
+            u32 sh = HashNfaStates(stateNfa.els + first, stateFirst[s + 1] - first);
+            int slot = (int)(sh & (u32)(newSlots - 1));
+            while (hashSlots[slot] != 0) {
+                slot = (slot + 1) & (newSlots - 1);
+            }
+            hashSlots[slot] = s + 1;
+        }
+        nSlots = newSlots;
+    }
+    int slot = (int)(h & (u32)(nSlots - 1));
+    while (hashSlots[slot] != 0) {
+        slot = (slot + 1) & (nSlots - 1);
+    }
+    hashSlots[slot] = nStates + 1;
+
+    bool isMatch = false;
+    for (int q : work) {
+        isMatch |= nfa[q].kind == NfaKind::Match;
+    }
+    stateNfa.Append(work);
+    stateFirst.Append(len(stateNfa));
+    accepting.Append(isMatch);
+    int* cells = next.AppendBlanks(nClasses);
+    for (int i = 0; i < nClasses; i++) {
+        cells[i] = kDfaUnknown;
+    }
+    return nStates;
+}
+
+int SearchPattern::Dfa::Start() {
+    if (start == kDfaUnknown) {
+        work.Reset();
+        markGen++;
+        AddClosure(nfaStart);
+        start = AddState();
+    }
+    return start;
+}
+
+bool SearchPattern::Dfa::IsAccepting(int s) const {
+    return accepting[s];
+}
+
+int SearchPattern::Dfa::Step(int s, int cls) {
+    int t = next[s * nClasses + cls];
+    if (t != kDfaUnknown) {
+        return t;
+    }
+    work.Reset();
+    markGen++;
+    for (int i = stateFirst[s]; i < stateFirst[s + 1]; i++) {
+        const NfaState& st = nfa[stateNfa[i]];
+        if (st.kind != NfaKind::Char) {
+            continue;
+        }
+        u64 bits = setBits[st.set * wordsPerSet + cls / 64];
+        if (bits & ((u64)1 << (cls % 64))) {
+            AddClosure(st.out);
+        }
+    }
+    if (unanchored) {
+        AddClosure(nfaStart);
+    }
+    if (len(work) == 0) {
+        next[s * nClasses + cls] = kDfaDead;
+        return kDfaDead;
+    }
+    bool flush = (len(accepting) + 1) * nClasses > kMaxDfaCells;
+    if (flush) {
+        // states from before are gone, s included, so the transition isn't
+        // recorded. The caller only has the state returned
+        Vec<int> keep = work;
+        Flush();
+        work = keep;
+        return AddState();
+    }
+    t = AddState();
+    next[s * nClasses + cls] = t;
+    return t;
+}
+
+SearchPattern::SearchPattern() = default;
+
+SearchPattern::~SearchPattern() {
+    Free();
+}
+
+void SearchPattern::Free() {
+    delete forward;
+    delete backward;
+    forward = nullptr;
+    backward = nullptr;
+    classStarts.Reset();
+    error = {};
+}
+
+bool SearchPattern::IsValid() const {
+    return forward != nullptr;
+}
+
+// the last class starting at or before c
+static int FindClass(const Vec<u32>& classStarts, u32 c) {
+    int lo = 0;
+    int hi = len(classStarts) - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (classStarts[mid] <= c) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+int SearchPattern::ClassOf(u32 c) const {
+    if (c < 128) {
+        return asciiClasses[c];
+    }
+    return FindClass(classStarts, c);
+}
+
+bool SearchPattern::Compile(Str pattern, bool fold) {
+    Free();
+    PatternParser p;
+    p.s = pattern;
+    p.fold = fold;
+    int root = p.Parse();
+    if (root < 0) {
+        error = Str(p.error);
+        return false;
+    }
+
+    // the classes: every range of a set starts a class and the one after it
+    // starts another one
+    Vec<u32> bounds;
+    bounds.Append(0);
+    for (UnitRange r : p.ranges) {
+        bounds.Append(r.lo);
+        if (r.hi < kMaxUnit) {
+            bounds.Append(r.hi + 1);
+        }
+    }
+    VecSort(bounds, CmpU32);
+    for (u32 b : bounds) {
+        if (len(classStarts) == 0 || classStarts.Last() != b) {
+            classStarts.Append(b);
+        }
+    }
+    int nClasses = len(classStarts);
+    if (nClasses > 0xffff) {
+        classStarts.Reset();
+        error = StrL("pattern is too complex");
+        return false;
+    }
+    for (u32 c = 0; c < 128; c++) {
+        asciiClasses[c] = (u16)FindClass(classStarts, c);
+    }
+
+    int wordsPerSet = (nClasses + 63) / 64;
+    Vec<u64> setBits;
+    VecResize(setBits, len(p.sets) * wordsPerSet);
+    for (int i = 0; i < len(p.sets); i++) {
+        PatternSet set = p.sets[i];
+        u64* bits = setBits.els + i * wordsPerSet;
+        for (int j = set.first; j < set.first + set.n; j++) {
+            UnitRange r = p.ranges[j];
+            int last = ClassOf(r.hi);
+            for (int cls = ClassOf(r.lo); cls <= last; cls++) {
+                bits[cls / 64] |= (u64)1 << (cls % 64);
+            }
+        }
+    }
+
+    Dfa* dfas[2] = {new Dfa(), new Dfa()};
+    for (int i = 0; i < 2; i++) {
+        Dfa* d = dfas[i];
+        bool reverse = i == 1;
+        d->unanchored = reverse;
+        d->nClasses = nClasses;
+        d->wordsPerSet = wordsPerSet;
+        d->setBits = setBits;
+        int match = d->AddNfa(NfaKind::Match, -1, -1, -1);
+        d->nfaStart = d->Compile(p, root, match, reverse);
+        VecResize(d->mark, len(d->nfa));
+        d->Flush();
+    }
+    if (dfas[0]->nfaStart < 0 || dfas[1]->nfaStart < 0) {
+        delete dfas[0];
+        delete dfas[1];
+        classStarts.Reset();
+        error = StrL("pattern is too complex");
+        return false;
+    }
+    forward = dfas[0];
+    backward = dfas[1];
+    return true;
+}
+
+void SearchPattern::FindAll(const u32* units, int nUnits, Vec<int>& matches) {
+    if (!IsValid() || nUnits <= 0) {
+        return;
+    }
+    VecResize(unitClasses, nUnits);
+    VecResize(canStart, nUnits);
+    // going backward, the reversed pattern matches at every unit a match
+    // starts at
+    int s = backward->Start();
+    for (int i = nUnits - 1; i >= 0; i--) {
+        int cls = ClassOf(units[i]);
+        unitClasses[i] = (u16)cls;
+        s = backward->Step(s, cls);
+        if (s == kDfaDead) {
+            s = backward->Start();
+        }
+        canStart[i] = backward->IsAccepting(s);
+    }
+    // the longest match starting there
+    int i = 0;
+    while (i < nUnits) {
+        if (!canStart[i]) {
+            i++;
+            continue;
+        }
+        int end = -1;
+        s = forward->Start();
+        for (int j = i; j < nUnits; j++) {
+            s = forward->Step(s, unitClasses[j]);
+            if (s == kDfaDead) {
+                break;
+            }
+            if (forward->IsAccepting(s)) {
+                end = j + 1;
+            }
+        }
+        if (end > i) {
+            matches.Append(i);
+            matches.Append(end);
+            i = end;
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// Page text is searched as one unit per glyph (see BuildSearchUnits()), case
+// folded for a case insensitive search
+int FoldCaseForSearch(int c);
+u32 FoldUnitForSearch(int c);
+void BuildSearchUnits(Str text, int textLen, bool fold, Vec<u32>& units);
+// where n matches in h searching from startOff. In folded units ß and "ss"
+// match each other
+int FindSearchUnits(const u32* h, int hLen, const u32* n, int nLen, int startOff, bool forward, bool folded);
+
+// the pattern of a search text of the form /pattern/ or an empty Str if it's
+// a plain text. //text/ is the escape for a plain search for /text/
+Str SearchPatternFromText(Str text);
+// text without the leading / of the //text/ escape
+Str SearchLiteralFromText(Str text);
+
+// A regular expression search compiled once into an automaton (a DFA built
+// lazily, state by state, as the text needs it) that finds all matches in a
+// page with a single pass over its units, however many alternatives
+// ("term1|term2|...") the pattern has. Matches are leftmost-longest and don't
+// overlap. Supported: literals, ., [...] and [^...], \d \w \s (and \D \W \S),
+// ( ), (?: ), |, *, +, ?, {m}, {m,}, {m,n}. A space matches any whitespace.
+// Doesn't know about pages or engines so that it can be tested alone.
+class SearchPattern {
+  public:
+    struct Dfa;
+
+    SearchPattern();
+    ~SearchPattern();
+
+    // fold must be the same as for the units searched. Returns false (and sets
+    // error) if the pattern can't be compiled
+    bool Compile(Str pattern, bool fold);
+    bool IsValid() const;
+
+    // appends start and end (one past the last unit) of each match in units
+    // to matches
+    void FindAll(const u32* units, int nUnits, Vec<int>& matches);
+
+    // static string, set if Compile() failed
+    Str error;
+
+  private:
+    // units are mapped to classes: ranges of units no part of the pattern
+    // tells apart. classStarts[i] is the first unit of class i
+    Vec<u32> classStarts;
+    u16 asciiClasses[128] = {};
+    Vec<u16> unitClasses;
+
+    Dfa* forward = nullptr;  // anchored: matches starting at a given unit
+    Dfa* backward = nullptr; // unanchored, reversed: where matches can start
+    Vec<bool> canStart;
+
+    int ClassOf(u32 c) const;
+    void Free();
+};
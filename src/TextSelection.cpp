@@ -6,6 +6,8 @@
 #include "DocController.h"
 #include "gui/UIModels.h"
 #include "EngineBase.h"
+#include "GlyphIndex.h"
+#include "PageStructure.h"
 #if defined(DEBUG)
 #include "base/UtAssert.h"
 #endif
@@ -53,32 +55,9 @@ static int FindClosestGlyph(TextSelection* ts, int pageNo, double x, double y) {
     ts->engine->GetTextForPage(pageNo, &textLen, &coords);
     PointF pt = PointF((float)x, (float)y);
 
-    unsigned int maxDist = UINT_MAX;
-    Point pti = ToPoint(pt);
-    bool overGlyph = false;
-    int result = -1;
-
-    for (int i = 0; i < textLen; i++) {
-        Rect& coord = coords[i];
-        if (!coord.x && !coord.dx) {
-            continue;
-        }
-        if (overGlyph && !coord.Contains(pti)) {
-            continue;
-        }
-
-        uint dist = distSq((int)x - coord.x - (coord.dx / 2), (int)y - coord.y - (coord.dy / 2));
-        if (dist < maxDist) {
-            result = i;
-            maxDist = dist;
-        }
-        // prefer glyphs the cursor is actually over
-        if (!overGlyph && coord.Contains(pti)) {
-            overGlyph = true;
-            result = i;
-            maxDist = dist;
-        }
-    }
+    // prefers glyphs the cursor is actually over
+    const GlyphIndex* index = ts->engine->GetGlyphIndex(pageNo);
+    int result = index ? index->FindClosest(x, y) : -1;
 
     if (-1 == result) {
         return 0;
@@ -515,37 +494,14 @@ void TextSelection::SelectLineAt(int pageNo, double x, double y) {
     if (i < 0) {
         return;
     }
-    Rect* coords;
-    int textLen = 0;
-    Str text = engine->GetTextForPage(pageNo, &textLen, &coords);
-    // line breaks are newline glyphs with zero-size coords. Some whitespace (e.g.
-    // spaces with FZ_STEXT_ACCURATE_BBOXES) can also have empty boxes and must not
-    // be treated as line ends (issue #5712).
-    int lineStart = i;
-    int lineStartByte = Utf8CodepointToByteIndex(text, lineStart);
-    while (lineStart > 0) {
-        int prevByte = lineStartByte;
-        int c = Utf8CodepointPrev(text, prevByte);
-        int prevGlyph = lineStart - 1;
-        if (c == '\n' && !coords[prevGlyph].x && !coords[prevGlyph].dx) {
-            break;
-        }
-        lineStart--;
-        lineStartByte = prevByte;
-    }
-    int lineEnd = i;
-    int lineEndByte = Utf8CodepointToByteIndex(text, lineEnd);
-    while (lineEnd < textLen) {
-        int nextByte = lineEndByte;
-        int c = Utf8CodepointNext(text, nextByte);
-        if (c == '\n' && !coords[lineEnd].x && !coords[lineEnd].dx) {
-            break;
-        }
-        lineEnd++;
-        lineEndByte = nextByte;
+    // line breaks are newline glyphs with zero-size coords (see PageStructure)
+    const PageStructure* ps = engine->GetPageStructure(pageNo);
+    if (!ps) {
+        return;
     }
-    StartAt(pageNo, lineStart);
-    SelectUpTo(pageNo, lineEnd);
+    const PageLine& line = ps->lines[ps->LineOf(i)];
+    StartAt(pageNo, line.start);
+    SelectUpTo(pageNo, line.end);
 }
 
 // (pageA, glyphA) is before (pageB, glyphB) in reading order
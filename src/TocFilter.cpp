@@ -0,0 +1,112 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+
+#include "FilterUtil.h"
+#include "TocFilter.h"
+
+TocFilterIndex::TocFilterIndex() {
+    arena = ArenaNew();
+}
+
+TocFilterIndex::~TocFilterIndex() {
+    ArenaDelete(arena);
+}
+
+int TocFilterIndex::Add(Str title, int parentIdx) {
+    int idx = len(foldedTitles);
+    ReportIf(parentIdx >= idx);
+    foldedTitles.Append(title ? str::FoldCase(arena, title) : Str());
+    parents.Append(parentIdx);
+    subtreeEnds.Append(idx + 1);
+    for (int p = parentIdx; p >= 0; p = parents[p]) {
+        subtreeEnds[p] = idx + 1;
+    }
+    return idx;
+}
+
+int TocFilterIndex::Count() const {
+    return len(foldedTitles);
+}
+
+static bool AllWordsIn(Str foldedTitle, const StrVec& words) {
+    for (Str word : words) {
+        if (str::IndexOf(foldedTitle, word) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// everything that matches newWords also matches prevWords if every previous
+// word is a part of one of the new words
+static bool IsNarrowing(const StrVec& prevWords, const StrVec& newWords) {
+    for (Str prev : prevWords) {
+        bool found = false;
+        for (Str word : newWords) {
+            if (str::Contains(word, prev)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TocFilterIndex::SetQuery(Str query) {
+    StrVec queryWords;
+    SplitFilterToWords(query, queryWords);
+    StrVec newWords;
+    for (Str word : queryWords) {
+        AppendIfNotExists(&newWords, str::FoldCase(GetTempArena(), word));
+    }
+
+    nChecked = 0;
+    if (len(newWords) == 0) {
+        words.Reset();
+        hasQuery = false;
+        matches.Reset();
+        matchParents.Reset();
+        return false;
+    }
+
+    if (hasQuery && IsNarrowing(words, newWords)) {
+        int n = 0;
+        for (int idx : matches) {
+            if (AllWordsIn(foldedTitles[idx], newWords)) {
+                matches[n++] = idx;
+            }
+        }
+        nChecked = len(matches);
+        VecResize(matches, n);
+    } else {
+        matches.Reset();
+        int nItems = len(foldedTitles);
+        for (int idx = 0; idx < nItems; idx++) {
+            if (AllWordsIn(foldedTitles[idx], newWords)) {
+                matches.Append(idx);
+            }
+        }
+        nChecked = nItems;
+    }
+    words = newWords;
+    hasQuery = true;
+
+    // matches are in document order, so the matching ancestors of a match
+    // are on the stack when we get to it
+    matchParents.Reset();
+    Vec<int> stack;
+    for (int i = 0; i < len(matches); i++) {
+        int idx = matches[i];
+        while (len(stack) > 0 && subtreeEnds[matches[stack.Last()]] <= idx) {
+            stack.Pop();
+        }
+        matchParents.Append(len(stack) > 0 ? stack.Last() : -1);
+        stack.Append(i);
+    }
+    return true;
+}
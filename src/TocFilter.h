@@ -0,0 +1,41 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// Filtering of a table of contents by the words typed in the filter box
+// (every word must be in an item's title). Titles are case-folded once,
+// when added, and a query that only extends the previous one (as it does
+// while typing) only re-checks the items that matched it.
+// Doesn't know about TocItem or windows so that it can be tested alone.
+class TocFilterIndex {
+    Arena* arena = nullptr;
+    // per item, in the order they were added
+    Vec<Str> foldedTitles;
+    Vec<int> parents;
+    // one past the index of the last descendant
+    Vec<int> subtreeEnds;
+
+    // case-folded words of the current query
+    StrVec words;
+    bool hasQuery = false;
+
+  public:
+    // indexes of the items that match the query, in the order they were added
+    Vec<int> matches;
+    // for each of matches, the index in matches of the closest ancestor that
+    // matches too (the parent in the filtered tree) or -1
+    Vec<int> matchParents;
+    // how many titles the last SetQuery() had to look at
+    int nChecked = 0;
+
+    TocFilterIndex();
+    ~TocFilterIndex();
+
+    // items must be added in document order: a parent before its children
+    // and children before the parent's next sibling. parentIdx is -1 for
+    // top level items. Returns the index of the item
+    int Add(Str title, int parentIdx);
+    int Count() const;
+
+    // returns false if query has no words (nothing is filtered)
+    bool SetQuery(Str query);
+};
@@ -65,12 +65,21 @@ static Archive::Format FormatFromArchive(struct archive* a) {
     return Archive::Format::Unknown;
 }
 
+static void FreeArchiveMap(Archive* ar) {
+    if (ar->archiveMap_) {
+        file::MemoryUnmap(ar->archiveMap_);
+        delete ar->archiveMap_;
+        ar->archiveMap_ = nullptr;
+    }
+}
+
 Archive::~Archive() {
     for (auto& fi : fileInfos_) {
         free((void*)fi->data);
     }
     str::Free(archivePath_);
     str::Free(archiveData_);
+    FreeArchiveMap(this);
     str::Free(password);
     ArenaDelete(a);
 }
@@ -295,6 +304,10 @@ static struct archive* OpenLibarchiveMemory(Str data, Str password) {
 }
 
 static struct archive* OpenLibarchiveSource(Archive* ar) {
+    if (ar->archiveMap_) {
+        Str data((char*)ar->archiveMap_->data, (int)ar->archiveMap_->size);
+        return OpenLibarchiveMemory(data, ar->password);
+    }
     if (ar->archiveData_) {
         return OpenLibarchiveMemory(ar->archiveData_, ar->password);
     }
@@ -347,12 +360,43 @@ bool Archive::OpenFromData(Str data, bool eagerLoad) {
     return ok;
 }
 
+// archives at least this big, extracted lazily, are memory-mapped
+constexpr i64 kArchiveMemoryMapMinFileSize = 64LL * 1024 * 1024;
+
+// Str holds an int length, so only map what it can address
+static file::Mapping* MemoryMapArchive(Str path) {
+    auto* m = new file::Mapping();
+    if (!file::MemoryMapIfLarge(path, kArchiveMemoryMapMinFileSize, m)) {
+        delete m;
+        return nullptr;
+    }
+    if (m->size > INT_MAX) {
+        file::MemoryUnmap(m);
+        delete m;
+        return nullptr;
+    }
+    return m;
+}
+
 bool Archive::OpenArchive(Str path, bool eagerLoad, const ArchiveExtractProgressCb& cbProgress) {
-    struct archive* a = NewLibarchiveReader(password);
-    int r = ArchiveReadOpenFilename(a, path);
-    if (r != ARCHIVE_OK) {
-        archive_read_free(a);
-        return false;
+    if (!eagerLoad) {
+        archiveMap_ = MemoryMapArchive(path);
+    }
+    struct archive* a = nullptr;
+    if (archiveMap_) {
+        Str data((char*)archiveMap_->data, (int)archiveMap_->size);
+        a = OpenLibarchiveMemory(data, password);
+        if (!a) {
+            FreeArchiveMap(this);
+        }
+    }
+    if (!a) {
+        a = NewLibarchiveReader(password);
+        int r = ArchiveReadOpenFilename(a, path);
+        if (r != ARCHIVE_OK) {
+            archive_read_free(a);
+            return false;
+        }
     }
     archivePath_ = str::Dup(path);
     bool ok = ParseEntries(a, eagerLoad, cbProgress);
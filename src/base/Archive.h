@@ -6,6 +6,10 @@ enum class FileType : u8;
 struct archive;
 struct archive_entry;
 
+namespace file {
+struct Mapping;
+}
+
 // forward-declared so ArchiveExtractProgress below can reference
 // Archive::FileInfo, which is defined inside the class body.
 struct Archive;
@@ -75,6 +79,9 @@ struct Archive {
     Str archivePath_;
     // compressed bytes when opened from memory; kept so we can re-open for lazy extract
     Str archiveData_;
+    // large archives opened from a file for lazy extract are memory-mapped, so
+    // re-opening them for every extracted entry doesn't go through file i/o
+    file::Mapping* archiveMap_ = nullptr;
 
     // only set when we loaded file infos using unrar.dll fallback
     Str rarFilePath_;
@@ -95,6 +95,7 @@ FileHandle OpenReadOnly(Str path);
 
 // handle-based i/o, for files kept open across many reads / appends
 FileHandle OpenReadWrite(Str path, bool createIfMissing);
+FileHandle OpenWrite(Str path);
 void Close(FileHandle);
 i64 SeekEnd(FileHandle);
 bool WriteAll(FileHandle, Str data);
@@ -117,6 +118,12 @@ struct Mapping {
     void* hMapping = nullptr;
 };
 bool MemoryMap(Str path, Mapping*);
+// documents at least this big are memory-mapped by the engines instead of read
+// or opened with fopen. A mapped file can't be overwritten or truncated while
+// it's open, so this is kept well above the size of documents that get rebuilt
+// while being viewed (LaTeX output)
+constexpr i64 kMemoryMapMinFileSize = 128LL * 1024 * 1024;
+bool MemoryMapIfLarge(Str path, i64 minSize, Mapping*);
 void MemoryUnmap(Mapping*);
 bool Delete(Str path);
 bool DeleteFileToTrash(Str path);
@@ -899,6 +899,12 @@ FileHandle OpenReadWrite(Str path, bool createIfMissing) {
                        FILE_ATTRIBUTE_NORMAL, nullptr);
 }
 
+// Creates path, or truncates it if it exists, for streaming writes with WriteAll().
+FileHandle OpenWrite(Str path) {
+    return CreateFileW(CWStrTemp(path), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+                       nullptr);
+}
+
 void Close(FileHandle h) {
     if (h != kInvalidFileHandle && h != nullptr) {
         CloseHandle(h);
@@ -1107,6 +1113,21 @@ bool MemoryMap(Str path, Mapping* res) {
     return true;
 }
 
+// MemoryMap() but only for files of at least minSize bytes on a local fixed
+// drive. Smaller files are cheaper to read whole, and files on network,
+// removable or cloud-placeholder drives must be read: if the media goes away
+// while mapped, the next page fault crashes us (see MemoryMap()).
+bool MemoryMapIfLarge(Str path, i64 minSize, Mapping* res) {
+    if (!path || path::IsOnNetworkDrive(path) || !path::IsOnFixedDrive(path) || path::IsCloudPlaceholder(path)) {
+        return false;
+    }
+    i64 size = GetSize(path);
+    if (size < minSize || size <= 0) {
+        return false;
+    }
+    return MemoryMap(path, res);
+}
+
 void MemoryUnmap(Mapping* m) {
     if (m->data) {
         UnmapViewOfFile(m->data);
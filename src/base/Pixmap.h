@@ -49,6 +49,11 @@ struct Pixmap {
     float xres = 96.0f;
     float yres = 96.0f;
     u8* data = nullptr; // pixel buffer; owned by malloc, or by hbmp when DIB-section-backed
+    // from the pixmap pool (see PixmapPool.cpp): FreePixmap() puts it back there
+    bool pooled = false;
+    // size of the malloc()ed buffer of a pooled pixmap, which can be bigger than
+    // stride * height
+    i64 bufferSize = 0;
 
 #if OS_WIN
     // When non-null, the Pixmap is backed by a GDI DIB section: `data` is its pixels and
@@ -79,9 +84,39 @@ Pixmap* PixmapFromRenderedBitmap(RenderedBitmap* rb);
 RenderedBitmap* RenderedBitmapFromPixmap(Pixmap* px);
 void RecolorPixmap(Pixmap* px, Color textColor, Color bgColor, Color linkColor = 0, Vec<Rect>* skipRects = nullptr);
 
+// A DIB-section-backed BGRA8 pixmap for a renderer to draw a tile into, so
+// that it can be blitted as is. Freed tiles are recycled: the pixels are
+// whatever the previous tile left there.
+Pixmap* AllocTilePixmap(int w, int h);
+
 void FreePixmapNativeBitmap(Pixmap* p);
 #endif
 
+// Pixmaps the size of a rendered tile are allocated and freed all the time
+// while scrolling. Their buffers are recycled through a pool instead of going
+// back to the allocator: AllocPixmap() of a size in this range takes one from
+// the pool and FreePixmap() puts it back. See PixmapPool.cpp
+constexpr i64 kMinPooledPixmapBytes = 64 * 1024;
+constexpr i64 kMaxPooledPixmapBytes = 64 * 1024 * 1024;
+
+// nBytes is stride * h. Returns nullptr on OOM
+Pixmap* AllocPooledPixmap(int w, int h, int stride, i64 nBytes, PixmapFormat fmt);
+// returns false if p isn't pooled or can't be kept (then the caller frees it)
+bool PutPixmapInPool(Pixmap* p);
+// frees pooled pixmaps, oldest first, until the pool has at most maxBytes
+void TrimPixmapPool(i64 maxBytes);
+// how many bytes the pool can keep, 0 disables it
+void SetPixmapPoolMaxBytes(i64 maxBytes);
+
+struct PixmapPoolStats {
+    i64 nAllocs = 0; // AllocPixmap() / AllocTilePixmap() of a pooled size
+    i64 nReused = 0; // of those, taken from the pool
+    int nPooled = 0;
+    i64 pooledBytes = 0;
+    i64 maxBytes = 0;
+};
+PixmapPoolStats GetPixmapPoolStats();
+
 inline int PixmapBytesPerPixel(PixmapFormat fmt) {
     return fmt == PixmapFormat::BGR8 ? 3 : 4;
 }
@@ -91,6 +126,15 @@ inline i64 PixmapByteSize(const Pixmap* p) {
     return p ? (i64)p->width * (i64)p->height * 4 : 0;
 }
 
+// memory held by p: a pooled buffer is rounded up to its size class (or can
+// be a bigger one reused for a smaller tile)
+inline i64 PixmapAllocatedBytes(const Pixmap* p) {
+    if (p && p->pooled && p->bufferSize > 0) {
+        return p->bufferSize;
+    }
+    return PixmapByteSize(p);
+}
+
 // allocate a top-down Pixmap; data is uninitialized. returns nullptr on bad args / OOM.
 // Default for decode / generate / cache. On Windows, AllocPixmapDIB only when the
 // pixmap must be SelectObject'd or must adopt a GDI HBITMAP / Native DIB.
@@ -105,6 +149,13 @@ inline Pixmap* AllocPixmap(int w, int h, PixmapFormat fmt = PixmapFormat::BGRA8,
     if (stride > INT_MAX || nBytes / stride != (size_t)h) {
         return nullptr;
     }
+    if ((i64)nBytes >= kMinPooledPixmapBytes && (i64)nBytes <= kMaxPooledPixmapBytes) {
+        Pixmap* p = AllocPooledPixmap(w, h, (int)stride, (i64)nBytes, fmt);
+        if (p) {
+            p->premultiplied = premultiplied;
+        }
+        return p;
+    }
     u8* data = (u8*)malloc(nBytes);
     if (!data) {
         return nullptr;
@@ -130,6 +181,9 @@ inline void FreePixmap(Pixmap* p) {
     if (!p) {
         return;
     }
+    if (p->pooled && PutPixmapInPool(p)) {
+        return;
+    }
 #if OS_WIN
     if (p->hbmp) {
         FreePixmapNativeBitmap(p);
@@ -0,0 +1,193 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/Pixmap.h"
+
+// While scrolling, the render cache drops tiles as fast as the renderers make
+// new ones, and at a given zoom they come in a few sizes. Instead of going
+// through malloc / free (or CreateDIBSection / DeleteObject) for each, freed
+// tiles are kept here, oldest first, for the next render to reuse. Heap
+// buffers are matched by size class, DIB sections (whose size can't change)
+// by width and height.
+constexpr int kMaxPooledPixmaps = 64;
+#if IS_INTEL_32
+constexpr i64 kDefaultPixmapPoolMaxBytes = 48 * 1024 * 1024;
+#else
+constexpr i64 kDefaultPixmapPoolMaxBytes = 128 * 1024 * 1024;
+#endif
+
+static Mutex gPixmapPoolMutex;
+static Vec<Pixmap*> gPixmapPool;
+static i64 gPixmapPoolMaxBytes = kDefaultPixmapPoolMaxBytes;
+static PixmapPoolStats gPixmapPoolStats;
+
+// heap buffers are made in sizes with 4 steps per power of 2, so that one
+// can be reused for a tile a bit smaller than the one it was made for (tiles
+// at the edges of a page are cut to its size), wasting at most 1/4 of it
+static i64 PooledBufferSize(i64 n) {
+    i64 pow2 = 1;
+    while (pow2 * 2 <= n) {
+        pow2 *= 2;
+    }
+    i64 step = std::max(pow2 / 4, (i64)1);
+    return ((n + step - 1) / step) * step;
+}
+
+static bool IsDibPixmap(const Pixmap* p) {
+#if OS_WIN
+    return p->hbmp != nullptr;
+#else
+    (void)p;
+    return false;
+#endif
+}
+
+// the most recently pooled pixmap that fits, removed from the pool
+static Pixmap* TakePooledPixmap(bool dib, int w, int h, i64 bufferSize) {
+    ScopedMutex lock(&gPixmapPoolMutex);
+    gPixmapPoolStats.nAllocs++;
+    for (int i = len(gPixmapPool) - 1; i >= 0; i--) {
+        Pixmap* p = gPixmapPool[i];
+        if (IsDibPixmap(p) != dib) {
+            continue;
+        }
+        bool fits = dib ? (p->width == w && p->height == h) : (p->bufferSize == bufferSize);
+        if (!fits) {
+            continue;
+        }
+        gPixmapPool.RemoveAt(i);
+        gPixmapPoolStats.nPooled--;
+        gPixmapPoolStats.pooledBytes -= p->bufferSize;
+        gPixmapPoolStats.nReused++;
+        return p;
+    }
+    return nullptr;
+}
+
+// the previous user might have changed any of those
+static void ResetPooledPixmap(Pixmap* p, int w, int h, int stride, PixmapFormat fmt) {
+    p->width = w;
+    p->height = h;
+    p->stride = stride;
+    p->format = fmt;
+    p->premultiplied = false;
+    p->hasAlpha = false;
+    p->xres = 96.0f;
+    p->yres = 96.0f;
+}
+
+static void FreePooledPixmaps(Vec<Pixmap*>& pixmaps) {
+    for (Pixmap* p : pixmaps) {
+        p->pooled = false;
+        FreePixmap(p);
+    }
+}
+
+// must be called with gPixmapPoolMutex held. The pixmaps are freed by the
+// caller, outside of the lock
+static void RemoveOldestPooled(Vec<Pixmap*>& removed) {
+    Pixmap* p = gPixmapPool[0];
+    gPixmapPool.RemoveAt(0);
+    gPixmapPoolStats.nPooled--;
+    gPixmapPoolStats.pooledBytes -= p->bufferSize;
+    removed.Append(p);
+}
+
+Pixmap* AllocPooledPixmap(int w, int h, int stride, i64 nBytes, PixmapFormat fmt) {
+    i64 bufferSize = PooledBufferSize(nBytes);
+    Pixmap* p = TakePooledPixmap(false, w, h, bufferSize);
+    if (!p) {
+        u8* data = (u8*)malloc((size_t)bufferSize);
+        if (!data) {
+            // memory is tight: what's pooled is better used for this
+            TrimPixmapPool(0);
+            data = (u8*)malloc((size_t)bufferSize);
+        }
+        if (!data) {
+            return nullptr;
+        }
+        p = new Pixmap();
+        p->data = data;
+        p->bufferSize = bufferSize;
+        p->pooled = true;
+    }
+    ResetPooledPixmap(p, w, h, stride, fmt);
+    return p;
+}
+
+#if OS_WIN
+Pixmap* AllocTilePixmap(int w, int h) {
+    if (w <= 0 || h <= 0) {
+        return nullptr;
+    }
+    i64 nBytes = (i64)w * (i64)h * 4;
+    Pixmap* p = TakePooledPixmap(true, w, h, nBytes);
+    if (p) {
+        ResetPooledPixmap(p, w, h, w * 4, PixmapFormat::BGRA8);
+        return p;
+    }
+    p = AllocPixmapDIB(w, h);
+    if (p) {
+        p->pooled = true;
+        p->bufferSize = nBytes;
+    }
+    return p;
+}
+#endif
+
+bool PutPixmapInPool(Pixmap* p) {
+    // whoever took the HBITMAP (RenderedBitmapFromPixmap) owns the pixels now
+    if (!p || !p->pooled || !p->data) {
+        return false;
+    }
+#if OS_WIN
+    if (p->hbmp) {
+        // GDI might still have a batched blit from this bitmap pending
+        GdiFlush();
+    }
+#endif
+    i64 size = p->bufferSize;
+    Vec<Pixmap*> removed;
+    {
+        ScopedMutex lock(&gPixmapPoolMutex);
+        if (size > gPixmapPoolMaxBytes) {
+            return false;
+        }
+        while (len(gPixmapPool) > 0 && (len(gPixmapPool) >= kMaxPooledPixmaps ||
+                                         gPixmapPoolStats.pooledBytes + size > gPixmapPoolMaxBytes)) {
+            RemoveOldestPooled(removed);
+        }
+        gPixmapPool.Append(p);
+        gPixmapPoolStats.nPooled++;
+        gPixmapPoolStats.pooledBytes += size;
+    }
+    FreePooledPixmaps(removed);
+    return true;
+}
+
+void TrimPixmapPool(i64 maxBytes) {
+    Vec<Pixmap*> removed;
+    {
+        ScopedMutex lock(&gPixmapPoolMutex);
+        while (len(gPixmapPool) > 0 && gPixmapPoolStats.pooledBytes > maxBytes) {
+            RemoveOldestPooled(removed);
+        }
+    }
+    FreePooledPixmaps(removed);
+}
+
+void SetPixmapPoolMaxBytes(i64 maxBytes) {
+    {
+        ScopedMutex lock(&gPixmapPoolMutex);
+        gPixmapPoolMaxBytes = maxBytes;
+    }
+    TrimPixmapPool(maxBytes);
+}
+
+PixmapPoolStats GetPixmapPoolStats() {
+    ScopedMutex lock(&gPixmapPoolMutex);
+    PixmapPoolStats stats = gPixmapPoolStats;
+    stats.maxBytes = gPixmapPoolMaxBytes;
+    return stats;
+}
@@ -0,0 +1,589 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#if OS_WIN
+#include "base/Win.h"
+#else
+#include <unistd.h>
+#endif
+
+#if IS_INTEL_64 || IS_INTEL_32
+#include <immintrin.h>
+#define RESIZE_SIMD 1
+#else
+#define RESIZE_SIMD 0
+#endif
+
+// clang-cl and gcc only allow AVX2 intrinsics in functions compiled for AVX2;
+// cl.exe allows them anywhere
+#if RESIZE_SIMD && (COMPILER_CLANG || COMPILER_GCC)
+#define RESIZE_AVX2_FUNC __attribute__((target("avx2")))
+#else
+#define RESIZE_AVX2_FUNC
+#endif
+
+#include "base/Pixmap.h"
+#include "base/PixmapResize.h"
+
+// weights are fixed point with this many fractional bits: few enough for the
+// 16-bit multiplies of _mm_madd_epi16, even for Lanczos' weights above 1
+constexpr int kWeightBits = 14;
+constexpr int kRoundBias = 1 << (kWeightBits - 1);
+
+// below this many output pixels per thread, starting threads costs more
+// than it saves
+constexpr i64 kMinPixelsPerThread = 256 * 1024;
+constexpr int kMaxThreads = 8;
+
+static double FilterSupport(PixmapFilter filter) {
+    switch (filter) {
+        case PixmapFilter::Box:
+            return 0.5;
+        case PixmapFilter::Bilinear:
+            return 1.0;
+        default:
+            return 3.0;
+    }
+}
+
+static double Sinc(double x) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= 3.14159265358979323846;
+    return sin(x) / x;
+}
+
+static double FilterWeight(PixmapFilter filter, double x) {
+    switch (filter) {
+        case PixmapFilter::Box:
+            return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+        case PixmapFilter::Bilinear:
+            x = fabs(x);
+            return x < 1.0 ? 1.0 - x : 0.0;
+        default:
+            x = fabs(x);
+            return x < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+    }
+}
+
+// for each output pixel along one axis: the input pixels it's made of and
+// their weights
+struct ResizeCoeffs {
+    int maxTaps = 0;
+    Vec<int> starts;
+    Vec<int> counts;
+    // maxTaps per output pixel
+    Vec<i16> weights;
+};
+
+// in0 and in1 delimit the (fractional) part of the input that is scaled to
+// outSize pixels. Taps are clamped to [0, inSize) and renormalized
+static void ComputeCoeffs(ResizeCoeffs& c, PixmapFilter filter, int inSize, double in0, double in1, int outSize) {
+    double scale = (in1 - in0) / outSize;
+    // when reducing, the filter is stretched to cover all the input pixels
+    double filterScale = std::max(scale, 1.0);
+    double support = FilterSupport(filter) * filterScale;
+    c.maxTaps = ((int)ceil(support) * 2) + 1;
+    VecResize(c.starts, outSize);
+    VecResize(c.counts, outSize);
+    VecResize(c.weights, outSize * c.maxTaps);
+    Vec<double> k;
+    VecResize(k, c.maxTaps);
+    for (int i = 0; i < outSize; i++) {
+        double center = in0 + ((i + 0.5) * scale);
+        int first = std::max((int)floor(center - support + 0.5), 0);
+        int end = std::min((int)floor(center + support + 0.5), inSize);
+        int n = std::min(end - first, c.maxTaps);
+        double sum = 0;
+        for (int j = 0; j < n; j++) {
+            k[j] = FilterWeight(filter, (first + j - center + 0.5) / filterScale);
+            sum += k[j];
+        }
+        if (n <= 0 || sum == 0) {
+            // can't happen for a center inside the input, but be safe
+            first = std::clamp((int)center, 0, inSize - 1);
+            n = 1;
+            k[0] = 1.0;
+            sum = 1.0;
+        }
+        i16* w = &c.weights[i * c.maxTaps];
+        for (int j = 0; j < c.maxTaps; j++) {
+            double v = j < n ? (k[j] / sum) * (1 << kWeightBits) : 0.0;
+            w[j] = (i16)std::clamp((int)(v < 0 ? v - 0.5 : v + 0.5), -32768, 32767);
+        }
+        c.starts[i] = first;
+        c.counts[i] = n;
+    }
+}
+
+static int CoeffsEnd(const ResizeCoeffs& c) {
+    int res = 0;
+    for (int i = 0; i < len(c.starts); i++) {
+        res = std::max(res, c.starts[i] + c.counts[i]);
+    }
+    return res;
+}
+
+enum class ResizeImpl {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+struct ResizeCtx {
+    const Pixmap* src = nullptr;
+    ResizeImpl impl = ResizeImpl::Scalar;
+    ResizeCoeffs h;
+    ResizeCoeffs v;
+    // source columns [srcX0, srcX1) are read by the horizontal pass
+    int srcX0 = 0;
+    int srcX1 = 0;
+    // result of the horizontal pass: dst->width pixels wide, for source rows
+    // starting at tmpY0
+    u8* tmp = nullptr;
+    int tmpY0 = 0;
+    int tmpStride = 0;
+    Pixmap* dst = nullptr;
+};
+
+static u8 ClampToByte(int v) {
+    return (u8)std::clamp(v, 0, 255);
+}
+
+// source pixels [x0, x1) of row y as premultiplied BGRA8, converted into buf
+// if they aren't already. Without hasAlpha the alpha byte can be anything and
+// is taken as 255. A premultiplied BGRA8 row is used as is even then: the
+// color channels are filtered independently of the alpha one, whose result
+// is replaced by FixRowAlpha()
+static const u8* SrcRowBgraPremultiplied(const Pixmap* src, int y, int x0, int x1, u8* buf) {
+    int bpp = PixmapBytesPerPixel(src->format);
+    const u8* s = src->data + ((size_t)y * src->stride) + ((size_t)x0 * bpp);
+    if (src->format == PixmapFormat::BGRA8 && src->premultiplied) {
+        return s;
+    }
+    bool opaque = !src->hasAlpha || src->format == PixmapFormat::BGR8;
+    u8* d = buf;
+    for (int x = x0; x < x1; x++, s += bpp, d += 4) {
+        if (src->format == PixmapFormat::RGBA8) {
+            d[0] = s[2];
+            d[1] = s[1];
+            d[2] = s[0];
+        } else {
+            d[0] = s[0];
+            d[1] = s[1];
+            d[2] = s[2];
+        }
+        u8 a = opaque ? 255 : s[3];
+        d[3] = a;
+        if (a != 255 && !src->premultiplied) {
+            d[0] = (u8)(((d[0] * a) + 127) / 255);
+            d[1] = (u8)(((d[1] * a) + 127) / 255);
+            d[2] = (u8)(((d[2] * a) + 127) / 255);
+        }
+    }
+    return buf;
+}
+
+// row[0] is source pixel c.starts[0]
+static void HorizontalRowScalar(const ResizeCoeffs& c, const u8* row, int outW, u8* out) {
+    int x0 = c.starts[0];
+    for (int i = 0; i < outW; i++) {
+        const u8* s = row + ((size_t)(c.starts[i] - x0) * 4);
+        const i16* w = &c.weights[i * c.maxTaps];
+        int n = c.counts[i];
+        int b = kRoundBias, g = kRoundBias, r = kRoundBias, a = kRoundBias;
+        for (int j = 0; j < n; j++, s += 4) {
+            b += s[0] * w[j];
+            g += s[1] * w[j];
+            r += s[2] * w[j];
+            a += s[3] * w[j];
+        }
+        u8* d = out + ((size_t)i * 4);
+        d[0] = ClampToByte(b >> kWeightBits);
+        d[1] = ClampToByte(g >> kWeightBits);
+        d[2] = ClampToByte(r >> kWeightBits);
+        d[3] = ClampToByte(a >> kWeightBits);
+    }
+}
+
+// accumulators for a (w0, w1) pair of rows or pixels: multiply-adding [a0 b0
+// a1 b1 ..] 16-bit lanes by [w0 w1 w0 w1 ..] sums the pair in one instruction
+static u32 WeightPair(i16 w0, i16 w1) {
+    return ((u32)(u16)w1 << 16) | (u16)w0;
+}
+
+#if RESIZE_SIMD
+
+static void HorizontalRowSse2(const ResizeCoeffs& c, const u8* row, int outW, u8* out) {
+    int x0 = c.starts[0];
+    __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < outW; i++) {
+        const u8* s = row + ((size_t)(c.starts[i] - x0) * 4);
+        const i16* w = &c.weights[i * c.maxTaps];
+        int n = c.counts[i];
+        __m128i acc = _mm_set1_epi32(kRoundBias);
+        int j = 0;
+        for (; j + 1 < n; j += 2) {
+            // 2 pixels: [b0 g0 r0 a0 b1 g1 r1 a1] -> [b0 b1 g0 g1 r0 r1 a0 a1]
+            __m128i px = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(s + ((size_t)j * 4))), zero);
+            px = _mm_unpacklo_epi16(px, _mm_srli_si128(px, 8));
+            __m128i wv = _mm_set1_epi32((int)WeightPair(w[j], w[j + 1]));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, wv));
+        }
+        if (j < n) {
+            int last = 0;
+            memcpy(&last, s + ((size_t)j * 4), 4);
+            __m128i px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(last), zero);
+            px = _mm_unpacklo_epi16(px, zero);
+            __m128i wv = _mm_set1_epi32((int)WeightPair(w[j], 0));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, wv));
+        }
+        acc = _mm_srai_epi32(acc, kWeightBits);
+        acc = _mm_packs_epi32(acc, acc);
+        acc = _mm_packus_epi16(acc, acc);
+        int v = _mm_cvtsi128_si32(acc);
+        memcpy(out + ((size_t)i * 4), &v, 4);
+    }
+}
+
+#endif
+
+static void HorizontalRows(ResizeCtx* ctx, int row0, int row1) {
+    const Pixmap* src = ctx->src;
+    int outW = ctx->dst->width;
+    u8* buf = AllocArray<u8>((ctx->srcX1 - ctx->srcX0) * 4);
+    for (int r = row0; r < row1; r++) {
+        const u8* row = SrcRowBgraPremultiplied(src, ctx->tmpY0 + r, ctx->srcX0, ctx->srcX1, buf);
+        u8* out = ctx->tmp + ((size_t)r * ctx->tmpStride);
+#if RESIZE_SIMD
+        if (ctx->impl != ResizeImpl::Scalar) {
+            HorizontalRowSse2(ctx->h, row, outW, out);
+            continue;
+        }
+#endif
+        HorizontalRowScalar(ctx->h, row, outW, out);
+    }
+    free(buf);
+}
+
+// one output row of the vertical pass: a weighted sum of n rows, byte by byte
+struct VerticalRow {
+    const u8* const* rows = nullptr;
+    const i16* weights = nullptr;
+    int n = 0;
+    int nBytes = 0;
+    u8* out = nullptr;
+    // per byte accumulators for the scalar tail
+    int* acc = nullptr;
+};
+
+static void VerticalRowScalar(const VerticalRow& vr, int x0) {
+    int nBytes = vr.nBytes - x0;
+    if (nBytes <= 0) {
+        return;
+    }
+    int* acc = vr.acc;
+    for (int x = 0; x < nBytes; x++) {
+        acc[x] = kRoundBias;
+    }
+    for (int j = 0; j < vr.n; j++) {
+        const u8* s = vr.rows[j] + x0;
+        int w = vr.weights[j];
+        for (int x = 0; x < nBytes; x++) {
+            acc[x] += s[x] * w;
+        }
+    }
+    u8* d = vr.out + x0;
+    for (int x = 0; x < nBytes; x++) {
+        d[x] = ClampToByte(acc[x] >> kWeightBits);
+    }
+}
+
+#if RESIZE_SIMD
+
+// returns how many bytes (a multiple of 16) it did
+static int VerticalRowSse2(const VerticalRow& vr, int x0) {
+    __m128i zero = _mm_setzero_si128();
+    int x = x0;
+    for (; x + 16 <= vr.nBytes; x += 16) {
+        __m128i acc0 = _mm_set1_epi32(kRoundBias);
+        __m128i acc1 = acc0;
+        __m128i acc2 = acc0;
+        __m128i acc3 = acc0;
+        for (int j = 0; j < vr.n; j += 2) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(vr.rows[j] + x));
+            __m128i b = zero;
+            i16 wb = 0;
+            if (j + 1 < vr.n) {
+                b = _mm_loadu_si128((const __m128i*)(vr.rows[j + 1] + x));
+                wb = vr.weights[j + 1];
+            }
+            __m128i wv = _mm_set1_epi32((int)WeightPair(vr.weights[j], wb));
+            __m128i alo = _mm_unpacklo_epi8(a, zero);
+            __m128i ahi = _mm_unpackhi_epi8(a, zero);
+            __m128i blo = _mm_unpacklo_epi8(b, zero);
+            __m128i bhi = _mm_unpackhi_epi8(b, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), wv));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), wv));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), wv));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), wv));
+        }
+        acc0 = _mm_srai_epi32(acc0, kWeightBits);
+        acc1 = _mm_srai_epi32(acc1, kWeightBits);
+        acc2 = _mm_srai_epi32(acc2, kWeightBits);
+        acc3 = _mm_srai_epi32(acc3, kWeightBits);
+        __m128i lo = _mm_packs_epi32(acc0, acc1);
+        __m128i hi = _mm_packs_epi32(acc2, acc3);
+        _mm_storeu_si128((__m128i*)(vr.out + x), _mm_packus_epi16(lo, hi));
+    }
+    return x - x0;
+}
+
+// same as VerticalRowSse2 32 bytes at a time. The unpacks and packs work
+// within each 128-bit half, so the bytes come out in the order they went in
+RESIZE_AVX2_FUNC static int VerticalRowAvx2(const VerticalRow& vr, int x0) {
+    __m256i zero = _mm256_setzero_si256();
+    int x = x0;
+    for (; x + 32 <= vr.nBytes; x += 32) {
+        __m256i acc0 = _mm256_set1_epi32(kRoundBias);
+        __m256i acc1 = acc0;
+        __m256i acc2 = acc0;
+        __m256i acc3 = acc0;
+        for (int j = 0; j < vr.n; j += 2) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(vr.rows[j] + x));
+            __m256i b = zero;
+            i16 wb = 0;
+            if (j + 1 < vr.n) {
+                b = _mm256_loadu_si256((const __m256i*)(vr.rows[j + 1] + x));
+                wb = vr.weights[j + 1];
+            }
+            __m256i wv = _mm256_set1_epi32((int)WeightPair(vr.weights[j], wb));
+            __m256i alo = _mm256_unpacklo_epi8(a, zero);
+            __m256i ahi = _mm256_unpackhi_epi8(a, zero);
+            __m256i blo = _mm256_unpacklo_epi8(b, zero);
+            __m256i bhi = _mm256_unpackhi_epi8(b, zero);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(alo, blo), wv));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(alo, blo), wv));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(ahi, bhi), wv));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(ahi, bhi), wv));
+        }
+        acc0 = _mm256_srai_epi32(acc0, kWeightBits);
+        acc1 = _mm256_srai_epi32(acc1, kWeightBits);
+        acc2 = _mm256_srai_epi32(acc2, kWeightBits);
+        acc3 = _mm256_srai_epi32(acc3, kWeightBits);
+        __m256i lo = _mm256_packs_epi32(acc0, acc1);
+        __m256i hi = _mm256_packs_epi32(acc2, acc3);
+        _mm256_storeu_si256((__m256i*)(vr.out + x), _mm256_packus_epi16(lo, hi));
+    }
+    return x - x0;
+}
+
+#endif
+
+// Lanczos' negative lobes can ring a color above its alpha, which isn't a
+// valid premultiplied pixel, so colors are clamped to alpha. Without alpha,
+// alpha is 255 whatever the filter made of it
+static void FixRowAlpha(u8* row, int nPixels, bool hasAlpha, ResizeImpl impl) {
+    int x = 0;
+#if RESIZE_SIMD
+    if (impl != ResizeImpl::Scalar) {
+        __m128i alphaMask = _mm_set1_epi32((int)0xff000000);
+        for (; x + 4 <= nPixels; x += 4) {
+            __m128i* p = (__m128i*)(row + ((size_t)x * 4));
+            __m128i px = _mm_loadu_si128(p);
+            if (hasAlpha) {
+                // alpha in all 4 bytes of each pixel; min() leaves it as is
+                __m128i a = _mm_and_si128(px, alphaMask);
+                a = _mm_or_si128(a, _mm_srli_epi32(a, 8));
+                a = _mm_or_si128(a, _mm_srli_epi32(a, 16));
+                px = _mm_min_epu8(px, a);
+            } else {
+                px = _mm_or_si128(px, alphaMask);
+            }
+            _mm_storeu_si128(p, px);
+        }
+    }
+#else
+    (void)impl;
+#endif
+    for (; x < nPixels; x++) {
+        u8* d = row + ((size_t)x * 4);
+        if (!hasAlpha) {
+            d[3] = 255;
+            continue;
+        }
+        d[0] = std::min(d[0], d[3]);
+        d[1] = std::min(d[1], d[3]);
+        d[2] = std::min(d[2], d[3]);
+    }
+}
+
+static void VerticalRows(ResizeCtx* ctx, int row0, int row1) {
+    const ResizeCoeffs& c = ctx->v;
+    Pixmap* dst = ctx->dst;
+    VerticalRow vr;
+    vr.nBytes = dst->width * 4;
+    const u8** rows = AllocArray<const u8*>(c.maxTaps);
+    vr.rows = rows;
+    vr.acc = AllocArray<int>(vr.nBytes);
+    for (int y = row0; y < row1; y++) {
+        vr.n = c.counts[y];
+        vr.weights = &c.weights[y * c.maxTaps];
+        for (int j = 0; j < vr.n; j++) {
+            rows[j] = ctx->tmp + ((size_t)(c.starts[y] - ctx->tmpY0 + j) * ctx->tmpStride);
+        }
+        vr.out = dst->data + ((size_t)y * dst->stride);
+        int x = 0;
+#if RESIZE_SIMD
+        if (ctx->impl == ResizeImpl::Avx2) {
+            x += VerticalRowAvx2(vr, x);
+        }
+        if (ctx->impl != ResizeImpl::Scalar) {
+            x += VerticalRowSse2(vr, x);
+        }
+#endif
+        VerticalRowScalar(vr, x);
+        FixRowAlpha(vr.out, dst->width, dst->hasAlpha, ctx->impl);
+    }
+    free(vr.acc);
+    free((void*)rows);
+}
+
+using ResizeRowsFn = void (*)(ResizeCtx*, int, int);
+
+struct ResizeBand {
+    ResizeCtx* ctx = nullptr;
+    ResizeRowsFn fn = nullptr;
+    int row0 = 0;
+    int row1 = 0;
+    Mutex* mutex = nullptr;
+    ConditionVariable* done = nullptr;
+    int* nPending = nullptr;
+};
+
+static void RunResizeBand(ResizeBand* band) {
+    band->fn(band->ctx, band->row0, band->row1);
+    ScopedMutex scope(band->mutex);
+    (*band->nPending)--;
+    band->done->WakeAll();
+}
+
+// runs fn over rows [0, nRows) split in nThreads bands, one of them on this
+// thread, and waits for all of them
+static void RunInBands(ResizeCtx* ctx, ResizeRowsFn fn, int nRows, int nThreads) {
+    nThreads = std::clamp(nThreads, 1, std::max(nRows, 1));
+    if (nThreads == 1) {
+        fn(ctx, 0, nRows);
+        return;
+    }
+    Mutex mutex;
+    ConditionVariable done;
+    int nPending = nThreads - 1;
+    ResizeBand* bands = AllocArray<ResizeBand>(nThreads);
+    for (int i = 0; i < nThreads; i++) {
+        ResizeBand& band = bands[i];
+        band.ctx = ctx;
+        band.fn = fn;
+        band.row0 = (int)(((i64)nRows * i) / nThreads);
+        band.row1 = (int)(((i64)nRows * (i + 1)) / nThreads);
+        band.mutex = &mutex;
+        band.done = &done;
+        band.nPending = &nPending;
+    }
+    for (int i = 1; i < nThreads; i++) {
+        auto fnBand = MkFunc0<ResizeBand>(RunResizeBand, &bands[i]);
+        ThreadHandle thread = StartThread(fnBand, StrL("ResizePixmap"));
+        if (!thread) {
+            RunResizeBand(&bands[i]);
+            continue;
+        }
+        SafeCloseThreadHandle(&thread);
+    }
+    fn(ctx, bands[0].row0, bands[0].row1);
+    {
+        ScopedMutex scope(&mutex);
+        while (nPending > 0) {
+            done.Wait(&mutex);
+        }
+    }
+    free(bands);
+}
+
+static int ResizeThreadCount(i64 nPixels) {
+    int nCores = 1;
+#if OS_WIN
+    nCores = CpuCoreCount();
+#else
+    nCores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    i64 n = std::max(nPixels / kMinPixelsPerThread, (i64)1);
+    return (int)std::clamp(n, (i64)1, (i64)std::clamp(nCores, 1, kMaxThreads));
+}
+
+static ResizeImpl PickResizeImpl(PixmapResizeSimd simd) {
+#if RESIZE_SIMD
+    if (simd == PixmapResizeSimd::Best) {
+#if OS_WIN
+        static bool hasAvx2 = (CpuID() & kCpuAVX2) != 0;
+#else
+        static bool hasAvx2 = __builtin_cpu_supports("avx2");
+#endif
+        return hasAvx2 ? ResizeImpl::Avx2 : ResizeImpl::Sse2;
+    }
+    if (simd == PixmapResizeSimd::Sse2) {
+        return ResizeImpl::Sse2;
+    }
+#endif
+    return ResizeImpl::Scalar;
+}
+
+Pixmap* ResizePixmap(const Pixmap* src, int dstW, int dstH, const PixmapResizeArgs& args) {
+    if (!src || !src->data || src->width <= 0 || src->height <= 0 || dstW <= 0 || dstH <= 0) {
+        return nullptr;
+    }
+    if (src->format == PixmapFormat::Native) {
+        return nullptr;
+    }
+    RectF r = args.srcRect;
+    if (r.IsEmpty()) {
+        r = RectF(0, 0, (float)src->width, (float)src->height);
+    }
+    double x0 = std::max((double)r.x, 0.0);
+    double y0 = std::max((double)r.y, 0.0);
+    double x1 = std::min((double)r.x + r.dx, (double)src->width);
+    double y1 = std::min((double)r.y + r.dy, (double)src->height);
+    if (x1 <= x0 || y1 <= y0) {
+        return nullptr;
+    }
+
+    ResizeCtx ctx;
+    ctx.src = src;
+    ctx.impl = PickResizeImpl(args.simd);
+    ComputeCoeffs(ctx.h, args.filter, src->width, x0, x1, dstW);
+    ComputeCoeffs(ctx.v, args.filter, src->height, y0, y1, dstH);
+    ctx.srcX0 = ctx.h.starts[0];
+    ctx.srcX1 = CoeffsEnd(ctx.h);
+    ctx.tmpY0 = ctx.v.starts[0];
+    int tmpRows = CoeffsEnd(ctx.v) - ctx.tmpY0;
+    ctx.tmpStride = dstW * 4;
+    ctx.tmp = (u8*)malloc((size_t)ctx.tmpStride * (size_t)tmpRows);
+    ctx.dst = AllocPixmap(dstW, dstH, PixmapFormat::BGRA8, true);
+    if (!ctx.tmp || !ctx.dst) {
+        free(ctx.tmp);
+        FreePixmap(ctx.dst);
+        return nullptr;
+    }
+    ctx.dst->hasAlpha = src->hasAlpha && src->format != PixmapFormat::BGR8;
+
+    int nThreads = args.nThreads;
+    if (nThreads <= 0) {
+        i64 nPixels = std::max((i64)dstW * tmpRows, (i64)dstW * dstH);
+        nThreads = ResizeThreadCount(nPixels);
+    }
+    RunInBands(&ctx, HorizontalRows, tmpRows, nThreads);
+    RunInBands(&ctx, VerticalRows, dstH, nThreads);
+    free(ctx.tmp);
+    return ctx.dst;
+}
@@ -0,0 +1,38 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+// Resampling of a Pixmap to a different size, without any OS imaging API.
+// Separable (a horizontal then a vertical pass) with integer weights, so the
+// SIMD paths give the same bytes as the scalar one. Large images are split
+// into bands of rows resized on several threads.
+
+enum class PixmapFilter : u8 {
+    // average of the covered source pixels; fastest, good for big reductions
+    Box,
+    Bilinear,
+    // sharpest, the default for thumbnails and zoomed-out images
+    Lanczos3,
+};
+
+enum class PixmapResizeSimd {
+    Best,
+    Sse2,
+    Scalar,
+};
+
+struct PixmapResizeArgs {
+    PixmapFilter filter = PixmapFilter::Lanczos3;
+    // part of the source to resize (in source pixels, can be fractional).
+    // Empty means the whole source. Filter taps past it read the pixels
+    // around it (clamped to the source), so tiles of one image line up
+    RectF srcRect;
+    PixmapResizeSimd simd = PixmapResizeSimd::Best;
+    // 0: pick by image size and core count
+    int nThreads = 0;
+};
+
+// Returns a premultiplied BGRA8 pixmap of dstW x dstH (hasAlpha if src has it)
+// or nullptr for a Native / empty source or on OOM. Filtering is done on
+// premultiplied pixels so transparent pixels don't bleed their color. The
+// alpha of a src without hasAlpha is ignored and the result's is 255.
+Pixmap* ResizePixmap(const Pixmap* src, int dstW, int dstH, const PixmapResizeArgs& args = {});
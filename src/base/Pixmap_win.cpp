@@ -396,6 +396,17 @@ static bool SkipRecolorPixel(int x, int y, Vec<Rect>* skipRects) {
     return false;
 }
 
+static bool IsTopDownDIBSection(const Pixmap* px) {
+    if (!px->data || (px->format != PixmapFormat::BGRA8 && px->format != PixmapFormat::BGR8)) {
+        return false;
+    }
+    DIBSECTION ds{};
+    if (GetObject(px->hbmp, sizeof(ds), &ds) != sizeof(ds)) {
+        return false;
+    }
+    return ds.dsBmih.biHeight < 0;
+}
+
 static int Mul255(int a, int b) {
     int n = (a * b) + 128;
     n += n >> 8;
@@ -406,7 +417,9 @@ void RecolorPixmap(Pixmap* px, Color textColor, Color bgColor, Color linkColor,
     if (!px) {
         return;
     }
-    if (px->hbmp) {
+    // the pixels of a top-down 24 / 32bpp DIB section (tiles are) are recolored
+    // right where the renderer put them, like those of a heap pixmap
+    if (px->hbmp && !IsTopDownDIBSection(px)) {
         UpdateBitmapColors(px->hbmp, textColor, bgColor, linkColor, skipRects);
         return;
     }
@@ -416,6 +429,9 @@ void RecolorPixmap(Pixmap* px, Color textColor, Color bgColor, Color linkColor,
     if ((textColor & 0xffffff) == kColBlack && (bgColor & 0xffffff) == kColWhite && !linkColor && !skipRects) {
         return;
     }
+    if (px->hbmp) {
+        GdiFlush();
+    }
     byte linkR = 0, linkG = 0, linkB = 0;
     UnpackColor(linkColor, linkR, linkG, linkB);
     byte textR, textG, textB, bgR, bgG, bgB;
@@ -426,8 +442,14 @@ void RecolorPixmap(Pixmap* px, Color textColor, Color bgColor, Color linkColor,
     int bpp = PixmapBytesPerPixel(px->format);
     for (int y = 0; y < px->height; y++) {
         u8* pixel = px->data + ((size_t)y * px->stride);
+        bool rowHasSkips = false;
+        if (skipRects) {
+            for (Rect& r : *skipRects) {
+                rowHasSkips |= y >= r.y && y < r.y + r.dy;
+            }
+        }
         for (int x = 0; x < px->width; x++, pixel += bpp) {
-            if (SkipRecolorPixel(x, y, skipRects)) {
+            if (rowHasSkips && SkipRecolorPixel(x, y, skipRects)) {
                 continue;
             }
             int maxRG = pixel[2] > pixel[1] ? pixel[2] : pixel[1];
@@ -0,0 +1,118 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/RectIndex.h"
+
+// fewer rects are tested one by one
+constexpr int kRectIndexMinCount = 16;
+constexpr int kRectIndexMaxSide = 32;
+
+// cell of the grid column / row for v. Monotonic in v, so the cells of the
+// start and end of a rect cover the cells of all the points in it
+static int RectIndexCell(float v, float start, float size, int n) {
+    float f = (v - start) / size * (float)n;
+    if (!(f >= 0.f)) {
+        return 0;
+    }
+    if (f >= (float)n) {
+        return n - 1;
+    }
+    return (int)f;
+}
+
+void RectIndexReset(RectIndex& idx) {
+    idx.rects.Reset();
+    idx.cellStart.Reset();
+    idx.cellEls.Reset();
+    idx.bounds = {};
+    idx.nCols = 0;
+    idx.nRows = 0;
+}
+
+void RectIndexAdd(RectIndex& idx, RectF r) {
+    idx.rects.Append(r);
+    idx.bounds = idx.bounds.Union(r);
+}
+
+// counting sort of rect indexes into cells, with about 2 rects per cell
+void RectIndexBuild(RectIndex& idx) {
+    idx.cellStart.Reset();
+    idx.cellEls.Reset();
+    idx.nCols = 0;
+    idx.nRows = 0;
+    int n = len(idx.rects);
+    RectF b = idx.bounds;
+    if (n < kRectIndexMinCount || b.dx <= 0 || b.dy <= 0) {
+        return;
+    }
+    int side = (int)ceilf(sqrtf((float)n / 2.f));
+    side = std::clamp(side, 2, kRectIndexMaxSide);
+    int nCells = side * side;
+    idx.cellStart.AppendBlanks(nCells + 1);
+
+    // the first pass counts the rects in each cell, the second places them
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < n; i++) {
+            RectF r = idx.rects[i];
+            if (r.dx <= 0 || r.dy <= 0) {
+                // doesn't contain any point
+                continue;
+            }
+            int col0 = RectIndexCell(r.x, b.x, b.dx, side);
+            int col1 = RectIndexCell(r.x + r.dx, b.x, b.dx, side);
+            int row0 = RectIndexCell(r.y, b.y, b.dy, side);
+            int row1 = RectIndexCell(r.y + r.dy, b.y, b.dy, side);
+            for (int row = row0; row <= row1; row++) {
+                for (int col = col0; col <= col1; col++) {
+                    int cell = row * side + col;
+                    if (pass == 0) {
+                        idx.cellStart[cell + 1]++;
+                    } else {
+                        // cellStart[cell] is where the next one goes
+                        idx.cellEls[idx.cellStart[cell]++] = i;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (int cell = 0; cell < nCells; cell++) {
+                idx.cellStart[cell + 1] += idx.cellStart[cell];
+            }
+            idx.cellEls.AppendBlanks(idx.cellStart[nCells]);
+        }
+    }
+    // placing moved each cellStart[cell] to the start of the next cell
+    for (int cell = nCells; cell > 0; cell--) {
+        idx.cellStart[cell] = idx.cellStart[cell - 1];
+    }
+    idx.cellStart[0] = 0;
+    idx.nCols = side;
+    idx.nRows = side;
+}
+
+void RectIndexFind(const RectIndex& idx, PointF pt, Vec<int>& res) {
+    if (idx.nCols == 0) {
+        for (int i = 0; i < len(idx.rects); i++) {
+            if (idx.rects[i].Contains(pt)) {
+                res.Append(i);
+            }
+        }
+        return;
+    }
+
+    RectF b = idx.bounds;
+    if (!b.Contains(pt)) {
+        return;
+    }
+    int col = RectIndexCell(pt.x, b.x, b.dx, idx.nCols);
+    int row = RectIndexCell(pt.y, b.y, b.dy, idx.nRows);
+    int cell = row * idx.nCols + col;
+    // the indexes in a cell are in the order the rects were added
+    for (int k = idx.cellStart[cell]; k < idx.cellStart[cell + 1]; k++) {
+        int i = idx.cellEls[k];
+        if (idx.rects[i].Contains(pt)) {
+            res.Append(i);
+        }
+    }
+}
@@ -0,0 +1,25 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+// Finds the rects that contain a point (hit-testing the elements of a page).
+// Rects are identified by the order they were added in and are found in that
+// order. Once built, many rects are also bucketed in a grid over their bounds:
+// cellEls[cellStart[i]] .. cellEls[cellStart[i + 1] - 1] are the indexes of
+// the rects that overlap cell i, so a lookup only tests those.
+struct RectIndex {
+    Vec<RectF> rects;
+    RectF bounds;
+    int nCols = 0;
+    int nRows = 0;
+    Vec<int> cellStart;
+    Vec<int> cellEls;
+};
+
+void RectIndexReset(RectIndex&);
+void RectIndexAdd(RectIndex&, RectF);
+// builds the grid, after all the rects are added. Until then (and for few
+// rects) a lookup tests all of them
+void RectIndexBuild(RectIndex&);
+// appends the indexes of the rects that contain pt to res, in the order the
+// rects were added
+void RectIndexFind(const RectIndex&, PointF pt, Vec<int>& res);
@@ -0,0 +1,511 @@
+/* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/Dict.h"
+#include "base/File.h"
+#include "base/AppendStore.h"
+#include "base/SettingsUtil.h"
+#include "base/SettingsJournal.h"
+
+// an item as last written. Only a hash of its values is kept: serializing 10k
+// items on every save to find the one that changed is what we want to avoid
+struct SettingsJournalEntry {
+    Str key;
+    u64 hash = 0;
+};
+
+static bool EntryEq(const SettingsJournalEntry& a, const SettingsJournalEntry& b) {
+    return a.hash == b.hash && str::Eq(a.key, b.key);
+}
+
+static void FreeItem(SettingsJournal* j, void* item) {
+    if (j->freeItem) {
+        j->freeItem(item);
+    } else {
+        FreeStruct(j->itemInfo, item);
+    }
+}
+
+static void FreePersisted(SettingsJournal* j) {
+    if (j->persisted) {
+        for (SettingsJournalEntry& e : *j->persisted) {
+            str::Free(e.key);
+        }
+        delete j->persisted;
+        j->persisted = nullptr;
+    }
+}
+
+// keys alias the items
+static void ComputeEntries(SettingsJournal* j, Vec<void*>* items, Vec<SettingsJournalEntry>& out) {
+    for (void* item : *items) {
+        SettingsJournalEntry e;
+        e.key = j->getKey(item);
+        e.hash = HashStruct(j->itemInfo, item);
+        out.Append(e);
+    }
+}
+
+static void RememberPersisted(SettingsJournal* j, Vec<SettingsJournalEntry>& entries, Str rest) {
+    FreePersisted(j);
+    j->persisted = new Vec<SettingsJournalEntry>();
+    for (SettingsJournalEntry e : entries) {
+        e.key = str::Dup(e.key);
+        j->persisted->Append(e);
+    }
+    if (rest.s) {
+        j->persistedRestHash = MurmurHash2(rest);
+        j->persistedRestLen = rest.len;
+    }
+}
+
+static void OnJournalRecord(AppendStoreRecord* rec, Str, void* userData) {
+    auto records = (Vec<AppendStoreRecord*>*)userData;
+    records->Append(rec);
+}
+
+static bool OpenStore(SettingsJournal* j, Vec<AppendStoreRecord*>* records) {
+    j->store = AppendStore{};
+    j->store.dataDir = j->dir;
+    j->store.indexFileName = j->indexFileName;
+    j->store.dataFileName = j->dataFileName;
+    if (records) {
+        j->store.onRecord = OnJournalRecord;
+        j->store.userData = records;
+    }
+    j->isOpen = AppendStoreOpen(&j->store);
+    j->store.onRecord = nullptr;
+    j->store.userData = nullptr;
+    if (!j->isOpen) {
+        logf("SettingsJournal: %s\n", AppendStoreError(&j->store));
+        AppendStoreClose(&j->store);
+    }
+    return j->isOpen;
+}
+
+static void DeleteStoreFiles(SettingsJournal* j) {
+    file::Delete(path::JoinTemp(j->dir, j->indexFileName));
+    file::Delete(path::JoinTemp(j->dir, j->dataFileName));
+}
+
+void SettingsJournalClose(SettingsJournal* j) {
+    if (j->isOpen) {
+        AppendStoreClose(&j->store);
+    }
+    j->isOpen = false;
+    j->nRecords = 0;
+    j->seenIndexEnd = 0;
+    j->ownRecords.Reset();
+    FreePersisted(j);
+    j->persistedRestHash = 0;
+    j->persistedRestLen = -1;
+}
+
+// the items by key, so that replaying a record doesn't compare its key with
+// every item's. Records insert and remove items, which moves the others: an
+// item's position is found by its pointer
+struct ItemsByKey {
+    dict::MapStrToInt ids;
+    // indexed by id, null once removed
+    Vec<void*> items;
+
+    explicit ItemsByKey(int n) : ids(n * 2 + 16) {
+    }
+};
+
+static void IndexItem(SettingsJournal* j, ItemsByKey& idx, void* item) {
+    int id = len(idx.items);
+    int existingId = -1;
+    if (idx.ids.Insert(j->getKey(item), id, &existingId)) {
+        idx.items.Append(item);
+    } else if (existingId >= 0 && !idx.items[existingId]) {
+        idx.items[existingId] = item;
+    }
+    // an empty key can't be addressed by a record. Of repeated keys the first
+    // item is found
+}
+
+static void IndexItems(SettingsJournal* j, Vec<void*>* items, ItemsByKey& idx) {
+    for (void* item : *items) {
+        IndexItem(j, idx, item);
+    }
+}
+
+static void* FindItem(ItemsByKey& idx, Str key, int* idOut = nullptr) {
+    int id;
+    if (key.len == 0 || !idx.ids.Get(key, &id)) {
+        return nullptr;
+    }
+    if (idOut) {
+        *idOut = id;
+    }
+    return idx.items[id];
+}
+
+static void ReplayDel(SettingsJournal* j, Vec<void*>* items, ItemsByKey& idx, Str key) {
+    int id;
+    void* item = FindItem(idx, key, &id);
+    if (!item) {
+        return;
+    }
+    items->RemoveAt(items->Find(item));
+    idx.items[id] = nullptr;
+    FreeItem(j, item);
+}
+
+// item, deserialized from data, goes before the item with key before, or at the
+// end if there's none. If there's an item with the same key already, its values
+// are replaced instead and it is moved: the caller can hold pointers to it.
+// Returns the item that is now in items
+static void* ReplaySet(SettingsJournal* j, Vec<void*>* items, ItemsByKey& idx, void* item, Str data, Str before) {
+    void* existing = FindItem(idx, j->getKey(item));
+    if (existing) {
+        FreeItem(j, item);
+        ReplaceStructValues(j->itemInfo, existing, data);
+        items->RemoveAt(items->Find(existing));
+        item = existing;
+    } else {
+        IndexItem(j, idx, item);
+    }
+    void* next = FindItem(idx, before);
+    int pos = next ? items->Find(next) : -1;
+    items->InsertAt(pos >= 0 ? pos : len(*items), item);
+    return item;
+}
+
+static void ReplayRecord(SettingsJournal* j, Vec<void*>* items, ItemsByKey& idx, AppendStoreRecord* rec) {
+    if (str::Eq(rec->kind, StrL("del"))) {
+        ReplayDel(j, items, idx, rec->meta);
+    } else if (str::Eq(rec->kind, StrL("set"))) {
+        Str data = AppendStoreReadPayload(&j->store, rec);
+        if (data.s) {
+            ReplaySet(j, items, idx, DeserializeStruct(j->itemInfo, data), data, rec->meta);
+        }
+        str::Free(data);
+    }
+}
+
+static int FindLastBase(Vec<AppendStoreRecord*>& records) {
+    for (int i = len(records) - 1; i >= 0; i--) {
+        if (str::Eq(records[i]->kind, StrL("base"))) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void SetSeen(SettingsJournal* j, Vec<AppendStoreRecord*>& records) {
+    j->nRecords = len(records);
+    j->seenIndexEnd = len(records) > 0 ? records.Last()->indexOffset + 1 : 0;
+}
+
+// Applies the journal to items, as read from the settings file identified by
+// baseStamp. Returns the latest "rest" record (caller frees), null if there's none.
+// If the settings file was written by someone that didn't fold the journal into
+// it, the items records still apply but the file's rest is newer than ours
+Str SettingsJournalLoad(SettingsJournal* j, Vec<void*>* items, Str baseStamp) {
+    SettingsJournalClose(j);
+    Vec<AppendStoreRecord*> records;
+    if (!OpenStore(j, &records)) {
+        // most likely a torn write: nothing in it can be trusted
+        DeleteStoreFiles(j);
+        OpenStore(j, nullptr);
+        return {};
+    }
+    int base = FindLastBase(records);
+    if (base < 0) {
+        if (len(records) > 0) {
+            logf("SettingsJournal: dropping journal without a base\n");
+        }
+        AppendStoreClose(&j->store);
+        DeleteStoreFiles(j);
+        OpenStore(j, nullptr);
+        return {};
+    }
+    bool sameBase = str::Eq(records[base]->meta, baseStamp);
+    if (!sameBase) {
+        logf("SettingsJournal: settings file changed, keeping only the list changes\n");
+    }
+    SetSeen(j, records);
+
+    Str rest;
+    ItemsByKey idx(len(*items));
+    IndexItems(j, items, idx);
+    for (int i = base + 1; i < len(records); i++) {
+        AppendStoreRecord* rec = records[i];
+        if (str::Eq(rec->kind, StrL("rest"))) {
+            if (sameBase) {
+                str::Free(rest);
+                rest = AppendStoreReadPayload(&j->store, rec);
+            }
+            continue;
+        }
+        ReplayRecord(j, items, idx, rec);
+    }
+    // without the rest of the settings, SettingsJournalAppend() still refuses
+    Vec<SettingsJournalEntry> cur;
+    ComputeEntries(j, items, cur);
+    RememberPersisted(j, cur, {});
+    return rest;
+}
+
+// true if the item with key isn't what the settings file plus the journal hold.
+// persistedIds maps keys to their index in j->persisted
+static bool ChangedSincePersisted(SettingsJournal* j, ItemsByKey& idx, dict::MapStrToInt& persistedIds, Str key) {
+    void* item = FindItem(idx, key);
+    int i;
+    if (!persistedIds.Get(key, &i)) {
+        return item != nullptr;
+    }
+    return !item || HashStruct(j->itemInfo, item) != (*j->persisted)[i].hash;
+}
+
+static int FindPersisted(SettingsJournal* j, Str key) {
+    for (int i = 0; key.len > 0 && i < len(*j->persisted); i++) {
+        if (str::Eq((*j->persisted)[i].key, key)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// a record of another process was applied to the items, and is in the journal:
+// keep persisted in step so that our next append doesn't journal it again
+static void PersistedDel(SettingsJournal* j, Str key) {
+    int i = FindPersisted(j, key);
+    if (i >= 0) {
+        str::Free((*j->persisted)[i].key);
+        j->persisted->RemoveAt(i);
+    }
+}
+
+static void PersistedSet(SettingsJournal* j, void* item, Str before) {
+    SettingsJournalEntry e;
+    e.key = j->getKey(item);
+    e.hash = HashStruct(j->itemInfo, item);
+    PersistedDel(j, e.key);
+    int pos = FindPersisted(j, before);
+    e.key = str::Dup(e.key);
+    j->persisted->InsertAt(pos >= 0 ? pos : len(*j->persisted), e);
+}
+
+// Applies to items the records other processes appended since it was loaded or
+// last synced, unless we changed the same item since. Call it before a full
+// write, which otherwise throws their changes away with the journal, and when
+// the journal changes, to show them.
+// Their "rest" records lose to ours, as with a full write.
+// Items are updated in place, so pointers to them stay valid. A removed item
+// is freed unless isItemInUse() says it's still used; then it's kept.
+// Returns how many items were replaced or removed
+int SettingsJournalSync(SettingsJournal* j, Vec<void*>* items) {
+    if (!j->isOpen || !j->persisted) {
+        return 0;
+    }
+    AppendStoreClose(&j->store);
+    Vec<AppendStoreRecord*> records;
+    if (!OpenStore(j, &records)) {
+        return 0;
+    }
+    int base = FindLastBase(records);
+    ItemsByKey idx(len(*items));
+    IndexItems(j, items, idx);
+    dict::MapStrToInt persistedIds(len(*j->persisted) * 2 + 16);
+    for (int i = 0; i < len(*j->persisted); i++) {
+        persistedIds.Insert((*j->persisted)[i].key, i);
+    }
+    // newest first, so that only the last change to an item counts
+    dict::MapStrToInt changedKeys;
+    Vec<AppendStoreRecord*> toApply;
+    // for "set" records the deserialized item and its data, null for "del"
+    Vec<void*> toApplyItems;
+    Vec<Str> toApplyData;
+    for (int i = len(records) - 1; i > base && records[i]->indexOffset >= j->seenIndexEnd; i--) {
+        AppendStoreRecord* rec = records[i];
+        bool isDel = str::Eq(rec->kind, StrL("del"));
+        if (!isDel && !str::Eq(rec->kind, StrL("set"))) {
+            continue;
+        }
+        void* item = nullptr;
+        Str data;
+        Str key = rec->meta;
+        if (!isDel) {
+            data = AppendStoreReadPayload(&j->store, rec);
+            if (!data.s) {
+                continue;
+            }
+            item = DeserializeStruct(j->itemInfo, data);
+            key = j->getKey(item);
+        }
+        bool isLast = changedKeys.Insert(key, i);
+        // our own changes, journaled or not yet saved, are already in items
+        bool isOurs = j->ownRecords.Contains(rec->indexOffset) || ChangedSincePersisted(j, idx, persistedIds, key);
+        // freeing it would leave the caller with a dangling pointer. Once no
+        // longer used it's likely changed, and journaled again, anyway
+        void* toDel = isDel ? FindItem(idx, key) : nullptr;
+        bool inUse = toDel && j->isItemInUse && j->isItemInUse(toDel);
+        if (!isLast || isOurs || inUse) {
+            if (item) {
+                FreeItem(j, item);
+            }
+            str::Free(data);
+            continue;
+        }
+        toApply.Append(rec);
+        toApplyItems.Append(item);
+        toApplyData.Append(data);
+    }
+    for (int i = len(toApply) - 1; i >= 0; i--) {
+        Str meta = toApply[i]->meta;
+        if (toApplyItems[i]) {
+            void* item = ReplaySet(j, items, idx, toApplyItems[i], toApplyData[i], meta);
+            str::Free(toApplyData[i]);
+            PersistedSet(j, item, meta);
+        } else {
+            ReplayDel(j, items, idx, meta);
+            PersistedDel(j, meta);
+        }
+    }
+    SetSeen(j, records);
+    return len(toApply);
+}
+
+struct SettingsJournalChange {
+    bool isDelete = false;
+    // index into cur of the item to set
+    int pos = 0;
+    Str key;
+    // key of the item that follows it, empty if it's the last
+    Str before;
+};
+
+static bool IsValidKey(Str key) {
+    return key.len > 0 && str::IndexOfChar(key, '\n') < 0 && str::IndexOfChar(key, '\r') < 0;
+}
+
+// the edits that turn the persisted list into cur. Records address items by key,
+// not by position, so that records of other processes replay in any order.
+// false if a full write is the better deal
+static bool DiffEntries(SettingsJournal* j, Vec<SettingsJournalEntry>& cur, Vec<SettingsJournalChange>& changes) {
+    dict::MapStrToInt curKeys(len(cur) * 2 + 16);
+    for (int i = 0; i < len(cur); i++) {
+        // an empty or repeated key can't be addressed by a record, nor one that
+        // doesn't fit on an index line
+        if (!IsValidKey(cur[i].key) || !curKeys.Insert(cur[i].key, i)) {
+            return false;
+        }
+    }
+    Vec<SettingsJournalEntry> sim;
+    for (SettingsJournalEntry& e : *j->persisted) {
+        sim.Append(e);
+    }
+    // back to front so that earlier deletes don't shift later positions
+    for (int i = len(sim) - 1; i >= 0; i--) {
+        int ignore;
+        if (!curKeys.Get(sim[i].key, &ignore)) {
+            changes.Append({true, i, sim[i].key, {}});
+            sim.RemoveAt(i);
+        }
+    }
+    // sim[0..i) matches cur[0..i) after each step. Moving a file to the front of
+    // the history (the common case) is a single set before the previous first
+    for (int i = 0; i < len(cur); i++) {
+        if (i < len(sim) && EntryEq(sim[i], cur[i])) {
+            continue;
+        }
+        if (len(changes) >= j->maxChangesPerAppend) {
+            return false;
+        }
+        for (int k = i; k < len(sim); k++) {
+            if (str::Eq(sim[k].key, cur[i].key)) {
+                sim.RemoveAt(k);
+                break;
+            }
+        }
+        sim.InsertAt(i, cur[i]);
+        Str before = i + 1 < len(sim) ? sim[i + 1].key : Str{};
+        changes.Append({false, i, cur[i].key, before});
+    }
+    return len(changes) <= j->maxChangesPerAppend;
+}
+
+static bool AppendRecord(SettingsJournal* j, AppendStoreMode mode, Str kind, Str meta, Str data) {
+    AppendStoreAppendOptions opts;
+    opts.mode = mode;
+    opts.kind = kind;
+    opts.meta = meta;
+    opts.data = data;
+    AppendStoreRecord* rec = nullptr;
+    if (!AppendStoreAppend(&j->store, opts, &rec)) {
+        logf("SettingsJournal: %s\n", AppendStoreError(&j->store));
+        return false;
+    }
+    j->ownRecords.Append(rec->indexOffset);
+    j->nRecords++;
+    return true;
+}
+
+// Appends records for what changed since the last full write or append.
+// rest is the serialized settings minus the list.
+// false means nothing usable was written: do a full write and SettingsJournalReset()
+bool SettingsJournalAppend(SettingsJournal* j, Vec<void*>* items, Str rest) {
+    if (!j->isOpen || !j->persisted || j->persistedRestLen < 0) {
+        return false;
+    }
+    Vec<SettingsJournalEntry> cur;
+    ComputeEntries(j, items, cur);
+    Vec<SettingsJournalChange> changes;
+    if (!DiffEntries(j, cur, changes)) {
+        return false;
+    }
+    bool restChanged = rest.s && (rest.len != j->persistedRestLen || MurmurHash2(rest) != j->persistedRestHash);
+    int nNew = len(changes) + (restChanged ? 1 : 0);
+    if (nNew == 0) {
+        return true;
+    }
+    if (j->nRecords + nNew > j->maxRecords) {
+        return false;
+    }
+
+    // from here on a failure leaves a journal that doesn't match memory, which
+    // is fine as long as the caller follows up with a full write
+    if (restChanged && !AppendRecord(j, AppendStoreMode::DataFile, StrL("rest"), {}, rest)) {
+        return false;
+    }
+    for (SettingsJournalChange& c : changes) {
+        if (c.isDelete) {
+            if (!AppendRecord(j, AppendStoreMode::Inline, StrL("del"), c.key, {})) {
+                return false;
+            }
+            continue;
+        }
+        Str data = SerializeStruct(j->itemInfo, (*items)[c.pos]);
+        bool ok = AppendRecord(j, AppendStoreMode::DataFile, StrL("set"), c.before, data);
+        str::Free(data);
+        if (!ok) {
+            return false;
+        }
+    }
+    RememberPersisted(j, cur, restChanged ? rest : Str{});
+    return true;
+}
+
+// Starts an empty journal on top of a just written settings file identified by
+// baseStamp, whose list is items and the rest of which serializes to rest.
+bool SettingsJournalReset(SettingsJournal* j, Vec<void*>* items, Str rest, Str baseStamp) {
+    SettingsJournalClose(j);
+    // if another process still has them open deleting fails; the new "base"
+    // record then supersedes everything before it
+    DeleteStoreFiles(j);
+    if (!OpenStore(j, nullptr)) {
+        return false;
+    }
+    if (!AppendRecord(j, AppendStoreMode::Inline, StrL("base"), baseStamp, {})) {
+        SettingsJournalClose(j);
+        return false;
+    }
+    Vec<SettingsJournalEntry> cur;
+    ComputeEntries(j, items, cur);
+    RememberPersisted(j, cur, rest);
+    return true;
+}
@@ -0,0 +1,72 @@
+/* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+/*
+Incremental persistence for a settings file whose bulk is one list of structs
+identified by a string key (FileStates, identified by FilePath).
+
+Instead of re-serializing and rewriting the whole file on every save, changes
+since the last full write are appended to an AppendStore next to it:
+
+  base <stamp>   the full write this journal applies to (e.g. size + mtime)
+  rest           the settings minus the list, whenever that part changed
+  set [<key>]    one serialized item; replaces the item with the same key (if
+                 any) and goes before the item with <key>, or last
+  del <key>      the item with <key> was removed
+
+Records name items by key, not by position, so they stay valid when several
+processes append to the same journal and when the settings file changes under
+it. If its base doesn't match the settings file (edited by hand, a version
+without journal support) only the "rest" records are dropped on load.
+
+SettingsJournalSync() picks up what other processes journaled, updating the
+items in place. Call it when the journal's index file changes and before a full
+write. The full write starts a new journal with SettingsJournalReset(), which
+is also what compacts it: SettingsJournalAppend() refuses once a save would
+change too many items or the journal has grown too long.
+
+Needs base/AppendStore.h and base/SettingsUtil.h.
+*/
+
+using SettingsJournalKeyFn = Str (*)(const void* item);
+using SettingsJournalFreeFn = void (*)(void* item);
+using SettingsJournalInUseFn = bool (*)(const void* item);
+
+struct SettingsJournalEntry;
+
+struct SettingsJournal {
+    // set by the caller before SettingsJournalLoad()
+    const StructInfo* itemInfo = nullptr;
+    SettingsJournalKeyFn getKey = nullptr;
+    // defaults to FreeStruct(itemInfo, item)
+    SettingsJournalFreeFn freeItem = nullptr;
+    // optional: true if the caller holds pointers to item, which
+    // SettingsJournalSync() then doesn't remove
+    SettingsJournalInUseFn isItemInUse = nullptr;
+    Str dir;
+    Str indexFileName;
+    Str dataFileName;
+    // a save that changes more items than this is cheaper as a full write
+    int maxChangesPerAppend = 64;
+    // past this many records the next save is a full write (compaction)
+    int maxRecords = 512;
+
+    AppendStore store;
+    bool isOpen = false;
+    int nRecords = 0;
+    // records before this index offset were already applied
+    i64 seenIndexEnd = 0;
+    // index offsets of the records we appended
+    Vec<i64> ownRecords;
+    // what the settings file plus the journal hold. The rest is only known
+    // after SettingsJournalReset(): until then every SettingsJournalAppend() fails
+    Vec<SettingsJournalEntry>* persisted = nullptr;
+    u32 persistedRestHash = 0;
+    int persistedRestLen = -1;
+};
+
+Str SettingsJournalLoad(SettingsJournal* j, Vec<void*>* items, Str baseStamp);
+int SettingsJournalSync(SettingsJournal* j, Vec<void*>* items);
+bool SettingsJournalAppend(SettingsJournal* j, Vec<void*>* items, Str rest);
+bool SettingsJournalReset(SettingsJournal* j, Vec<void*>* items, Str rest, Str baseStamp);
+void SettingsJournalClose(SettingsJournal* j);
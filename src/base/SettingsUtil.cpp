@@ -611,6 +611,95 @@ static void* DeserializeStructRec(const StructInfo* info, SquareTreeNode* node,
     return base;
 }
 
+static u64 HashBytes(u64 h, const void* data, int n) {
+    const u8* d = (const u8*)data;
+    for (int i = 0; i < n; i++) {
+        h = (h ^ d[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+static u64 HashStr(u64 h, Str s) {
+    // distinguishes a null string (not serialized) from an empty one
+    int n = s.s ? s.len : -1;
+    h = HashBytes(h, &n, sizeof(n));
+    return HashBytes(h, s.s, s.len);
+}
+
+static u64 HashStructRec(u64 h, const StructInfo* info, const u8* base) {
+    for (size_t i = 0; i < info->fieldCount; i++) {
+        const FieldInfo& field = info->fields[i];
+        const u8* fieldPtr = base + field.offset;
+        switch (field.type) {
+            case SettingType::Struct:
+            case SettingType::Compact:
+                h = HashStructRec(h, GetSubstruct(field), fieldPtr);
+                break;
+            case SettingType::StructPtr: {
+                const u8* sub = *(const u8* const*)fieldPtr;
+                u8 isSet = sub ? 1 : 0;
+                h = HashBytes(h, &isSet, 1);
+                if (sub) {
+                    h = HashStructRec(h, GetSubstruct(field), sub);
+                }
+                break;
+            }
+            case SettingType::Array: {
+                Vec<void*>* array = *(Vec<void*>**)fieldPtr;
+                int n = array ? len(*array) : 0;
+                h = HashBytes(h, &n, sizeof(n));
+                for (int j = 0; j < n; j++) {
+                    h = HashStructRec(h, GetSubstruct(field), (const u8*)(*array)[j]);
+                }
+                break;
+            }
+            case SettingType::Bool:
+                h = HashBytes(h, fieldPtr, sizeof(bool));
+                break;
+            case SettingType::Int:
+            case SettingType::Float:
+                h = HashBytes(h, fieldPtr, sizeof(int));
+                break;
+            case SettingType::String:
+                h = HashStr(h, *(const Str*)fieldPtr);
+                break;
+            case SettingType::Color:
+                h = HashStr(h, ((const ParsedColor*)fieldPtr)->s);
+                break;
+            case SettingType::FloatArray:
+            case SettingType::IntArray: {
+                Vec<int>* array = *(Vec<int>**)fieldPtr;
+                int n = array ? len(*array) : 0;
+                h = HashBytes(h, &n, sizeof(n));
+                if (n > 0) {
+                    h = HashBytes(h, array->els, n * sizeofi(int));
+                }
+                break;
+            }
+            case SettingType::ColorArray:
+            case SettingType::StringArray: {
+                Vec<Str>* array = *(Vec<Str>**)fieldPtr;
+                int n = array ? len(*array) : 0;
+                h = HashBytes(h, &n, sizeof(n));
+                for (int j = 0; j < n; j++) {
+                    h = HashStr(h, (*array)[j]);
+                }
+                break;
+            }
+            case SettingType::Comment:
+                break;
+        }
+    }
+    return h;
+}
+
+// A fingerprint of the values SerializeStruct() would write for strct, without
+// formatting them. Changes whenever the serialization does (and then some, e.g.
+// for session-only array elements), so equal hashes mean "no need to save"
+u64 HashStruct(const StructInfo* info, const void* strct) {
+    return HashStructRec(14695981039346656037ull, info, (const u8*)strct);
+}
+
 Str SerializeStruct(const StructInfo* info, const void* strct, Str prevData) {
     str::Builder out;
     out.Append(Str(UTF8_BOM));
@@ -627,6 +716,15 @@ void* DeserializeStruct(const StructInfo* info, Str data, void* strct) {
     return res;
 }
 
+// like DeserializeStruct() into a new struct, but into strct: fields missing
+// from data are reset to their defaults. Pointers to strct stay valid and what
+// isn't described by info (fields not saved in settings) is left alone
+void ReplaceStructValues(const StructInfo* info, void* strct, Str data) {
+    SquareTreeNode* root = ParseSquareTree(data);
+    DeserializeStructRec(info, root, (u8*)strct, true);
+    delete root;
+}
+
 static void FreeStructData(const StructInfo* info, u8* base) {
     for (size_t i = 0; i < info->fieldCount; i++) {
         const FieldInfo& field = info->fields[i];
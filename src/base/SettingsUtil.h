@@ -72,4 +72,6 @@ struct StructInfo {
 
 Str SerializeStruct(const StructInfo* info, const void* strct, Str prevData = {});
 void* DeserializeStruct(const StructInfo* info, Str data, void* strct = nullptr);
+void ReplaceStructValues(const StructInfo* info, void* strct, Str data);
 void FreeStruct(const StructInfo* info, void* strct);
+u64 HashStruct(const StructInfo* info, const void* strct);
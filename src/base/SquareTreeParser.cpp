@@ -154,15 +154,109 @@ static void FreeDataItem(SquareTreeNode::DataItem* item) {
     Free(nullptr, item);
 }
 
+// nodes with fewer items (e.g. a FileState) are cheaper to scan than to hash
+constexpr int kMinIndexedItems = 32;
+
+// One slot per distinct (case-insensitive) key holds its first item; items with
+// equal keys are chained in data order, so both the first lookup and each
+// "continue after *startIdx" step of a list walk are O(1) on average.
+struct SquareTreeIndex {
+    int nItems = 0;
+    u32 mask = 0;
+    // per slot: first item with that key, -1 if the slot is empty
+    int* heads = nullptr;
+    u32* hashes = nullptr;
+    // per item: next item with the same key, -1 at the end of the chain
+    int* next = nullptr;
+};
+
+// must agree with str::EqI(), which only folds ASCII
+static u32 HashKeyI(Str key) {
+    u32 h = 2166136261u;
+    for (int i = 0; i < key.len; i++) {
+        u8 c = (u8)key.s[i];
+        if ('A' <= c && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        h = (h ^ c) * 16777619u;
+    }
+    return h;
+}
+
+static void FreeIndex(SquareTreeIndex* idx) {
+    if (!idx) {
+        return;
+    }
+    free(idx->heads);
+    free(idx->hashes);
+    free(idx->next);
+    delete idx;
+}
+
+// returns the slot for key: either the one holding it or the empty one where it belongs
+static u32 FindSlot(const SquareTreeNode* node, const SquareTreeIndex* idx, Str key, u32 h) {
+    u32 slot = h & idx->mask;
+    while (idx->heads[slot] >= 0) {
+        if (idx->hashes[slot] == h && str::EqI(key, node->data[idx->heads[slot]]->key)) {
+            break;
+        }
+        slot = (slot + 1) & idx->mask;
+    }
+    return slot;
+}
+
+static SquareTreeIndex* BuildIndex(const SquareTreeNode* node) {
+    int n = len(node->data);
+    u32 nSlots = 32;
+    while (nSlots < (u32)n * 2) {
+        nSlots *= 2;
+    }
+    auto idx = new SquareTreeIndex();
+    idx->nItems = n;
+    idx->mask = nSlots - 1;
+    idx->heads = AllocArray<int>(nSlots);
+    idx->hashes = AllocArray<u32>(nSlots);
+    idx->next = AllocArray<int>(n);
+    memset(idx->heads, 0xff, nSlots * sizeof(int));
+    // walk backwards so that each new item becomes the head of its chain
+    for (int i = n - 1; i >= 0; i--) {
+        u32 h = HashKeyI(node->data[i]->key);
+        u32 slot = FindSlot(node, idx, node->data[i]->key, h);
+        idx->next[i] = idx->heads[slot];
+        idx->heads[slot] = i;
+        idx->hashes[slot] = h;
+    }
+    return idx;
+}
+
+static const SquareTreeIndex* GetIndex(const SquareTreeNode* node) {
+    int n = len(node->data);
+    if (n < kMinIndexedItems) {
+        return nullptr;
+    }
+    // the parser and callers append to data directly, so catch up with growth
+    if (node->index && node->index->nItems != n) {
+        FreeIndex(node->index);
+        node->index = nullptr;
+    }
+    if (!node->index) {
+        node->index = BuildIndex(node);
+    }
+    return node->index;
+}
+
 SquareTreeNode::~SquareTreeNode() {
     for (int i = 0; i < len(data); i++) {
         FreeDataItem(data[i]);
     }
+    FreeIndex(index);
 }
 
 void SquareTreeNode::RemoveDataAt(int idx) {
     FreeDataItem(data[idx]);
     data.RemoveAt(idx);
+    FreeIndex(index);
+    index = nullptr;
 }
 
 // wantChild: match items with a child node; otherwise match value items (no child).
@@ -170,6 +264,28 @@ void SquareTreeNode::RemoveDataAt(int idx) {
 static SquareTreeNode::DataItem* FindDataItem(const SquareTreeNode* node, Str key, bool wantChild, int* startIdx) {
     int start = startIdx ? *startIdx : 0;
     int n = len(node->data);
+    const SquareTreeIndex* idx = GetIndex(node);
+    if (idx && (start == 0 || (start <= n && str::EqI(key, node->data[start - 1]->key)))) {
+        int i;
+        if (start == 0) {
+            u32 slot = FindSlot(node, idx, key, HashKeyI(key));
+            i = idx->heads[slot];
+        } else {
+            // continuing a walk over a list: the previous match links to the next
+            i = idx->next[start - 1];
+        }
+        for (; i >= 0; i = idx->next[i]) {
+            SquareTreeNode::DataItem* item = node->data[i];
+            if (wantChild != (item->child != nullptr)) {
+                continue;
+            }
+            if (startIdx) {
+                *startIdx = i + 1;
+            }
+            return item;
+        }
+        return nullptr;
+    }
     for (int i = start; i < n; i++) {
         SquareTreeNode::DataItem* item = node->data[i];
         if (!str::EqI(key, item->key)) {
@@ -15,6 +15,9 @@ struct SquareTreeNode {
         SquareTreeNode* child = nullptr;
     };
     Vec<DataItem*> data;
+    // hashed key -> item lookup for nodes with many items (e.g. the FileStates
+    // list); built lazily by GetValue / GetChild and dropped when data shrinks
+    mutable struct SquareTreeIndex* index = nullptr;
 
     void RemoveDataAt(int idx);
 
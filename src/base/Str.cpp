@@ -714,6 +714,32 @@ Str ToLower(Str s) {
     return ToLowerInPlace(s2);
 }
 
+Str FoldCase(Arena* a, Str s) {
+    bool isAscii = true;
+    for (int i = 0; i < s.len; i++) {
+        if ((u8)s.s[i] >= 0x80) {
+            isAscii = false;
+            break;
+        }
+    }
+    if (isAscii) {
+        Str res = str::Dup(a, s);
+        for (int i = 0; i < res.len; i++) {
+            res.s[i] = (char)tolower(res.s[i]);
+        }
+        return res;
+    }
+    Arena* temp = GetTempArena();
+    ArenaSavepoint scratch = GetArenaSavepoint(temp);
+    WStr ws = ToWStrTemp(s);
+    FoldCaseWInPlace(ws);
+    Str res = ToUtf8(a, ws);
+    if (a != temp) {
+        RestoreArenaSavepoint(scratch);
+    }
+    return res;
+}
+
 // Note: I tried an optimization: return (unsigned)(c - '0') < 10;
 // but it seems to mis-compile in release builds
 bool IsDigit(char c) {
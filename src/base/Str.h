@@ -88,6 +88,9 @@ bool EqNIx(Str s, int n, Str s2);
 Str ToLowerInPlace(Str s);
 
 Str ToLower(Str s);
+// folded the way IndexOfI() folds, so that many case-insensitive matches
+// against the same text can fold it once and use IndexOf()
+Str FoldCase(Arena* a, Str s);
 
 Str ToUpperInPlace(Str s);
 
@@ -2,6 +2,7 @@
    License: Simplified BSD (see COPYING.BSD) */
 
 #include "base/Base.h"
+#include "base/Trace.h"
 
 #if OS_WIN
 #include "base/WinDynCalls.h"
@@ -37,6 +38,7 @@ void SetThreadName(Str threadName, ThreadId threadId) {
     if (!threadName) {
         return;
     }
+    TraceSetThreadName(threadName, threadId);
     if (DynSetThreadDescription && threadId == 0) {
         WCHAR* ws = CWStrTemp(threadName);
         DynSetThreadDescription(GetCurrentThread(), ws);
@@ -61,7 +63,11 @@ void SetThreadName(Str threadName, ThreadId threadId) {
 
 #elif OS_WIN
 
-void SetThreadName(Str, ThreadId) {}
+void SetThreadName(Str threadName, ThreadId threadId) {
+    if (threadName) {
+        TraceSetThreadName(threadName, threadId);
+    }
+}
 
 #else
 
@@ -81,6 +87,7 @@ void SetThreadName(Str threadName, ThreadId threadId) {
     if (!threadName) {
         return;
     }
+    TraceSetThreadName(threadName, threadId);
     if (threadId != 0 && threadId != GetCurrentThreadId()) {
         return;
     }
@@ -0,0 +1,260 @@
+/* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/File.h"
+#include "base/Trace.h"
+
+struct TraceEvent {
+    const char* name;
+    i64 start;
+    i64 dur;
+    i64 arg;
+};
+
+// one per thread that ever recorded a span. Only that thread writes events and
+// nRecorded; the exporter reads them without stopping it
+struct TraceThreadBuf {
+    TraceThreadBuf* next = nullptr;
+    ThreadId threadId = 0;
+    // guarded by gTraceMutex
+    char threadName[64]{};
+    TraceEvent* events = nullptr;
+    // a power of 2
+    u32 capacity = 0;
+    // spans recorded so far, mod 2^32. Published after the event is written
+    AtomicInt nRecorded = 0;
+    // set once the ring has wrapped
+    AtomicInt isFull = 0;
+};
+
+AtomicInt gTraceEnabled = 0;
+
+// guards the list of buffers (never freed: spans of threads that have exited
+// still belong in the export) and thread names
+static Mutex gTraceMutex;
+static TraceThreadBuf* gTraceBufs = nullptr;
+static u32 gTraceCapacity = 0;
+// timestamps are exported relative to the first TraceStart()
+static i64 gTraceOrigin = 0;
+
+// names of threads that haven't recorded a span yet, applied when they do.
+// Guarded by gTraceMutex
+struct TraceThreadName {
+    ThreadId threadId;
+    char name[64];
+};
+static Vec<TraceThreadName>* gTracePendingNames = nullptr;
+
+static thread_local TraceThreadBuf* gTraceThreadBuf = nullptr;
+
+i64 TraceNow() {
+#if OS_WIN
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t.QuadPart;
+#else
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (i64)t.tv_sec * 1000000000 + t.tv_nsec;
+#endif
+}
+
+static double TraceTicksPerUs() {
+#if OS_WIN
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return (double)freq.QuadPart / 1000000.0;
+#else
+    return 1000.0;
+#endif
+}
+
+void TraceStart(int maxSpansPerThread) {
+    ScopedMutex lock(&gTraceMutex);
+    if (gTraceCapacity == 0) {
+        // buffers already created keep their size
+        u32 cap = 1024;
+        while (cap < (u32)maxSpansPerThread && cap < (1u << 24)) {
+            cap *= 2;
+        }
+        gTraceCapacity = cap;
+        gTraceOrigin = TraceNow();
+    }
+    AtomicIntSet(&gTraceEnabled, 1);
+}
+
+void TraceStop() {
+    AtomicIntSet(&gTraceEnabled, 0);
+}
+
+static void CopyThreadName(char (&dst)[64], Str name) {
+    int n = std::min(len(name), (int)sizeof(dst) - 1);
+    memcpy(dst, name.s, (size_t)n);
+    dst[n] = 0;
+}
+
+void TraceSetThreadName(Str name, ThreadId threadId) {
+    if (threadId == 0) {
+        threadId = GetCurrentThreadId();
+    }
+    ScopedMutex lock(&gTraceMutex);
+    for (TraceThreadBuf* buf = gTraceBufs; buf; buf = buf->next) {
+        if (buf->threadId == threadId) {
+            CopyThreadName(buf->threadName, name);
+            return;
+        }
+    }
+    if (!gTracePendingNames) {
+        gTracePendingNames = new Vec<TraceThreadName>();
+    }
+    for (TraceThreadName& tn : *gTracePendingNames) {
+        if (tn.threadId == threadId) {
+            CopyThreadName(tn.name, name);
+            return;
+        }
+    }
+    // threads that never record a span would otherwise pile up
+    if (len(*gTracePendingNames) >= 256) {
+        gTracePendingNames->RemoveAt(0);
+    }
+    TraceThreadName tn;
+    tn.threadId = threadId;
+    CopyThreadName(tn.name, name);
+    gTracePendingNames->Append(tn);
+}
+
+static TraceThreadBuf* NewTraceThreadBuf() {
+    ScopedMutex lock(&gTraceMutex);
+    if (gTraceCapacity == 0) {
+        return nullptr;
+    }
+    auto buf = new TraceThreadBuf();
+    buf->events = AllocArray<TraceEvent>((int)gTraceCapacity);
+    if (!buf->events) {
+        delete buf;
+        return nullptr;
+    }
+    buf->capacity = gTraceCapacity;
+    buf->threadId = GetCurrentThreadId();
+    int nPending = gTracePendingNames ? len(*gTracePendingNames) : 0;
+    for (int i = 0; i < nPending; i++) {
+        TraceThreadName& tn = (*gTracePendingNames)[i];
+        if (tn.threadId == buf->threadId) {
+            memcpy(buf->threadName, tn.name, sizeof(tn.name));
+            gTracePendingNames->RemoveAt(i);
+            break;
+        }
+    }
+    ListInsertFront(&gTraceBufs, buf);
+    gTraceThreadBuf = buf;
+    return buf;
+}
+
+void TraceRecord(const char* name, i64 start, i64 arg) {
+    i64 end = TraceNow();
+    TraceThreadBuf* buf = gTraceThreadBuf;
+    if (!buf) {
+        buf = NewTraceThreadBuf();
+        if (!buf) {
+            return;
+        }
+    }
+    // only this thread writes nRecorded, so a plain read is up to date
+    u32 n = (u32)buf->nRecorded;
+    TraceEvent& e = buf->events[n & (buf->capacity - 1)];
+    e.name = name;
+    e.start = start;
+    e.dur = end - start;
+    e.arg = arg;
+    n++;
+    if (n == buf->capacity) {
+        AtomicIntSet(&buf->isFull, 1);
+    }
+    AtomicIntSet(&buf->nRecorded, (int)n);
+}
+
+// copies the spans of buf, oldest first, leaving out any that the owning
+// thread may have overwritten while we were copying
+static void CopyTraceEvents(TraceThreadBuf* buf, Vec<TraceEvent>& out) {
+    u32 cap = buf->capacity;
+    u32 n = (u32)AtomicIntGet(&buf->nRecorded);
+    u32 nAvail = AtomicIntGet(&buf->isFull) ? cap : n;
+    u32 first = n - nAvail;
+    TraceEvent* dst = out.AppendBlanks((int)nAvail);
+    for (u32 i = 0; i < nAvail; i++) {
+        dst[i] = buf->events[(first + i) & (cap - 1)];
+    }
+    // relative to first, the oldest span that can't have been touched is
+    // 1 past the one being written now
+    i64 nAfter = (i64)nAvail + (i64)(u32)((u32)AtomicIntGet(&buf->nRecorded) - n);
+    i64 nSkip = nAfter + 1 - (i64)cap;
+    if (nSkip > 0) {
+        out.RemoveAt(len(out) - (int)nAvail, (int)std::min(nSkip, (i64)nAvail));
+    }
+}
+
+static void AppendJsonStr(str::Builder& b, const char* s) {
+    b.AppendChar('"');
+    for (; *s; s++) {
+        char c = *s;
+        if (c == '"' || c == '\\') {
+            b.AppendChar('\\');
+            b.AppendChar(c);
+        } else if ((u8)c >= 0x20) {
+            b.AppendChar(c);
+        }
+    }
+    b.AppendChar('"');
+}
+
+Str TraceExportJson() {
+    double ticksPerUs = TraceTicksPerUs();
+    str::Builder b;
+    b.Append(StrL("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"));
+    bool isFirst = true;
+    char tmp[256];
+    Vec<TraceEvent> events;
+
+    ScopedMutex lock(&gTraceMutex);
+    for (TraceThreadBuf* buf = gTraceBufs; buf; buf = buf->next) {
+        u64 tid = (u64)buf->threadId;
+        if (buf->threadName[0]) {
+            int n = snprintf(tmp, sizeof(tmp), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":",
+                             isFirst ? "" : ",\n", (unsigned long long)tid);
+            b.Append(Str(tmp, n));
+            AppendJsonStr(b, buf->threadName);
+            b.Append(StrL("}}"));
+            isFirst = false;
+        }
+        events.Reset();
+        CopyTraceEvents(buf, events);
+        for (TraceEvent& e : events) {
+            double ts = (double)(e.start - gTraceOrigin) / ticksPerUs;
+            double dur = (double)e.dur / ticksPerUs;
+            b.Append(isFirst ? StrL("{\"name\":") : StrL(",\n{\"name\":"));
+            AppendJsonStr(b, e.name);
+            int n = snprintf(tmp, sizeof(tmp), ",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f",
+                             (unsigned long long)tid, ts, dur);
+            b.Append(Str(tmp, n));
+            if (e.arg != kTraceNoArg) {
+                n = snprintf(tmp, sizeof(tmp), ",\"args\":{\"arg\":%lld}", (long long)e.arg);
+                b.Append(Str(tmp, n));
+            }
+            b.AppendChar('}');
+            isFirst = false;
+        }
+    }
+    b.Append(StrL("\n]}\n"));
+    return b.TakeStr();
+}
+
+bool TraceWriteJson(Str path) {
+    Str json = TraceExportJson();
+    bool ok = file::WriteFile(path, json);
+    str::Free(json);
+    if (!ok) {
+        logf("TraceWriteJson: failed to write '%s'\n", path);
+    }
+    return ok;
+}
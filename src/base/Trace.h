@@ -0,0 +1,58 @@
+/* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+/*
+Span tracing: where the time goes, across threads, on one timeline.
+
+    TraceSpan span("render page", pageNo);
+
+records the time from here to the end of the scope. Every thread records into a
+ring buffer of its own, so recording takes no locks; when a buffer is full the
+oldest spans are overwritten. TraceExportJson() turns what the buffers hold into
+Chrome trace-event JSON, which Perfetto (ui.perfetto.dev) and chrome://tracing
+show as a timeline.
+
+Off until TraceStart(). While off a TraceSpan is a load and a branch.
+
+Span names must be string literals (or live as long as the program): only the
+pointer is recorded.
+*/
+
+constexpr i64 kTraceNoArg = INT64_MIN;
+
+// read without a lock by every TraceSpan; set by TraceStart() / TraceStop()
+extern AtomicInt gTraceEnabled;
+
+// spans per thread that are kept; rounded up to a power of 2
+void TraceStart(int maxSpansPerThread = 64 * 1024);
+void TraceStop();
+// a name for a thread (0 is the current one) in the timeline. SetThreadName() calls it
+void TraceSetThreadName(Str name, ThreadId threadId = 0);
+// everything recorded so far, oldest first per thread. Caller frees
+Str TraceExportJson();
+bool TraceWriteJson(Str path);
+
+i64 TraceNow();
+void TraceRecord(const char* name, i64 start, i64 arg);
+
+struct TraceSpan {
+    const char* name = nullptr;
+    i64 start = 0;
+    i64 arg = kTraceNoArg;
+
+    // arg shows up in the span's details, e.g. a page number
+    explicit TraceSpan(const char* name, i64 arg = kTraceNoArg) {
+        if (gTraceEnabled) {
+            this->name = name;
+            this->arg = arg;
+            start = TraceNow();
+        }
+    }
+    ~TraceSpan() {
+        if (name) {
+            TraceRecord(name, start, arg);
+        }
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
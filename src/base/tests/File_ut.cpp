@@ -161,6 +161,15 @@ void FileUtilTest() {
         utassert(m.data && memcmp(m.data, content.s, (size_t)len(content)) == 0);
         file::MemoryUnmap(&m);
         utassert(!m.data && m.size == 0);
+        // too small to be worth mapping
+        ok = file::MemoryMapIfLarge(path, (i64)len(content) + 1, &m);
+        utassert(!ok && !m.data);
+        // at the threshold, on the (local, fixed) drive of the temp dir
+        ok = file::MemoryMapIfLarge(path, (i64)len(content), &m);
+        utassert(ok);
+        utassert(m.size == (i64)len(content));
+        utassert(m.data && memcmp(m.data, content.s, (size_t)len(content)) == 0);
+        file::MemoryUnmap(&m);
         ok = file::Delete(path);
         utassert(ok);
     }
@@ -0,0 +1,164 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "base/Timer.h"
+#include "GlyphIndex.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+// what FindClosestGlyph() did before the index: look at every glyph
+static int FindClosestLinear(const Rect* coords, int n, double x, double y) {
+    unsigned int maxDist = UINT_MAX;
+    Point pti = ToPoint(PointF((float)x, (float)y));
+    bool overGlyph = false;
+    int result = -1;
+    for (int i = 0; i < n; i++) {
+        const Rect& coord = coords[i];
+        if (!coord.x && !coord.dx) {
+            continue;
+        }
+        if (overGlyph && !coord.Contains(pti)) {
+            continue;
+        }
+        int dx = (int)x - coord.x - (coord.dx / 2);
+        int dy = (int)y - coord.y - (coord.dy / 2);
+        uint dist = (uint)((dx * dx) + (dy * dy));
+        if (dist < maxDist) {
+            result = i;
+            maxDist = dist;
+        }
+        if (!overGlyph && coord.Contains(pti)) {
+            overGlyph = true;
+            result = i;
+            maxDist = dist;
+        }
+    }
+    return result;
+}
+
+static u32 gRandState = 1;
+
+static int RandInt(int n) {
+    gRandState = (gRandState * 1103515245) + 12345;
+    return (int)((gRandState >> 8) % (u32)n);
+}
+
+// lines of glyphs in 2 columns, with the things real pages have: glyphs
+// sharing a box (DjVu), overlapping lines, empty boxes and a few big ones
+static void MakePage(Vec<Rect>& coords, int nGlyphs) {
+    coords.Reset();
+    int x = 40;
+    int y = 50;
+    int col = 0;
+    while (len(coords) < nGlyphs) {
+        int kind = RandInt(100);
+        int dx = 3 + RandInt(6);
+        if (kind < 3) {
+            // line separator without a box
+            coords.Append(Rect());
+        } else if (kind < 6 && len(coords) > 0) {
+            coords.Append(coords.Last());
+        } else if (kind < 7) {
+            coords.Append(Rect(RandInt(300), RandInt(400), 100 + RandInt(200), 100 + RandInt(300)));
+        } else if (kind < 8) {
+            coords.Append(Rect(x, y - 2, 0, 14));
+        } else {
+            coords.Append(Rect(x, y + RandInt(3) - 1, dx, 10 + RandInt(3)));
+        }
+        x += dx + (RandInt(6) == 0 ? 4 : 0);
+        if (x > 280 + (col * 300)) {
+            x = 40 + (col * 300);
+            y += 11;
+            if (y > 760) {
+                col = 1 - col;
+                x = 40 + (col * 300);
+                y = 50 + RandInt(5);
+            }
+        }
+    }
+}
+
+static void CheckSameAsLinear(const Vec<Rect>& coords, double x, double y) {
+    GlyphIndex index(coords.els, len(coords));
+    int expected = FindClosestLinear(coords.els, len(coords), x, y);
+    int got = index.FindClosest(x, y);
+    utassert(got == expected);
+}
+
+static void Test01() {
+    Vec<Rect> coords;
+    GlyphIndex empty(coords.els, 0);
+    utassert(empty.FindClosest(10, 10) == -1);
+
+    coords.Append(Rect());
+    coords.Append(Rect(10, 10, 10, 10));
+    // same center as the previous glyph: the lower index wins
+    coords.Append(Rect(11, 11, 8, 8));
+    coords.Append(Rect(30, 10, 10, 10));
+    // covers the 2nd glyph: over both, the closest center wins
+    coords.Append(Rect(0, 0, 100, 100));
+    GlyphIndex index(coords.els, len(coords));
+    utassert(index.FindClosest(15, 15) == 1);
+    utassert(index.FindClosest(35.5, 12) == 3);
+    utassert(index.FindClosest(90, 90) == 4);
+    // over nothing
+    utassert(index.FindClosest(-50, 15) == 1);
+    utassert(index.FindClosest(500, 500) == 4);
+    for (double y = -20; y < 130; y += 3.5) {
+        for (double x = -20; x < 130; x += 2.5) {
+            CheckSameAsLinear(coords, x, y);
+        }
+    }
+}
+
+static void Test02() {
+    Vec<Rect> coords;
+    for (int n : {1, 2, 10, 100, 3000}) {
+        MakePage(coords, n);
+        GlyphIndex index(coords.els, len(coords));
+        for (int i = 0; i < 2000; i++) {
+            double x = (double)RandInt(800) - 100 + (RandInt(4) / 4.0);
+            double y = (double)RandInt(1000) - 100 + (RandInt(4) / 4.0);
+            int expected = FindClosestLinear(coords.els, len(coords), x, y);
+            utassert(index.FindClosest(x, y) == expected);
+        }
+    }
+}
+
+void GlyphIndex_UnitTests() {
+    Test01();
+    Test02();
+}
+
+// -bench-glyph-index: hit-testing a dense page on every mouse move
+void GlyphIndex_Benchmark() {
+    const int kGlyphs = 20000;
+    const int kQueries = 20000;
+    Vec<Rect> coords;
+    MakePage(coords, kGlyphs);
+
+    auto t = TimeGet();
+    GlyphIndex index(coords.els, len(coords));
+    printf("%d glyphs, build index : %.2f ms\n", kGlyphs, TimeSinceInMs(t));
+
+    Vec<PointF> pts;
+    for (int i = 0; i < kQueries; i++) {
+        pts.Append(PointF((float)RandInt(640), (float)RandInt(820)));
+    }
+    t = TimeGet();
+    i64 sum = 0;
+    for (PointF& pt : pts) {
+        sum += index.FindClosest(pt.x, pt.y);
+    }
+    printf("indexed, %d queries  : %.2f ms\n", kQueries, TimeSinceInMs(t));
+
+    t = TimeGet();
+    i64 sumLinear = 0;
+    for (PointF& pt : pts) {
+        sumLinear += FindClosestLinear(coords.els, len(coords), pt.x, pt.y);
+    }
+    printf("linear, %d queries   : %.2f ms\n", kQueries, TimeSinceInMs(t));
+    utassert(sum == sumLinear);
+}
@@ -0,0 +1,92 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "base/HtmlTags.h"
+#include "GumboHelpers.h"
+#include "GumboHtmlParser.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+// three spine items, the way EbookDoc concatenates them
+static const char* gChunkedHtml =
+    "<pagebreak page_path=\"ch1.html\" page_marker />"
+    "<h1 id=\"c1\">Chapter <i>one</i></h1>\n<p>It was a &amp; b, <b>bold</b> text.</p>\n"
+    "<pagebreak page_path=\"ch2.html\" page_marker />"
+    "<p class=\"x\">Second <a href=\"ch1.html#c1\">link</a></p><img src=\"pic.png\" /><br/>\n"
+    "<pagebreak page_path=\"ch3.html\" page_marker />"
+    "<div><p>Last one</p><p>after &lt;that&gt;</p></div>";
+
+// off is where the token starts (its reparse point), s is its text or the
+// inside of the tag
+struct ParsedToken {
+    HtmlToken::TokenType type;
+    int off;
+    int sOff;
+    int sLen;
+};
+
+static ParsedToken ToParsed(GumboHtmlParser& p, HtmlToken* t) {
+    return {t->type, p.PosOf(t->GetReparsePoint()), p.PosOf(t->s), t->s.len};
+}
+
+static bool TokenEq(const ParsedToken& a, GumboHtmlParser& p, HtmlToken* t) {
+    if (!t) {
+        return false;
+    }
+    ParsedToken b = ToParsed(p, t);
+    return a.type == b.type && a.off == b.off && a.sOff == b.sOff && a.sLen == b.sLen;
+}
+
+// the html is parsed one chunk at a time; the tags and their offsets must be
+// the same as when the whole html is parsed in one go
+static void TestChunksMatchWholeParse() {
+    Str html(gChunkedHtml);
+    // the same html without chunk markers, at the same offsets
+    Str whole = str::ReplaceTemp(html, StrL("<pagebreak page_path="), StrL("<pagebreak page_pbth="));
+    utassert(whole.len == html.len);
+
+    Vec<ParsedToken> expected;
+    GumboHtmlParser wholeParser(whole);
+    while (HtmlToken* t = wholeParser.Next()) {
+        utassert(t->IsTag() || t->IsText());
+        expected.Append(ToParsed(wholeParser, t));
+    }
+    utassert(len(expected) > 30);
+
+    GumboHtmlParser chunked(html);
+    int nPageBreaks = 0;
+    int i = 0;
+    while (HtmlToken* t = chunked.Next()) {
+        utassert(i < len(expected) && TokenEq(expected[i], chunked, t));
+        if (t->IsEmptyElementEndTag() && t->NameIs(StrL("pagebreak"))) {
+            nPageBreaks++;
+        }
+        i++;
+    }
+    utassert(i == len(expected));
+    utassert(nPageBreaks == 3);
+
+    // re-layout resumes at the reparse point of a token, also one in an
+    // earlier chunk than the current one
+    GumboHtmlParser resumed(html);
+    for (int k = len(expected) - 1; k >= 0; k -= 2) {
+        resumed.SetCurrPosOff(expected[k].off);
+        utassert(TokenEq(expected[k], resumed, resumed.Next()));
+        if (k + 1 < len(expected)) {
+            utassert(TokenEq(expected[k + 1], resumed, resumed.Next()));
+        }
+    }
+
+    // in the middle of a text the rest of it is returned
+    int textOff = str::IndexOf(html, StrL("Second"));
+    resumed.SetCurrPosOff(textOff + 3);
+    HtmlToken* t = resumed.Next();
+    utassert(t && t->IsText() && str::StartsWith(t->s, StrL("ond")));
+    utassert(resumed.PosOf(t->GetReparsePoint()) == textOff + 3);
+}
+
+void GumboHtmlParser_UnitTests() {
+    TestChunksMatchWholeParse();
+}
@@ -0,0 +1,144 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "base/HtmlTags.h"
+#include "base/CssParser.h"
+#include "base/Timer.h"
+#include "HtmlStyleSheet.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+static bool IsIndent(const StyleRule& rule, float indent, StyleRule::Unit unit) {
+    return rule.textIndentUnit == unit && rule.textIndent == indent;
+}
+
+static void Test01() {
+    HtmlStyleSheet sheet;
+    utassert(sheet.Compute(Tag_P, StrL("c1")).textAlign == AlignAttr::NotFound);
+
+    sheet.Parse(StrL("p { text-align: center }\n.c1 { text-indent: 2em }\np.c1 { text-align: right }\n"
+                     "body { text-align: left }\n* { text-indent: 1px }\nh1, p { text-indent: 3pt }"));
+    // "p" and "h1, p" are one rule
+    utassert(len(sheet.rules) == 6);
+    utassert(sheet.Find(Tag_P, Str()) != nullptr);
+    utassert(sheet.Find(Tag_P, StrL("c1")) != nullptr);
+    utassert(sheet.Find(Tag_Div, StrL("c1")) == nullptr);
+
+    StyleRule rule = sheet.Compute(Tag_P, Str());
+    utassert(rule.textAlign == AlignAttr::Center && IsIndent(rule, 3, StyleRule::pt));
+    rule = sheet.Compute(Tag_P, StrL("c1"));
+    utassert(rule.textAlign == AlignAttr::Right && IsIndent(rule, 2, StyleRule::em));
+    rule = sheet.Compute(Tag_Div, StrL("c1"));
+    utassert(rule.textAlign == AlignAttr::Left && IsIndent(rule, 2, StyleRule::em));
+    rule = sheet.Compute(Tag_Div, StrL("unknown"));
+    utassert(rule.textAlign == AlignAttr::Left && IsIndent(rule, 1, StyleRule::px));
+    // the same again, from the memoized results
+    rule = sheet.Compute(Tag_P, StrL("c1"));
+    utassert(rule.textAlign == AlignAttr::Right && IsIndent(rule, 2, StyleRule::em));
+}
+
+static void Test02() {
+    HtmlStyleSheet sheet;
+    sheet.Parse(StrL(".a { text-align: center } .b { text-indent: 3pt } span.a { text-align: right }"));
+    StyleRule rule = sheet.Compute(Tag_Div, StrL(" a\tb "));
+    utassert(rule.textAlign == AlignAttr::Center && IsIndent(rule, 3, StyleRule::pt));
+    // tag.class rules win over .class rules
+    rule = sheet.Compute(Tag_Span, StrL("b a"));
+    utassert(rule.textAlign == AlignAttr::Right && IsIndent(rule, 3, StyleRule::pt));
+
+    // a later stylesheet changes what was memoized
+    sheet.Parse(StrL("div.b { text-indent: 1em }"));
+    rule = sheet.Compute(Tag_Div, StrL(" a\tb "));
+    utassert(rule.textAlign == AlignAttr::Center && IsIndent(rule, 1, StyleRule::em));
+
+    sheet.Reset();
+    utassert(len(sheet.rules) == 0);
+    rule = sheet.Compute(Tag_Div, StrL(" a\tb "));
+    utassert(rule.textAlign == AlignAttr::NotFound && rule.textIndentUnit == StyleRule::inherit);
+}
+
+static Str ManyClassRulesCss(int nRules) {
+    str::Builder css;
+    for (int i = 0; i < nRules; i++) {
+        css.Append(fmt(".c%d { text-indent: %dpx }\np.c%d { text-align: right }\n", i, i, i));
+    }
+    return css.TakeStr();
+}
+
+static void Test03() {
+    const int kRules = 3000;
+    Str css = ManyClassRulesCss(kRules);
+    HtmlStyleSheet sheet;
+    sheet.Parse(css);
+    str::Free(css);
+    utassert(len(sheet.rules) == 2 * kRules);
+    for (int i = 0; i < kRules; i += 7) {
+        StyleRule rule = sheet.Compute(Tag_P, fmt("c%d", i));
+        utassert(rule.textAlign == AlignAttr::Right && IsIndent(rule, (float)i, StyleRule::px));
+        rule = sheet.Compute(Tag_Div, fmt("c%d", i));
+        utassert(rule.textAlign == AlignAttr::NotFound && IsIndent(rule, (float)i, StyleRule::px));
+    }
+}
+
+void HtmlStyleSheet_UnitTests() {
+    Test01();
+    Test02();
+    Test03();
+}
+
+// -bench-css: styling every tag of a book with a big stylesheet, the
+// indexed and memoized lookup vs. scanning all the rules
+void HtmlStyleSheet_Benchmark() {
+    const int kRules = 5000;
+    const int kClassAttrs = 500;
+    const int kTags = 1000000;
+
+    Str css = ManyClassRulesCss(kRules);
+    HtmlStyleSheet sheet;
+    auto t = TimeGet();
+    sheet.Parse(css);
+    printf("%d rules, parse      : %.2f ms\n", len(sheet.rules), TimeSinceInMs(t));
+    str::Free(css);
+
+    StrVec classAttrs;
+    for (int i = 0; i < kClassAttrs; i++) {
+        classAttrs.Append(fmt("c%d", (i * 37) % kRules));
+    }
+    HtmlTag tags[] = {Tag_P, Tag_Div, Tag_Span};
+
+    t = TimeGet();
+    float sum = 0;
+    for (int i = 0; i < kTags; i++) {
+        StyleRule rule = sheet.Compute(tags[i % dimof(tags)], classAttrs.At(i % kClassAttrs));
+        sum += rule.textIndent;
+    }
+    printf("indexed, %d tags : %.2f ms\n", kTags, TimeSinceInMs(t));
+
+    // what finding each rule by going through all of them costs
+    t = TimeGet();
+    float sumLinear = 0;
+    u32 noClassHash = MurmurHash2(Str());
+    for (int i = 0; i < kTags / 100; i++) {
+        HtmlTag tag = tags[i % dimof(tags)];
+        u32 classHash = MurmurHash2(classAttrs.At(i % kClassAttrs));
+        struct {
+            HtmlTag tag;
+            u32 classHash;
+        } lookups[] = {{Tag_Body, noClassHash}, {Tag_Any, noClassHash}, {tag, noClassHash},
+                       {Tag_Any, classHash},    {tag, classHash}};
+        StyleRule res;
+        for (auto& lookup : lookups) {
+            for (StyleRule& rule : sheet.rules) {
+                if (rule.tag == lookup.tag && rule.classHash == lookup.classHash) {
+                    res.Merge(rule);
+                    break;
+                }
+            }
+        }
+        sumLinear += res.textIndent;
+    }
+    printf("linear, %d tags   : %.2f ms\n", kTags / 100, TimeSinceInMs(t));
+    printf("(%.0f %.0f)\n", sum, sumLinear);
+}
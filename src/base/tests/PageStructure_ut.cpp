@@ -0,0 +1,87 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "PageStructure.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+// builds page text the way engines do: a '\n' glyph with an empty box ends a line
+struct TestPage {
+    str::Builder text;
+    Vec<Rect> coords;
+
+    void AddLine(Str s, int x, int y) {
+        for (int i = 0; i < s.len; i++) {
+            text.AppendChar(s.s[i]);
+            // a space with an empty box isn't a line break (issue #5712)
+            coords.Append(s.s[i] == ' ' ? Rect() : Rect(x + (i * 6), y, 5, 10));
+        }
+    }
+    void AddBreak() {
+        text.AppendChar('\n');
+        coords.Append(Rect());
+    }
+};
+
+// SelectLineAt() before PageStructure: walk from the glyph to the line breaks
+static void LineAtLinear(Str text, const Rect* coords, int textLen, int i, int* startOut, int* endOut) {
+    int start = i;
+    while (start > 0 && !(text.s[start - 1] == '\n' && !coords[start - 1].x && !coords[start - 1].dx)) {
+        start--;
+    }
+    int end = i;
+    while (end < textLen && !(text.s[end] == '\n' && !coords[end].x && !coords[end].dx)) {
+        end++;
+    }
+    *startOut = start;
+    *endOut = end;
+}
+
+static void CheckLines(TestPage& page) {
+    Str text = ToStr(page.text);
+    int n = len(page.coords);
+    PageStructure* ps = BuildPageStructure(text, page.coords.els, n);
+    utassert(ps->text.len == n);
+    utassert(len(ps->lines) >= 1);
+    for (int i = 0; i <= n; i++) {
+        int start = 0, end = 0;
+        LineAtLinear(text, page.coords.els, n, i, &start, &end);
+        const PageLine& line = ps->lines[ps->LineOf(i)];
+        utassert(line.start == start);
+        utassert(line.end == end);
+    }
+    delete ps;
+}
+
+static void LinesTest() {
+    TestPage empty;
+    CheckLines(empty);
+
+    TestPage page;
+    page.AddLine(StrL("first line"), 72, 100);
+    page.AddBreak();
+    page.AddLine(StrL("second"), 72, 112);
+    page.AddBreak();
+    page.AddBreak();
+    page.AddLine(StrL("after a blank line"), 72, 136);
+    page.AddBreak();
+    CheckLines(page);
+
+    PageStructure* ps = BuildPageStructure(ToStr(page.text), page.coords.els, len(page.coords));
+    // a line after every break, the last one empty
+    utassert(len(ps->lines) == 5);
+    utassert(ps->lines[0].bbox == Rect(72, 100, 59, 10));
+    utassert(ps->lines[2].bbox.IsEmpty());
+    utassert(ps->lines[4].bbox.IsEmpty());
+    utassert(ps->lines[4].start == len(page.coords));
+    // no watermark: the clean text is the whole text
+    utassert(ps->cleanText.len == len(page.coords));
+    utassert(ps->cleanCoords[0].y == 100);
+    delete ps;
+}
+
+void PageStructure_UnitTests() {
+    LinesTest();
+}
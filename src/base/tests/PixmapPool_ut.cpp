@@ -0,0 +1,130 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/Pixmap.h"
+#include "base/Timer.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+static void TestReuse() {
+    // too small to be worth pooling
+    Pixmap* small = AllocPixmap(16, 16);
+    utassert(small && !small->pooled);
+    FreePixmap(small);
+
+    Pixmap* p = AllocPixmap(300, 300, PixmapFormat::BGRA8, true);
+    utassert(p && p->pooled && p->premultiplied);
+    utassert(p->bufferSize >= (i64)p->stride * p->height);
+    u8* data = p->data;
+    i64 bufferSize = p->bufferSize;
+    p->hasAlpha = true;
+    p->xres = 300.0f;
+    FreePixmap(p);
+    PixmapPoolStats stats = GetPixmapPoolStats();
+    utassert(stats.nPooled == 1 && stats.pooledBytes == bufferSize);
+
+    // a bit smaller is the same size class
+    p = AllocPixmap(290, 300, PixmapFormat::RGBA8);
+    utassert(p && p->data == data && p->bufferSize == bufferSize);
+    utassert(p->width == 290 && p->height == 300 && p->stride == 290 * 4);
+    utassert(p->format == PixmapFormat::RGBA8 && !p->premultiplied && !p->hasAlpha && p->xres == 96.0f);
+    PixmapPoolStats stats2 = GetPixmapPoolStats();
+    utassert(stats2.nPooled == 0 && stats2.pooledBytes == 0);
+    utassert(stats2.nAllocs == stats.nAllocs + 1 && stats2.nReused == stats.nReused + 1);
+
+    // twice as big isn't
+    Pixmap* big = AllocPixmap(600, 300);
+    utassert(big && big->pooled && big->data != data);
+    FreePixmap(big);
+    FreePixmap(p);
+    utassert(GetPixmapPoolStats().nPooled == 2);
+
+    Pixmap* clone = ClonePixmap(p = AllocPixmap(300, 300));
+    utassert(clone && clone->pooled && clone->data != p->data);
+    FreePixmap(clone);
+    FreePixmap(p);
+    TrimPixmapPool(0);
+    utassert(GetPixmapPoolStats().nPooled == 0);
+}
+
+static void TestLimits() {
+    i64 prevMaxBytes = GetPixmapPoolStats().maxBytes;
+    Pixmap* pixmaps[8];
+    for (Pixmap*& p : pixmaps) {
+        p = AllocPixmap(256, 256);
+        utassert(p && p->pooled && p->bufferSize == 256 * 256 * 4);
+    }
+
+    // the oldest ones are dropped to make room
+    SetPixmapPoolMaxBytes(3 * 256 * 256 * 4);
+    for (Pixmap* p : pixmaps) {
+        FreePixmap(p);
+    }
+    PixmapPoolStats stats = GetPixmapPoolStats();
+    utassert(stats.nPooled == 3 && stats.pooledBytes == 3 * 256 * 256 * 4);
+    Pixmap* p = AllocPixmap(256, 256);
+    utassert(p->data == pixmaps[7]->data);
+    FreePixmap(p);
+
+    TrimPixmapPool(256 * 256 * 4);
+    utassert(GetPixmapPoolStats().nPooled == 1);
+
+    // bigger than the whole pool
+    p = AllocPixmap(1024, 1024);
+    utassert(p && p->pooled);
+    FreePixmap(p);
+    utassert(GetPixmapPoolStats().nPooled == 1);
+
+    // disabled
+    SetPixmapPoolMaxBytes(0);
+    utassert(GetPixmapPoolStats().nPooled == 0);
+    p = AllocPixmap(256, 256);
+    FreePixmap(p);
+    utassert(GetPixmapPoolStats().nPooled == 0);
+
+    SetPixmapPoolMaxBytes(prevMaxBytes);
+}
+
+void PixmapPool_UnitTests() {
+    TrimPixmapPool(0);
+    TestReuse();
+    TestLimits();
+}
+
+// -bench-pixmap-pool: scrolling through pages rendered in screen-sized tiles
+// (at 4K), with the render cache dropping the oldest tile for each new one
+void PixmapPool_Benchmark() {
+    const int kTiles = 1000;
+    const int kCachedTiles = 8;
+    Size sizes[] = {{3840, 2160}, {3840, 1317}, {2733, 2160}, {2733, 1317}};
+    i64 prevMaxBytes = GetPixmapPoolStats().maxBytes;
+    for (bool usePool : {false, true}) {
+        TrimPixmapPool(0);
+        SetPixmapPoolMaxBytes(usePool ? prevMaxBytes : 0);
+        PixmapPoolStats before = GetPixmapPoolStats();
+        Vec<Pixmap*> cached;
+        auto t = TimeGet();
+        for (int i = 0; i < kTiles; i++) {
+            Size sz = sizes[i % dimof(sizes)];
+            Pixmap* p = AllocPixmap(sz.dx, sz.dy);
+            // a renderer writes all of the tile, which for a new buffer is
+            // where the page faults are
+            memset(p->data, 0xff, (size_t)p->stride * p->height);
+            if (len(cached) == kCachedTiles) {
+                FreePixmap(cached[0]);
+                cached.RemoveAt(0);
+            }
+            cached.Append(p);
+        }
+        double ms = TimeSinceInMs(t);
+        for (Pixmap* p : cached) {
+            FreePixmap(p);
+        }
+        PixmapPoolStats after = GetPixmapPoolStats();
+        printf("%-8s: %d tiles in %.2f ms, %.0f allocs/s, %d reused\n", usePool ? "pool" : "no pool", kTiles, ms,
+               kTiles * 1000.0 / ms, (int)(after.nReused - before.nReused));
+    }
+    SetPixmapPoolMaxBytes(prevMaxBytes);
+}
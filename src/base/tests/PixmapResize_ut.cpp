@@ -0,0 +1,314 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/Pixmap.h"
+#include "base/PixmapResize.h"
+#include "base/Timer.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+static u32 gRandState = 7;
+
+static int RandInt(int n) {
+    gRandState = (gRandState * 1103515245) + 12345;
+    return (int)((gRandState >> 8) % (u32)n);
+}
+
+static Pixmap* NewRandomPixmap(int w, int h, PixmapFormat fmt, bool premultiplied) {
+    Pixmap* p = AllocPixmap(w, h, fmt, premultiplied);
+    int bpp = PixmapBytesPerPixel(fmt);
+    for (int y = 0; y < h; y++) {
+        u8* d = p->data + ((size_t)y * p->stride);
+        for (int x = 0; x < w; x++, d += bpp) {
+            int a = RandInt(3) == 0 ? RandInt(256) : 255;
+            for (int i = 0; i < bpp; i++) {
+                d[i] = (u8)RandInt(256);
+            }
+            if (bpp == 4) {
+                d[3] = (u8)a;
+                if (premultiplied) {
+                    d[0] = (u8)std::min((int)d[0], a);
+                    d[1] = (u8)std::min((int)d[1], a);
+                    d[2] = (u8)std::min((int)d[2], a);
+                }
+            }
+        }
+    }
+    p->hasAlpha = bpp == 4;
+    return p;
+}
+
+// smooth, so that a good filter can get it back after a reduction
+static Pixmap* NewSmoothPixmap(int w, int h) {
+    Pixmap* p = AllocPixmap(w, h, PixmapFormat::BGRA8, true);
+    for (int y = 0; y < h; y++) {
+        u8* d = p->data + ((size_t)y * p->stride);
+        for (int x = 0; x < w; x++, d += 4) {
+            double v = sin(x / 37.0) * cos(y / 23.0);
+            d[0] = (u8)(127.5 + (127.0 * v));
+            d[1] = (u8)((x * 255) / w);
+            d[2] = (u8)((y * 255) / h);
+            d[3] = 255;
+        }
+    }
+    return p;
+}
+
+static bool SamePixels(const Pixmap* a, const Pixmap* b) {
+    if (!a || !b || a->width != b->width || a->height != b->height) {
+        return false;
+    }
+    for (int y = 0; y < a->height; y++) {
+        const u8* ra = a->data + ((size_t)y * a->stride);
+        const u8* rb = b->data + ((size_t)y * b->stride);
+        if (memcmp(ra, rb, (size_t)a->width * 4) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the SIMD paths and the number of threads must not change a single byte
+static void SameAsScalarTest() {
+    PixmapFilter filters[] = {PixmapFilter::Box, PixmapFilter::Bilinear, PixmapFilter::Lanczos3};
+    PixmapFormat formats[] = {PixmapFormat::BGRA8, PixmapFormat::BGR8, PixmapFormat::RGBA8};
+    Size sizes[] = {{1, 1}, {3, 2}, {17, 9}, {64, 48}, {200, 150}, {333, 101}};
+    for (PixmapFormat fmt : formats) {
+        Pixmap* src = NewRandomPixmap(97, 61, fmt, fmt == PixmapFormat::BGRA8);
+        for (PixmapFilter filter : filters) {
+            for (Size sz : sizes) {
+                PixmapResizeArgs args;
+                args.filter = filter;
+                args.nThreads = 1;
+                args.simd = PixmapResizeSimd::Scalar;
+                Pixmap* scalar = ResizePixmap(src, sz.dx, sz.dy, args);
+                utassert(scalar && scalar->format == PixmapFormat::BGRA8 && scalar->premultiplied);
+                args.simd = PixmapResizeSimd::Sse2;
+                Pixmap* sse2 = ResizePixmap(src, sz.dx, sz.dy, args);
+                utassert(SamePixels(scalar, sse2));
+                args.simd = PixmapResizeSimd::Best;
+                args.nThreads = 3;
+                Pixmap* best = ResizePixmap(src, sz.dx, sz.dy, args);
+                utassert(SamePixels(scalar, best));
+                FreePixmap(scalar);
+                FreePixmap(sse2);
+                FreePixmap(best);
+            }
+        }
+        FreePixmap(src);
+    }
+}
+
+static void SimpleTest() {
+    utassert(ResizePixmap(nullptr, 10, 10) == nullptr);
+    Pixmap* src = AllocPixmap(40, 30, PixmapFormat::BGRA8, false);
+    utassert(ResizePixmap(src, 0, 10) == nullptr);
+
+    // a solid color stays that color with every filter
+    for (int i = 0; i < 40 * 30; i++) {
+        u8* d = src->data + ((size_t)i * 4);
+        d[0] = 10;
+        d[1] = 20;
+        d[2] = 30;
+        d[3] = 255;
+    }
+    for (PixmapFilter filter : {PixmapFilter::Box, PixmapFilter::Bilinear, PixmapFilter::Lanczos3}) {
+        PixmapResizeArgs args;
+        args.filter = filter;
+        for (Size sz : {Size(7, 5), Size(40, 30), Size(123, 77)}) {
+            Pixmap* dst = ResizePixmap(src, sz.dx, sz.dy, args);
+            bool same = true;
+            for (int i = 0; i < sz.dx * sz.dy; i++) {
+                u8* d = dst->data + ((size_t)i * 4);
+                same &= d[0] == 10 && d[1] == 20 && d[2] == 30 && d[3] == 255;
+            }
+            utassert(same);
+            FreePixmap(dst);
+        }
+    }
+
+    // transparent pixels don't bleed their (meaningless) color: the left half
+    // is opaque blue, the right half transparent red
+    src->hasAlpha = true;
+    for (int y = 0; y < 30; y++) {
+        for (int x = 0; x < 40; x++) {
+            u8* d = src->data + ((size_t)y * src->stride) + ((size_t)x * 4);
+            bool left = x < 20;
+            d[0] = left ? 255 : 0;
+            d[1] = 0;
+            d[2] = left ? 0 : 255;
+            d[3] = left ? 255 : 0;
+        }
+    }
+    PixmapResizeArgs args;
+    args.filter = PixmapFilter::Bilinear;
+    Pixmap* dst = ResizePixmap(src, 10, 3, args);
+    bool noRed = true;
+    for (int i = 0; i < 30; i++) {
+        noRed &= dst->data[((size_t)i * 4) + 2] == 0;
+    }
+    utassert(noRed);
+    FreePixmap(dst);
+
+    // 2x box reduction averages 2x2 blocks
+    Pixmap* grid = AllocPixmap(4, 2, PixmapFormat::BGRA8, true);
+    u8 vals[] = {0, 100, 50, 50, 200, 40, 50, 50};
+    for (int i = 0; i < 8; i++) {
+        u8* d = grid->data + ((size_t)(i / 4) * grid->stride) + ((size_t)(i % 4) * 4);
+        d[0] = d[1] = d[2] = vals[i];
+        d[3] = 255;
+    }
+    args.filter = PixmapFilter::Box;
+    dst = ResizePixmap(grid, 2, 1, args);
+    utassert(dst->data[0] == 85 && dst->data[4] == 50);
+    FreePixmap(dst);
+
+    // a part of the source
+    args.srcRect = RectF(2, 0, 2, 2);
+    dst = ResizePixmap(grid, 1, 1, args);
+    utassert(dst->data[0] == 50);
+    FreePixmap(dst);
+
+    FreePixmap(grid);
+    FreePixmap(src);
+}
+
+static bool ColorsWithinAlpha(const Pixmap* p) {
+    for (int y = 0; y < p->height; y++) {
+        const u8* d = p->data + ((size_t)y * p->stride);
+        for (int x = 0; x < p->width; x++, d += 4) {
+            if (d[0] > d[3] || d[1] > d[3] || d[2] > d[3]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool AllOpaque(const Pixmap* p) {
+    for (int y = 0; y < p->height; y++) {
+        const u8* d = p->data + ((size_t)y * p->stride);
+        for (int x = 0; x < p->width; x++, d += 4) {
+            if (d[3] != 255) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void AlphaTest() {
+    PixmapResizeSimd impls[] = {PixmapResizeSimd::Scalar, PixmapResizeSimd::Best};
+    for (bool premultiplied : {false, true}) {
+        // random alpha bytes that don't mean anything give the same result as
+        // opaque pixels
+        Pixmap* src = NewRandomPixmap(61, 43, PixmapFormat::BGRA8, false);
+        src->hasAlpha = false;
+        src->premultiplied = premultiplied;
+        Pixmap* opaque = ClonePixmap(src);
+        for (int y = 0; y < opaque->height; y++) {
+            u8* d = opaque->data + ((size_t)y * opaque->stride);
+            for (int x = 0; x < opaque->width; x++, d += 4) {
+                d[3] = 255;
+            }
+        }
+        for (PixmapResizeSimd simd : impls) {
+            PixmapResizeArgs args;
+            args.simd = simd;
+            Pixmap* a = ResizePixmap(src, 29, 90, args);
+            Pixmap* b = ResizePixmap(opaque, 29, 90, args);
+            utassert(a && !a->hasAlpha && AllOpaque(a));
+            utassert(SamePixels(a, b));
+            FreePixmap(a);
+            FreePixmap(b);
+        }
+        FreePixmap(opaque);
+        FreePixmap(src);
+    }
+
+    // Lanczos rings at the sharp alpha edges of random pixels; the colors
+    // must still be valid premultiplied ones
+    Pixmap* src = NewRandomPixmap(57, 39, PixmapFormat::BGRA8, true);
+    for (PixmapResizeSimd simd : impls) {
+        for (Size sz : {Size(20, 13), Size(57, 39), Size(151, 97)}) {
+            PixmapResizeArgs args;
+            args.simd = simd;
+            Pixmap* dst = ResizePixmap(src, sz.dx, sz.dy, args);
+            utassert(dst && dst->hasAlpha && ColorsWithinAlpha(dst));
+            FreePixmap(dst);
+        }
+    }
+    FreePixmap(src);
+}
+
+void PixmapResize_UnitTests() {
+    SimpleTest();
+    AlphaTest();
+    SameAsScalarTest();
+}
+
+static double Psnr(const Pixmap* a, const Pixmap* b) {
+    double sum = 0;
+    for (int y = 0; y < a->height; y++) {
+        const u8* ra = a->data + ((size_t)y * a->stride);
+        const u8* rb = b->data + ((size_t)y * b->stride);
+        for (int x = 0; x < a->width * 4; x++) {
+            double d = (double)ra[x] - rb[x];
+            sum += d * d;
+        }
+    }
+    double mse = sum / ((double)a->width * a->height * 4);
+    return mse == 0 ? 99.0 : 10.0 * log10((255.0 * 255.0) / mse);
+}
+
+// -bench-resize: speed of each filter / SIMD path / threading, and quality
+// as the PSNR of an image reduced to 1/4 and enlarged back
+void PixmapResize_Benchmark() {
+    const int kW = 4000;
+    const int kH = 3000;
+    Pixmap* src = NewSmoothPixmap(kW, kH);
+    struct {
+        PixmapFilter filter;
+        const char* name;
+    } filters[] = {
+        {PixmapFilter::Box, "box"},
+        {PixmapFilter::Bilinear, "bilinear"},
+        {PixmapFilter::Lanczos3, "lanczos3"},
+    };
+    struct {
+        PixmapResizeSimd simd;
+        int nThreads;
+        const char* name;
+    } impls[] = {
+        {PixmapResizeSimd::Scalar, 1, "scalar 1 thread"},
+        {PixmapResizeSimd::Sse2, 1, "sse2 1 thread"},
+        {PixmapResizeSimd::Best, 1, "best 1 thread"},
+        {PixmapResizeSimd::Best, 0, "best threaded"},
+    };
+    Size sizes[] = {{kW / 10, kH / 10}, {kW * 3 / 10, kH * 3 / 10}, {kW * 6 / 5, kH * 6 / 5}};
+    printf("%dx%d BGRA8\n", kW, kH);
+    for (auto& f : filters) {
+        for (Size sz : sizes) {
+            for (auto& impl : impls) {
+                PixmapResizeArgs args;
+                args.filter = f.filter;
+                args.simd = impl.simd;
+                args.nThreads = impl.nThreads;
+                auto t = TimeGet();
+                Pixmap* dst = ResizePixmap(src, sz.dx, sz.dy, args);
+                printf("%-9s -> %5dx%-5d %-16s: %7.2f ms\n", f.name, sz.dx, sz.dy, impl.name, TimeSinceInMs(t));
+                FreePixmap(dst);
+            }
+        }
+        PixmapResizeArgs args;
+        args.filter = f.filter;
+        Pixmap* small = ResizePixmap(src, kW / 4, kH / 4, args);
+        Pixmap* back = ResizePixmap(small, kW, kH, args);
+        printf("%-9s 1/4 and back PSNR: %.2f dB\n", f.name, Psnr(src, back));
+        FreePixmap(small);
+        FreePixmap(back);
+    }
+    FreePixmap(src);
+}
@@ -0,0 +1,128 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/RectIndex.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+static u32 gRandState = 13;
+
+static int RandInt(int n) {
+    gRandState = (gRandState * 1103515245) + 12345;
+    return (int)((gRandState >> 8) % (u32)n);
+}
+
+static float RandCoord(float max) {
+    // a quarter of them on a coarse grid so that rects share edges
+    if (RandInt(4) == 0) {
+        return (float)(RandInt(20) * 10);
+    }
+    return ((float)RandInt(100000) / 100000.f) * max;
+}
+
+// what the grid must find: every rect that contains pt, in the order added
+static void FindLinear(const RectIndex& idx, PointF pt, Vec<int>& res) {
+    for (int i = 0; i < len(idx.rects); i++) {
+        if (idx.rects[i].Contains(pt)) {
+            res.Append(i);
+        }
+    }
+}
+
+static bool SameFound(const RectIndex& idx, PointF pt) {
+    Vec<int> expected;
+    FindLinear(idx, pt, expected);
+    Vec<int> got;
+    RectIndexFind(idx, pt, got);
+    if (len(got) != len(expected)) {
+        return false;
+    }
+    for (int i = 0; i < len(got); i++) {
+        if (got[i] != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a page's worth of elements: links in lines of text, some big images over
+// them and a few empty rects
+static void AddPageRects(RectIndex& idx, int n) {
+    for (int i = 0; i < n; i++) {
+        int kind = RandInt(10);
+        RectF r;
+        if (kind == 0) {
+            r = RectF(RandCoord(300), RandCoord(400), RandCoord(300), RandCoord(400));
+        } else if (kind == 1) {
+            r = RectF(RandCoord(600), RandCoord(800), 0, RandCoord(20));
+        } else {
+            r = RectF(RandCoord(560), RandCoord(780), 5.f + RandCoord(40), 8.f + RandCoord(4));
+        }
+        RectIndexAdd(idx, r);
+    }
+}
+
+static void TestGridMatchesLinearScan() {
+    for (int n : {0, 1, 15, 16, 17, 100, 1000, 5000}) {
+        RectIndex idx;
+        AddPageRects(idx, n);
+        RectIndexBuild(idx);
+        utassert((n >= 16) == (idx.nCols > 0));
+
+        bool same = true;
+        // random points, including outside of the bounds
+        for (int i = 0; i < 2000; i++) {
+            PointF pt(RandCoord(700) - 50.f, RandCoord(900) - 50.f);
+            same &= SameFound(idx, pt);
+        }
+        // corners and edges of the rects, where the cells must not be off by one
+        for (RectF r : idx.rects) {
+            float x1 = r.x + r.dx;
+            float y1 = r.y + r.dy;
+            for (PointF pt : {PointF(r.x, r.y), PointF(x1, y1), PointF(x1, r.y), PointF(r.x, y1),
+                              PointF(nextafterf(x1, r.x), nextafterf(y1, r.y))}) {
+                same &= SameFound(idx, pt);
+            }
+        }
+        utassert(same);
+    }
+}
+
+static void TestOrderAndRebuild() {
+    RectIndex idx;
+    // the same rect many times: found in the order added
+    for (int i = 0; i < 40; i++) {
+        RectIndexAdd(idx, RectF(10, 10, 5, 5));
+    }
+    RectIndexAdd(idx, RectF(0, 0, 100, 100));
+    RectIndexBuild(idx);
+    Vec<int> found;
+    RectIndexFind(idx, PointF(12, 12), found);
+    utassert(len(found) == 41);
+    bool inOrder = true;
+    for (int i = 0; i < len(found); i++) {
+        inOrder &= found[i] == i;
+    }
+    utassert(inOrder);
+    found.Reset();
+    RectIndexFind(idx, PointF(50, 50), found);
+    utassert(len(found) == 1 && found[0] == 40);
+
+    // building again after a reset gives the new rects only
+    RectIndexReset(idx);
+    RectIndexAdd(idx, RectF(0, 0, 1, 1));
+    RectIndexBuild(idx);
+    utassert(idx.nCols == 0);
+    found.Reset();
+    RectIndexFind(idx, PointF(12, 12), found);
+    utassert(len(found) == 0);
+    RectIndexFind(idx, PointF(0.5f, 0.5f), found);
+    utassert(len(found) == 1 && found[0] == 0);
+}
+
+void RectIndex_UnitTests() {
+    TestGridMatchesLinearScan();
+    TestOrderAndRebuild();
+}
@@ -7,6 +7,7 @@
 // region matching the documented behaviour.
 
 #include "base/Base.h"
+#include "PageStructure.h"
 #include "RefHoverDetect.h"
 #include "RefHoverTextDetect.h"
 
@@ -0,0 +1,444 @@
+/* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/File.h"
+#include "base/AppendStore.h"
+#include "base/SettingsUtil.h"
+#include "base/SettingsJournal.h"
+#include "base/SquareTreeParser.h"
+#include "base/Timer.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+// a cut-down FileState
+struct SjtFavorite {
+    Str name;
+    int pageNo;
+};
+
+static const FieldInfo gSjtFavoriteFields[] = {
+    {offsetof(SjtFavorite, name), SettingType::String, 0},
+    {offsetof(SjtFavorite, pageNo), SettingType::Int, 0},
+};
+static const StructInfo gSjtFavoriteInfo = {sizeof(SjtFavorite), 2, gSjtFavoriteFields, "Name\0PageNo"};
+
+static const FieldInfo gSjtPointFields[] = {
+    {offsetof(Point, x), SettingType::Int, 0},
+    {offsetof(Point, y), SettingType::Int, 0},
+};
+static const StructInfo gSjtPointInfo = {sizeof(Point), 2, gSjtPointFields, "X\0Y"};
+
+struct SjtFileState {
+    Str filePath;
+    int openCount;
+    bool isPinned;
+    Str displayMode;
+    Point scrollPos;
+    int pageNo;
+    float zoom;
+    int rotation;
+    bool showToc;
+    Vec<SjtFavorite*>* favorites;
+};
+
+static const FieldInfo gSjtFileStateFields[] = {
+    {offsetof(SjtFileState, filePath), SettingType::String, 0},
+    {offsetof(SjtFileState, openCount), SettingType::Int, 0},
+    {offsetof(SjtFileState, isPinned), SettingType::Bool, false},
+    {offsetof(SjtFileState, displayMode), SettingType::String, (intptr_t)"automatic"},
+    {offsetof(SjtFileState, scrollPos), SettingType::Compact, (intptr_t)&gSjtPointInfo},
+    {offsetof(SjtFileState, pageNo), SettingType::Int, 1},
+    {offsetof(SjtFileState, zoom), SettingType::Float, (intptr_t)"fit page"},
+    {offsetof(SjtFileState, rotation), SettingType::Int, 0},
+    {offsetof(SjtFileState, showToc), SettingType::Bool, true},
+    {offsetof(SjtFileState, favorites), SettingType::Array, (intptr_t)&gSjtFavoriteInfo},
+};
+static const StructInfo gSjtFileStateInfo = {
+    sizeof(SjtFileState), 10, gSjtFileStateFields,
+    "FilePath\0OpenCount\0IsPinned\0DisplayMode\0ScrollPos\0PageNo\0Zoom\0Rotation\0ShowToc\0Favorites"};
+
+struct SjtPrefs {
+    int tabWidth;
+    Vec<SjtFileState*>* fileStates;
+};
+
+static const FieldInfo gSjtPrefsFields[] = {
+    {offsetof(SjtPrefs, tabWidth), SettingType::Int, 300},
+    {offsetof(SjtPrefs, fileStates), SettingType::Array, (intptr_t)&gSjtFileStateInfo},
+};
+static const StructInfo gSjtPrefsInfo = {sizeof(SjtPrefs), 2, gSjtPrefsFields, "TabWidth\0FileStates"};
+
+static Str GetSjtKey(const void* item) {
+    return ((const SjtFileState*)item)->filePath;
+}
+
+static SjtFileState* NewSjtFileState(int n) {
+    auto fs = (SjtFileState*)DeserializeStruct(&gSjtFileStateInfo, {});
+    str::ReplaceWithCopy(&fs->filePath, fmt("C:\\Users\\me\\Documents\\book %d.pdf", n));
+    fs->openCount = n % 7;
+    fs->pageNo = n % 300 + 1;
+    fs->scrollPos = Point(n % 50, n % 900);
+    if (n % 5 == 0) {
+        auto fav = (SjtFavorite*)DeserializeStruct(&gSjtFavoriteInfo, {});
+        str::ReplaceWithCopy(&fav->name, StrL("chapter 2"));
+        fav->pageNo = 17;
+        fs->favorites->Append(fav);
+    }
+    return fs;
+}
+
+static Vec<void*>* NewSjtFileStates(int n) {
+    auto res = new Vec<void*>();
+    for (int i = 0; i < n; i++) {
+        res->Append(NewSjtFileState(i));
+    }
+    return res;
+}
+
+static void FreeSjtFileStates(Vec<void*>* items) {
+    for (void* fs : *items) {
+        FreeStruct(&gSjtFileStateInfo, fs);
+    }
+    delete items;
+}
+
+static bool SjtFileStatesEq(Vec<void*>* a, Vec<void*>* b) {
+    if (len(*a) != len(*b)) {
+        return false;
+    }
+    for (int i = 0; i < len(*a); i++) {
+        Str sa = SerializeStruct(&gSjtFileStateInfo, (*a)[i]);
+        Str sb = SerializeStruct(&gSjtFileStateInfo, (*b)[i]);
+        bool same = str::Eq(sa, sb);
+        str::Free(sa);
+        str::Free(sb);
+        if (!same) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void InitSjtJournal(SettingsJournal* j, Str dir) {
+    j->itemInfo = &gSjtFileStateInfo;
+    j->getKey = GetSjtKey;
+    j->dir = dir;
+    j->indexFileName = StrL("journal.txt");
+    j->dataFileName = StrL("journal.bin");
+}
+
+static SjtFileState* FindSjtFileState(Vec<void*>* items, int n) {
+    TempStr path = fmt("C:\\Users\\me\\Documents\\book %d.pdf", n);
+    for (void* fs : *items) {
+        if (str::Eq(((SjtFileState*)fs)->filePath, path)) {
+            return (SjtFileState*)fs;
+        }
+    }
+    return nullptr;
+}
+
+// two processes share the journal: one journals its saves, the other picks them
+// up before its full write would throw them away
+static void TestTwoWriters() {
+    Str testDir = str::Dup(GetTempFilePathTemp(StrL("sjt2")));
+    utassert(testDir.len > 0);
+    file::Delete(testDir);
+    utassert(dir::Create(testDir));
+
+    // both started from the same settings file, written by the first one
+    Vec<void*>* items1 = NewSjtFileStates(8);
+    Vec<void*>* items2 = NewSjtFileStates(8);
+    SettingsJournal j1;
+    InitSjtJournal(&j1, testDir);
+    SettingsJournalLoad(&j1, items1, StrL("stamp 1"));
+    utassert(SettingsJournalReset(&j1, items1, StrL("rest 1"), StrL("stamp 1")));
+    SettingsJournal j2;
+    InitSjtJournal(&j2, testDir);
+    Str rest = SettingsJournalLoad(&j2, items2, StrL("stamp 1"));
+    utassert(!rest.s && SjtFileStatesEq(items1, items2));
+
+    // the first one re-opens book 2, forgets book 7 and scrolls in book 3
+    auto fs = FindSjtFileState(items1, 2);
+    items1->Remove(fs);
+    fs->pageNo = 77;
+    items1->InsertAt(0, fs);
+    fs = FindSjtFileState(items1, 7);
+    items1->Remove(fs);
+    FreeStruct(&gSjtFileStateInfo, fs);
+    FindSjtFileState(items1, 3)->pageNo = 78;
+    utassert(SettingsJournalAppend(&j1, items1, StrL("rest 1")));
+
+    // meanwhile the second one changed book 3 as well and book 4, not saved yet
+    FindSjtFileState(items2, 3)->rotation = 90;
+    FindSjtFileState(items2, 4)->rotation = 180;
+    utassert(2 == SettingsJournalSync(&j2, items2));
+    utassert(7 == len(*items2));
+    utassert(77 == ((SjtFileState*)(*items2)[0])->pageNo);
+    utassert(!FindSjtFileState(items2, 7));
+    // its own change wins over the older one of the other process
+    utassert(90 == FindSjtFileState(items2, 3)->rotation && 78 != FindSjtFileState(items2, 3)->pageNo);
+    utassert(180 == FindSjtFileState(items2, 4)->rotation);
+    // nothing new since
+    utassert(0 == SettingsJournalSync(&j2, items2));
+
+    // its full write folds everything in; loading it gives back what it wrote
+    utassert(SettingsJournalReset(&j2, items2, StrL("rest 2"), StrL("stamp 2")));
+    SettingsJournalClose(&j2);
+    Vec<void*>* onDisk = NewSjtFileStates(0);
+    for (void* item : *items2) {
+        Str data = SerializeStruct(&gSjtFileStateInfo, item);
+        onDisk->Append(DeserializeStruct(&gSjtFileStateInfo, data));
+        str::Free(data);
+    }
+    rest = SettingsJournalLoad(&j2, onDisk, StrL("stamp 2"));
+    utassert(!rest.s && SjtFileStatesEq(onDisk, items2));
+    SettingsJournalClose(&j2);
+    SettingsJournalClose(&j1);
+
+    FreeSjtFileStates(onDisk);
+    FreeSjtFileStates(items1);
+    FreeSjtFileStates(items2);
+    utassert(dir::RemoveAll(testDir));
+    str::Free(testDir);
+}
+
+static SjtFileState* gSjtInUse = nullptr;
+
+static bool IsSjtInUse(const void* item) {
+    return item == gSjtInUse;
+}
+
+// the app holds pointers to items (a window showing a document): picking up the
+// changes of another process must update those, not replace them
+static void TestSyncKeepsItems() {
+    Str testDir = str::Dup(GetTempFilePathTemp(StrL("sjt3")));
+    utassert(testDir.len > 0);
+    file::Delete(testDir);
+    utassert(dir::Create(testDir));
+
+    // both did a full write of the same settings, the first one last
+    Vec<void*>* items1 = NewSjtFileStates(8);
+    Vec<void*>* items2 = NewSjtFileStates(8);
+    SettingsJournal j2;
+    InitSjtJournal(&j2, testDir);
+    j2.isItemInUse = IsSjtInUse;
+    SettingsJournalLoad(&j2, items2, StrL("stamp 1"));
+    utassert(SettingsJournalReset(&j2, items2, StrL("rest 1"), StrL("stamp 1")));
+    SettingsJournal j1;
+    InitSjtJournal(&j1, testDir);
+    SettingsJournalLoad(&j1, items1, StrL("stamp 1"));
+    utassert(SettingsJournalReset(&j1, items1, StrL("rest 1"), StrL("stamp 1")));
+
+    SjtFileState* book3 = FindSjtFileState(items2, 3);
+    SjtFileState* book5 = FindSjtFileState(items2, 5);
+    gSjtInUse = FindSjtFileState(items2, 6);
+    utassert(1 == len(*book5->favorites));
+
+    // the first one re-opens book 3, removes the favorite of book 5 and forgets
+    // books 1 and 6
+    auto fs = FindSjtFileState(items1, 3);
+    items1->Remove(fs);
+    fs->pageNo = 55;
+    items1->InsertAt(0, fs);
+    fs = FindSjtFileState(items1, 5);
+    FreeStruct(&gSjtFavoriteInfo, fs->favorites->Pop());
+    for (int n : {1, 6}) {
+        fs = FindSjtFileState(items1, n);
+        items1->Remove(fs);
+        FreeStruct(&gSjtFileStateInfo, fs);
+    }
+    utassert(SettingsJournalAppend(&j1, items1, StrL("rest 1")));
+
+    utassert(3 == SettingsJournalSync(&j2, items2));
+    utassert(book3 == (*items2)[0] && 55 == book3->pageNo);
+    utassert(book5 == FindSjtFileState(items2, 5) && 0 == len(*book5->favorites));
+    utassert(!FindSjtFileState(items2, 1));
+    // still shown: kept, not freed
+    utassert(gSjtInUse == FindSjtFileState(items2, 6) && 7 == len(*items2));
+    // what was picked up is in the journal already: not journaled again
+    int nRecords = j2.nRecords;
+    utassert(SettingsJournalAppend(&j2, items2, StrL("rest 1")));
+    utassert(nRecords == j2.nRecords);
+
+    // an item without a key can't be addressed by a record, and isn't confused
+    // with anything
+    auto noKey = (SjtFileState*)DeserializeStruct(&gSjtFileStateInfo, {});
+    str::ReplaceWithCopy(&noKey->filePath, StrL(""));
+    items2->Append(noKey);
+    FindSjtFileState(items1, 4)->rotation = 270;
+    utassert(SettingsJournalAppend(&j1, items1, StrL("rest 1")));
+    utassert(1 == SettingsJournalSync(&j2, items2));
+    utassert(270 == FindSjtFileState(items2, 4)->rotation);
+    utassert(noKey == items2->Last() && 8 == len(*items2));
+
+    SettingsJournalClose(&j2);
+    SettingsJournalClose(&j1);
+    gSjtInUse = nullptr;
+    FreeSjtFileStates(items1);
+    FreeSjtFileStates(items2);
+    utassert(dir::RemoveAll(testDir));
+    str::Free(testDir);
+}
+
+void SettingsJournalTest() {
+    Str testDir = str::Dup(GetTempFilePathTemp(StrL("sjt")));
+    utassert(testDir.len > 0);
+    file::Delete(testDir);
+    utassert(dir::Create(testDir));
+
+    // what the settings file holds
+    Vec<void*>* onDisk = NewSjtFileStates(8);
+    Vec<void*>* items = NewSjtFileStates(8);
+
+    SettingsJournal j;
+    InitSjtJournal(&j, testDir);
+    Str rest = SettingsJournalLoad(&j, items, StrL("stamp 1"));
+    utassert(!rest.s && j.isOpen && 8 == len(*items));
+    // nothing to compare against until the first full write
+    utassert(!SettingsJournalAppend(&j, items, StrL("rest 1")));
+    utassert(SettingsJournalReset(&j, items, StrL("rest 1"), StrL("stamp 1")));
+    utassert(SettingsJournalAppend(&j, items, StrL("rest 1")));
+    utassert(1 == j.nRecords);
+
+    // re-open a document: it moves to the front
+    auto fs = (SjtFileState*)(*items)[5];
+    items->RemoveAt(5);
+    fs->pageNo = 42;
+    items->InsertAt(0, fs);
+    // forget one, open a new one
+    FreeStruct(&gSjtFileStateInfo, (*items)[7]);
+    items->RemoveAt(7);
+    items->InsertAt(0, NewSjtFileState(100));
+    utassert(SettingsJournalAppend(&j, items, StrL("rest 1")));
+    utassert(4 == j.nRecords);
+    // no changes, no records
+    utassert(SettingsJournalAppend(&j, items, StrL("rest 1")));
+    utassert(4 == j.nRecords);
+    ((SjtFileState*)(*items)[3])->rotation = 90;
+    utassert(SettingsJournalAppend(&j, items, StrL("rest 2")));
+    utassert(6 == j.nRecords);
+    SettingsJournalClose(&j);
+
+    // replaying on top of the settings file gives back what we had
+    rest = SettingsJournalLoad(&j, onDisk, StrL("stamp 1"));
+    utassert(str::Eq(rest, StrL("rest 2")));
+    str::Free(rest);
+    utassert(SjtFileStatesEq(onDisk, items));
+    SettingsJournalClose(&j);
+
+    // the settings file was edited by hand: its rest wins over the journal's,
+    // the list changes still apply, on top of the edit
+    Vec<void*>* edited = NewSjtFileStates(8);
+    ((SjtFileState*)(*edited)[6])->isPinned = true;
+    rest = SettingsJournalLoad(&j, edited, StrL("stamp 2"));
+    utassert(!rest.s && 8 == len(*edited));
+    auto pinned = (SjtFileState*)(*items)[7];
+    utassert(str::Eq(pinned->filePath, ((SjtFileState*)(*edited)[7])->filePath));
+    pinned->isPinned = true;
+    utassert(SjtFileStatesEq(edited, items));
+    pinned->isPinned = false;
+    // until the next full write the journal can't be appended to
+    utassert(!SettingsJournalAppend(&j, edited, StrL("rest 2")));
+    SettingsJournalClose(&j);
+
+    // too many changes at once: caller has to do a full write
+    utassert(SettingsJournalReset(&j, items, StrL("rest 2"), StrL("stamp 3")));
+    j.maxChangesPerAppend = 2;
+    for (int i = 0; i < 3; i++) {
+        ((SjtFileState*)(*items)[i])->openCount += 10;
+    }
+    utassert(!SettingsJournalAppend(&j, items, StrL("rest 2")));
+    SettingsJournalClose(&j);
+
+    FreeSjtFileStates(onDisk);
+    FreeSjtFileStates(items);
+    FreeSjtFileStates(edited);
+    utassert(dir::RemoveAll(testDir));
+    str::Free(testDir);
+
+    TestTwoWriters();
+    TestSyncKeepsItems();
+}
+
+// -bench-settings: the cost of a save and of a startup parse with a long history
+void SettingsJournal_Benchmark() {
+    const int kFileStates = 10000;
+    const int kSaves = 20;
+
+    Str testDir = str::Dup(GetTempFilePathTemp(StrL("sjb")));
+    file::Delete(testDir);
+    dir::Create(testDir);
+    TempStr settingsPath = path::JoinTemp(testDir, StrL("settings.txt"));
+
+    auto prefs = (SjtPrefs*)DeserializeStruct(&gSjtPrefsInfo, {});
+    auto items = (Vec<void*>*)prefs->fileStates;
+    for (int i = 0; i < kFileStates; i++) {
+        items->Append(NewSjtFileState(i));
+    }
+    Str data = SerializeStruct(&gSjtPrefsInfo, prefs);
+    file::WriteFile(settingsPath, data);
+    printf("%d file states, %d KB of settings\n", kFileStates, data.len / 1024);
+
+    auto t = TimeGet();
+    for (int i = 0; i < kSaves; i++) {
+        Str prev = file::ReadFile(settingsPath);
+        Str s = SerializeStruct(&gSjtPrefsInfo, prefs, prev);
+        file::WriteFile(settingsPath, s);
+        str::Free(prev);
+        str::Free(s);
+    }
+    printf("full save            : %.2f ms\n", TimeSinceInMs(t) / kSaves);
+
+    t = TimeGet();
+    auto parsed = (SjtPrefs*)DeserializeStruct(&gSjtPrefsInfo, data);
+    printf("startup parse        : %.2f ms\n", TimeSinceInMs(t));
+    FreeStruct(&gSjtPrefsInfo, parsed);
+
+    t = TimeGet();
+    SquareTreeNode* root = ParseSquareTree(data);
+    SquareTreeNode* list = root->GetChild(StrL("FileStates"));
+    int off = 0;
+    int n = 0;
+    while (SquareTreeNode* node = list->GetChild(StrL(""), &off)) {
+        n += !str::IsNull(node->GetValue(StrL("FilePath")));
+    }
+    printf("parse and walk list  : %.2f ms (%d)\n", TimeSinceInMs(t), n);
+    delete root;
+
+    SettingsJournal j;
+    InitSjtJournal(&j, testDir);
+    SettingsJournalLoad(&j, items, StrL("stamp"));
+    t = TimeGet();
+    SettingsJournalReset(&j, items, StrL("rest"), StrL("stamp"));
+    printf("journal reset        : %.2f ms\n", TimeSinceInMs(t));
+
+    // the typical save: one document moved to the front with a new position
+    t = TimeGet();
+    bool ok = true;
+    for (int i = 0; i < kSaves; i++) {
+        void* fs = (*items)[kFileStates / 2 + i];
+        items->RemoveAt(kFileStates / 2 + i);
+        ((SjtFileState*)fs)->pageNo += 1;
+        items->InsertAt(0, fs);
+        ok &= SettingsJournalAppend(&j, items, StrL("rest"));
+    }
+    printf("journaled save       : %.2f ms (%s)\n", TimeSinceInMs(t) / kSaves, ok ? "ok" : "failed");
+    SettingsJournalClose(&j);
+
+    t = TimeGet();
+    auto replayed = (SjtPrefs*)DeserializeStruct(&gSjtPrefsInfo, data);
+    Str rest = SettingsJournalLoad(&j, (Vec<void*>*)replayed->fileStates, StrL("stamp"));
+    double ms = TimeSinceInMs(t);
+    bool same = SjtFileStatesEq((Vec<void*>*)replayed->fileStates, items);
+    printf("startup parse+replay : %.2f ms (%s)\n", ms, same ? "matches" : "differs");
+    str::Free(rest);
+    SettingsJournalClose(&j);
+
+    FreeStruct(&gSjtPrefsInfo, replayed);
+    FreeStruct(&gSjtPrefsInfo, prefs);
+    str::Free(data);
+    dir::RemoveAll(testDir);
+    str::Free(testDir);
+}
@@ -243,4 +243,60 @@ void SquareTreeTest() {
         delete a;
         delete b;
     }
+
+    // nodes with many items are looked up through a hash index: must behave
+    // exactly like the linear scan (case-insensitive keys, lists, removal)
+    {
+        str::Builder b;
+        b.Append(Str(UTF8_BOM));
+        for (int i = 0; i < 100; i++) {
+            b.Append(fmt("Key%d = %d\n", i, i));
+            b.Append(fmt("[\n item = %d \n]\n", i));
+            if (i % 10 == 0) {
+                b.Append(fmt("list = %d\nlist [\n item = %d \n]\n", i, i));
+            }
+        }
+        SquareTreeNode* root = ParseSquareTree(ToStrTemp(b));
+        utassert(root && 220 == len(root->data));
+        utassert(str::Eq(root->GetValue(StrL("key57")), StrL("57")));
+        utassert(str::Eq(root->GetValue(StrL("KEY99")), StrL("99")));
+        utassert(!root->GetValue(StrL("key100")) && !root->GetChild(StrL("key5")));
+
+        int off = 0;
+        int n = 0;
+        while (SquareTreeNode* node = root->GetChild(StrL(""), &off)) {
+            utassert(str::Eq(node->GetValue(StrL("item")), fmt("%d", n)));
+            n++;
+        }
+        utassert(100 == n && 220 == off);
+
+        // values and children sharing a key are separate lists
+        off = 0;
+        for (int i = 0; i < 100; i += 10) {
+            utassert(str::Eq(root->GetValue(StrL("List"), &off), fmt("%d", i)));
+        }
+        utassert(!root->GetValue(StrL("list"), &off));
+        off = 0;
+        for (int i = 0; i < 100; i += 10) {
+            SquareTreeNode* node = root->GetChild(StrL("list"), &off);
+            utassert(node && str::Eq(node->GetValue(StrL("item")), fmt("%d", i)));
+        }
+        utassert(!root->GetChild(StrL("list"), &off));
+
+        // resuming at an arbitrary index falls back to scanning
+        off = 5;
+        utassert(str::Eq(root->GetValue(StrL("list"), &off), StrL("10")));
+
+        // removal (as done by SettingsUtil for known fields) and appending
+        off = 0;
+        utassert(!str::IsNull(root->GetValue(StrL("key0"), &off)));
+        root->RemoveDataAt(off - 1);
+        utassert(!root->GetValue(StrL("key0")) && str::Eq(root->GetValue(StrL("key1")), StrL("1")));
+        SquareTreeNode* extra = ParseSquareTree(StrL("late = 1"));
+        root->data.Append(extra->data[0]);
+        extra->data.Reset();
+        delete extra;
+        utassert(str::Eq(root->GetValue(StrL("late")), StrL("1")));
+        delete root;
+    }
 }
@@ -0,0 +1,447 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "base/Timer.h"
+#include "TextSearchPattern.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+// expected is start, end of each match, in units (which are codepoints)
+static bool FindsAll(const char* pattern, bool fold, const char* text, std::initializer_list<int> expected) {
+    SearchPattern sp;
+    if (!sp.Compile(Str(pattern), fold)) {
+        return false;
+    }
+    Str s(text);
+    Vec<u32> units;
+    BuildSearchUnits(s, len(s), fold, units);
+    Vec<int> matches;
+    sp.FindAll(units.els, len(units), matches);
+    if (len(matches) != (int)expected.size()) {
+        return false;
+    }
+    int i = 0;
+    for (int m : expected) {
+        if (matches[i++] != m) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool FailsToCompile(const char* pattern) {
+    SearchPattern sp;
+    bool ok = sp.Compile(Str(pattern), true);
+    return !ok && !sp.IsValid() && len(sp.error) > 0;
+}
+
+static void TestCompileErrors() {
+    utassert(FailsToCompile("("));
+    utassert(FailsToCompile("a)"));
+    utassert(FailsToCompile("[ab"));
+    utassert(FailsToCompile("[z-a]"));
+    utassert(FailsToCompile("*a"));
+    utassert(FailsToCompile("a|+"));
+    utassert(FailsToCompile("^a"));
+    utassert(FailsToCompile("a$"));
+    utassert(FailsToCompile("\\bword"));
+    utassert(FailsToCompile("(a)\\1"));
+    utassert(FailsToCompile("(?=a)"));
+    utassert(FailsToCompile("a\\"));
+    utassert(FailsToCompile("a{2000}"));
+    utassert(FailsToCompile("a{3,2}"));
+    utassert(FailsToCompile("a**********"));
+    // too many NFA states
+    utassert(FailsToCompile("(((a{100}){100}){100})"));
+
+    SearchPattern sp;
+    utassert(sp.Compile(StrL("a"), true));
+    utassert(sp.IsValid());
+    // a failed compile drops the previous pattern
+    utassert(!sp.Compile(StrL("a("), true));
+    utassert(!sp.IsValid());
+}
+
+static void TestLiterals() {
+    utassert(FindsAll("abc", false, "xabcabcx", {1, 4, 4, 7}));
+    utassert(FindsAll("abc", false, "ab", {}));
+    utassert(FindsAll("abc", false, "", {}));
+    // escaped special characters and a { that isn't a repeat count
+    utassert(FindsAll("1\\.5\\*", false, "1x5* 1.5*", {5, 9}));
+    utassert(FindsAll("a{b", false, "a{b", {0, 3}));
+    utassert(FindsAll("\\x41\\u00e9", false, "A\xc3\xa9", {0, 2}));
+    // a space matches any whitespace, including a line break
+    utassert(FindsAll("end of", false, "end\nof end\tof", {0, 6, 7, 13}));
+}
+
+static void TestTermLists() {
+    // a list of terms is an alternation, all found in one pass
+    utassert(FindsAll("cat|dog|bird", false, "dog, cat and a bird", {0, 3, 5, 8, 15, 19}));
+    // overlapping terms: the leftmost match wins, then the longest one
+    utassert(FindsAll("he|she|hers", false, "ushers", {1, 4}));
+    utassert(FindsAll("ab|abcd|bc", false, "abcd abc", {0, 4, 5, 7}));
+    utassert(FindsAll("a|", false, "bab", {1, 2}));
+}
+
+static void TestClassesAndRepeats() {
+    utassert(FindsAll("[a-c]+", false, "xxabcbyc", {2, 6, 7, 8}));
+    utassert(FindsAll("[^a-c ]+", false, "ab xyz c", {3, 6}));
+    utassert(FindsAll("[]x]", false, "a]x", {1, 2, 2, 3}));
+    utassert(FindsAll("\\d{3}-\\d{4}", false, "call 555-1234 or 12-3456", {5, 13}));
+    utassert(FindsAll("[a-z]{2}-?\\d{3,4}", false, "ab123 cd-45678 e12", {0, 5, 6, 13}));
+    utassert(FindsAll("\\w+", false, "foo_1, bar", {0, 5, 7, 10}));
+    utassert(FindsAll("\\S+", false, "a bc\n d", {0, 1, 2, 4, 6, 7}));
+    utassert(FindsAll("colou?r", false, "color colour colouur", {0, 5, 6, 12}));
+    utassert(FindsAll("(?:ab)*c", false, "ababc c abab", {0, 5, 6, 7}));
+    utassert(FindsAll("a{2,}", false, "a aa aaaa", {2, 4, 5, 9}));
+    utassert(FindsAll("a.c", false, "abc a\nc", {0, 3}));
+    // matches don't overlap and empty matches aren't reported
+    utassert(FindsAll("x*", false, "axxbx", {1, 3, 4, 5}));
+}
+
+static void TestCase() {
+    utassert(FindsAll("Word", true, "word WORD wOrD", {0, 4, 5, 9, 10, 14}));
+    utassert(FindsAll("Word", false, "word WORD Word", {10, 14}));
+    utassert(FindsAll("[A-C]+", true, "abc ABC", {0, 3, 4, 7}));
+    utassert(FindsAll("[A-C]+", false, "abc ABC", {4, 7}));
+    // non-ASCII letters fold as well
+    utassert(FindsAll("\xc3\x89t\xc3\xa9", true, "\xc3\xa9T\xc3\x89", {0, 3}));
+}
+
+static void TestPatternFromText() {
+    utassert(str::Eq(SearchPatternFromText(StrL("/a|b/")), StrL("a|b")));
+    utassert(str::Eq(SearchPatternFromText(StrL("/x/")), StrL("x")));
+    utassert(len(SearchPatternFromText(StrL("//"))) == 0);
+    utassert(len(SearchPatternFromText(StrL("/a"))) == 0);
+    utassert(len(SearchPatternFromText(StrL("a/b/"))) == 0);
+    utassert(len(SearchPatternFromText(StrL("a|b"))) == 0);
+    // //text/ is a plain search for /text/
+    utassert(len(SearchPatternFromText(StrL("//a|b/"))) == 0);
+    utassert(len(SearchPatternFromText(StrL("///"))) == 0);
+    utassert(str::Eq(SearchLiteralFromText(StrL("//a|b/")), StrL("/a|b/")));
+    utassert(str::Eq(SearchLiteralFromText(StrL("///")), StrL("//")));
+    utassert(str::Eq(SearchLiteralFromText(StrL("/a|b/")), StrL("/a|b/")));
+    utassert(str::Eq(SearchLiteralFromText(StrL("//")), StrL("//")));
+    utassert(str::Eq(SearchLiteralFromText(StrL("a/b")), StrL("a/b")));
+}
+
+// The anchor of a plain text search used to be searched for in the UTF-8 text
+// of the page, codepoint by codepoint. FindSearchUnits() must find what these
+// did, also where its SIMD loops and their tails meet
+static bool IsSharpS(int c) {
+    return c != 0 && FoldCaseForSearch(c) == 0x00DF;
+}
+static bool IsLatinS(int c) {
+    return c != 0 && FoldCaseForSearch(c) == L's';
+}
+
+static bool MatchSearchUnit(Str h, int hLen, int hIdx, int hByteIdx, Str n, int nLen, int nIdx, int nByteIdx, int& hAdv,
+                            int& nAdv, int& hByteAdv, int& nByteAdv) {
+    hAdv = nAdv = hByteAdv = nByteAdv = 0;
+    if (hIdx >= hLen || nIdx >= nLen) {
+        return false;
+    }
+    int hNextByte = hByteIdx;
+    int hc = Utf8CodepointNext(h, hNextByte);
+    int nNextByte = nByteIdx;
+    int nc = Utf8CodepointNext(n, nNextByte);
+    // ß in the needle matches "ss" in the text
+    if (IsSharpS(nc) && hIdx + 1 < hLen && IsLatinS(hc)) {
+        int hAfterNextByte = hNextByte;
+        int hNextChar = Utf8CodepointNext(h, hAfterNextByte);
+        if (IsLatinS(hNextChar)) {
+            hAdv = 2;
+            nAdv = 1;
+            hByteAdv = hAfterNextByte - hByteIdx;
+            nByteAdv = nNextByte - nByteIdx;
+            return true;
+        }
+    }
+    // "ss" in the needle matches ß in the text
+    if (nIdx + 1 < nLen && IsLatinS(nc) && IsSharpS(hc)) {
+        int nAfterNextByte = nNextByte;
+        int nNextChar = Utf8CodepointNext(n, nAfterNextByte);
+        if (IsLatinS(nNextChar)) {
+            hAdv = 1;
+            nAdv = 2;
+            hByteAdv = hNextByte - hByteIdx;
+            nByteAdv = nAfterNextByte - nByteIdx;
+            return true;
+        }
+    }
+    // everything else (including ß~ß and ss~ss) matches one-to-one
+    if (FoldCaseForSearch(hc) == FoldCaseForSearch(nc)) {
+        hAdv = 1;
+        nAdv = 1;
+        hByteAdv = hNextByte - hByteIdx;
+        nByteAdv = nNextByte - nByteIdx;
+        return true;
+    }
+    return false;
+}
+
+static int StrStrFoldCase(Str haystack, int haystackLen, int startOff, Str needle, int needleLen) {
+    if (!haystack || !needle) {
+        return startOff;
+    }
+    int byteIdx = Utf8CodepointToByteIndex(haystack, startOff);
+    for (int i = startOff; i < haystackLen; i++) {
+        int hIdx = i;
+        int hByteIdx = byteIdx;
+        int nIdx = 0;
+        int nByteIdx = 0;
+        bool isMatch = true;
+        while (nIdx < needleLen) {
+            if (hIdx >= haystackLen) {
+                isMatch = false;
+                break;
+            }
+            int hAdv, nAdv, hByteAdv, nByteAdv;
+            if (!MatchSearchUnit(haystack, haystackLen, hIdx, hByteIdx, needle, needleLen, nIdx, nByteIdx, hAdv, nAdv,
+                                 hByteAdv, nByteAdv)) {
+                isMatch = false;
+                break;
+            }
+            hIdx += hAdv;
+            nIdx += nAdv;
+            hByteIdx += hByteAdv;
+            nByteIdx += nByteAdv;
+        }
+        if (isMatch) {
+            return i;
+        }
+        Utf8CodepointNext(haystack, byteIdx);
+    }
+    return -1;
+}
+
+static bool StartsWithAtByte(Str text, int byteIdx, Str prefix) {
+    return text && prefix && byteIdx >= 0 && byteIdx + prefix.len <= text.len &&
+           memcmp(text.s + byteIdx, prefix.s, prefix.len) == 0;
+}
+
+static int StrRStr(Str text, int textLen, int endOff, Str needle, int needleLen) {
+    if (!text || !needle || endOff <= 0 || endOff > textLen) {
+        return -1;
+    }
+    if (needleLen <= 0 || needleLen > endOff) {
+        return -1;
+    }
+    int result = -1;
+    int byteIdx = 0;
+    for (int i = 0; i <= endOff - needleLen; i++) {
+        if (StartsWithAtByte(text, byteIdx, needle)) {
+            result = i;
+        }
+        Utf8CodepointNext(text, byteIdx);
+    }
+    return result;
+}
+
+static int StrRStrFoldCase(Str text, int textLen, int endOff, Str needle, int needleLen) {
+    if (!text || !needle || endOff <= 0 || endOff > textLen) {
+        return -1;
+    }
+    // ß <-> ss makes the matched length variable, so scan forward within
+    // [start, end) and remember the last start position that matches.
+    int result = -1;
+    int byteIdx = 0;
+    for (int i = 0; i < endOff; i++) {
+        int hIdx = i;
+        int hByteIdx = byteIdx;
+        int nIdx = 0;
+        int nByteIdx = 0;
+        bool isMatch = true;
+        while (nIdx < needleLen) {
+            if (hIdx >= endOff) {
+                isMatch = false;
+                break;
+            }
+            int hAdv, nAdv, hByteAdv, nByteAdv;
+            if (!MatchSearchUnit(text, textLen, hIdx, hByteIdx, needle, needleLen, nIdx, nByteIdx, hAdv, nAdv, hByteAdv,
+                                 nByteAdv)) {
+                isMatch = false;
+                break;
+            }
+            hIdx += hAdv;
+            nIdx += nAdv;
+            hByteIdx += hByteAdv;
+            nByteIdx += nByteAdv;
+        }
+        if (isMatch) {
+            result = i;
+        }
+        Utf8CodepointNext(text, byteIdx);
+    }
+    return result;
+}
+
+static int StrStr(Str haystack, int haystackLen, int startOff, Str needle, int needleLen) {
+    if (!haystack || len(needle) == 0) {
+        return -1;
+    }
+    int byteIdx = Utf8CodepointToByteIndex(haystack, startOff);
+    for (int i = startOff; i <= haystackLen - needleLen; i++) {
+        if (StartsWithAtByte(haystack, byteIdx, needle)) {
+            return i;
+        }
+        Utf8CodepointNext(haystack, byteIdx);
+    }
+    return -1;
+}
+
+static int OldFind(Str text, Str needle, int startOff, bool forward, bool matchCase) {
+    int textLen = Utf8CodepointCount(text);
+    int needleLen = Utf8CodepointCount(needle);
+    if (forward) {
+        if (matchCase) {
+            return StrStr(text, textLen, startOff, needle, needleLen);
+        }
+        return StrStrFoldCase(text, textLen, startOff, needle, needleLen);
+    }
+    if (matchCase) {
+        return StrRStr(text, textLen, startOff, needle, needleLen);
+    }
+    return StrRStrFoldCase(text, textLen, startOff, needle, needleLen);
+}
+
+static int NewFind(Str text, Str needle, int startOff, bool forward, bool matchCase) {
+    Vec<u32> h;
+    Vec<u32> n;
+    BuildSearchUnits(text, Utf8CodepointCount(text), !matchCase, h);
+    BuildSearchUnits(needle, Utf8CodepointCount(needle), !matchCase, n);
+    return FindSearchUnits(h.els, len(h), n.els, len(n), startOff, forward, !matchCase);
+}
+
+// finds at expected, the same as before
+static bool FindsAt(const char* text, const char* needle, int startOff, bool forward, bool matchCase, int expected) {
+    Str t(text);
+    Str n(needle);
+    int found = NewFind(t, n, startOff, forward, matchCase);
+    return found == expected && found == OldFind(t, n, startOff, forward, matchCase);
+}
+
+static void TestFindSearchUnits() {
+    // "Stra\xc3\x9f" is Straße, "\xc3\x89" É
+    const char* strasse = "Die Stra\xc3\x9f" "e, die Strasse";
+    utassert(FindsAt(strasse, "strasse", 0, true, false, 4));
+    utassert(FindsAt(strasse, "STRA\xc3\x9f" "E", 5, true, false, 16));
+    utassert(FindsAt(strasse, "\xc3\x9f", 0, true, false, 8));
+    utassert(FindsAt(strasse, "\xc3\x9f", 9, true, false, 20));
+    utassert(FindsAt(strasse, "ss", 0, true, false, 8));
+    utassert(FindsAt(strasse, "strasse", 23, false, false, 16));
+    utassert(FindsAt(strasse, "strasse", 22, false, false, 4));
+    utassert(FindsAt(strasse, "ss", 10, false, false, 8));
+    // match case: ß and ss are different letters
+    utassert(FindsAt(strasse, "Strasse", 0, true, true, 16));
+    utassert(FindsAt(strasse, "Strasse", 22, false, true, -1));
+    utassert(FindsAt(strasse, "strasse", 0, true, true, -1));
+    utassert(FindsAt("word Word WORD", "Word", 0, true, true, 5));
+    utassert(FindsAt("word Word WORD", "Word", 14, false, true, 5));
+    utassert(FindsAt("word Word WORD", "Word", 1, true, false, 5));
+    utassert(FindsAt("word Word WORD", "Word", 14, false, false, 10));
+    utassert(FindsAt("\xc3\x89t\xc3\xa9", "\xc3\xa9T", 0, true, false, 0));
+    // at the start and the end of the text
+    utassert(FindsAt("abcdefgh", "ab", 0, true, false, 0));
+    utassert(FindsAt("abcdefgh", "gh", 0, true, true, 6));
+    utassert(FindsAt("abcdefgh", "h", 7, true, false, 7));
+    utassert(FindsAt("abcdefgh", "gh", 8, false, true, 6));
+    utassert(FindsAt("abcdefgh", "gh", 7, false, false, -1));
+    utassert(FindsAt("abcdefgh", "ab", 2, false, false, 0));
+    utassert(FindsAt("abcdefgh", "ab", 1, false, false, -1));
+    utassert(FindsAt("abcdefgs", "s\xc3\x9f", 0, true, false, -1));
+    utassert(FindsAt("abcdefgs", "ss", 8, false, false, -1));
+    utassert(FindsAt("abcdefg\xc3\x9f", "ss", 8, false, false, 7));
+
+    // every start offset in texts of all lengths around the 4 units a SIMD
+    // compare takes, made of letters that fold and ß / ss
+    static const char* letters[] = {"a", "A", "s", "S", "\xc3\x9f", "\xc3\xa9", "\xc3\x89", " "};
+    u32 rand = 7;
+    auto next = [&rand](int n) {
+        rand = rand * 1103515245 + 12345;
+        return (int)((rand >> 8) % (u32)n);
+    };
+    bool same = true;
+    int nFound = 0;
+    for (int iter = 0; iter < 3000; iter++) {
+        // the old code didn't expect a page without text
+        str::Builder text;
+        int textLen = 1 + next(13);
+        for (int i = 0; i < textLen; i++) {
+            text.Append(Str(letters[next(dimofi(letters))]));
+        }
+        str::Builder needle;
+        int needleLen = 1 + next(3);
+        for (int i = 0; i < needleLen; i++) {
+            needle.Append(Str(letters[next(5)]));
+        }
+        Str t = ToStr(text);
+        Str n = ToStr(needle);
+        for (int startOff = 0; startOff <= textLen; startOff++) {
+            for (int flags = 0; flags < 4; flags++) {
+                bool forward = flags & 1;
+                bool matchCase = flags & 2;
+                int found = NewFind(t, n, startOff, forward, matchCase);
+                same &= found == OldFind(t, n, startOff, forward, matchCase);
+                nFound += found >= 0 ? 1 : 0;
+            }
+        }
+    }
+    utassert(same);
+    utassert(nFound > 10000);
+}
+
+void TextSearchPattern_UnitTests() {
+    TestCompileErrors();
+    TestLiterals();
+    TestTermLists();
+    TestClassesAndRepeats();
+    TestCase();
+    TestPatternFromText();
+    TestFindSearchUnits();
+}
+
+static u32 gRandState = 1;
+
+static int RandInt(int n) {
+    gRandState = (gRandState * 1103515245) + 12345;
+    return (int)((gRandState >> 8) % (u32)n);
+}
+
+// -bench-search-pattern: a list of terms searched in a big document
+void TextSearchPattern_Benchmark() {
+    const int kUnits = 4 * 1024 * 1024;
+    str::Builder text;
+    while (len(text) < kUnits) {
+        int k = RandInt(40);
+        text.AppendChar(k < 26 ? (char)('a' + k) : k < 36 ? (char)('0' + k - 26) : ' ');
+    }
+    Vec<u32> units;
+    BuildSearchUnits(ToStr(text), len(text), true, units);
+
+    for (int nTerms : {1, 10, 100, 300}) {
+        str::Builder pattern;
+        for (int i = 0; i < nTerms; i++) {
+            if (i > 0) {
+                pattern.AppendChar('|');
+            }
+            for (int j = 0; j < 4; j++) {
+                pattern.AppendChar((char)('a' + RandInt(26)));
+            }
+        }
+        SearchPattern sp;
+        auto t = TimeGet();
+        utassert(sp.Compile(ToStr(pattern), true));
+        double compileMs = TimeSinceInMs(t);
+        // the first pass builds the DFA states the text needs
+        for (int pass = 0; pass < 2; pass++) {
+            Vec<int> matches;
+            t = TimeGet();
+            sp.FindAll(units.els, len(units), matches);
+            printf("%3d terms, pass %d: %d matches in %.2f ms (compile: %.2f ms)\n", nTerms, pass, len(matches) / 2,
+                   TimeSinceInMs(t), compileMs);
+        }
+    }
+}
@@ -0,0 +1,170 @@
+/* Copyright 2026 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "base/Base.h"
+#include "base/Timer.h"
+#include "TocFilter.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+//  0 Introduction
+//  1   Scope of this Code
+//  2   Definitions
+//  3 Part I: Contracts
+//  4   Chapter 1: Formation of contracts
+//  5     Offer
+//  6     Acceptance
+//  7   Chapter 2: Breach of CONTRACT
+//  8 Appendix: Contract forms
+//  9   Straße
+static void AddTestToc(TocFilterIndex& idx) {
+    idx.Add(StrL("Introduction"), -1);
+    idx.Add(StrL("Scope of this Code"), 0);
+    idx.Add(StrL("Definitions"), 0);
+    idx.Add(StrL("Part I: Contracts"), -1);
+    idx.Add(StrL("Chapter 1: Formation of contracts"), 3);
+    idx.Add(StrL("Offer"), 4);
+    idx.Add(StrL("Acceptance"), 4);
+    idx.Add(StrL("Chapter 2: Breach of CONTRACT"), 3);
+    idx.Add(StrL("Appendix: Contract forms"), -1);
+    idx.Add(Str("STRA\xc3\x9f" "E"), 8);
+}
+
+static bool MatchesAre(TocFilterIndex& idx, std::initializer_list<int> expected) {
+    if (len(idx.matches) != (int)expected.size()) {
+        return false;
+    }
+    int i = 0;
+    for (int m : expected) {
+        if (idx.matches[i++] != m) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool MatchParentsAre(TocFilterIndex& idx, std::initializer_list<int> expected) {
+    if (len(idx.matchParents) != (int)expected.size()) {
+        return false;
+    }
+    int i = 0;
+    for (int m : expected) {
+        if (idx.matchParents[i++] != m) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void Test01() {
+    TocFilterIndex idx;
+    AddTestToc(idx);
+    utassert(idx.Count() == 10);
+
+    utassert(!idx.SetQuery(StrL("  ")));
+    utassert(len(idx.matches) == 0);
+
+    utassert(idx.SetQuery(StrL("contract")));
+    utassert(idx.nChecked == 10);
+    utassert(MatchesAre(idx, {3, 4, 7, 8}));
+    // "Chapter 1" and "Chapter 2" are under the matching "Part I"
+    utassert(MatchParentsAre(idx, {-1, 0, 0, -1}));
+
+    // extends the previous query: only its matches are checked
+    idx.SetQuery(StrL("contracts"));
+    utassert(idx.nChecked == 4);
+    utassert(MatchesAre(idx, {3, 4}));
+    utassert(MatchParentsAre(idx, {-1, 0}));
+
+    idx.SetQuery(StrL("CONTRACTS chap"));
+    utassert(idx.nChecked == 2);
+    utassert(MatchesAre(idx, {4}));
+    utassert(MatchParentsAre(idx, {-1}));
+
+    // not an extension: everything is checked again
+    idx.SetQuery(StrL("chap"));
+    utassert(idx.nChecked == 10);
+    utassert(MatchesAre(idx, {4, 7}));
+
+    idx.SetQuery(StrL("c"));
+    utassert(idx.nChecked == 10);
+    utassert(MatchesAre(idx, {0, 1, 3, 4, 6, 7, 8}));
+    idx.SetQuery(StrL("co"));
+    utassert(idx.nChecked == 7);
+    utassert(MatchesAre(idx, {1, 3, 4, 7, 8}));
+    utassert(MatchParentsAre(idx, {-1, -1, 1, 1, -1}));
+
+    idx.SetQuery(StrL("nothing like this"));
+    utassert(len(idx.matches) == 0 && len(idx.matchParents) == 0);
+}
+
+static void Test02() {
+    TocFilterIndex idx;
+    AddTestToc(idx);
+    // non-ASCII titles and words are case-folded too
+    idx.SetQuery(Str("stra\xc3\x9f"));
+    utassert(MatchesAre(idx, {9}));
+    utassert(MatchParentsAre(idx, {-1}));
+    idx.SetQuery(StrL("forms"));
+    utassert(MatchesAre(idx, {8}));
+    idx.SetQuery(StrL("a"));
+    utassert(MatchesAre(idx, {3, 4, 6, 7, 8, 9}));
+    utassert(MatchParentsAre(idx, {-1, 0, 1, 0, -1, 4}));
+}
+
+static void BuildBigToc(TocFilterIndex& idx, int nItems) {
+    // 3 levels: parts, chapters, sections
+    int part = -1;
+    int chapter = -1;
+    for (int i = 0; i < nItems; i++) {
+        if (i % 1000 == 0) {
+            part = idx.Add(fmt("Part %d", i / 1000), -1);
+        } else if (i % 50 == 0) {
+            chapter = idx.Add(fmt("Chapter %d of part %d", i / 50, i / 1000), part);
+        } else {
+            idx.Add(fmt("Section %d: Obligations and remedies %d", i, i % 7), chapter);
+        }
+    }
+}
+
+static void Test03() {
+    TocFilterIndex idx;
+    BuildBigToc(idx, 20000);
+    idx.SetQuery(StrL("chapter"));
+    utassert(len(idx.matches) == 20000 / 50 - 20000 / 1000);
+    for (int p : idx.matchParents) {
+        utassert(p == -1);
+    }
+    idx.SetQuery(StrL("part 1"));
+    // "Part 1", "Part 10".."Part 19" and their chapters
+    for (int i = 0; i < len(idx.matches); i++) {
+        int p = idx.matchParents[i];
+        utassert(p < i);
+    }
+    // words match anywhere: "Section 1999:" and "Section 11999:"
+    idx.SetQuery(StrL("section 1999:"));
+    utassert(MatchesAre(idx, {1999, 11999}));
+}
+
+void TocFilter_UnitTests() {
+    Test01();
+    Test02();
+    Test03();
+}
+
+// -bench-toc-filter: typing a query into the filter of a 100k item toc
+void TocFilter_Benchmark() {
+    const int kItems = 100000;
+    TocFilterIndex idx;
+    auto t = TimeGet();
+    BuildBigToc(idx, kItems);
+    printf("%d items, index     : %.2f ms\n", kItems, TimeSinceInMs(t));
+    Str queries[] = {StrL("o"), StrL("ob"), StrL("obl"), StrL("obli"), StrL("oblig"), StrL("oblig 3"), StrL("oblig 37")};
+    for (Str q : queries) {
+        t = TimeGet();
+        idx.SetQuery(q);
+        printf("'%.*s'%*s: %.2f ms, %d checked, %d matches\n", q.len, q.s, 10 - q.len, "", TimeSinceInMs(t),
+               idx.nChecked, len(idx.matches));
+    }
+}
@@ -0,0 +1,51 @@
+/* Copyright 2022 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "base/Base.h"
+#include "base/Trace.h"
+
+// must be last due to assert() over-write
+#include "base/UtAssert.h"
+
+static int CountOccurrences(Str s, const char* sub) {
+    int n = 0;
+    for (const char* p = strstr(s.s, sub); p; p = strstr(p + 1, sub)) {
+        n++;
+    }
+    return n;
+}
+
+void TraceTest() {
+    // off: nothing is recorded
+    {
+        TraceSpan span("trace test off");
+    }
+    // rounded up to the smallest ring of 1024 spans
+    TraceStart(1);
+    TraceSetThreadName(StrL("trace \"test\""));
+    for (int i = 0; i < 1500; i++) {
+        TraceSpan span("trace test", i);
+    }
+    {
+        TraceSpan span("trace test no arg");
+    }
+    TraceStop();
+    {
+        TraceSpan span("trace test stopped");
+    }
+
+    Str json = TraceExportJson();
+    utassert(str::StartsWith(json, StrL("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")));
+    utassert(str::EndsWith(json, StrL("]}\n")));
+    utassert(str::Contains(json, StrL("\"args\":{\"name\":\"trace \\\"test\\\"\"}")));
+    utassert(0 == CountOccurrences(json, "\"trace test off\""));
+    utassert(0 == CountOccurrences(json, "\"trace test stopped\""));
+    // the ring keeps the newest spans, minus the oldest one: once the ring is
+    // full that's the slot the thread writes next, so it might be half-written
+    utassert(1022 == CountOccurrences(json, "\"trace test\""));
+    utassert(1 == CountOccurrences(json, "\"trace test no arg\""));
+    utassert(str::Contains(json, StrL("\"args\":{\"arg\":478}")));
+    utassert(!str::Contains(json, StrL("\"args\":{\"arg\":477}")));
+    utassert(str::Contains(json, StrL("\"args\":{\"arg\":1499}")));
+    str::Free(json);
+}
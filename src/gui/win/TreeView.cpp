@@ -104,8 +104,31 @@ HWND TreeView::GetToolTipsHwnd() {
     return TreeView_GetToolTips(hwnd);
 }
 
+static void PopulateTreeItem(TreeView* treeView, TreeItem item, HTREEITEM parent);
+
+// children of a collapsed item are only inserted when it's expanded, so an
+// item that's asked for before that is inserted here, with its siblings
 HTREEITEM TreeView::GetHandleByTreeItem(TreeItem item) {
-    return (HTREEITEM)treeModel->GetUserData(item);
+    TreeModel* tm = treeModel;
+    if (!tm || item == TreeModel::kNullItem) {
+        return nullptr;
+    }
+    HTREEITEM res = (HTREEITEM)tm->GetUserData(item);
+    if (res) {
+        return res;
+    }
+    // top level items are always inserted
+    TreeItem parent = tm->Parent(item);
+    if (parent == TreeModel::kNullItem || parent == tm->Root()) {
+        return nullptr;
+    }
+    HTREEITEM hParent = GetHandleByTreeItem(parent);
+    if (!hParent || TreeView_GetChild(hwnd, hParent)) {
+        // children are already inserted, so item isn't in this tree
+        return nullptr;
+    }
+    PopulateTreeItem(this, parent, hParent);
+    return (HTREEITEM)tm->GetUserData(item);
 }
 
 // the result only valid until the next GetItem call
@@ -131,14 +154,10 @@ static TVITEMW* GetTVITEM(TreeView* tree, TreeItem ti) {
 // expand if collapse, collapse if expanded
 static void TreeViewToggle(TreeView* tree, HTREEITEM hItem, bool recursive) {
     HWND hTree = tree->hwnd;
-    HTREEITEM child = TreeView_GetChild(hTree, hItem);
-    if (!child) {
-        // only applies to nodes with children
-        return;
-    }
-
     TVITEMW* item = GetTVITEM(tree, hItem);
-    if (!item) {
+    // only applies to nodes with children (which are not inserted until
+    // the node is expanded for the first time)
+    if (!item || item->cChildren == 0) {
         return;
     }
     uint flag = TVE_EXPAND;
@@ -359,8 +378,10 @@ TreeItem TreeView::GetTreeItemByHandle(HTREEITEM item) {
 }
 
 static void FillTVITEM(TVITEMEXW* tvitem, TreeModel* tm, TreeItem ti) {
-    uint mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE;
+    uint mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_CHILDREN;
     tvitem->mask = mask;
+    // shows the expand button before the children are inserted
+    tvitem->cChildren = tm->ChildCount(ti) > 0 ? 1 : 0;
 
     uint stateMask = TVIS_EXPANDED;
     uint state = 0;
@@ -421,14 +442,32 @@ static void PopulateTreeItem(TreeView* treeView, TreeItem item, HTREEITEM parent
         auto ti = a[i];
         HTREEITEM h = insertItemFront(treeView, ti, parent);
         tm->SetUserData(ti, (uintptr_t)h);
-        // avoid recursing if not needed because we use a lot of stack space
-        if (tm->ChildCount(ti) > 0) {
+        // children of collapsed items are inserted on TVN_ITEMEXPANDING, which
+        // keeps trees with many thousands of items fast to show
+        if (tm->IsExpanded(ti) && tm->ChildCount(ti) > 0) {
             PopulateTreeItem(treeView, ti, h);
         }
     }
 }
 
+// handles of items that were inserted before are no longer valid and
+// GetHandleByTreeItem() relies on items not inserted yet having none
+static void ClearTreeUserData(TreeModel* tm) {
+    Vec<TreeItem> toVisit;
+    toVisit.Append(tm->Root());
+    while (len(toVisit) > 0) {
+        TreeItem ti = toVisit.Pop();
+        int n = tm->ChildCount(ti);
+        for (int i = 0; i < n; i++) {
+            TreeItem child = tm->ChildAt(ti, i);
+            tm->SetUserData(child, 0);
+            toVisit.Append(child);
+        }
+    }
+}
+
 static void PopulateTree(TreeView* treeView, TreeModel* tm) {
+    ClearTreeUserData(tm);
     TreeItem root = tm->Root();
     PopulateTreeItem(treeView, root, nullptr);
 }
@@ -583,6 +622,19 @@ void TreeView::OnNotifyReflect(ControlBase::NotifyReflectEvent* rev) {
         return;
     }
 
+    // https://learn.microsoft.com/en-us/windows/win32/controls/tvn-itemexpanding
+    if (code == TVN_ITEMEXPANDING) {
+        HTREEITEM hItem = nmtv->itemNew.hItem;
+        TreeItem ti = (TreeItem)nmtv->itemNew.lParam;
+        bool isExpand = bitmask::IsSet(nmtv->action, TVE_EXPAND);
+        if (isExpand && treeModel && ti && !TreeView_GetChild(hwnd, hItem) && treeModel->ChildCount(ti) > 0) {
+            PopulateTreeItem(this, ti, hItem);
+        }
+        // 0 allows the item to expand
+        rev->result = 0;
+        return;
+    }
+
     // https://docs.microsoft.com/en-us/windows/win32/controls/tvn-selchanged
     if (code == TVN_SELCHANGED) {
         // log(StrL("tv: TVN_SELCHANGED\n"));
@@ -9,6 +9,8 @@
 // -jxl:  jxldec vs WIC vs GDI+ on .jxl
 // Loads each file into memory once, times full decode (to pixels), 3 runs,
 // keeps the best time.
+// -png:  zopflipng recompression (what PngOptimizer does to saved PNGs) on one
+// thread vs on all cores
 
 #include "base/Base.h"
 #include "base/DirScan.h"
@@ -25,6 +27,8 @@
 #include "heic.h"
 #include "jxl.h"
 
+#include "zopflipng/zopflipng_lib.h"
+
 extern "C" {
 #include "jpeglib.h"
 }
@@ -44,6 +48,7 @@ enum class BenchFormat {
     Avif,
     Heif,
     Jxl,
+    Png,
 };
 
 static bool IsJpegPath(Str path) {
@@ -71,6 +76,11 @@ static bool IsJxlPath(Str path) {
     return str::EqI(ext, StrL(".jxl"));
 }
 
+static bool IsPngPath(Str path) {
+    TempStr ext = path::GetExtTemp(path);
+    return str::EqI(ext, StrL(".png"));
+}
+
 static bool MatchesFormat(Str path, BenchFormat fmt) {
     switch (fmt) {
         case BenchFormat::Jpeg:
@@ -83,6 +93,8 @@ static bool MatchesFormat(Str path, BenchFormat fmt) {
             return IsHeifPath(path);
         case BenchFormat::Jxl:
             return IsJxlPath(path);
+        case BenchFormat::Png:
+            return IsPngPath(path);
     }
     return false;
 }
@@ -452,6 +464,8 @@ static const char* NativeShortName(BenchFormat fmt) {
             return "heic";
         case BenchFormat::Jxl:
             return "jxl";
+        case BenchFormat::Png:
+            return "zopfli";
     }
     return "?";
 }
@@ -468,6 +482,8 @@ static const char* NativeLongName(BenchFormat fmt) {
             return "heicdec"; // HEVC pure-C
         case BenchFormat::Jxl:
             return "jxldec";
+        case BenchFormat::Png:
+            return "zopflipng";
     }
     return "?";
 }
@@ -483,6 +499,8 @@ static DecodeFn NativeDecodeFn(BenchFormat fmt) {
             return DecodeHeicdec;
         case BenchFormat::Jxl:
             return DecodeJxldec;
+        case BenchFormat::Png:
+            break; // not a decode benchmark, see BenchZopfli()
     }
     return DecodeLibjpegTurbo;
 }
@@ -499,6 +517,8 @@ static const char* FormatExts(BenchFormat fmt) {
             return ".heic/.heif";
         case BenchFormat::Jxl:
             return ".jxl";
+        case BenchFormat::Png:
+            return ".png";
     }
     return "";
 }
@@ -575,13 +595,82 @@ static void BenchFile(Str path, BenchFormat fmt, Totals& tot) {
            h, path.len, path.s);
 }
 
+// --- zopfli ----------------------------------------------------------------
+
+static double ZopfliMs(Str data, int nThreads, Str* out) {
+    CZopfliPNGOptions opts;
+    CZopfliPNGSetDefaults(&opts);
+    opts.num_threads = nThreads;
+    unsigned char* res = nullptr;
+    size_t resSize = 0;
+    auto t0 = TimeGet();
+    int err = CZopfliPNGOptimize((const unsigned char*)data.s, (size_t)data.len, &opts, 0, &res, &resSize);
+    double ms = TimeSinceInMs(t0);
+    if (err != 0 || !res) {
+        free(res);
+        return -1;
+    }
+    *out = str::Dup(Str((char*)res, (int)resSize));
+    free(res);
+    return ms;
+}
+
+// Recompresses each file once on one thread and once on all cores. Returns
+// false if a file fails or the threaded output isn't the same
+static bool BenchZopfli(const StrVec& files) {
+    int nCores = CpuCoreCount();
+    printf("format: zopflipng  files: %d  cores: %d\n", len(files), nCores);
+    printf("%9s  %9s  %9s  %9s  %7s  path\n", "size", "optimized", "1 thread", "threaded", "speedup");
+    printf("---------  ---------  ---------  ---------  -------  ----\n");
+    i64 totalBytes = 0;
+    double totalMs1 = 0;
+    double totalMsN = 0;
+    bool ok = true;
+    for (Str path : files) {
+        Str data = file::ReadFile(path);
+        if (!data) {
+            printf("READ FAIL  %.*s\n", path.len, path.s);
+            ok = false;
+            continue;
+        }
+        Str out1{};
+        Str outN{};
+        double ms1 = ZopfliMs(data, 1, &out1);
+        double msN = ZopfliMs(data, nCores, &outN);
+        bool same = ms1 >= 0 && msN >= 0 && str::Eq(out1, outN);
+        if (!same) {
+            printf("FAIL (%s)  %.*s\n", ms1 < 0 || msN < 0 ? "zopfli error" : "threaded output differs", path.len,
+                   path.s);
+            ok = false;
+        } else {
+            totalBytes += data.len;
+            totalMs1 += ms1;
+            totalMsN += msN;
+            printf("%9d  %9d  %9.0f  %9.0f  %6.2fx  %.*s\n", data.len, out1.len, ms1, msN, ms1 / msN, path.len,
+                   path.s);
+        }
+        str::Free(data);
+        str::Free(out1);
+        str::Free(outN);
+    }
+    if (totalMs1 > 0 && totalMsN > 0) {
+        double mb = (double)totalBytes / (1024.0 * 1024.0);
+        printf("\n=== totals ===\n");
+        printf("1 thread: %.2f MB in %.0f ms, %.3f MB/s\n", mb, totalMs1, mb * 1000.0 / totalMs1);
+        printf("threaded: %.2f MB in %.0f ms, %.3f MB/s (%.2fx)\n", mb, totalMsN, mb * 1000.0 / totalMsN,
+               totalMs1 / totalMsN);
+    }
+    return ok;
+}
+
 static void Usage() {
-    printf("usage: bench_image -jpeg|-webp|-avif|-heif|-jxl <file-or-dir>\n");
+    printf("usage: bench_image -jpeg|-webp|-avif|-heif|-jxl|-png <file-or-dir>\n");
     printf("  -jpeg  bench .jpg/.jpeg with libjpeg-turbo vs WIC vs GDI+\n");
     printf("  -webp  bench .webp with libwebp vs WIC vs GDI+\n");
     printf("  -avif  bench .avif with heicdec+dav1d vs WIC vs GDI+\n");
     printf("  -heif  bench .heic/.heif with heicdec vs WIC vs GDI+\n");
     printf("  -jxl   bench .jxl with jxldec vs WIC vs GDI+\n");
+    printf("  -png   bench .png recompression with zopflipng, 1 thread vs all cores\n");
     printf("  Recursively finds matching files under a directory.\n");
     printf("  Loads each file into memory, decodes 3x per backend, reports best ms.\n");
 }
@@ -609,6 +698,9 @@ int main(int argc, char** argv) {
         } else if (str::EqI(arg, StrL("-jxl")) || str::EqI(arg, StrL("--jxl"))) {
             fmt = BenchFormat::Jxl;
             haveFmt = true;
+        } else if (str::EqI(arg, StrL("-png")) || str::EqI(arg, StrL("--png"))) {
+            fmt = BenchFormat::Png;
+            haveFmt = true;
         } else if (str::EqI(arg, StrL("-h")) || str::EqI(arg, StrL("--help")) || str::EqI(arg, StrL("/?"))) {
             Usage();
             return 0;
@@ -640,6 +732,9 @@ int main(int argc, char** argv) {
         printf("no %s files under '%.*s'\n", FormatExts(fmt), root.len, root.s);
         return 1;
     }
+    if (fmt == BenchFormat::Png) {
+        return BenchZopfli(files) ? 0 : 1;
+    }
 
     const char* nativeShort = NativeShortName(fmt);
     const char* nativeLong = NativeLongName(fmt);
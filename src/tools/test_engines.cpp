@@ -16,8 +16,23 @@
 #include "TextSelection.h"
 #include "ProgressUpdateUI.h"
 #include "TextSearch.h"
+#include "TextExport.h"
 #include "LitDoc.h"
 
+extern "C" {
+#include <mupdf/fitz.h>
+}
+
+// in mupdf_load_system_font.c
+extern "C" {
+void set_system_font_dirs(const char* const* dirs, int nDirs);
+void set_system_font_cache_path(const char* path);
+int build_system_font_index(fz_context* ctx);
+void reset_system_font_index(void);
+void get_system_font_index_stats(int* nFiles, int* nNames, int* nParsed);
+int check_system_font_index(void);
+}
+
 void _uploadDebugReport(Str, Str, bool, bool) {}
 
 void log(Str s) {
@@ -45,6 +60,8 @@ static void Usage() {
     printf("       test_engines <path> -find-text <term> search all pages for text\n");
     printf("       test_engines <path> -list-toc        list table-of-contents entries\n");
     printf("       test_engines <path> -list-properties list document properties\n");
+    printf("       test_engines <path> -extract-text <dst.txt> [threads]  write the text of all pages\n");
+    printf("       test_engines -bench-font-index [<font-dir>...]  time building the system font index\n");
 }
 
 static EngineBase* CreateEngineForPath(Str path) {
@@ -155,13 +172,26 @@ static bool FindText(Str path, Str term) {
 
     TextSearch search(engine);
     search.SetDirection(TextSearch::Direction::Forward);
-    TextSel* result = search.FindFirst(1, term);
+    // the first pass also extracts the text of the pages, the next ones only search it
     int matches = 0;
-    while (result) {
-        matches++;
-        result = search.FindNext();
+    for (int pass = 0; pass < 3; pass++) {
+        bool matchCase = pass == 2;
+        search.SetMatchCase(matchCase);
+        auto timeStart = TimeGet();
+        TextSel* result = search.FindFirst(1, term);
+        int n = 0;
+        while (result) {
+            n++;
+            result = search.FindNext();
+        }
+        double ms = TimeSinceInMs(timeStart);
+        if (pass == 0) {
+            matches = n;
+            printf("matches: %d\n", matches);
+        }
+        printf("%s%s: %d matches in %.2f ms\n", matchCase ? "match case" : "ignore case",
+               pass == 0 ? " (with text extraction)" : "", n, ms);
     }
-    printf("matches: %d\n", matches);
     engine->Release();
     return matches > 0;
 }
@@ -206,6 +236,30 @@ static bool ListProperties(Str path) {
     return len(props) > 0;
 }
 
+// Headless text export (the Extract Text tool for non-PDF documents), for
+// batch jobs and for timing the parallel pipeline: pass threads=1 to compare
+static bool ExtractText(Str path, Str destPath, int nThreads) {
+    EngineBase* engine = CreateEngineForPath(path);
+    if (!engine) {
+        printf("failed to load: %.*s\n", path.len, path.s);
+        return false;
+    }
+    TextExportArgs args;
+    args.engine = engine;
+    args.destPath = destPath;
+    args.nThreads = nThreads;
+    for (int pageNo = 1; pageNo <= engine->PageCount(); pageNo++) {
+        args.pages.Append(pageNo);
+    }
+    auto t = TimeGet();
+    bool ok = ExportDocumentText(&args);
+    double ms = TimeSinceInMs(t);
+    i64 size = file::GetSize(destPath);
+    printf("extract text: %d pages, %.2f ms, %lld bytes, ok: %d\n", len(args.pages), ms, (long long)size, (int)ok);
+    engine->Release();
+    return ok;
+}
+
 // Times PageMediabox() for every page: that's what the UI needs before it can
 // lay out a document, and for image dirs / cbx it's the dominant open cost.
 static bool BenchMediabox(Str path) {
@@ -437,7 +491,78 @@ static bool BenchReadN(Str dir) {
     return bytesNew == bytesCrt;
 }
 
+// Times building the index of installed fonts, which a document without
+// embedded fonts waits for: from scratch, then from the index file the first
+// build saved, which is what every launch after the first one does.
+// No dirs: the Windows fonts directory
+static bool BenchFontIndex(char** dirs, int nDirs) {
+    TempStr indexPath = GetTempFilePathTemp(StrL("fidx"));
+    if (!indexPath) {
+        printf("BenchFontIndex: couldn't get a temp file\n");
+        return false;
+    }
+    // GetTempFilePathTemp() created it empty, as if there was no index yet
+    file::Delete(indexPath);
+    fz_context* ctx = fz_new_context(nullptr, nullptr, FZ_STORE_DEFAULT);
+    if (!ctx) {
+        return false;
+    }
+    set_system_font_dirs(dirs, nDirs);
+    set_system_font_cache_path(CStrTemp(indexPath));
+
+    bool ok = true;
+    const char* names[] = {"cold (no index file)", "warm (from index file)"};
+    for (int i = 0; i < 2; i++) {
+        reset_system_font_index();
+        auto t = TimeGet();
+        fz_try(ctx) {
+            build_system_font_index(ctx);
+        }
+        fz_catch(ctx) {
+            fz_report_error(ctx);
+            ok = false;
+        }
+        double ms = TimeSinceInMs(t);
+        int nFiles = 0;
+        int nNames = 0;
+        int nParsed = 0;
+        get_system_font_index_stats(&nFiles, &nNames, &nParsed);
+        int nBad = check_system_font_index();
+        printf("%-22s: %8.2f ms, %d files (%d parsed), %d names\n", names[i], ms, nFiles, nParsed, nNames);
+        if (nBad != 0) {
+            printf("  %d names are found in a different font by the hash lookup\n", nBad);
+            ok = false;
+        }
+        // nothing changed since the first build, so nothing needs parsing
+        if (i == 1 && nParsed != 0) {
+            printf("  the index file wasn't used\n");
+            ok = false;
+        }
+    }
+    reset_system_font_index();
+    set_system_font_dirs(nullptr, 0);
+    set_system_font_cache_path(nullptr);
+    fz_drop_context(ctx);
+    file::Delete(indexPath);
+    printf("BenchFontIndex: %s\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
 int main(int argc, char** argv) {
+    if (argc >= 2 && str::Eq(argv[1], StrL("-bench-font-index"))) {
+        bool ok = BenchFontIndex(argv + 2, argc - 2);
+        DestroyTempArena();
+        return ok ? 0 : 1;
+    }
+    if ((argc == 4 || argc == 5) && str::Eq(argv[2], StrL("-extract-text"))) {
+        int nThreads = 0;
+        if (argc == 5) {
+            str::Parse(Str(argv[4]), "%d", &nThreads);
+        }
+        bool ok = ExtractText(Str(argv[1]), Str(argv[3]), nThreads);
+        DestroyTempArena();
+        return ok ? 0 : 1;
+    }
     if (argc == 4 && str::Eq(argv[2], StrL("-find-text"))) {
         bool ok = FindText(Str(argv[1]), Str(argv[3]));
         DestroyTempArena();
@@ -17,17 +17,36 @@ extern void CryptoUtilTest();
 extern void CssParser_UnitTests();
 extern void DictTest();
 extern void FileUtilTest();
+extern void GlyphIndex_UnitTests();
+extern void GlyphIndex_Benchmark();
 extern void GuessFileTypeTest();
+extern void GumboHtmlParser_UnitTests();
+extern void HtmlStyleSheet_UnitTests();
+extern void HtmlStyleSheet_Benchmark();
 extern void JsonTest();
+extern void PageStructure_UnitTests();
+extern void PixmapPool_UnitTests();
+extern void PixmapPool_Benchmark();
+extern void PixmapResize_UnitTests();
+extern void PixmapResize_Benchmark();
+extern void RectIndex_UnitTests();
 extern void RefHoverTest();
+extern void SettingsJournalTest();
 extern void SettingsUtilTest();
 extern void SimpleLogTest();
 extern void SquareTreeTest();
 extern void StrFormatTest();
 extern void StrTest();
+extern void TextSearchPattern_UnitTests();
+extern void TextSearchPattern_Benchmark();
+extern void TocFilter_UnitTests();
+extern void TocFilter_Benchmark();
+extern void TraceTest();
 extern void VecTest();
 extern void StrVecTest();
 extern void PdfDarkModeOklab_UnitTests();
+extern void PdfDarkModeOklab_Benchmark();
+extern void SettingsJournal_Benchmark();
 extern void PdfDarkModeImageClassifier_UnitTests();
 extern void AppendStoreTest();
 #if OS_WIN
@@ -87,12 +106,36 @@ static LONG WINAPI ForAiCrashHandler(EXCEPTION_POINTERS* exceptionInfo) {
 }
 #endif
 
+// "test_util.exe -bench-<name>" runs only that benchmark
+struct BenchmarkFlag {
+    const char* flag;
+    void (*fn)();
+};
+
+static BenchmarkFlag gBenchmarks[] = {
+    {"-bench-oklab", PdfDarkModeOklab_Benchmark},
+    {"-bench-settings", SettingsJournal_Benchmark},
+    {"-bench-css", HtmlStyleSheet_Benchmark},
+    {"-bench-toc-filter", TocFilter_Benchmark},
+    {"-bench-search-pattern", TextSearchPattern_Benchmark},
+    {"-bench-glyph-index", GlyphIndex_Benchmark},
+    {"-bench-resize", PixmapResize_Benchmark},
+    {"-bench-pixmap-pool", PixmapPool_Benchmark},
+};
+
 int main(int argc, char** argv) {
     bool forAi = false;
     for (int i = 1; i < argc; i++) {
-        if (str::Eq(Str(argv[i]), StrL("-for-ai"))) {
+        Str arg(argv[i]);
+        if (str::Eq(arg, StrL("-for-ai"))) {
             forAi = true;
         }
+        for (const BenchmarkFlag& b : gBenchmarks) {
+            if (str::Eq(arg, Str(b.flag))) {
+                b.fn();
+                return 0;
+            }
+        }
     }
     if (forAi) {
         setvbuf(stdout, nullptr, _IONBF, 0);
@@ -115,14 +158,25 @@ int main(int argc, char** argv) {
     DictTest();
     FileUtilTest();
     GuessFileTypeTest();
+    GumboHtmlParser_UnitTests();
+    HtmlStyleSheet_UnitTests();
     JsonTest();
     RefHoverTest();
+    SettingsJournalTest();
     SettingsUtilTest();
     SimpleLogTest();
     SquareTreeTest();
     StrFormatTest();
     StrTest();
     StrVecTest();
+    TextSearchPattern_UnitTests();
+    TocFilter_UnitTests();
+    GlyphIndex_UnitTests();
+    PageStructure_UnitTests();
+    PixmapPool_UnitTests();
+    PixmapResize_UnitTests();
+    RectIndex_UnitTests();
+    TraceTest();
     VecTest();
     PdfDarkModeOklab_UnitTests();
     PdfDarkModeImageClassifier_UnitTests();
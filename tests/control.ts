@@ -70,6 +70,7 @@ export enum ControlCommand {
   TestSelectionToolbar = 73,
   TestMarkupAnnots = 74,
   TestCmykImageSave = 75,
+  GetPerfStats = 76,
 }
 
 export type ControlArg = number | string | Uint8Array | ControlArg[];
@@ -110,6 +111,24 @@ export type LayoutInfo = {
   raw: string;
 };
 
+// one group of counters, e.g. "cache hits=12 misses=3" -> { hits: 12, misses: 3 }
+export type PerfCounters = Record<string, number | number[]>;
+
+export type PerfStats = {
+  sinceMs: number;
+  // by kind: visible, predictive, other. hist counts latencies < 1, 2, 4 ... 4096 ms and the rest
+  render: Record<string, PerfCounters>;
+  // by phase: engine, controller, finish, firstTile
+  load: Record<string, PerfCounters>;
+  // rendered tiles: bytes, copiedBytes (copied / converted after rendering), recoloredBytes
+  tiles: PerfCounters;
+  cache: PerfCounters;
+  find: PerfCounters;
+  ui: PerfCounters;
+  memory: PerfCounters;
+  raw: string;
+};
+
 const enum ArgType {
   End = 0,
   Int32 = 1,
@@ -483,6 +502,55 @@ export class ControlClient {
     };
   }
 
+  // Counters since the app started or the last "reset": render latencies,
+  // bytes copied per rendered tile, render cache hits, search throughput,
+  // load phase times and UI stalls.
+  // Reset, do the thing being measured, then check its budget.
+  async perfStats(action: "get" | "reset" = "get"): Promise<PerfStats> {
+    const res = await this.request(ControlCommand.GetPerfStats, [action]);
+    const code = typeof res[0] === "number" ? res[0] : -1;
+    const raw = String(res[1] ?? "").trim();
+    if (code !== 0) {
+      throw new Error(`GetPerfStats failed: ${raw || code}`);
+    }
+    const lines = raw.split("\n");
+    if (lines[0] !== "OK") {
+      throw new Error(`GetPerfStats: could not parse '${raw}'`);
+    }
+    const stats: PerfStats = {
+      sinceMs: 0,
+      render: {},
+      load: {},
+      tiles: {},
+      cache: {},
+      find: {},
+      ui: {},
+      memory: {},
+      raw,
+    };
+    for (const line of lines.slice(1)) {
+      const [group, ...pairs] = line.trim().split(" ");
+      let name = "";
+      const counters: PerfCounters = {};
+      for (const pair of pairs) {
+        const [k, v] = pair.split("=");
+        if (k === "kind" || k === "phase") {
+          name = v;
+        } else {
+          counters[k] = v.includes(",") ? v.split(",").map(Number) : Number(v);
+        }
+      }
+      if (group === "since") {
+        stats.sinceMs = counters.ms as number;
+      } else if (group === "render" || group === "load") {
+        stats[group][name] = counters;
+      } else if (group === "tiles" || group === "cache" || group === "find" || group === "ui" || group === "memory") {
+        stats[group] = counters;
+      }
+    }
+    return stats;
+  }
+
   // Notifications are drawn over the document and linger for ~2s, so a test
   // that reads pixels would have to wait them out. Turning them off also takes
   // down any that are already showing.
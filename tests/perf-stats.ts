@@ -0,0 +1,169 @@
+// GetPerfStats, the -dbg-control counters a perf test resets and then reads
+// back: render latencies, tiles, render cache, search, load phases, UI stalls
+// and memory.
+//
+// Opens a small text PDF and checks that loading it and showing its first page
+// was counted, that "reset" zeroes the counters, that a search is counted
+// afterwards and that an unknown action is an error. The numbers themselves
+// depend on the machine: only their presence and consistency are checked
+// (e.g. a latency histogram adds up to its count).
+
+import { writeFileSync } from "node:fs";
+import { ControlClient, ControlCommand, type PerfStats, withControlledSumatra } from "./control.ts";
+import { EXE, runStandalone, tmpPath } from "./util.ts";
+
+const WORD = "needle";
+const PAGE_COUNT = 3;
+// < 1, 2, 4 ... 4096 ms and the rest
+const HIST_BUCKETS = 14;
+
+// PAGE_COUNT pages with one line of text each, WORD on every page
+function buildPdf(): Buffer {
+  const objs: string[] = [];
+  objs[1] = "<< /Type /Catalog /Pages 2 0 R >>";
+  objs[3] = "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica /Encoding /WinAnsiEncoding >>";
+  const kids: number[] = [];
+  let objNum = 4;
+  for (let page = 1; page <= PAGE_COUNT; page++) {
+    const pageNum = objNum++;
+    const contentNum = objNum++;
+    kids.push(pageNum);
+    const content = `BT /F1 24 Tf 72 720 Td (page ${page} has a ${WORD} on it) Tj ET`;
+    objs[pageNum] =
+      `<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] ` +
+      `/Resources << /Font << /F1 3 0 R >> >> /Contents ${contentNum} 0 R >>`;
+    objs[contentNum] = `<< /Length ${content.length} >>\nstream\n${content}\nendstream`;
+  }
+  objs[2] = `<< /Type /Pages /Kids [${kids.map((k) => `${k} 0 R`).join(" ")}] /Count ${PAGE_COUNT} >>`;
+  const maxN = objNum - 1;
+
+  let pdf = "%PDF-1.5\n";
+  const offsets: number[] = [];
+  for (let i = 1; i <= maxN; i++) {
+    offsets.push(Buffer.byteLength(pdf, "latin1"));
+    pdf += `${i} 0 obj\n${objs[i]}\nendobj\n`;
+  }
+  const xrefPos = Buffer.byteLength(pdf, "latin1");
+  pdf += `xref\n0 ${maxN + 1}\n0000000000 65535 f \n`;
+  for (const off of offsets) {
+    pdf += off.toString().padStart(10, "0") + " 00000 n \n";
+  }
+  pdf += `trailer\n<< /Size ${maxN + 1} /Root 1 0 R >>\nstartxref\n${xrefPos}\n%%EOF\n`;
+  return Buffer.from(pdf, "latin1");
+}
+
+function check(ok: boolean, what: string, stats: PerfStats): void {
+  if (!ok) {
+    throw new Error(`perf-stats: ${what}\n${stats.raw}`);
+  }
+}
+
+function num(counters: Record<string, number | number[]> | undefined, key: string): number {
+  const v = counters?.[key];
+  return typeof v === "number" ? v : NaN;
+}
+
+// every group is there, with the counters a test relies on
+function checkShape(stats: PerfStats): void {
+  for (const kind of ["visible", "predictive", "other"]) {
+    const r = stats.render[kind];
+    check(r !== undefined, `no render kind=${kind}`, stats);
+    const hist = r.hist;
+    check(Array.isArray(hist) && hist.length === HIST_BUCKETS, `render ${kind}: hist length`, stats);
+    const sum = (hist as number[]).reduce((a, b) => a + b, 0);
+    check(sum === num(r, "count"), `render ${kind}: hist adds up to ${sum}, count is ${num(r, "count")}`, stats);
+  }
+  for (const phase of ["engine", "controller", "finish", "firstTile"]) {
+    check(stats.load[phase] !== undefined, `no load phase=${phase}`, stats);
+  }
+  for (const [group, key] of [
+    ["tiles", "bytes"],
+    ["cache", "hits"],
+    ["find", "pages"],
+    ["ui", "messages"],
+    ["memory", "renderCacheBytes"],
+  ] as const) {
+    check(!Number.isNaN(num(stats[group], key)), `no ${group} ${key}`, stats);
+  }
+  check(stats.sinceMs >= 0, "no since", stats);
+}
+
+// the first tile is counted once it's painted, which can be after the render
+async function waitForFirstTile(client: ControlClient): Promise<PerfStats> {
+  const deadline = Date.now() + 20_000;
+  for (;;) {
+    const stats = await client.perfStats();
+    if (num(stats.load.firstTile, "count") >= 1) {
+      return stats;
+    }
+    if (Date.now() > deadline) {
+      throw new Error(`perf-stats: the first tile was never counted\n${stats.raw}`);
+    }
+    await new Promise((r) => setTimeout(r, 200));
+  }
+}
+
+async function search(client: ControlClient): Promise<void> {
+  const deadline = Date.now() + 20_000;
+  for (;;) {
+    const res = await client.request(ControlCommand.TestFindResultsOrder, [WORD, 1]);
+    const raw = String(res[1] ?? "").trim();
+    if (!raw.includes("NOTREADY")) {
+      if (res[0] !== 0) {
+        throw new Error(`perf-stats: search failed: ${raw}`);
+      }
+      return;
+    }
+    if (Date.now() > deadline) {
+      throw new Error(`perf-stats: search never finished: ${raw}`);
+    }
+    await new Promise((r) => setTimeout(r, 200));
+  }
+}
+
+export async function testit(): Promise<void> {
+  const pdfPath = tmpPath("perf-stats.pdf");
+  writeFileSync(pdfPath, buildPdf());
+
+  await withControlledSumatra(
+    EXE,
+    async (client) => {
+      await client.waitForRenderIdle();
+      let stats = await waitForFirstTile(client);
+      checkShape(stats);
+      for (const phase of ["engine", "controller", "finish"]) {
+        check(num(stats.load[phase], "count") >= 1, `loading wasn't counted: phase=${phase}`, stats);
+      }
+      check(num(stats.render.visible, "count") >= 1, "no visible render counted", stats);
+      check(num(stats.tiles, "count") >= 1 && num(stats.tiles, "bytes") > 0, "no rendered tile counted", stats);
+      check(num(stats.cache, "hits") + num(stats.cache, "misses") >= 1, "no render cache lookup counted", stats);
+      check(num(stats.memory, "renderCacheBytes") > 0, "the rendered page isn't in the memory stats", stats);
+      check(num(stats.ui, "messages") > 0, "no UI message counted", stats);
+
+      stats = await client.perfStats("reset");
+      checkShape(stats);
+      check(num(stats.render.visible, "count") === 0, "reset kept the render counts", stats);
+      check(num(stats.load.engine, "count") === 0, "reset kept the load counts", stats);
+      check(num(stats.find, "pages") === 0, "reset kept the search counts", stats);
+      // memory is what's held now, not a counter: the page is still cached
+      check(num(stats.memory, "renderCacheBytes") > 0, "reset dropped the memory stats", stats);
+
+      await search(client);
+      stats = await client.perfStats();
+      check(num(stats.find, "pages") >= 1 && num(stats.find, "bytes") > 0, "the search wasn't counted", stats);
+      check(num(stats.load.engine, "count") === 0, "a search counted as a load", stats);
+
+      const res = await client.request(ControlCommand.GetPerfStats, ["bogus"]);
+      const raw = String(res[1] ?? "");
+      if (res[0] !== 1 || !raw.includes("unknown-action")) {
+        throw new Error(`perf-stats: an unknown action wasn't an error: ${res[0]} ${raw}`);
+      }
+      console.log(`perf-stats: ok, since reset: ${stats.raw.split("\n").find((l) => l.startsWith("find")) ?? ""}`);
+    },
+    [pdfPath],
+  );
+}
+
+if (import.meta.main) {
+  await runStandalone(testit);
+}
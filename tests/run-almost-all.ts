@@ -50,6 +50,7 @@ import { testit as issue2568 } from "./issue-2568.ts";
 import { testit as issue2799 } from "./issue-2799.ts";
 import { testit as findMatchSelect } from "./issue-find-match-select.ts";
 import { testit as findResultsSorted } from "./find-results-sorted.ts";
+import { testit as perfStats } from "./perf-stats.ts";
 import { testit as findWindowLayout } from "./find-window-layout.ts";
 import { testit as issue5874 } from "./issue-5874.ts";
 import { testit as issue2252 } from "./issue-2252.ts";
@@ -222,6 +223,7 @@ export const tests: NamedTest[] = [
   ["issue-2799", issue2799],
   ["issue-find-match-select", findMatchSelect],
   ["find-results-sorted", findResultsSorted],
+  ["perf-stats", perfStats],
   ["find-window-layout", findWindowLayout],
   ["issue-5874", issue5874],
   ["issue-2252", issue2252],